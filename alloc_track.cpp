@@ -0,0 +1,282 @@
+/**
+ * BJJ Gym Timer - Heap Allocation Tracker Implementation
+ */
+
+#include "alloc_track.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <malloc.h>
+#include <new>
+#include <unistd.h>
+
+namespace bjj {
+
+void describeCodeAddress(const void* addr, char* buf, size_t size) {
+    Dl_info info;
+    if (!dladdr(addr, &info) || !info.dli_fname) {
+        snprintf(buf, size, "%p", addr);
+        return;
+    }
+    const char* module = strrchr(info.dli_fname, '/');
+    module = module ? module + 1 : info.dli_fname;
+    const uintptr_t offset = reinterpret_cast<uintptr_t>(addr) - reinterpret_cast<uintptr_t>(info.dli_fbase);
+    if (info.dli_sname) {
+        snprintf(buf, size, "%s+0x%zx (%s)", module, static_cast<size_t>(offset), info.dli_sname);
+    } else {
+        snprintf(buf, size, "%s+0x%zx", module, static_cast<size_t>(offset));
+    }
+}
+
+void writeErr(const char* line, int len, size_t size) {
+    if (len <= 0) return;
+    ssize_t w = write(STDERR_FILENO, line, std::min(static_cast<size_t>(len), size - 1));
+    (void)w;
+}
+
+namespace {
+
+// Everything here is zero-initialised static storage: operator new runs
+// during static initialisation too, before any constructor could.
+struct SiteSlot {
+    std::atomic<const void*> caller;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> bytes;
+};
+
+struct PhaseCounters {
+    std::atomic<uint64_t> allocs;
+    std::atomic<uint64_t> frees;
+    std::atomic<uint64_t> bytes;
+    SiteSlot sites[ALLOC_SITE_SLOTS];
+};
+
+PhaseCounters g_phases[ALLOC_PHASE_COUNT];
+std::atomic<uint8_t> g_phase;
+std::atomic<uint8_t> g_strict;
+std::atomic<uint64_t> g_live;
+std::atomic<uint64_t> g_peak;
+std::atomic<uint64_t> g_blocks;
+std::atomic<uint32_t> g_dropped;
+std::atomic<uint32_t> g_logged;
+thread_local bool t_reporting;  // A strict-mode report must not report itself
+
+const char* const PHASE_NAMES[ALLOC_PHASE_COUNT] = {"init", "steady", "shutdown"};
+
+// Open addressing on the return address; a slot, once claimed, keeps its caller
+void chargeSite(PhaseCounters& c, const void* caller, size_t size) {
+    const uint64_t key = reinterpret_cast<uintptr_t>(caller);
+    unsigned i = static_cast<unsigned>((key * 0x9E3779B97F4A7C15ULL) >> 57) % ALLOC_SITE_SLOTS;
+    for (unsigned probe = 0; probe < ALLOC_SITE_SLOTS; ++probe, i = (i + 1) % ALLOC_SITE_SLOTS) {
+        SiteSlot& s = c.sites[i];
+        const void* seen = s.caller.load(std::memory_order_acquire);
+        if (!seen && s.caller.compare_exchange_strong(seen, caller, std::memory_order_acq_rel)) seen = caller;
+        if (seen != caller) continue;
+        s.count.fetch_add(1, std::memory_order_relaxed);
+        s.bytes.fetch_add(size, std::memory_order_relaxed);
+        return;
+    }
+    g_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Straight to fd 2 with stack buffers: stdio could allocate its buffer here.
+// The caller is often inside libstdc++ (std::string), so a few frames
+// above it follow.
+void strictHit(size_t size, const void* caller, AllocStrict mode) {
+    if (t_reporting) return;
+    t_reporting = true;
+    const uint32_t n = g_logged.fetch_add(1, std::memory_order_relaxed);
+    if (n < STRICT_LOG_MAX || mode == AllocStrict::ABORT) {
+        char where[160];
+        char line[256];
+        describeCodeAddress(caller, where, sizeof(where));
+        writeErr(line, snprintf(line, sizeof(line), "[alloc] steady-state allocation: %zu bytes from %s%s\n", size,
+                                where, n + 1 == STRICT_LOG_MAX ? " (further ones counted only)" : ""), sizeof(line));
+        // The frames above the caller; the ones below it are this file's
+        void* frames[STRICT_FRAMES + 8];
+        const int count = backtrace(frames, STRICT_FRAMES + 8);
+        int i = 0;
+        while (i < count && frames[i] != caller) ++i;
+        for (int last = i + STRICT_FRAMES; ++i < count && i <= last;) {
+            describeCodeAddress(frames[i], where, sizeof(where));
+            writeErr(line, snprintf(line, sizeof(line), "[alloc]   from %s\n", where), sizeof(line));
+        }
+    }
+    if (mode == AllocStrict::ABORT) abort();
+    t_reporting = false;
+}
+
+void* allocate(size_t size, size_t align, const void* caller) {
+    if (size == 0) size = 1;
+    void* p = nullptr;
+    if (align > alignof(std::max_align_t)) {
+        if (posix_memalign(&p, std::max(align, sizeof(void*)), size) != 0) p = nullptr;
+    } else {
+        p = malloc(size);
+    }
+    if (!p) return nullptr;
+
+    const unsigned phase = g_phase.load(std::memory_order_relaxed);
+    PhaseCounters& c = g_phases[phase];
+    c.allocs.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(size, std::memory_order_relaxed);
+    const uint64_t usable = malloc_usable_size(p);
+    const uint64_t live = g_live.fetch_add(usable, std::memory_order_relaxed) + usable;
+    g_blocks.fetch_add(1, std::memory_order_relaxed);
+    uint64_t peak = g_peak.load(std::memory_order_relaxed);
+    while (live > peak && !g_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    chargeSite(c, caller, size);
+
+    const AllocStrict mode = static_cast<AllocStrict>(g_strict.load(std::memory_order_relaxed));
+    if (phase == static_cast<unsigned>(AllocPhase::STEADY) && mode != AllocStrict::OFF) strictHit(size, caller, mode);
+    return p;
+}
+
+void release(void* p) {
+    if (!p) return;
+    g_live.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+    g_blocks.fetch_sub(1, std::memory_order_relaxed);
+    g_phases[g_phase.load(std::memory_order_relaxed)].frees.fetch_add(1, std::memory_order_relaxed);
+    free(p);
+}
+
+void* allocateOrThrow(size_t size, size_t align, const void* caller) {
+    void* p = allocate(size, align, caller);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+} // namespace
+
+void setAllocPhase(AllocPhase phase) {
+    g_phase.store(static_cast<uint8_t>(phase), std::memory_order_relaxed);
+}
+
+AllocPhase allocPhase() {
+    return static_cast<AllocPhase>(g_phase.load(std::memory_order_relaxed));
+}
+
+void setAllocStrict(AllocStrict mode) {
+    if (mode != AllocStrict::OFF) {
+        // backtrace() loads its unwinder on first use; do that now, not mid-report
+        void* frame;
+        backtrace(&frame, 1);
+    }
+    g_strict.store(static_cast<uint8_t>(mode), std::memory_order_relaxed);
+}
+
+bool parseAllocStrict(const char* s, AllocStrict& out) {
+    if (!strcmp(s, "log")) out = AllocStrict::LOG;
+    else if (!strcmp(s, "abort")) out = AllocStrict::ABORT;
+    else if (!strcmp(s, "off")) out = AllocStrict::OFF;
+    else return false;
+    return true;
+}
+
+AllocStats allocStats() {
+    AllocStats st{};
+    for (unsigned i = 0; i < ALLOC_PHASE_COUNT; ++i) {
+        st.phase[i].allocs = g_phases[i].allocs.load(std::memory_order_relaxed);
+        st.phase[i].frees = g_phases[i].frees.load(std::memory_order_relaxed);
+        st.phase[i].bytes = g_phases[i].bytes.load(std::memory_order_relaxed);
+    }
+    st.liveBytes = g_live.load(std::memory_order_relaxed);
+    st.peakBytes = g_peak.load(std::memory_order_relaxed);
+    st.liveBlocks = g_blocks.load(std::memory_order_relaxed);
+    st.sitesDropped = g_dropped.load(std::memory_order_relaxed);
+    return st;
+}
+
+unsigned allocSites(AllocPhase phase, AllocSite* out, unsigned max) {
+    const PhaseCounters& c = g_phases[static_cast<unsigned>(phase)];
+    // Keep the max busiest: insertion into a sorted prefix
+    unsigned n = 0;
+    for (const SiteSlot& s : c.sites) {
+        const void* caller = s.caller.load(std::memory_order_acquire);
+        const uint64_t count = s.count.load(std::memory_order_relaxed);
+        if (!caller || !count || max == 0) continue;
+        if (n == max && count <= out[n - 1].count) continue;
+        unsigned k = n < max ? n++ : n - 1;
+        while (k > 0 && out[k - 1].count < count) {
+            out[k] = out[k - 1];
+            --k;
+        }
+        out[k] = {caller, count, s.bytes.load(std::memory_order_relaxed)};
+    }
+    return n;
+}
+
+void printAllocReport(FILE* out, const char* prefix, bool allSites) {
+    const AllocStats st = allocStats();
+    const AllocPhaseStats* p = st.phase;
+    fprintf(out, "%sheap: init %llu allocs (%.1f KiB), steady %llu (%.1f KiB), shutdown %llu; "
+            "%.1f KiB live in %llu blocks, peak %.1f KiB\n", prefix,
+            static_cast<unsigned long long>(p[0].allocs), p[0].bytes / 1024.0,
+            static_cast<unsigned long long>(p[1].allocs), p[1].bytes / 1024.0,
+            static_cast<unsigned long long>(p[2].allocs), st.liveBytes / 1024.0,
+            static_cast<unsigned long long>(st.liveBlocks), st.peakBytes / 1024.0);
+    for (unsigned ph = 0; ph < ALLOC_PHASE_COUNT; ++ph) {
+        if (!p[ph].allocs || (!allSites && ph != static_cast<unsigned>(AllocPhase::STEADY))) continue;
+        AllocSite sites[REPORT_SITES];
+        const unsigned n = allocSites(static_cast<AllocPhase>(ph), sites, REPORT_SITES);
+        for (unsigned i = 0; i < n; ++i) {
+            char where[160];
+            describeCodeAddress(sites[i].caller, where, sizeof(where));
+            fprintf(out, "%s  %-8s %6llu x %8llu B  %s\n", prefix, PHASE_NAMES[ph],
+                    static_cast<unsigned long long>(sites[i].count),
+                    static_cast<unsigned long long>(sites[i].bytes), where);
+        }
+    }
+    if (st.sitesDropped) {
+        fprintf(out, "%s  %u allocations from sites past the %u-slot table\n", prefix, st.sitesDropped,
+                ALLOC_SITE_SLOTS);
+    }
+}
+
+} // namespace bjj
+
+// ============================================================================
+// GLOBAL OPERATOR NEW/DELETE
+// ============================================================================
+// Each variant passes its own return address: operator new is the frame
+// directly under the code that allocated.
+void* operator new(std::size_t n) {
+    return bjj::allocateOrThrow(n, 0, __builtin_return_address(0));
+}
+void* operator new[](std::size_t n) {
+    return bjj::allocateOrThrow(n, 0, __builtin_return_address(0));
+}
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+    return bjj::allocate(n, 0, __builtin_return_address(0));
+}
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept {
+    return bjj::allocate(n, 0, __builtin_return_address(0));
+}
+void* operator new(std::size_t n, std::align_val_t a) {
+    return bjj::allocateOrThrow(n, static_cast<size_t>(a), __builtin_return_address(0));
+}
+void* operator new[](std::size_t n, std::align_val_t a) {
+    return bjj::allocateOrThrow(n, static_cast<size_t>(a), __builtin_return_address(0));
+}
+void* operator new(std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept {
+    return bjj::allocate(n, static_cast<size_t>(a), __builtin_return_address(0));
+}
+void* operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept {
+    return bjj::allocate(n, static_cast<size_t>(a), __builtin_return_address(0));
+}
+
+void operator delete(void* p) noexcept { bjj::release(p); }
+void operator delete[](void* p) noexcept { bjj::release(p); }
+void operator delete(void* p, std::size_t) noexcept { bjj::release(p); }
+void operator delete[](void* p, std::size_t) noexcept { bjj::release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { bjj::release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { bjj::release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { bjj::release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { bjj::release(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { bjj::release(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { bjj::release(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { bjj::release(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { bjj::release(p); }
@@ -0,0 +1,85 @@
+/**
+ * BJJ Gym Timer - Heap Allocation Tracker
+ * Replaces the global operator new/delete of the binary it is linked into
+ * and counts every C++ heap allocation by phase: INIT (startup), STEADY (the
+ * main loop) and SHUTDOWN. Each allocation is charged to the code that
+ * called operator new, so a report names the call sites behind any count.
+ *
+ * After setAllocPhase(AllocPhase::STEADY) the process is expected not to
+ * allocate at all: every steady-state path works out of buffers sized at
+ * init. setAllocStrict() turns that expectation into a check - LOG writes
+ * one line per allocation (up to STRICT_LOG_MAX), ABORT stops the process at
+ * the first one so a core dump shows the stack.
+ *
+ * Scope: operator new/delete only. C code (LVGL, SDL, ALSA, stdio) is not
+ * counted; LVGL draws from its own fixed LV_MEM_SIZE pool, reported
+ * separately (lv_mem_monitor).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace bjj {
+
+enum class AllocPhase : uint8_t { INIT, STEADY, SHUTDOWN };
+constexpr unsigned ALLOC_PHASE_COUNT = 3;
+
+enum class AllocStrict : uint8_t {
+    OFF,
+    LOG,     // One line on stderr per steady-state allocation
+    ABORT,   // Log the first one, then abort()
+};
+
+struct AllocPhaseStats {
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t bytes;          // Requested
+};
+
+struct AllocStats {
+    AllocPhaseStats phase[ALLOC_PHASE_COUNT];
+    uint64_t liveBytes;      // Usable size of the blocks still allocated
+    uint64_t peakBytes;
+    uint64_t liveBlocks;
+    uint32_t sitesDropped;   // Allocations from call sites past the table
+};
+
+struct AllocSite {
+    const void* caller;      // Return address into the code that allocated
+    uint64_t count;
+    uint64_t bytes;
+};
+
+constexpr unsigned ALLOC_SITE_SLOTS = 128;   // Per phase
+constexpr unsigned STRICT_LOG_MAX = 32;
+constexpr unsigned STRICT_FRAMES = 6;         // Backtrace lines per logged allocation
+constexpr unsigned REPORT_SITES = 16;        // Per phase in a report
+
+void setAllocPhase(AllocPhase phase);
+AllocPhase allocPhase();
+void setAllocStrict(AllocStrict mode);
+
+// "log" / "abort" / "off"; false if unknown
+bool parseAllocStrict(const char* s, AllocStrict& out);
+
+AllocStats allocStats();
+
+// The phase's call sites, most allocations first. Returns the number written.
+unsigned allocSites(AllocPhase phase, AllocSite* out, unsigned max);
+
+// Per-phase totals, then the steady-state call sites (all phases' with
+// allSites) as module+offset for addr2line; every line starts with prefix
+void printAllocReport(FILE* out, const char* prefix, bool allSites);
+
+// "bjj_timer+0x1a2b3 (symbol)" for a code address, via dladdr: the offset is
+// what addr2line -e wants
+void describeCodeAddress(const void* addr, char* buf, size_t size);
+
+// Write an snprintf result (len) from a size-byte buffer straight to fd 2,
+// clipped as snprintf clipped it: no stdio lock, no allocation
+void writeErr(const char* line, int len, size_t size);
+
+} // namespace bjj
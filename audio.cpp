@@ -0,0 +1,137 @@
+/**
+ * BJJ Gym Timer - Audio Cue Playback Implementation
+ */
+
+#include "audio.hpp"
+#include "perf_trace.hpp"
+#include <cerrno>
+#include <chrono>
+#include <ctime>
+
+namespace bjj {
+
+void CuePlayer::start(int gpioHandle) {
+    if (worker_.joinable()) return;
+    handle_ = gpioHandle;
+    buzzer_.init(handle_);
+    quit_ = false;
+    worker_ = std::thread(&CuePlayer::run, this);
+}
+
+void CuePlayer::stop() {
+    if (!worker_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    cv_.notify_one();
+    worker_.join();
+    buzzer_.silence(handle_);
+    lgGpioFree(handle_, buzzer_.pin());
+    handle_ = -1;
+}
+
+void CuePlayer::play(uint8_t cues) {
+    if (!cues) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t now = monotonicMs();
+        // The tick raising an armed cue runs just after its deadline
+        if (playedCues_ && now - playedMs_ < MATCH_MS) {
+            cues &= ~playedCues_;
+            playedCues_ = 0;
+        }
+        // ... unless the worker has not got to it yet: play it now instead
+        if (armedCues_ && armedMs_ <= now) armedCues_ = 0;
+        if (!cues) return;
+        pending_ |= cues;
+        ++stats_.immediate;
+    }
+    cv_.notify_one();
+}
+
+void CuePlayer::arm(uint64_t deadlineMs, uint8_t cues) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (inFlight_) {
+            if (deadlineMs == playedMs_ && cues == playedCues_) return;
+            // From its deadline on, the cue has fired and this is the next one
+            if (monotonicMs() < playedMs_) ++armGen_;
+        }
+        armedMs_ = deadlineMs;
+        armedCues_ = cues;
+    }
+    cv_.notify_one();
+}
+
+CueStats CuePlayer::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CueStats st = stats_;
+    st.avgOnsetUs = st.scheduled ? static_cast<uint32_t>(onsetSumUs_ / st.scheduled) : 0;
+    return st;
+}
+
+void CuePlayer::run() {
+    for (;;) {
+        uint8_t cues = 0;
+        uint64_t dueNs = 0;
+        uint32_t gen = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!cues) {
+                if (quit_) return;
+                if (pending_) {
+                    cues = pending_;
+                    pending_ = 0;
+                } else if (armedCues_) {
+                    uint64_t now = monotonicNs();
+                    uint64_t due = armedMs_ * 1000000ULL;
+                    if (due > now + SPIN_US * 1000ULL) {
+                        cv_.wait_for(lock, std::chrono::nanoseconds(due - now - SPIN_US * 1000ULL));
+                        continue;
+                    }
+                    cues = armedCues_;
+                    dueNs = due;
+                    playedMs_ = armedMs_;
+                    playedCues_ = armedCues_;
+                    armedCues_ = 0;
+                    inFlight_ = true;
+                    gen = armGen_;
+                } else {
+                    cv_.wait(lock);
+                }
+            }
+        }
+        if (dueNs) {
+            // Last stretch: absolute sleep on the deadline's own clock, no lock held
+            struct timespec ts;
+            ts.tv_sec = static_cast<time_t>(dueNs / 1000000000ULL);
+            ts.tv_nsec = static_cast<long>(dueNs % 1000000000ULL);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+            uint64_t now = monotonicNs();
+            uint32_t onsetUs = static_cast<uint32_t>(now > dueNs ? (now - dueNs) / 1000 : 0);
+            std::lock_guard<std::mutex> lock(mutex_);
+            inFlight_ = false;
+            // Paused, reset or re-armed during the sleep: the mat no longer wants it
+            if (gen != armGen_) {
+                playedCues_ = 0;
+                continue;
+            }
+            ++stats_.scheduled;
+            stats_.lastOnsetUs = onsetUs;
+            if (onsetUs > stats_.maxOnsetUs) stats_.maxOnsetUs = onsetUs;
+            onsetSumUs_ += onsetUs;
+        }
+        playPattern(cues);
+    }
+}
+
+void CuePlayer::playPattern(uint8_t cues) {
+    // Same order the main loop used to play them inline
+    if (cues & CUE_ROUND_START) buzzer_.playStartRound(handle_);
+    if (cues & CUE_TEN_SECOND)  buzzer_.play10SecondWarning(handle_);
+    if (cues & CUE_ROUND_END)   buzzer_.playEndRound(handle_);
+    if (cues & CUE_SWITCH)      buzzer_.playDrillingSwitch(handle_);
+}
+
+} // namespace bjj
@@ -0,0 +1,101 @@
+/**
+ * BJJ Gym Timer - Audio Cue Playback
+ * Cue patterns play on a worker thread so a 2 s end buzzer never blocks
+ * the main loop (or, in a multi-mat host, every other mat).
+ *
+ * Boundary cues are armed ahead of time from MatHost's cue schedule and
+ * started by the worker on an absolute CLOCK_MONOTONIC sleep, so the horn
+ * lands on the boundary rather than a loop period plus render time later.
+ * The tick that then raises the same cue finds it already played.
+ */
+
+#pragma once
+
+#include "hardware.hpp"
+#include "timer_logic.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace bjj {
+
+// Cue bits - one per DisplayInfo audio flag
+enum Cue : uint8_t {
+    CUE_ROUND_START = 1 << 0,
+    CUE_TEN_SECOND  = 1 << 1,
+    CUE_ROUND_END   = 1 << 2,
+    CUE_SWITCH      = 1 << 3,
+};
+
+inline uint8_t cueMask(const DisplayInfo& info) {
+    uint8_t m = 0;
+    if (info.roundStartDue)       m |= CUE_ROUND_START;
+    if (info.tenSecondWarningDue) m |= CUE_TEN_SECOND;
+    if (info.roundEndDue)         m |= CUE_ROUND_END;
+    if (info.switchDue)           m |= CUE_SWITCH;
+    return m;
+}
+
+struct CueStats {
+    uint32_t scheduled;       // Started at their armed deadline
+    uint32_t immediate;       // Started when raised (presses, or armed too late)
+    uint32_t lastOnsetUs;     // Scheduled: first tone start - deadline
+    uint32_t maxOnsetUs;
+    uint32_t avgOnsetUs;
+};
+
+// ============================================================================
+// CUE PLAYER - one worker thread per buzzer pin
+// ============================================================================
+class CuePlayer {
+public:
+    explicit CuePlayer(unsigned pin = BUZZER_PIN) : buzzer_(pin) {}
+    ~CuePlayer() { stop(); }
+    CuePlayer(const CuePlayer&) = delete;
+    CuePlayer& operator=(const CuePlayer&) = delete;
+
+    // Claim the buzzer pin and start the worker
+    void start(int gpioHandle);
+    // Silence, join the worker and free the pin
+    void stop();
+
+    // Non-blocking: queue cue bits; cues already pending are merged. Bits
+    // the worker just played on schedule are dropped.
+    void play(uint8_t cues);
+
+    // Play cues at deadlineMs (monotonicMs() clock), replacing any earlier
+    // arming; cues == 0 disarms. Fed from MatHost::CueScheduleSink. Also
+    // cancels a cue already in its last SPIN_US, before its deadline, unless
+    // re-armed unchanged.
+    void arm(uint64_t deadlineMs, uint8_t cues);
+
+    CueStats stats();
+
+    Buzzer& buzzer() { return buzzer_; }
+
+    static constexpr unsigned SPIN_US = 2000;     // Final approach off the condvar
+    static constexpr unsigned MATCH_MS = 500;     // Raised this close to a played deadline: same cue
+
+private:
+    void run();
+    void playPattern(uint8_t cues);
+
+    Buzzer buzzer_;
+    int handle_{-1};
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    uint8_t pending_{0};
+    uint64_t armedMs_{0};
+    uint8_t armedCues_{0};
+    uint64_t playedMs_{0};    // Last scheduled cue the worker took
+    uint8_t playedCues_{0};
+    bool inFlight_{false};    // Taken for the final approach, not started yet
+    uint32_t armGen_{0};      // Bumped by an arm() that cancels the cue in flight
+    bool quit_{false};
+    CueStats stats_{};
+    uint64_t onsetSumUs_{0};
+};
+
+} // namespace bjj
@@ -0,0 +1,249 @@
+/**
+ * BJJ Gym Timer - Crash-safe State Checkpoint Implementation
+ */
+
+#include "checkpoint.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bjj {
+
+static_assert(sizeof(CheckpointSlot) % 8 == 0, "CheckpointSlot must stay 8-byte aligned");
+
+namespace {
+
+struct Crc32Table {
+    uint32_t v[256];
+    constexpr Crc32Table() : v() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            v[i] = c;
+        }
+    }
+};
+constexpr Crc32Table CRC_TABLE;
+
+} // namespace
+
+uint32_t crc32(const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; ++i) c = CRC_TABLE.v[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+namespace {
+
+uint32_t slotCrc(const CheckpointSlot& s) {
+    return crc32(&s, offsetof(CheckpointSlot, crc));
+}
+
+bool slotValid(const CheckpointSlot& s) {
+    return s.magic == CHECKPOINT_MAGIC && s.version == CHECKPOINT_VERSION &&
+           s.size == sizeof(CheckpointSlot) && s.crc == slotCrc(s);
+}
+
+int64_t clockNs(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void readBootId(uint8_t out[16]) {
+    std::memset(out, 0, 16);
+    FILE* f = std::fopen("/proc/sys/kernel/random/boot_id", "r");
+    if (!f) return;
+    char buf[64] = {};
+    size_t n = std::fread(buf, 1, sizeof(buf) - 1, f);
+    std::fclose(f);
+    unsigned byte = 0;
+    for (size_t i = 0; i + 1 < n && byte < 16; ++i) {
+        if (buf[i] == '-') continue;
+        unsigned hi, lo;
+        if (std::sscanf(buf + i, "%1x%1x", &hi, &lo) != 2) break;
+        out[byte++] = static_cast<uint8_t>((hi << 4) | lo);
+        ++i;
+    }
+}
+
+} // namespace
+
+Checkpoint::~Checkpoint() {
+    close();
+}
+
+std::string Checkpoint::defaultPath() {
+    if (const char* env = std::getenv("BJJ_CHECKPOINT")) return env;
+    if (const char* home = std::getenv("HOME")) return std::string(home) + "/.bjj_timer.ckpt";
+    return "bjj_timer.ckpt";
+}
+
+bool Checkpoint::open(const std::string& path) {
+    close();
+    readBootId(bootId_);
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        fprintf(stderr, "[checkpoint] open %s failed\n", path.c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0 ||
+        (st.st_size < static_cast<off_t>(sizeof(CheckpointFile)) &&
+         ftruncate(fd_, sizeof(CheckpointFile)) != 0)) {
+        fprintf(stderr, "[checkpoint] resize %s failed\n", path.c_str());
+        close();
+        return false;
+    }
+    void* p = mmap(nullptr, sizeof(CheckpointFile), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "[checkpoint] mmap %s failed\n", path.c_str());
+        close();
+        return false;
+    }
+    file_ = static_cast<CheckpointFile*>(p);
+
+    for (const CheckpointSlot& s : file_->slots) {
+        if (slotValid(s) && s.seq > seq_) seq_ = s.seq;
+    }
+    dirty_ = false;
+    stopping_ = false;
+    thread_ = std::thread(&Checkpoint::run, this);
+    return true;
+}
+
+void Checkpoint::close() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+    if (file_) {
+        msync(file_, sizeof(CheckpointFile), MS_SYNC);
+        munmap(file_, sizeof(CheckpointFile));
+        file_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void Checkpoint::save(const TimerSnapshot& snap, uint32_t untilTickMs) {
+    if (!file_) return;
+    ++seq_;
+    CheckpointSlot s{};
+    s.magic = CHECKPOINT_MAGIC;
+    s.version = CHECKPOINT_VERSION;
+    s.size = sizeof(CheckpointSlot);
+    s.seq = seq_;
+    std::memcpy(s.bootId, bootId_, sizeof(s.bootId));
+    s.boottimeNs = clockNs(CLOCK_BOOTTIME);
+    s.realtimeNs = clockNs(CLOCK_REALTIME);
+    s.state = static_cast<uint8_t>(snap.state);
+    s.mode = static_cast<uint8_t>(snap.mode);
+    s.phase = static_cast<uint8_t>(snap.phase);
+    s.tenSecondPlayed = snap.tenSecondPlayed ? 1 : 0;
+    s.workSeconds = snap.config.workSeconds;
+    s.restSeconds = snap.config.restSeconds;
+    s.roundCount = snap.config.roundCount;
+    s.compTimeIndex = snap.config.compTimeIndex;
+    s.currentRound = snap.currentRound;
+    s.totalRounds = snap.totalRounds;
+    s.secondsRemaining = snap.secondsRemaining;
+    for (unsigned a = 0; a < 2; ++a) {
+        s.points[a] = snap.score.points[a];
+        s.advantages[a] = snap.score.advantages[a];
+        s.penalties[a] = snap.score.penalties[a];
+    }
+    s.untilTickMs = untilTickMs;
+    s.crc = slotCrc(s);
+
+    // Overwrite the older slot; the other one stays valid if this write tears
+    file_->slots[seq_ & 1] = s;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dirty_ = true;
+    }
+    cv_.notify_one();
+}
+
+void Checkpoint::run() {
+    // MS_ASYNC is a no-op on Linux; only MS_SYNC gets the page to storage.
+    // Saves arriving during a flush coalesce into the next one.
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cv_.wait(lock, [this] { return stopping_ || dirty_; });
+        if (stopping_) return;  // close() does the final msync
+        dirty_ = false;
+        lock.unlock();
+        if (msync(file_, sizeof(CheckpointFile), MS_SYNC) != 0) {
+            fprintf(stderr, "[checkpoint] msync failed\n");
+        }
+        lock.lock();
+    }
+}
+
+bool Checkpoint::load(TimerSnapshot& snap, unsigned& elapsedTicks, uint32_t& firstTickMs) const {
+    if (!file_) return false;
+    const CheckpointSlot* best = nullptr;
+    for (const CheckpointSlot& s : file_->slots) {
+        if (slotValid(s) && (!best || s.seq > best->seq)) best = &s;
+    }
+    if (!best) return false;
+    if (best->state > static_cast<uint8_t>(TimerState::FINISHED) ||
+        best->mode > static_cast<uint8_t>(TimerMode::COMPETITION) ||
+        best->phase > static_cast<uint8_t>(Phase::SWITCH)) {
+        return false;
+    }
+
+    // Same boot: CLOCK_BOOTTIME is exact. After a reboot fall back to wall time.
+    int64_t ageNs = (std::memcmp(best->bootId, bootId_, sizeof(bootId_)) == 0)
+        ? clockNs(CLOCK_BOOTTIME) - best->boottimeNs
+        : clockNs(CLOCK_REALTIME) - best->realtimeNs;
+    if (ageNs < 0 || ageNs > static_cast<int64_t>(CHECKPOINT_MAX_AGE_SEC) * 1000000000LL) {
+        return false;
+    }
+    // Ticks fell untilTickMs after the write, then every second
+    const uint64_t ageMs = static_cast<uint64_t>(ageNs + 500000) / 1000000ULL;
+    const uint32_t untilTick = best->untilTickMs >= 1 && best->untilTickMs <= 1000 ? best->untilTickMs : 1000;
+    if (ageMs < untilTick) {
+        elapsedTicks = 0;
+        firstTickMs = static_cast<uint32_t>(untilTick - ageMs);
+    } else {
+        const uint64_t over = ageMs - untilTick;
+        elapsedTicks = static_cast<unsigned>(1 + over / 1000);
+        firstTickMs = static_cast<uint32_t>(1000 - over % 1000);
+    }
+
+    snap.state = static_cast<TimerState>(best->state);
+    snap.mode = static_cast<TimerMode>(best->mode);
+    snap.phase = static_cast<Phase>(best->phase);
+    snap.tenSecondPlayed = best->tenSecondPlayed != 0;
+    snap.config.workSeconds = best->workSeconds;
+    snap.config.restSeconds = best->restSeconds;
+    snap.config.roundCount = best->roundCount;
+    snap.config.compTimeIndex = best->compTimeIndex;
+    snap.currentRound = best->currentRound;
+    snap.totalRounds = best->totalRounds;
+    snap.secondsRemaining = best->secondsRemaining;
+    for (unsigned a = 0; a < 2; ++a) {
+        snap.score.points[a] = best->points[a];
+        snap.score.advantages[a] = best->advantages[a];
+        snap.score.penalties[a] = best->penalties[a];
+    }
+    return true;
+}
+
+} // namespace bjj
@@ -0,0 +1,111 @@
+/**
+ * BJJ Gym Timer - Crash-safe State Checkpoint
+ * Fixed-layout mmap'd file holding the last TimerLogic transition
+ *
+ * Two CRC-protected slots are written alternately, so a torn write
+ * (power loss mid-update) always leaves the previous slot intact. A flusher
+ * thread forces each save to storage with msync(MS_SYNC); power lost before
+ * that completes resumes from the previous save.
+ */
+
+#pragma once
+
+#include "timer_logic.hpp"
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace bjj {
+
+// CRC-32 (IEEE 802.3), shared by the on-disk formats
+uint32_t crc32(const void* data, size_t len);
+
+// ============================================================================
+// ON-DISK LAYOUT (little-endian, fixed size - never reorder fields)
+// ============================================================================
+constexpr uint32_t CHECKPOINT_MAGIC   = 0x434A4A42;  // "BJJC"
+constexpr uint16_t CHECKPOINT_VERSION = 1;
+constexpr unsigned CHECKPOINT_MAX_AGE_SEC = 6 * 3600;  // Older sessions are not resumed
+
+struct CheckpointSlot {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;            // sizeof(CheckpointSlot)
+    uint64_t seq;             // Monotonic write counter; highest valid slot wins
+    uint8_t  bootId[16];      // /proc/sys/kernel/random/boot_id
+    int64_t  boottimeNs;      // CLOCK_BOOTTIME at write (same-boot resume)
+    int64_t  realtimeNs;      // CLOCK_REALTIME at write (after reboot)
+    uint8_t  state;
+    uint8_t  mode;
+    uint8_t  phase;
+    uint8_t  tenSecondPlayed;
+    uint32_t workSeconds;
+    uint32_t restSeconds;
+    uint32_t roundCount;
+    uint32_t compTimeIndex;
+    uint32_t currentRound;
+    uint32_t totalRounds;
+    uint32_t secondsRemaining;
+    uint16_t points[2];       // Competition score (zero in files written before scoring)
+    uint8_t  advantages[2];
+    uint8_t  penalties[2];
+    uint32_t untilTickMs;     // From this write to the next tick, 1..1000; 0: not recorded (a fresh second)
+    uint32_t reserved;
+    uint32_t crc;             // CRC-32 of every byte before this field
+};
+
+struct CheckpointFile {
+    CheckpointSlot slots[2];
+};
+
+// ============================================================================
+// CHECKPOINT
+// ============================================================================
+class Checkpoint {
+public:
+    Checkpoint() = default;
+    ~Checkpoint();
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+    // Map (creating if needed) the checkpoint file. Returns false on failure.
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file_ != nullptr; }
+
+    // Per transition: two clock reads, a CRC over the slot, one slot-sized
+    // store into the mapped page and a wake of the flusher thread, which does
+    // the msync(MS_SYNC) off the timer path.
+    // untilTickMs: MatHost::untilTickMs() for the mat, so resume keeps the
+    // position within the second.
+    void save(const TimerSnapshot& snap, uint32_t untilTickMs);
+
+    // Newest valid slot, the whole ticks missed since it was written and the
+    // ms from now to the next one (1..1000; MatHost::alignTick). Time since the
+    // write is rounded to the nearest ms. Returns false if no valid, recent
+    // checkpoint exists.
+    bool load(TimerSnapshot& snap, unsigned& elapsedTicks, uint32_t& firstTickMs) const;
+
+    // Default location: $BJJ_CHECKPOINT, else ~/.bjj_timer.ckpt
+    static std::string defaultPath();
+
+private:
+    void run();
+
+    CheckpointFile* file_{nullptr};
+    int fd_{-1};
+    uint64_t seq_{0};
+    uint8_t bootId_[16]{};
+    std::thread thread_;
+
+    // Shared, under mutex_
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool dirty_ = false;
+    bool stopping_ = false;
+};
+
+} // namespace bjj
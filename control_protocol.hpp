@@ -0,0 +1,110 @@
+/**
+ * BJJ Gym Timer - Control Socket Wire Protocol
+ * Unix-domain SOCK_SEQPACKET, little-endian, one message per packet:
+ *
+ *   request : CtlHeader{type=CTL_REQUEST, count=N} + N x CtlCommand
+ *   reply   : CtlHeader{type=CTL_REPLY,   count=N} + N x CtlResult  (same seq)
+ *   event   : CtlHeader{type=CTL_EVENT,   count=N} + N x CtlMatState
+ *
+ * Commands in a batch run in order on the timer thread in one go, so a batch
+ * such as "load preset on mats 1-4, then start all" lands on the same tick.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace bjj {
+
+constexpr uint16_t CTL_MAGIC       = 0x4A42;  // "BJ"
+constexpr uint8_t  CTL_VERSION     = 2;       // 2: CtlMatState carries the score
+constexpr unsigned CTL_MAX_BATCH   = 64;
+constexpr uint8_t  CTL_ALL_MATS    = 0xFF;
+
+enum CtlType : uint8_t {
+    CTL_REQUEST = 1,
+    CTL_REPLY   = 2,
+    CTL_EVENT   = 3,
+};
+
+enum CtlOp : uint8_t {
+    CTL_OP_QUERY       = 1,  // Current state, no change
+    CTL_OP_START       = 2,  // Run the loaded config, or resume
+    CTL_OP_PAUSE       = 3,
+    CTL_OP_ADJUST      = 4,  // arg = +/- seconds
+    CTL_OP_LOAD_PRESET = 5,  // mode, rounds, arg = work s, arg2 = rest s
+    CTL_OP_RESET       = 6,  // Back to the menu
+    CTL_OP_SUBSCRIBE   = 7,  // arg2 = mat bitmask for events (0 = unsubscribe)
+    CTL_OP_STATS       = 8,  // Command handling cost
+    CTL_OP_RESULT      = 9,  // Tournament: arg = winner, 1 or 2 (listed first/second)
+    CTL_OP_SCORE       = 10, // Competition: mode = athlete 1 or 2, arg = ScoreKind
+    CTL_OP_UNDO_SCORE  = 11, // Competition: take back the last score
+    CTL_OP_REDO_SCORE  = 12,
+};
+
+enum CtlStatus : uint8_t {
+    CTL_OK          = 0,
+    CTL_BAD_MAT     = 1,
+    CTL_BAD_OP      = 2,
+    CTL_NOT_ALLOWED = 3,  // e.g. pause while not running
+};
+
+#pragma pack(push, 1)
+struct CtlHeader {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t type;
+    uint16_t count;
+    uint16_t reserved;
+    uint32_t seq;       // Chosen by the client, echoed in the reply
+};
+
+struct CtlCommand {
+    uint8_t op;
+    uint8_t mat;        // 0-based, or CTL_ALL_MATS
+    uint8_t mode;       // LOAD_PRESET: TimerMode
+    uint8_t rounds;     // LOAD_PRESET
+    int32_t arg;
+    uint32_t arg2;
+};
+
+struct CtlMatState {
+    uint8_t mat;
+    uint8_t state;      // TimerState
+    uint8_t mode;       // TimerMode
+    uint8_t phase;      // Phase
+    uint16_t currentRound;
+    uint16_t totalRounds;
+    uint32_t secondsRemaining;
+    uint32_t phaseTotalSeconds;
+    uint16_t points[2];     // Competition score, athletes 1 and 2; 0 unless scoring
+    uint8_t advantages[2];
+    uint8_t penalties[2];
+    uint8_t scoring;        // Competition match on screen: show the score
+    uint8_t reserved[3];
+};
+
+struct CtlStats {
+    uint32_t commands;
+    uint32_t batches;
+    uint32_t avgNs;     // Per command, on the timer thread
+    uint32_t maxNs;
+};
+
+struct CtlResult {
+    uint8_t op;
+    uint8_t status;     // CtlStatus
+    uint16_t reserved;
+    union {
+        CtlMatState state;  // All ops but STATS (for CTL_ALL_MATS: the last mat)
+        CtlStats stats;
+    };
+};
+#pragma pack(pop)
+
+static_assert(sizeof(CtlHeader) == 12, "wire layout");
+static_assert(sizeof(CtlCommand) == 12, "wire layout");
+static_assert(sizeof(CtlMatState) == 28, "wire layout");
+static_assert(sizeof(CtlResult) == 32, "wire layout");
+
+} // namespace bjj
@@ -0,0 +1,442 @@
+/**
+ * BJJ Gym Timer - Unix-Domain Socket Control Server Implementation
+ */
+
+#include "control_server.hpp"
+#include "perf_trace.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace bjj {
+
+// epoll user data: listener and wake fd are tagged, clients carry their slot
+static constexpr uint64_t TAG_LISTEN = ~0ULL;
+static constexpr uint64_t TAG_WAKE   = ~0ULL - 1;
+
+CtlMatState ctlMatState(unsigned mat, const DisplayInfo& info) {
+    CtlMatState s{};
+    s.mat = static_cast<uint8_t>(mat);
+    s.state = static_cast<uint8_t>(info.state);
+    s.mode = static_cast<uint8_t>(info.mode);
+    s.phase = static_cast<uint8_t>(info.phase);
+    s.currentRound = static_cast<uint16_t>(info.currentRound);
+    s.totalRounds = static_cast<uint16_t>(info.totalRounds);
+    s.secondsRemaining = info.secondsRemaining;
+    s.phaseTotalSeconds = info.phaseTotalSeconds;
+    s.scoring = info.scoring;
+    if (info.scoring) {
+        for (unsigned a = 0; a < 2; ++a) {
+            s.points[a] = info.score.points[a];
+            s.advantages[a] = info.score.advantages[a];
+            s.penalties[a] = info.score.penalties[a];
+        }
+    }
+    return s;
+}
+
+std::string ControlServer::defaultPath() {
+    const char* env = std::getenv("BJJ_CONTROL");
+    if (env && *env) return env;
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime && *runtime) return std::string(runtime) + "/bjj_timer.sock";
+    return "/tmp/bjj_timer.sock";
+}
+
+bool ControlServer::start(const std::string& path, unsigned matCount) {
+    stop();
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "[control] socket path too long: %s\n", path.c_str());
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    listenFd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        perror("[control] socket");
+        return false;
+    }
+    unlink(path.c_str());  // Stale socket from a previous run
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd_, 8) != 0) {
+        perror("[control] bind");
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    chmod(path.c_str(), 0660);
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.u64 = TAG_LISTEN;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &ev);
+    ev.data.u64 = TAG_WAKE;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+
+    path_ = path;
+    matCount_ = matCount < MAX_MATS ? matCount : MAX_MATS;
+    inbound_.reset(new Batch[QUEUE_DEPTH]);
+    outbound_.reset(new ReplyBatch[QUEUE_DEPTH]);
+    running_ = true;
+    thread_ = std::thread(&ControlServer::run, this);
+    return true;
+}
+
+void ControlServer::stop() {
+    if (thread_.joinable()) {
+        running_ = false;
+        uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+        thread_.join();
+    }
+    for (Client& c : clients_) closeClient(c);
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        unlink(path_.c_str());
+        listenFd_ = -1;
+    }
+    if (wakeFd_ >= 0) close(wakeFd_);
+    if (epollFd_ >= 0) close(epollFd_);
+    wakeFd_ = epollFd_ = -1;
+}
+
+// ============================================================================
+// I/O THREAD
+// ============================================================================
+void ControlServer::run() {
+    epoll_event events[16];
+    while (running_) {
+        int n = epoll_wait(epollFd_, events, 16, -1);
+        if (n < 0 && errno != EINTR) break;
+        for (int i = 0; i < n; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == TAG_LISTEN) {
+                acceptClients();
+            } else if (tag == TAG_WAKE) {
+                uint64_t v;
+                while (read(wakeFd_, &v, sizeof(v)) > 0) {}
+                flushOutbound();
+            } else if (tag < MAX_CLIENTS) {
+                Client& c = clients_[tag];
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) closeClient(c);
+                else readClient(c);
+            }
+        }
+    }
+}
+
+void ControlServer::acceptClients() {
+    // Edge-triggered: drain the backlog completely
+    for (;;) {
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        unsigned slot = 0;
+        while (slot < MAX_CLIENTS && clients_[slot].fd >= 0) ++slot;
+        if (slot == MAX_CLIENTS) {
+            close(fd);
+            continue;
+        }
+        Client& c = clients_[slot];
+        c.fd = fd;
+        c.id = ++nextClientId_;
+        c.subscribed = 0;
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLET | EPOLLRDHUP;
+        ev.data.u64 = slot;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void ControlServer::readClient(Client& c) {
+    alignas(8) uint8_t buf[sizeof(CtlHeader) + sizeof(CtlCommand) * CTL_MAX_BATCH];
+    while (c.fd >= 0) {
+        ssize_t len = recv(c.fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (len <= 0) {
+            closeClient(c);
+            return;
+        }
+        CtlHeader hdr{};
+        if (static_cast<size_t>(len) >= sizeof(hdr)) std::memcpy(&hdr, buf, sizeof(hdr));
+        if (hdr.magic != CTL_MAGIC || hdr.version != CTL_VERSION ||
+            hdr.type != CTL_REQUEST || hdr.count > CTL_MAX_BATCH ||
+            static_cast<size_t>(len) != sizeof(hdr) + hdr.count * sizeof(CtlCommand)) {
+            closeClient(c);  // Malformed: the protocol has no resync point
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (inCount_ == QUEUE_DEPTH) continue;  // Timer thread is behind: shed load
+        Batch& b = inbound_[(inHead_ + inCount_++) % QUEUE_DEPTH];
+        b.client = c.id;
+        b.seq = hdr.seq;
+        b.count = hdr.count;
+        std::memcpy(b.cmds, buf + sizeof(hdr), hdr.count * sizeof(CtlCommand));
+        // Subscriptions are connection state, so they are taken here; the timer
+        // thread still answers them in batch order
+        for (unsigned i = 0; i < b.count; ++i) {
+            if (b.cmds[i].op == CTL_OP_SUBSCRIBE) {
+                c.subscribed = b.cmds[i].arg2 | (static_cast<uint64_t>(static_cast<uint32_t>(b.cmds[i].arg)) << 32);
+            }
+        }
+    }
+}
+
+void ControlServer::closeClient(Client& c) {
+    if (c.fd < 0) return;
+    if (epollFd_ >= 0) epoll_ctl(epollFd_, EPOLL_CTL_DEL, c.fd, nullptr);
+    close(c.fd);
+    c.fd = -1;
+    c.id = 0;
+    c.subscribed = 0;
+}
+
+bool ControlServer::sendTo(Client& c, const void* msg, size_t len) {
+    if (c.fd < 0) return false;
+    ssize_t n = send(c.fd, msg, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        closeClient(c);
+        return false;
+    }
+    return n == static_cast<ssize_t>(len);  // A full socket drops this message only
+}
+
+void ControlServer::flushOutbound() {
+    alignas(8) uint8_t buf[sizeof(CtlHeader) + sizeof(CtlResult) * CTL_MAX_BATCH];
+    CtlHeader hdr{CTL_MAGIC, CTL_VERSION, 0, 0, 0, 0};
+
+    // Replies
+    for (;;) {
+        ReplyBatch r;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (outCount_ == 0) break;
+            ReplyBatch& src = outbound_[outHead_];
+            r.client = src.client;
+            r.seq = src.seq;
+            r.count = src.count;
+            std::memcpy(r.results, src.results, src.count * sizeof(CtlResult));
+            outHead_ = (outHead_ + 1) % QUEUE_DEPTH;
+            --outCount_;
+        }
+        for (Client& c : clients_) {
+            if (c.fd < 0 || c.id != r.client) continue;
+            hdr.type = CTL_REPLY;
+            hdr.count = r.count;
+            hdr.seq = r.seq;
+            std::memcpy(buf, &hdr, sizeof(hdr));
+            std::memcpy(buf + sizeof(hdr), r.results, r.count * sizeof(CtlResult));
+            sendTo(c, buf, sizeof(hdr) + r.count * sizeof(CtlResult));
+            break;
+        }
+    }
+
+    // Coalesced state events: only the latest state of each changed mat
+    CtlMatState states[MAX_MATS];
+    uint64_t dirty;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dirty = dirty_;
+        dirty_ = 0;
+        wakePending_ = false;
+        for (uint64_t m = dirty; m; m &= m - 1) {
+            unsigned i = static_cast<unsigned>(__builtin_ctzll(m));
+            states[i] = latest_[i];
+        }
+    }
+    if (!dirty) return;
+    alignas(8) uint8_t ebuf[sizeof(CtlHeader) + sizeof(CtlMatState) * MAX_MATS];
+    for (Client& c : clients_) {
+        uint64_t mask = dirty & c.subscribed;
+        if (c.fd < 0 || !mask) continue;
+        uint16_t count = 0;
+        for (uint64_t m = mask; m; m &= m - 1) {
+            unsigned i = static_cast<unsigned>(__builtin_ctzll(m));
+            std::memcpy(ebuf + sizeof(CtlHeader) + count++ * sizeof(CtlMatState), &states[i], sizeof(CtlMatState));
+        }
+        hdr.type = CTL_EVENT;
+        hdr.count = count;
+        hdr.seq = 0;
+        std::memcpy(ebuf, &hdr, sizeof(hdr));
+        sendTo(c, ebuf, sizeof(hdr) + count * sizeof(CtlMatState));
+    }
+}
+
+// ============================================================================
+// TIMER THREAD
+// ============================================================================
+void ControlServer::notify(unsigned mat, const DisplayInfo& info) {
+    if (!running_ || mat >= matCount_) return;
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        latest_[mat] = ctlMatState(mat, info);
+        dirty_ |= 1ULL << mat;
+        wake = !wakePending_ && !inApply_;
+        if (wake) wakePending_ = true;
+    }
+    if (wake) {
+        uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+    }
+}
+
+static CtlTap g_ctlTap = nullptr;
+static void* g_ctlTapCtx = nullptr;
+
+void setControlTap(CtlTap fn, void* ctx) {
+    g_ctlTap = fn;
+    g_ctlTapCtx = ctx;
+}
+
+static MatchResultSink g_resultSink = nullptr;
+static void* g_resultCtx = nullptr;
+
+void setMatchResultSink(MatchResultSink fn, void* ctx) {
+    g_resultSink = fn;
+    g_resultCtx = ctx;
+}
+
+CtlResult runControlCommand(MatHost& host, const CtlCommand& cmd) {
+    if (g_ctlTap) g_ctlTap(g_ctlTapCtx, cmd);
+    CtlResult r{};
+    r.op = cmd.op;
+    unsigned first = cmd.mat, last = cmd.mat;
+    if (cmd.mat == CTL_ALL_MATS) {
+        first = 0;
+        last = host.size() - 1;
+    } else if (cmd.mat >= host.size()) {
+        r.status = CTL_BAD_MAT;
+        return r;
+    }
+
+    for (unsigned m = first; m <= last; ++m) {
+        TimerLogic& t = host.timer(m);
+        bool ok = true;
+        switch (cmd.op) {
+            case CTL_OP_QUERY:
+            case CTL_OP_SUBSCRIBE:
+                break;
+            case CTL_OP_START:  ok = t.start(); break;
+            case CTL_OP_PAUSE:  ok = t.pause(); break;
+            case CTL_OP_ADJUST: ok = t.adjustSeconds(cmd.arg); break;
+            case CTL_OP_RESET:  t.reset(); break;
+            case CTL_OP_RESULT:
+                ok = g_resultSink && cmd.arg >= 1 && g_resultSink(g_resultCtx, m, static_cast<unsigned>(cmd.arg));
+                break;
+            case CTL_OP_SCORE:
+                ok = cmd.mode >= 1 && cmd.arg >= 0 && static_cast<unsigned>(cmd.arg) < SCORE_KIND_COUNT &&
+                     t.score(cmd.mode - 1u, static_cast<ScoreKind>(cmd.arg));
+                break;
+            case CTL_OP_UNDO_SCORE: ok = t.undoScore(); break;
+            case CTL_OP_REDO_SCORE: ok = t.redoScore(); break;
+            case CTL_OP_LOAD_PRESET: {
+                TimerMode mode = static_cast<TimerMode>(cmd.mode);
+                TimerConfig cfg;
+                cfg.workSeconds = cmd.arg > 0 ? static_cast<unsigned>(cmd.arg) : 0;
+                cfg.restSeconds = cmd.arg2;
+                cfg.roundCount = cmd.rounds;
+                ok = false;
+                if (mode == TimerMode::COMPETITION) {
+                    // Competition lengths are fixed; the work time picks one
+                    for (unsigned i = 0; i < COMPETITION_COUNT; ++i) {
+                        if (COMPETITION_TIMES[i] == cfg.workSeconds) {
+                            cfg.compTimeIndex = i;
+                            ok = true;
+                        }
+                    }
+                    ok = ok && t.loadPreset(mode, cfg);
+                } else {
+                    ok = t.loadPreset(mode, cfg);
+                }
+                break;
+            }
+            default:
+                r.status = CTL_BAD_OP;
+                return r;
+        }
+        host.flushCues(m);
+        if (!ok) r.status = CTL_NOT_ALLOWED;
+        r.state = ctlMatState(m, t.getDisplayInfo());
+    }
+    return r;
+}
+
+unsigned ControlServer::apply(MatHost& host) {
+    if (!running_) return 0;
+    unsigned ran = 0;
+    inApply_ = true;
+    for (;;) {
+        Batch b;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (inCount_ == 0) break;
+            Batch& src = inbound_[inHead_];
+            b.client = src.client;
+            b.seq = src.seq;
+            b.count = src.count;
+            std::memcpy(b.cmds, src.cmds, src.count * sizeof(CtlCommand));
+            inHead_ = (inHead_ + 1) % QUEUE_DEPTH;
+            --inCount_;
+        }
+
+        ReplyBatch r;
+        r.client = b.client;
+        r.seq = b.seq;
+        r.count = b.count;
+        for (unsigned i = 0; i < b.count; ++i) {
+            uint64_t t0 = monotonicNs();
+            if (b.cmds[i].op == CTL_OP_STATS) {
+                r.results[i] = CtlResult{};
+                r.results[i].op = CTL_OP_STATS;
+                r.results[i].stats = stats();
+            } else {
+                r.results[i] = runControlCommand(host, b.cmds[i]);
+            }
+            uint32_t ns = static_cast<uint32_t>(monotonicNs() - t0);
+            totalNs_ += ns;
+            if (ns > maxNs_) maxNs_ = ns;
+            ++commands_;
+        }
+        ++batches_;
+        ran += b.count;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (outCount_ < QUEUE_DEPTH) {
+            ReplyBatch& dst = outbound_[(outHead_ + outCount_++) % QUEUE_DEPTH];
+            dst.client = r.client;
+            dst.seq = r.seq;
+            dst.count = r.count;
+            std::memcpy(dst.results, r.results, r.count * sizeof(CtlResult));
+        }
+    }
+    inApply_ = false;
+    // One wakeup carries the replies and the coalesced events they caused
+    if (ran) {
+        uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+    }
+    return ran;
+}
+
+CtlStats ControlServer::stats() const {
+    CtlStats s{};
+    s.commands = commands_;
+    s.batches = batches_;
+    s.avgNs = commands_ ? static_cast<uint32_t>(totalNs_ / commands_) : 0;
+    s.maxNs = maxNs_;
+    return s;
+}
+
+} // namespace bjj
@@ -0,0 +1,119 @@
+/**
+ * BJJ Gym Timer - Unix-Domain Socket Control Server
+ * Remote start/pause/adjust/load-preset/query for every mat (see
+ * control_protocol.hpp). Socket I/O runs on its own edge-triggered epoll
+ * thread; command batches are queued and executed on the timer thread by
+ * apply(), so TimerLogic is never touched from two threads.
+ */
+
+#pragma once
+
+#include "control_protocol.hpp"
+#include "mat_host.hpp"
+#include "timer_logic.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace bjj {
+
+// Run one control command against the host on the timer thread (CTL_OP_STATS
+// is answered by ControlServer itself). Shared by every remote front end.
+CtlResult runControlCommand(MatHost& host, const CtlCommand& cmd);
+CtlMatState ctlMatState(unsigned mat, const DisplayInfo& info);
+
+// Record/replay tap (see input_replay.hpp): every command runControlCommand()
+// is about to run, from any front end
+using CtlTap = void (*)(void* ctx, const CtlCommand& cmd);
+void setControlTap(CtlTap fn, void* ctx);
+
+// Who takes CTL_OP_RESULT (the tournament scheduler); false refuses it
+using MatchResultSink = bool (*)(void* ctx, unsigned mat, unsigned winner);
+void setMatchResultSink(MatchResultSink fn, void* ctx);
+
+class ControlServer {
+public:
+    static constexpr unsigned MAX_CLIENTS = 32;
+    static constexpr unsigned QUEUE_DEPTH = 64;  // Batches in flight each way
+
+    ControlServer() = default;
+    ~ControlServer() { stop(); }
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    bool start(const std::string& path, unsigned matCount);
+    void stop();
+    bool isRunning() const { return thread_.joinable(); }
+
+    // Timer thread: run queued batches against the host. Returns commands run.
+    unsigned apply(MatHost& host);
+
+    // Timer thread: a mat's display changed. Coalesced per mat until the I/O
+    // thread pushes it to subscribers, so a burst costs one event each.
+    void notify(unsigned mat, const DisplayInfo& info);
+
+    // Command handling cost so far (timer thread side)
+    CtlStats stats() const;
+
+    // $BJJ_CONTROL, else $XDG_RUNTIME_DIR/bjj_timer.sock, else /tmp/bjj_timer.sock
+    static std::string defaultPath();
+
+private:
+    struct Batch {
+        uint64_t client;
+        uint32_t seq;
+        uint16_t count;
+        CtlCommand cmds[CTL_MAX_BATCH];
+    };
+    struct ReplyBatch {
+        uint64_t client;
+        uint32_t seq;
+        uint16_t count;
+        CtlResult results[CTL_MAX_BATCH];
+    };
+    struct Client {
+        int fd = -1;
+        uint64_t id = 0;
+        uint64_t subscribed = 0;  // Mat bitmask
+    };
+
+    void run();
+    void acceptClients();
+    void readClient(Client& c);
+    void closeClient(Client& c);
+    void flushOutbound();
+    bool sendTo(Client& c, const void* msg, size_t len);
+
+    std::string path_;
+    unsigned matCount_ = 0;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;  // eventfd: timer thread -> I/O thread
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // I/O thread only
+    Client clients_[MAX_CLIENTS];
+    uint64_t nextClientId_ = 0;
+
+    // Shared, under mutex_
+    std::mutex mutex_;
+    std::unique_ptr<Batch[]> inbound_;
+    unsigned inHead_ = 0, inCount_ = 0;
+    std::unique_ptr<ReplyBatch[]> outbound_;
+    unsigned outHead_ = 0, outCount_ = 0;
+    CtlMatState latest_[MAX_MATS] = {};
+    uint64_t dirty_ = 0;
+    bool wakePending_ = false;
+
+    // Timer thread only
+    bool inApply_ = false;  // Hold event wakeups until the batch's reply is queued
+    uint32_t commands_ = 0;
+    uint32_t batches_ = 0;
+    uint64_t totalNs_ = 0;
+    uint32_t maxNs_ = 0;
+};
+
+} // namespace bjj
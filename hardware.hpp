@@ -8,7 +8,9 @@
 
 #pragma once
 
+#include "perf_trace.hpp"
 #include <cstdint>
+#include <cstdio>
 #include <ctime>
 #include <lgpio.h>
 
@@ -39,31 +41,40 @@ namespace Tones {
 constexpr unsigned ENCODER_CLK = 17;  // Physical pin 11
 constexpr unsigned ENCODER_DT  = 18;  // Physical pin 12
 constexpr unsigned ENCODER_SW  = 27;  // Physical pin 13
-constexpr unsigned LONG_PRESS_MS = 2000;
+constexpr unsigned LONG_PRESS_MS = 2000;    // Fires while the button is still held
+constexpr unsigned DOUBLE_PRESS_MS = 300;   // Release to second press-down
+
+struct EncoderPins {
+    unsigned clk{ENCODER_CLK};
+    unsigned dt{ENCODER_DT};
+    unsigned sw{ENCODER_SW};
+};
 
 // ============================================================================
 // BUZZER DRIVER
 // ============================================================================
 class Buzzer {
 public:
-    Buzzer() = default;
+    explicit Buzzer(unsigned pin = BUZZER_PIN) : pin_(pin) {}
+    
+    unsigned pin() const { return pin_; }
     
     void init(int h) {
-        lgGpioClaimOutput(h, 0, BUZZER_PIN, 0);
+        lgGpioClaimOutput(h, 0, pin_, 0);
     }
     
     void tone(int h, unsigned freq_hz, unsigned duration_ms) {
         if (freq_hz == 0) {
-            lgTxPwm(h, BUZZER_PIN, 0, 0, 0, 0);
+            lgTxPwm(h, pin_, 0, 0, 0, 0);
             return;
         }
-        lgTxPwm(h, BUZZER_PIN, static_cast<float>(freq_hz), 50.0f, 0, 0);
+        lgTxPwm(h, pin_, static_cast<float>(freq_hz), 50.0f, 0, 0);
         lguSleep(static_cast<double>(duration_ms) / 1000.0);
-        lgTxPwm(h, BUZZER_PIN, 0, 0, 0, 0);
+        lgTxPwm(h, pin_, 0, 0, 0, 0);
     }
     
     void silence(int h) {
-        lgTxPwm(h, BUZZER_PIN, 0, 0, 0, 0);
+        lgTxPwm(h, pin_, 0, 0, 0, 0);
     }
     
     void playStartRound(int h) {
@@ -88,64 +99,207 @@ public:
         lguSleep(0.06);
         tone(h, Tones::SWITCH_CHIRP, 80);
     }
+    
+private:
+    unsigned pin_;
+};
+
+// ============================================================================
+// GESTURE RECOGNISER - timestamped button/knob samples to gestures
+// ============================================================================
+struct EncoderEvents {
+    int delta{0};
+    int coarseDelta{0};         // Turned while the button is held
+    bool shortPress{false};
+    bool longPress{false};
+    bool doublePress{false};
+
+    bool any() const { return delta || coarseDelta || shortPress || longPress || doublePress; }
+};
+
+// How the current screen wants presses resolved
+struct GesturePolicy {
+    bool shortOnDown{false};    // Short press at press-down: no double press
+    unsigned doubleMs{0};       // Wait after a release for a second press; 0: none
+};
+
+// Latencies are from the sample that saw the deciding edge, so they include
+// up to one poll period of sampling delay on top of the recogniser's own
+struct GestureStats {
+    LatencyHistogram shortUs;       // Press-down to short press
+    LatencyHistogram confirmUs;     // Release to short press: the double-press wait
+    LatencyHistogram longLateUs;    // Long press past its LONG_PRESS_MS deadline
+    LatencyHistogram doubleUs;      // First press-down to double press
+    uint32_t chords{0};             // Presses turned into a coarse adjustment
+};
+
+// One line for the exit report
+inline int formatGestureStats(char* buf, size_t size, const GestureStats& st) {
+    return snprintf(buf, size, "%llu short (p50 %.1f ms, p99 %.1f ms from press-down, p99 %.1f ms from release), "
+                    "%llu long (p99 %.1f ms late), %llu double, %u coarse turns",
+                    static_cast<unsigned long long>(st.shortUs.count()), st.shortUs.percentile(50) / 1000.0,
+                    st.shortUs.percentile(99) / 1000.0, st.confirmUs.percentile(99) / 1000.0,
+                    static_cast<unsigned long long>(st.longLateUs.count()),
+                    st.longLateUs.percentile(99) / 1000.0, static_cast<unsigned long long>(st.doubleUs.count()),
+                    st.chords);
+}
+
+// Fed one sample per poll: the rotation decoded since the last one and the
+// button level. A press resolves to exactly one of:
+//   long    held for LONG_PRESS_MS - fires then, not on release
+//   chord   knob turned while held - the turn is reported as coarseDelta
+//   double  second press-down within doubleMs of the release (if enabled)
+//   short   otherwise, at press-down (shortOnDown), at the release, or once
+//           the double-press window closes
+// With shortOnDown the short fires first and a long press or chord may follow
+// it in the same hold.
+class GestureRecognizer {
+public:
+    void setPolicy(const GesturePolicy& p) { policy_ = p; }
+
+    EncoderEvents feed(int delta, bool down, uint64_t nowUs) {
+        EncoderEvents ev;
+        ev.delta = carry_;
+        carry_ = 0;
+        const bool pressEdge = down && !down_;
+        const bool releaseEdge = !down && down_;
+        down_ = down;
+
+        switch (phase_) {
+            case Phase::IDLE:
+                ev.delta += delta;
+                if (pressEdge) {
+                    downUs_ = nowUs;
+                    beginHold(nowUs, policy_.shortOnDown);
+                    if (policy_.shortOnDown) {
+                        ev.shortPress = true;
+                        stats_.shortUs.record(0);
+                    }
+                }
+                break;
+            case Phase::HELD:
+                if (delta != 0) {
+                    ev.coarseDelta = delta;
+                    if (!chord_) ++stats_.chords;
+                    chord_ = true;
+                }
+                if (longOk_ && !chord_ && down && nowUs >= holdUs_ + LONG_PRESS_MS * 1000ULL) {
+                    ev.longPress = true;
+                    longOk_ = false;
+                    stats_.longLateUs.record(nowUs - holdUs_ - LONG_PRESS_MS * 1000ULL);
+                }
+                if (releaseEdge) {
+                    if (chord_ || resolved_ || !longOk_) {
+                        phase_ = Phase::IDLE;
+                    } else if (policy_.doubleMs) {
+                        releaseUs_ = nowUs;
+                        phase_ = Phase::WAIT;
+                    } else {
+                        releaseUs_ = nowUs;
+                        confirmShort(ev, nowUs);
+                    }
+                }
+                break;
+            case Phase::WAIT:
+                if (pressEdge) {
+                    ev.doublePress = true;
+                    ev.delta += delta;
+                    stats_.doubleUs.record(nowUs - downUs_);
+                    beginHold(nowUs, true);
+                    longOk_ = false;
+                } else if (delta != 0 || nowUs >= releaseUs_ + policy_.doubleMs * 1000ULL) {
+                    // A turn closes the window too, and follows the press on the next sample
+                    confirmShort(ev, nowUs);
+                    carry_ = delta;
+                }
+                break;
+        }
+        return ev;
+    }
+
+    bool held() const { return down_; }
+    const GestureStats& stats() const { return stats_; }
+
+private:
+    enum class Phase : uint8_t { IDLE, HELD, WAIT };
+
+    void beginHold(uint64_t nowUs, bool resolved) {
+        phase_ = Phase::HELD;
+        holdUs_ = nowUs;
+        chord_ = false;
+        longOk_ = true;
+        resolved_ = resolved;
+    }
+    void confirmShort(EncoderEvents& ev, uint64_t nowUs) {
+        ev.shortPress = true;
+        stats_.shortUs.record(nowUs - downUs_);
+        stats_.confirmUs.record(nowUs - releaseUs_);
+        phase_ = Phase::IDLE;
+    }
+
+    GesturePolicy policy_;
+    Phase phase_{Phase::IDLE};
+    bool down_{false};
+    bool chord_{false};         // Turned during this hold
+    bool longOk_{false};        // Long press still possible this hold
+    bool resolved_{false};      // Short or double already sent for this hold
+    uint64_t downUs_{0};        // First press-down of the gesture
+    uint64_t holdUs_{0};        // This hold's press-down
+    uint64_t releaseUs_{0};
+    int carry_{0};              // Turn that closed a double-press window
+    GestureStats stats_;
 };
 
 // ============================================================================
 // ROTARY ENCODER DRIVER (Polling - reliable on Pi 5)
 // ============================================================================
+
 class RotaryEncoder {
 public:
-    using RotateCallback = void (*)(int delta);
-    using PressCallback = void (*)(bool isLong);
-    
-    RotaryEncoder(RotateCallback onRotate, PressCallback onPress)
-        : rotateCb_(onRotate), pressCb_(onPress) {}
+    explicit RotaryEncoder(EncoderPins pins = EncoderPins{}) : pins_(pins) {}
     
     void init(int h) {
         handle_ = h;
-        lgGpioClaimInput(h, LG_SET_PULL_UP, ENCODER_CLK);
-        lgGpioClaimInput(h, LG_SET_PULL_UP, ENCODER_DT);
-        lgGpioClaimInput(h, LG_SET_PULL_UP, ENCODER_SW);
-        lastClk_ = readPin(ENCODER_CLK);
-        lastDt_  = readPin(ENCODER_DT);
-        lastSw_  = readPin(ENCODER_SW);
+        lgGpioClaimInput(h, LG_SET_PULL_UP, pins_.clk);
+        lgGpioClaimInput(h, LG_SET_PULL_UP, pins_.dt);
+        lgGpioClaimInput(h, LG_SET_PULL_UP, pins_.sw);
+        lastClk_ = readPin(pins_.clk);
+        lastDt_  = readPin(pins_.dt);
+        lastSw_  = readPin(pins_.sw);
     }
     
-    // Call every main loop iteration - polls encoder and button
-    void poll() {
-        int clk = readPin(ENCODER_CLK);
-        int dt  = readPin(ENCODER_DT);
-        int sw  = readPin(ENCODER_SW);
+    // Call every main loop iteration - polls encoder and button and returns
+    // the gestures that sample completed
+    EncoderEvents pollEvents() {
+        int delta = 0;
+        int clk = readPin(pins_.clk);
+        int dt  = readPin(pins_.dt);
+        int sw  = readPin(pins_.sw);
         
         // Quadrature decode on CLK edges (inverted: CW=+1, CCW=-1)
         if (clk != lastClk_) {
-            int delta = (clk == dt) ? -1 : 1;
+            delta = (clk == dt) ? -1 : 1;
             lastClk_ = clk;
             lastDt_ = dt;
-            if (rotateCb_) rotateCb_(delta);
         } else {
             lastDt_ = dt;
         }
         
         // Button: 0=pressed (active low), 1=released
-        if (sw == 0 && !swPressed_) {
-            swPressed_ = true;
-            pressStartMs_ = nowMs();
-        } else if (sw == 1 && swPressed_) {
-            swPressed_ = false;
-            unsigned duration = nowMs() - pressStartMs_;
-            bool longPress = (duration >= LONG_PRESS_MS);
-            if (pressCb_) pressCb_(longPress);
-        }
+        return gestures_.feed(delta, sw == 0, monotonicNs() / 1000);
     }
     
+    // Per screen: see GesturePolicy
+    void setPolicy(const GesturePolicy& p) { gestures_.setPolicy(p); }
+    const GestureStats& gestureStats() const { return gestures_.stats(); }
+    
     void attachInterrupts() {}   // No-op for polling
     void detachInterrupts() {}
     
     void freeGpio(int h) {
-        lgGpioFree(h, ENCODER_CLK);
-        lgGpioFree(h, ENCODER_DT);
-        lgGpioFree(h, ENCODER_SW);
+        lgGpioFree(h, pins_.clk);
+        lgGpioFree(h, pins_.dt);
+        lgGpioFree(h, pins_.sw);
     }
     
 private:
@@ -153,18 +307,10 @@ private:
         int v = lgGpioRead(handle_, gpio);
         return (v > 0) ? 1 : 0;
     }
-    static unsigned nowMs() {
-        struct timespec ts;
-        clock_gettime(CLOCK_MONOTONIC, &ts);
-        return static_cast<unsigned>(ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000);
-    }
-    
     int handle_{0};
-    RotateCallback rotateCb_;
-    PressCallback pressCb_;
+    EncoderPins pins_;
     int lastClk_{1}, lastDt_{1}, lastSw_{1};
-    unsigned pressStartMs_{0};
-    bool swPressed_{false};
+    GestureRecognizer gestures_;
 };
 
 } // namespace bjj
@@ -0,0 +1,267 @@
+/**
+ * BJJ Gym Timer - Session History Log Implementation
+ */
+
+#include "history_log.hpp"
+#include "checkpoint.hpp"
+#include "perf_trace.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bjj {
+
+uint32_t historyRecordCrc(const HistoryRecord& r) {
+    return crc32(&r, offsetof(HistoryRecord, crc));
+}
+
+static int64_t realtimeMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool readAt(int fd, void* buf, size_t len, off_t off) {
+    return pread(fd, buf, len, off) == static_cast<ssize_t>(len);
+}
+
+static bool writeAt(int fd, const void* buf, size_t len, off_t off) {
+    const uint8_t* p = static_cast<const uint8_t*>(buf);
+    while (len) {
+        ssize_t n = pwrite(fd, p, len, off);
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<size_t>(n);
+        off += n;
+    }
+    return true;
+}
+
+static off_t recordOffset(uint64_t i) {
+    return static_cast<off_t>(sizeof(HistoryHeader) + i * sizeof(HistoryRecord));
+}
+
+static off_t indexOffset(uint64_t i) {
+    return static_cast<off_t>(sizeof(HistoryIndexHeader) + i * sizeof(HistoryIndexEntry));
+}
+
+// Fold the record at ms into the index entry of its block; prevMs: the record
+// before it, in this block or the last one (INT64_MIN for the first record)
+static void indexRecord(HistoryIndexEntry& e, bool startsBlock, int64_t ms, int64_t& prevMs) {
+    if (startsBlock) e = {ms, ms, ms, HISTORY_BLOCK_ORDERED, 0};
+    if (ms < e.minMs) e.minMs = ms;
+    if (ms > e.maxMs) e.maxMs = ms;
+    if (ms < prevMs) e.flags &= ~HISTORY_BLOCK_ORDERED;
+    prevMs = ms;
+}
+
+std::string HistoryLog::defaultPath() {
+    if (const char* env = std::getenv("BJJ_HISTORY")) return env;
+    if (const char* home = std::getenv("HOME")) return std::string(home) + "/.bjj_timer.history";
+    return ".bjj_timer.history";
+}
+
+bool HistoryLog::open(const std::string& path) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        perror("[history] open");
+        return false;
+    }
+    struct stat st;
+    fstat(fd_, &st);
+
+    HistoryHeader hdr{};
+    if (static_cast<size_t>(st.st_size) < sizeof(hdr)) {
+        // New (or torn before the first record): start over
+        hdr.magic = HISTORY_MAGIC;
+        hdr.version = HISTORY_VERSION;
+        hdr.recordSize = sizeof(HistoryRecord);
+        hdr.createdMs = realtimeMs();
+        if (ftruncate(fd_, 0) != 0 || !writeAt(fd_, &hdr, sizeof(hdr), 0) || fdatasync(fd_) != 0) {
+            perror("[history] create");
+            close();
+            return false;
+        }
+        st.st_size = sizeof(hdr);
+    } else if (!readAt(fd_, &hdr, sizeof(hdr), 0) || hdr.magic != HISTORY_MAGIC ||
+               hdr.version != HISTORY_VERSION || hdr.recordSize != sizeof(HistoryRecord)) {
+        fprintf(stderr, "[history] %s is not a history log (version %u); not logging\n", path.c_str(), hdr.version);
+        close();
+        return false;
+    }
+
+    // Drop a torn tail: a partial record, then any record whose CRC fails
+    records_ = (st.st_size - sizeof(hdr)) / sizeof(HistoryRecord);
+    while (records_ > 0) {
+        HistoryRecord r;
+        if (readAt(fd_, &r, sizeof(r), recordOffset(records_ - 1)) && r.crc == historyRecordCrc(r)) break;
+        --records_;
+    }
+    if (recordOffset(records_) != st.st_size && ftruncate(fd_, recordOffset(records_)) != 0) {
+        perror("[history] truncate");
+    }
+
+    path_ = path;
+    catchUpIndex();
+    stats_ = {};
+    stats_.records = records_;
+    stopping_ = false;
+    queued_ = 0;
+    thread_ = std::thread(&HistoryLog::run, this);
+    return true;
+}
+
+void HistoryLog::catchUpIndex() {
+    block_ = {};
+    lastMs_ = INT64_MIN;
+    std::string idxPath = path_ + ".idx";
+    indexFd_ = ::open(idxPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (indexFd_ < 0) {
+        perror("[history] index");
+        return;
+    }
+    struct stat st;
+    fstat(indexFd_, &st);
+    HistoryIndexHeader hdr{};
+    uint64_t entries = 0;
+    if (readAt(indexFd_, &hdr, sizeof(hdr), 0) && hdr.magic == HISTORY_INDEX_MAGIC &&
+        hdr.version == HISTORY_INDEX_VERSION && hdr.blockRecords == HISTORY_BLOCK_RECORDS) {
+        entries = (st.st_size - sizeof(hdr)) / sizeof(HistoryIndexEntry);
+    } else {
+        hdr = {HISTORY_INDEX_MAGIC, HISTORY_INDEX_VERSION, static_cast<uint16_t>(HISTORY_BLOCK_RECORDS), 0};
+        if (ftruncate(indexFd_, 0) != 0 || !writeAt(indexFd_, &hdr, sizeof(hdr), 0)) return;
+    }
+
+    // Entries past the log (a truncated tail) or not matching it are stale
+    uint64_t complete = records_ / HISTORY_BLOCK_RECORDS;
+    if (entries > complete) entries = complete;
+    while (entries > 0) {
+        HistoryIndexEntry e;
+        HistoryRecord r;
+        if (readAt(indexFd_, &e, sizeof(e), indexOffset(entries - 1)) &&
+            readAt(fd_, &r, sizeof(r), recordOffset((entries - 1) * HISTORY_BLOCK_RECORDS)) &&
+            e.firstMs == r.realtimeMs) {
+            break;
+        }
+        --entries;
+    }
+    if (entries > 0) {
+        HistoryRecord r;
+        if (readAt(fd_, &r, sizeof(r), recordOffset(entries * HISTORY_BLOCK_RECORDS - 1))) lastMs_ = r.realtimeMs;
+    }
+    static HistoryRecord block[HISTORY_BLOCK_RECORDS];  // open() runs once, before the writer starts
+    for (; entries < complete; ++entries) {
+        if (!readAt(fd_, block, sizeof(block), recordOffset(entries * HISTORY_BLOCK_RECORDS))) break;
+        HistoryIndexEntry e;
+        for (unsigned i = 0; i < HISTORY_BLOCK_RECORDS; ++i) indexRecord(e, i == 0, block[i].realtimeMs, lastMs_);
+        if (!writeAt(indexFd_, &e, sizeof(e), indexOffset(entries))) break;
+    }
+    indexed_ = entries;
+    // The block the writer carries on filling
+    const unsigned tail = static_cast<unsigned>(records_ % HISTORY_BLOCK_RECORDS);
+    if (entries == complete && tail &&
+        readAt(fd_, block, tail * sizeof(HistoryRecord), recordOffset(complete * HISTORY_BLOCK_RECORDS))) {
+        for (unsigned i = 0; i < tail; ++i) indexRecord(block_, i == 0, block[i].realtimeMs, lastMs_);
+    }
+    if (ftruncate(indexFd_, indexOffset(indexed_)) != 0) perror("[history] index truncate");
+}
+
+void HistoryLog::close() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+    if (indexFd_ >= 0) ::close(indexFd_);
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = indexFd_ = -1;
+}
+
+void HistoryLog::record(unsigned mat, const TimerSnapshot& snap, uint8_t cues) {
+    if (fd_ < 0) return;
+    HistoryRecord r{};
+    r.realtimeMs = realtimeMs();  // vDSO: no syscall
+    r.mat = static_cast<uint8_t>(mat);
+    r.state = static_cast<uint8_t>(snap.state);
+    r.mode = static_cast<uint8_t>(snap.mode);
+    r.phase = static_cast<uint8_t>(snap.phase);
+    r.cues = cues;
+    r.roundCount = static_cast<uint8_t>(snap.config.roundCount);
+    r.currentRound = static_cast<uint16_t>(snap.currentRound);
+    r.totalRounds = static_cast<uint16_t>(snap.totalRounds);
+    unsigned work = snap.config.workSeconds;
+    if (snap.mode == TimerMode::COMPETITION && snap.config.compTimeIndex < COMPETITION_COUNT) {
+        work = COMPETITION_TIMES[snap.config.compTimeIndex];
+    }
+    r.workSeconds = static_cast<uint16_t>(work);
+    r.restSeconds = static_cast<uint16_t>(snap.config.restSeconds);
+    r.secondsRemaining = snap.secondsRemaining;
+    r.crc = historyRecordCrc(r);
+
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queued_ == QUEUE_DEPTH) {
+            ++stats_.dropped;
+            return;
+        }
+        queue_[queued_++] = r;
+        wake = queued_ == QUEUE_DEPTH / 2;
+    }
+    if (wake) cv_.notify_one();
+}
+
+void HistoryLog::run() {
+    HistoryRecord batch[QUEUE_DEPTH];
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cv_.wait_for(lock, std::chrono::milliseconds(FLUSH_MS),
+                     [this] { return stopping_ || queued_ >= QUEUE_DEPTH / 2; });
+        unsigned n = queued_;
+        if (n) {
+            std::memcpy(batch, queue_, n * sizeof(HistoryRecord));
+            queued_ = 0;
+            lock.unlock();
+            uint64_t t0 = monotonicNs();
+            writeBatch(batch, n);
+            uint32_t us = static_cast<uint32_t>((monotonicNs() - t0) / 1000);
+            lock.lock();
+            stats_.records = records_;
+            ++stats_.syncs;
+            if (us > stats_.maxSyncUs) stats_.maxSyncUs = us;
+        }
+        if (stopping_ && queued_ == 0) return;
+    }
+}
+
+void HistoryLog::writeBatch(const HistoryRecord* recs, unsigned count) {
+    if (!writeAt(fd_, recs, count * sizeof(HistoryRecord), recordOffset(records_))) {
+        perror("[history] write");
+        return;
+    }
+    fdatasync(fd_);
+    for (unsigned i = 0; i < count; ++i) {
+        indexRecord(block_, records_ % HISTORY_BLOCK_RECORDS == 0, recs[i].realtimeMs, lastMs_);
+        if (++records_ % HISTORY_BLOCK_RECORDS == 0 && indexFd_ >= 0) {
+            // Not synced: a lost entry is rebuilt from the log on the next open
+            if (writeAt(indexFd_, &block_, sizeof(block_), indexOffset(indexed_))) ++indexed_;
+        }
+    }
+}
+
+HistoryStats HistoryLog::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace bjj
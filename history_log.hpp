@@ -0,0 +1,146 @@
+/**
+ * BJJ Gym Timer - Session History Log
+ * Every TimerLogic transition is appended to a fixed-record binary log, so
+ * rounds run, mat time and preset usage can be totalled per day or week
+ * (see history_query.cpp). The timer thread only queues a 32-byte record;
+ * a writer thread appends and fsyncs in batches, keeping SD card writes
+ * off the tick path and few in number.
+ *
+ * Alongside the log, <path>.idx holds one entry per BLOCK_RECORDS records
+ * (earliest/latest wall-clock time), so a query seeks straight to its date
+ * range. CLOCK_REALTIME can step back (NTP, a Pi booting without an RTC), so
+ * each entry also says whether its records are in order; a query only binary
+ * searches while they are. The index is derived data: it is rebuilt from the
+ * log when short or stale.
+ */
+
+#pragma once
+
+#include "timer_logic.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace bjj {
+
+// ============================================================================
+// ON-DISK LAYOUT (little-endian, fixed size - never reorder fields)
+// ============================================================================
+constexpr uint32_t HISTORY_MAGIC         = 0x484A4A42;  // "BJJH"
+constexpr uint32_t HISTORY_INDEX_MAGIC   = 0x584A4A42;  // "BJJX"
+constexpr uint16_t HISTORY_VERSION       = 1;
+constexpr uint16_t HISTORY_INDEX_VERSION = 2;         // 1: first/last time only
+constexpr unsigned HISTORY_BLOCK_RECORDS = 1024;        // 32 KiB of log per index entry
+
+struct HistoryHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;      // sizeof(HistoryRecord)
+    int64_t  createdMs;       // CLOCK_REALTIME
+    uint8_t  reserved[48];
+};
+
+struct HistoryRecord {
+    int64_t  realtimeMs;      // CLOCK_REALTIME: days and weeks are wall-clock
+    uint8_t  mat;
+    uint8_t  state;           // TimerState after the transition
+    uint8_t  mode;            // TimerMode
+    uint8_t  phase;           // Phase
+    uint8_t  cues;            // Cue bits this transition fired (round end, switch, ...)
+    uint8_t  roundCount;      // Configured rounds
+    uint16_t currentRound;
+    uint16_t totalRounds;
+    uint16_t workSeconds;     // Effective work length (competition: the match length)
+    uint16_t restSeconds;
+    uint16_t reserved;
+    uint32_t secondsRemaining;
+    uint32_t crc;             // CRC-32 of every byte before this field
+};
+
+struct HistoryIndexHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t blockRecords;
+    uint64_t reserved;
+};
+
+// HistoryIndexEntry::flags
+constexpr uint32_t HISTORY_BLOCK_ORDERED = 1u << 0;     // No record earlier than the one before it
+
+struct HistoryIndexEntry {
+    int64_t  firstMs;         // First record of the block (checks the entry against the log)
+    int64_t  minMs;           // Earliest record of the block
+    int64_t  maxMs;           // Latest record of the block
+    uint32_t flags;           // HISTORY_BLOCK_*; ORDERED also covers the previous block's last record
+    uint32_t reserved;
+};
+
+static_assert(sizeof(HistoryHeader) == 64, "on-disk layout");
+static_assert(sizeof(HistoryRecord) == 32, "on-disk layout");
+static_assert(sizeof(HistoryIndexHeader) == 16, "on-disk layout");
+static_assert(sizeof(HistoryIndexEntry) == 32, "on-disk layout");
+
+uint32_t historyRecordCrc(const HistoryRecord& r);
+
+struct HistoryStats {
+    uint64_t records;         // In the log, including this run's
+    uint32_t dropped;         // Queue full: writer fell behind
+    uint32_t syncs;           // fdatasync batches
+    uint32_t maxSyncUs;       // Slowest write + fdatasync
+};
+
+// ============================================================================
+// HISTORY LOG (writer)
+// ============================================================================
+class HistoryLog {
+public:
+    static constexpr unsigned QUEUE_DEPTH = 256;
+    static constexpr unsigned FLUSH_MS = 5000;  // fsync batch interval
+
+    HistoryLog() = default;
+    ~HistoryLog() { close(); }
+    HistoryLog(const HistoryLog&) = delete;
+    HistoryLog& operator=(const HistoryLog&) = delete;
+
+    // Open (creating if needed), drop a torn tail record and catch the index up
+    bool open(const std::string& path);
+    // Flushes everything queued
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+
+    // Timer thread: queue one transition. No syscalls; a full queue drops it.
+    void record(unsigned mat, const TimerSnapshot& snap, uint8_t cues);
+
+    HistoryStats stats();
+
+    // $BJJ_HISTORY, else ~/.bjj_timer.history
+    static std::string defaultPath();
+
+private:
+    void run();
+    void writeBatch(const HistoryRecord* recs, unsigned count);
+    void catchUpIndex();
+
+    std::string path_;
+    int fd_ = -1;
+    int indexFd_ = -1;
+    std::thread thread_;
+
+    // Writer thread only (after open)
+    uint64_t records_ = 0;    // Records in the log file
+    uint64_t indexed_ = 0;    // Complete blocks in the index
+    HistoryIndexEntry block_ = {};  // Block being filled
+    int64_t lastMs_ = INT64_MIN;    // Last record written
+
+    // Shared, under mutex_
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    HistoryRecord queue_[QUEUE_DEPTH];
+    unsigned queued_ = 0;
+    bool stopping_ = false;
+    HistoryStats stats_ = {};
+};
+
+} // namespace bjj
@@ -0,0 +1,281 @@
+/**
+ * BJJ Gym Timer - Session History Query
+ * Memory-maps the history log and totals sessions, completed rounds and mat
+ * time per day (or ISO week). The block index locates the first record of
+ * the range with a binary search over a few KiB and skips blocks outside it,
+ * so a year-long log is read only where the requested dates are; local-time
+ * bucket boundaries are worked out once per bucket, not per record. The wall
+ * clock can step back, so once a block is out of order the index is walked
+ * block by block instead, and no record ends the scan early.
+ *
+ * Usage: ./bjj_history [--log PATH] [--from YYYY-MM-DD] [--to YYYY-MM-DD]
+ *                      [--week] [--mat N] [--presets]
+ */
+
+#include "audio.hpp"
+#include "history_log.hpp"
+#include "perf_trace.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+using namespace bjj;
+
+// A mat left running (crash, power cut) counts for at most this long
+static constexpr int64_t MAX_RUN_MS = 2 * 3600 * 1000;
+
+struct Mapping {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    bool map(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data = static_cast<const uint8_t*>(p);
+                size = st.st_size;
+            }
+        }
+        close(fd);
+        return data != nullptr;
+    }
+    ~Mapping() {
+        if (data) munmap(const_cast<uint8_t*>(data), size);
+    }
+};
+
+struct Bucket {
+    unsigned sessions = 0;
+    unsigned rounds = 0;
+    unsigned byMode[3] = {};
+    int64_t matMs = 0;
+};
+
+struct PresetKey {
+    uint8_t mode;
+    uint16_t work, rest;
+    uint8_t rounds;
+    bool operator<(const PresetKey& o) const {
+        return std::tie(mode, work, rest, rounds) < std::tie(o.mode, o.work, o.rest, o.rounds);
+    }
+};
+
+// Local midnight of the day (or the Monday of the ISO week) containing ms, and
+// the start of the next one. mktime() normalises across month ends and DST.
+static void bucketBounds(int64_t ms, bool week, int64_t& start, int64_t& end) {
+    time_t t = static_cast<time_t>(ms / 1000);
+    struct tm tm;
+    localtime_r(&t, &tm);
+    tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    if (week) tm.tm_mday -= (tm.tm_wday + 6) % 7;
+    struct tm next = tm;
+    next.tm_mday += week ? 7 : 1;
+    start = static_cast<int64_t>(mktime(&tm)) * 1000;
+    end = static_cast<int64_t>(mktime(&next)) * 1000;
+}
+
+static bool parseDate(const char* s, int64_t& ms) {
+    struct tm tm = {};
+    if (sscanf(s, "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday) != 3) return false;
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    ms = static_cast<int64_t>(mktime(&tm)) * 1000;
+    return true;
+}
+
+static const char* modeName(uint8_t mode) {
+    static const char* NAMES[] = {"sparring", "drilling", "competition"};
+    return mode < 3 ? NAMES[mode] : "?";
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = HistoryLog::defaultPath();
+    int64_t fromMs = INT64_MIN, toMs = INT64_MAX;
+    bool week = false, presets = false;
+    int matFilter = -1;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--log") && i + 1 < argc) path = argv[++i];
+        else if (!strcmp(argv[i], "--from") && i + 1 < argc) {
+            if (!parseDate(argv[++i], fromMs)) { fprintf(stderr, "bad --from date\n"); return 2; }
+        } else if (!strcmp(argv[i], "--to") && i + 1 < argc) {
+            int64_t day;
+            if (!parseDate(argv[++i], day)) { fprintf(stderr, "bad --to date\n"); return 2; }
+            int64_t start;
+            bucketBounds(day, false, start, toMs);  // Inclusive: up to the next midnight
+        } else if (!strcmp(argv[i], "--week")) week = true;
+        else if (!strcmp(argv[i], "--mat") && i + 1 < argc) matFilter = atoi(argv[++i]) - 1;
+        else if (!strcmp(argv[i], "--presets")) presets = true;
+        else {
+            fprintf(stderr, "Usage: %s [--log PATH] [--from YYYY-MM-DD] [--to YYYY-MM-DD] [--week] [--mat N] [--presets]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    uint64_t t0 = monotonicNs();
+    Mapping log;
+    if (!log.map(path)) {
+        perror(path.c_str());
+        return 1;
+    }
+    const HistoryHeader* hdr = reinterpret_cast<const HistoryHeader*>(log.data);
+    if (log.size < sizeof(HistoryHeader) || hdr->magic != HISTORY_MAGIC ||
+        hdr->version != HISTORY_VERSION || hdr->recordSize != sizeof(HistoryRecord)) {
+        fprintf(stderr, "%s: not a history log\n", path.c_str());
+        return 1;
+    }
+    const HistoryRecord* recs = reinterpret_cast<const HistoryRecord*>(log.data + sizeof(HistoryHeader));
+    const uint64_t count = (log.size - sizeof(HistoryHeader)) / sizeof(HistoryRecord);
+
+    // Index entries are trusted only while their first time matches the log
+    // (the index lags or may be stale after a crash); records past the last
+    // trusted entry are always read. Without an index every record is read.
+    const HistoryIndexEntry* blocks = nullptr;
+    uint64_t indexed = 0;
+    bool ordered = true;
+    Mapping idx;
+    if ((fromMs != INT64_MIN || toMs != INT64_MAX) && idx.map(path + ".idx") &&
+        idx.size >= sizeof(HistoryIndexHeader)) {
+        const HistoryIndexHeader* ih = reinterpret_cast<const HistoryIndexHeader*>(idx.data);
+        if (ih->magic == HISTORY_INDEX_MAGIC && ih->version == HISTORY_INDEX_VERSION &&
+            ih->blockRecords == HISTORY_BLOCK_RECORDS) {
+            blocks = reinterpret_cast<const HistoryIndexEntry*>(idx.data + sizeof(*ih));
+            indexed = std::min<uint64_t>((idx.size - sizeof(*ih)) / sizeof(*blocks), count / HISTORY_BLOCK_RECORDS);
+            while (indexed > 0 && blocks[indexed - 1].firstMs != recs[(indexed - 1) * HISTORY_BLOCK_RECORDS].realtimeMs) {
+                --indexed;
+            }
+            for (uint64_t k = 0; k < indexed && ordered; ++k) ordered = blocks[k].flags & HISTORY_BLOCK_ORDERED;
+        }
+    }
+    // In order, the first block that can hold fromMs is a binary search away;
+    // otherwise the scan starts at the top and skips blocks one by one
+    uint64_t begin = 0;
+    if (ordered) {
+        begin = (std::partition_point(blocks, blocks + indexed, [&](const HistoryIndexEntry& x) {
+            return x.maxMs < fromMs;
+        }) - blocks) * HISTORY_BLOCK_RECORDS;
+    }
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t from = (sizeof(HistoryHeader) + begin * sizeof(HistoryRecord)) / page * page;
+    madvise(const_cast<uint8_t*>(log.data) + from, log.size - from, MADV_SEQUENTIAL);
+
+    std::map<int64_t, Bucket> buckets;
+    std::map<PresetKey, unsigned> presetUse;
+    Bucket* cur = nullptr;
+    int64_t curStart = 0, curEnd = 0;
+    int64_t runStart[256];  // Per mat: RUNNING since, or -1
+    std::fill(runStart, runStart + 256, -1);
+    uint64_t scanned = 0, skipped = 0, corrupt = 0;
+
+    auto bucketFor = [&](int64_t ms) -> Bucket& {
+        if (!cur || ms < curStart || ms >= curEnd) {
+            bucketBounds(ms, week, curStart, curEnd);
+            cur = &buckets[curStart];
+        }
+        return *cur;
+    };
+
+    for (uint64_t i = begin; i < count; ++i) {
+        if (i % HISTORY_BLOCK_RECORDS == 0 && i / HISTORY_BLOCK_RECORDS < indexed) {
+            const HistoryIndexEntry& b = blocks[i / HISTORY_BLOCK_RECORDS];
+            if (b.maxMs < fromMs || b.minMs >= toMs) {
+                // In order, every later indexed block is past the range too
+                const uint64_t next = ordered && b.minMs >= toMs ? indexed : i / HISTORY_BLOCK_RECORDS + 1;
+                skipped += next * HISTORY_BLOCK_RECORDS - i;
+                i = next * HISTORY_BLOCK_RECORDS - 1;
+                continue;
+            }
+        }
+        const HistoryRecord& r = recs[i];
+        ++scanned;
+        if (matFilter >= 0 && r.mat != matFilter) continue;
+        if (r.realtimeMs < fromMs || r.realtimeMs >= toMs) continue;
+        if (r.crc != historyRecordCrc(r)) {
+            ++corrupt;
+            continue;
+        }
+
+        const bool running = r.state == static_cast<uint8_t>(TimerState::RUNNING);
+        int64_t& since = runStart[r.mat];
+        if (running && since < 0) {
+            since = r.realtimeMs;
+        } else if (!running && since >= 0) {
+            bucketFor(since).matMs += std::min(r.realtimeMs - since, MAX_RUN_MS);
+            since = -1;
+        }
+        if (!r.cues) continue;
+
+        Bucket& b = bucketFor(r.realtimeMs);
+        if (running && (r.cues & CUE_ROUND_START) && r.currentRound == 1) {
+            ++b.sessions;
+            if (r.mode < 3) ++b.byMode[r.mode];
+            if (presets) ++presetUse[{r.mode, r.workSeconds, r.restSeconds, r.roundCount}];
+        }
+        // A round ends on entering rest, on a drilling switch, or at the final buzzer
+        if ((r.cues & CUE_SWITCH) ||
+            ((r.cues & CUE_ROUND_END) && (r.phase == static_cast<uint8_t>(Phase::REST) ||
+                                          r.state == static_cast<uint8_t>(TimerState::FINISHED)))) {
+            ++b.rounds;
+        }
+    }
+    double elapsed = (monotonicNs() - t0) / 1e6;
+
+    Bucket total;
+    printf("%-10s %9s %7s %9s %9s %9s %12s\n", week ? "week of" : "day", "sessions", "rounds",
+           "mat time", "sparring", "drilling", "competition");
+    for (const auto& kv : buckets) {
+        const Bucket& b = kv.second;
+        if (!b.sessions && !b.rounds && !b.matMs) continue;
+        time_t t = static_cast<time_t>(kv.first / 1000);
+        struct tm tm;
+        localtime_r(&t, &tm);
+        char date[16];
+        strftime(date, sizeof(date), "%Y-%m-%d", &tm);
+        printf("%-10s %9u %7u %6lld:%02lld %9u %9u %12u\n", date, b.sessions, b.rounds,
+               static_cast<long long>(b.matMs / 3600000), static_cast<long long>(b.matMs / 60000 % 60),
+               b.byMode[0], b.byMode[1], b.byMode[2]);
+        total.sessions += b.sessions;
+        total.rounds += b.rounds;
+        total.matMs += b.matMs;
+        for (int m = 0; m < 3; ++m) total.byMode[m] += b.byMode[m];
+    }
+    printf("%-10s %9u %7u %6lld:%02lld %9u %9u %12u\n", "total", total.sessions, total.rounds,
+           static_cast<long long>(total.matMs / 3600000), static_cast<long long>(total.matMs / 60000 % 60),
+           total.byMode[0], total.byMode[1], total.byMode[2]);
+
+    if (presets && !presetUse.empty()) {
+        std::vector<std::pair<unsigned, PresetKey>> top;
+        for (const auto& kv : presetUse) top.push_back({kv.second, kv.first});
+        std::sort(top.begin(), top.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        printf("\nmost used presets:\n");
+        for (size_t k = 0; k < top.size() && k < 10; ++k) {
+            const PresetKey& p = top[k].second;
+            if (p.mode == static_cast<uint8_t>(TimerMode::SPARRING)) {
+                printf("  %5u  %-11s %u:%02u work, %u:%02u rest, %u rounds\n", top[k].first, modeName(p.mode),
+                       p.work / 60, p.work % 60, p.rest / 60, p.rest % 60, p.rounds);
+            } else {
+                printf("  %5u  %-11s %u:%02u\n", top[k].first, modeName(p.mode), p.work / 60, p.work % 60);
+            }
+        }
+    }
+
+    fprintf(stderr, "[bjj_history] %llu of %llu records from #%llu, %llu skipped (%s), %llu corrupt, %.2f ms\n",
+            static_cast<unsigned long long>(scanned), static_cast<unsigned long long>(count),
+            static_cast<unsigned long long>(begin), static_cast<unsigned long long>(skipped),
+            !indexed ? "no index" : ordered ? "index" : "index, clock stepped back",
+            static_cast<unsigned long long>(corrupt), elapsed);
+    return 0;
+}
@@ -0,0 +1,593 @@
+/**
+ * BJJ Gym Timer - HTTP Dashboard Server Implementation
+ */
+
+#include "http_server.hpp"
+#include "control_server.hpp"
+#include "perf_trace.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace bjj {
+
+// epoll user data: listener and wake fd are tagged, clients carry their slot
+static constexpr uint64_t TAG_LISTEN = ~0ULL;
+static constexpr uint64_t TAG_WAKE   = ~0ULL - 1;
+
+// CtlMatState::mat of a slot a stream has never been sent: forces every field
+static constexpr uint8_t NEVER_SENT = 0xFF;
+
+static const char PAGE[] = R"HTML(<!doctype html>
+<html><head><meta charset="utf-8"><meta name="viewport" content="width=device-width,initial-scale=1">
+<title>BJJ Timer</title>
+<style>
+body{margin:0;background:#111;color:#eee;font-family:sans-serif}
+#mats{display:flex;flex-wrap:wrap;gap:12px;padding:12px}
+.mat{background:#222;border-radius:8px;padding:12px;flex:1;min-width:240px}
+.head{color:#aaa;font-size:14px}
+.clock{font-size:64px;font-weight:bold;font-variant-numeric:tabular-nums}
+.WORK .clock{color:#4caf50}.REST .clock{color:#ff9800}.SWITCH .clock{color:#2196f3}
+.FINISHED .clock{color:#f44336}.PAUSED .clock{opacity:.5}
+.score{font-size:20px;font-variant-numeric:tabular-nums}.score:empty,.score:empty+.scoring{display:none}
+button{font-size:16px;margin:4px 4px 0 0;padding:8px 12px}
+#link{position:fixed;right:8px;bottom:8px;color:#666;font-size:12px}
+</style></head><body><div id="mats"></div><div id="link">connecting</div>
+<script>
+const ST=['MENU','SETUP','SETUP','SETUP','RUNNING','PAUSED','FINISHED'];
+const MO=['Sparring','Drilling','Competition'],PH=['WORK','REST','SWITCH'];
+const mats={};
+function fmt(s){return Math.floor(s/60)+':'+String(s%60).padStart(2,'0');}
+function cmd(q){fetch('/api/'+q,{method:'POST'});}
+function card(m){
+  const d=document.createElement('div');d.className='mat';
+  d.innerHTML='<div class="head"></div><div class="clock"></div><div class="info"></div>'+
+    ['start','pause','adjust&sec=-30','adjust&sec=30','reset'].map(q=>
+      '<button data-q="'+q+'">'+({start:'Start',pause:'Pause',reset:'Reset'}[q]||(q.endsWith('-30')?'-30s':'+30s'))+'</button>').join('')+
+    '<div class="score"></div><div class="scoring">'+[1,2].map(w=>['2','3','4','adv','pen'].map(k=>
+      '<button data-q="score&who='+w+'&kind='+k+'">'+w+': '+(k>'9'?k.toUpperCase():'+'+k)+'</button>').join('')+'<br>').join('')+
+    '<button data-q="undo">Undo</button><button data-q="redo">Redo</button></div>';
+  d.querySelectorAll('button').forEach(b=>b.onclick=()=>{
+    const [op,...arg]=b.dataset.q.split('&');cmd(op+'?mat='+m+arg.map(a=>'&'+a).join(''));});
+  document.getElementById('mats').appendChild(d);return d;
+}
+function draw(m){
+  const s=mats[m],el=s.el||(s.el=card(m)),st=ST[s.st];
+  el.className='mat '+(st==='RUNNING'?PH[s.ph]:st);
+  el.querySelector('.head').textContent='Mat '+(m+1)+' · '+MO[s.mo]+' · '+st;
+  el.querySelector('.clock').textContent=fmt(s.s);
+  el.querySelector('.info').textContent=st==='MENU'?'':(s.mo===1?PH[s.ph]:'Round '+s.r+' / '+s.tr);
+  el.querySelector('.score').textContent=s.sc?[1,2].map(w=>s['p'+w]+'  A'+s['a'+w]+' P'+s['n'+w]).join('  –  '):'';
+}
+const es=new EventSource('/events');
+es.onopen=()=>document.getElementById('link').textContent='live';
+es.onerror=()=>document.getElementById('link').textContent='reconnecting';
+es.onmessage=e=>{for(const d of JSON.parse(e.data)){Object.assign(mats[d.m]||(mats[d.m]={}),d);draw(d.m);}};
+</script></body></html>
+)HTML";
+
+// Append `{"m":N,...}` with only the fields that differ from `was`
+static size_t appendDelta(char* out, size_t room, const CtlMatState& now, const CtlMatState& was) {
+    if (now.mat == NEVER_SENT) return 0;  // Not seeded by the timer thread yet
+    bool full = was.mat != now.mat;
+    size_t n = 0;
+    auto put = [&](const char* key, unsigned value, bool changed) {
+        if (!changed || n >= room) return;
+        int w = snprintf(out + n, room - n, n ? ",\"%s\":%u" : "{\"%s\":%u", key, value);
+        n += w > 0 ? static_cast<size_t>(w) : 0;
+    };
+    put("m", now.mat, true);
+    size_t head = n;
+    put("st", now.state, full || now.state != was.state);
+    put("mo", now.mode, full || now.mode != was.mode);
+    put("ph", now.phase, full || now.phase != was.phase);
+    put("r", now.currentRound, full || now.currentRound != was.currentRound);
+    put("tr", now.totalRounds, full || now.totalRounds != was.totalRounds);
+    put("s", now.secondsRemaining, full || now.secondsRemaining != was.secondsRemaining);
+    put("t", now.phaseTotalSeconds, full || now.phaseTotalSeconds != was.phaseTotalSeconds);
+    put("sc", now.scoring, full || now.scoring != was.scoring);
+    put("p1", now.points[0], full || now.points[0] != was.points[0]);
+    put("p2", now.points[1], full || now.points[1] != was.points[1]);
+    put("a1", now.advantages[0], full || now.advantages[0] != was.advantages[0]);
+    put("a2", now.advantages[1], full || now.advantages[1] != was.advantages[1]);
+    put("n1", now.penalties[0], full || now.penalties[0] != was.penalties[0]);
+    put("n2", now.penalties[1], full || now.penalties[1] != was.penalties[1]);
+    if (n == head || n + 1 >= room) return 0;  // Nothing visible changed (or no room)
+    out[n++] = '}';
+    return n;
+}
+
+// Value of `key` in a query string, or nullptr
+static const char* queryParam(const char* query, const char* key, char* buf, size_t bufLen) {
+    size_t keyLen = strlen(key);
+    for (const char* p = query; p && *p;) {
+        const char* end = strchr(p, '&');
+        size_t len = end ? static_cast<size_t>(end - p) : strlen(p);
+        if (len > keyLen && p[keyLen] == '=' && strncmp(p, key, keyLen) == 0) {
+            size_t v = len - keyLen - 1;
+            if (v >= bufLen) v = bufLen - 1;
+            std::memcpy(buf, p + keyLen + 1, v);
+            buf[v] = '\0';
+            return buf;
+        }
+        p = end ? end + 1 : nullptr;
+    }
+    return nullptr;
+}
+
+static bool parseInt(const char* s, long lo, long hi, long& out) {
+    if (!s || !*s) return false;
+    char* end;
+    long v = strtol(s, &end, 10);
+    if (*end || v < lo || v > hi) return false;
+    out = v;
+    return true;
+}
+
+bool HttpServer::start(const std::string& spec, unsigned matCount) {
+    stop();
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    std::string port = spec;
+    size_t colon = spec.rfind(':');
+    if (colon != std::string::npos) {
+        port = spec.substr(colon + 1);
+        if (inet_pton(AF_INET, spec.substr(0, colon).c_str(), &addr.sin_addr) != 1) {
+            fprintf(stderr, "[http] bad address: %s\n", spec.c_str());
+            return false;
+        }
+    }
+    long portNum;
+    if (!parseInt(port.c_str(), 0, 65535, portNum)) {
+        fprintf(stderr, "[http] bad port: %s\n", spec.c_str());
+        return false;
+    }
+    addr.sin_port = htons(static_cast<uint16_t>(portNum));
+
+    listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        perror("[http] socket");
+        return false;
+    }
+    int one = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd_, 64) != 0) {
+        perror("[http] bind");
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.u64 = TAG_LISTEN;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &ev);
+    ev.data.u64 = TAG_WAKE;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+
+    matCount_ = matCount < MAX_MATS ? matCount : MAX_MATS;
+    clients_.reset(new Client[MAX_CLIENTS]);
+    for (unsigned m = 0; m < MAX_MATS; ++m) latest_[m].mat = view_[m].mat = NEVER_SENT;
+    seeded_ = false;
+    running_ = true;
+    thread_ = std::thread(&HttpServer::run, this);
+    return true;
+}
+
+void HttpServer::stop() {
+    if (thread_.joinable()) {
+        running_ = false;
+        uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+        thread_.join();
+    }
+    if (clients_) {
+        for (unsigned i = 0; i < MAX_CLIENTS; ++i) closeClient(clients_[i]);
+    }
+    if (listenFd_ >= 0) close(listenFd_);
+    if (wakeFd_ >= 0) close(wakeFd_);
+    if (epollFd_ >= 0) close(epollFd_);
+    listenFd_ = wakeFd_ = epollFd_ = -1;
+}
+
+// ============================================================================
+// I/O THREAD
+// ============================================================================
+void HttpServer::run() {
+    epoll_event events[64];
+    uint64_t lastSweep = monotonicMs();
+    while (running_) {
+        int n = epoll_wait(epollFd_, events, 64, KEEPALIVE_MS / 3);
+        if (n < 0 && errno != EINTR) break;
+        for (int i = 0; i < n; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == TAG_LISTEN) {
+                acceptClients();
+            } else if (tag == TAG_WAKE) {
+                uint64_t v;
+                while (read(wakeFd_, &v, sizeof(v)) > 0) {}
+                publish();
+            } else if (tag < MAX_CLIENTS) {
+                Client& c = clients_[tag];
+                uint32_t e = events[i].events;
+                if (e & (EPOLLHUP | EPOLLERR)) {
+                    closeClient(c);
+                    continue;
+                }
+                if (e & (EPOLLIN | EPOLLRDHUP)) readClient(c);
+                if (c.fd >= 0 && (e & EPOLLOUT)) pump(c);
+            }
+        }
+        uint64_t now = monotonicMs();
+        if (now - lastSweep >= KEEPALIVE_MS) {
+            lastSweep = now;
+            keepalive();
+        }
+    }
+}
+
+void HttpServer::acceptClients() {
+    // Edge-triggered: drain the backlog completely
+    for (;;) {
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        unsigned slot = 0;
+        while (slot < MAX_CLIENTS && clients_[slot].fd >= 0) ++slot;
+        if (slot == MAX_CLIENTS) {
+            close(fd);
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        Client& c = clients_[slot];
+        c.fd = fd;
+        c.stream = false;
+        c.closeAfterWrite = false;
+        c.openedMs = monotonicMs();
+        c.dirty = 0;
+        c.inLen = c.outPos = c.outLen = 0;
+        c.body = nullptr;
+        c.bodyLen = 0;
+        // Writability is watched from the start so a stream that backed up
+        // resumes on the edge without re-arming
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+        ev.data.u64 = slot;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void HttpServer::readClient(Client& c) {
+    while (c.fd >= 0) {
+        char scratch[256];
+        bool discard = c.stream || c.closeAfterWrite;  // Request already answered
+        char* dst = discard ? scratch : c.in + c.inLen;
+        size_t room = discard ? sizeof(scratch) : IN_BUF - 1 - c.inLen;
+        if (room == 0) {
+            respond(c, "431 Request Header Fields Too Large", "text/plain", nullptr, 0);
+            return;
+        }
+        ssize_t len = recv(c.fd, dst, room, MSG_DONTWAIT);
+        if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (len <= 0) {
+            closeClient(c);
+            return;
+        }
+        if (discard) continue;
+        c.inLen += static_cast<unsigned>(len);
+        c.in[c.inLen] = '\0';
+        char* end = strstr(c.in, "\r\n\r\n");
+        if (!end) continue;
+        *end = '\0';
+        requests_.fetch_add(1, std::memory_order_relaxed);
+        handleRequest(c, c.in);
+    }
+}
+
+void HttpServer::handleRequest(Client& c, char* head) {
+    // Request line only: METHOD SP TARGET SP VERSION
+    char* lineEnd = strstr(head, "\r\n");
+    if (lineEnd) *lineEnd = '\0';
+    char* method = head;
+    char* target = strchr(method, ' ');
+    if (!target) {
+        respond(c, "400 Bad Request", "text/plain", nullptr, 0);
+        return;
+    }
+    *target++ = '\0';
+    char* version = strchr(target, ' ');
+    if (version) *version = '\0';
+    char* query = strchr(target, '?');
+    if (query) *query++ = '\0';
+
+    if (strcmp(method, "GET") == 0 && (strcmp(target, "/") == 0 || strcmp(target, "/index.html") == 0)) {
+        respond(c, "200 OK", "text/html; charset=utf-8", PAGE, sizeof(PAGE) - 1);
+        return;
+    }
+
+    if (strcmp(method, "GET") == 0 && strcmp(target, "/events") == 0) {
+        c.outPos = 0;
+        c.outLen = static_cast<unsigned>(snprintf(c.out, OUT_BUF,
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/event-stream\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Connection: keep-alive\r\n"
+            "\r\n"
+            "retry: 1000\n\n"
+            "event: version\ndata: %u\n\n", HTTP_STREAM_VERSION));
+        c.stream = true;
+        for (unsigned m = 0; m < MAX_MATS; ++m) c.sent[m].mat = NEVER_SENT;
+        c.dirty = matCount_ >= 64 ? ~0ULL : (1ULL << matCount_) - 1;
+        streams_.fetch_add(1, std::memory_order_relaxed);
+        pump(c);
+        return;
+    }
+
+    if (strcmp(method, "POST") == 0 && strncmp(target, "/api/", 5) == 0) {
+        const char* op = target + 5;
+        char buf[16];
+        CtlCommand cmd{};
+        long v = 0;
+        const char* mat = queryParam(query, "mat", buf, sizeof(buf));
+        if (mat && strcmp(mat, "all") == 0) cmd.mat = CTL_ALL_MATS;
+        else if (parseInt(mat, 0, static_cast<long>(matCount_) - 1, v)) cmd.mat = static_cast<uint8_t>(v);
+        else {
+            respond(c, "400 Bad Request", "text/plain", "bad mat\n", 8);
+            return;
+        }
+
+        bool ok = true;
+        if (strcmp(op, "start") == 0) cmd.op = CTL_OP_START;
+        else if (strcmp(op, "pause") == 0) cmd.op = CTL_OP_PAUSE;
+        else if (strcmp(op, "reset") == 0) cmd.op = CTL_OP_RESET;
+        else if (strcmp(op, "result") == 0) {
+            cmd.op = CTL_OP_RESULT;
+            ok = parseInt(queryParam(query, "winner", buf, sizeof(buf)), 1, 2, v);
+            if (ok) cmd.arg = static_cast<int32_t>(v);
+        } else if (strcmp(op, "score") == 0) {
+            // kind: 2, 3, 4 points, adv or pen
+            static const char* const KINDS[SCORE_KIND_COUNT] = {"2", "3", "4", "adv", "pen"};
+            cmd.op = CTL_OP_SCORE;
+            ok = parseInt(queryParam(query, "who", buf, sizeof(buf)), 1, 2, v);
+            if (ok) cmd.mode = static_cast<uint8_t>(v);
+            const char* kind = queryParam(query, "kind", buf, sizeof(buf));
+            cmd.arg = -1;
+            for (unsigned k = 0; kind && k < SCORE_KIND_COUNT; ++k) {
+                if (strcmp(kind, KINDS[k]) == 0) cmd.arg = static_cast<int32_t>(k);
+            }
+            ok = ok && cmd.arg >= 0;
+        } else if (strcmp(op, "undo") == 0) cmd.op = CTL_OP_UNDO_SCORE;
+        else if (strcmp(op, "redo") == 0) cmd.op = CTL_OP_REDO_SCORE;
+        else if (strcmp(op, "adjust") == 0) {
+            cmd.op = CTL_OP_ADJUST;
+            ok = parseInt(queryParam(query, "sec", buf, sizeof(buf)), -3600, 3600, v);
+            if (ok) cmd.arg = static_cast<int32_t>(v);
+        } else if (strcmp(op, "preset") == 0) {
+            cmd.op = CTL_OP_LOAD_PRESET;
+            ok = parseInt(queryParam(query, "mode", buf, sizeof(buf)), 0, 2, v);
+            if (ok) cmd.mode = static_cast<uint8_t>(v);
+            ok = ok && parseInt(queryParam(query, "work", buf, sizeof(buf)), 1, 3600, v);
+            if (ok) cmd.arg = static_cast<int32_t>(v);
+            v = DEFAULT_REST_SEC;
+            const char* rest = queryParam(query, "rest", buf, sizeof(buf));
+            ok = ok && (!rest || parseInt(rest, 0, 3600, v));
+            if (ok) cmd.arg2 = static_cast<uint32_t>(v);
+            v = DEFAULT_ROUNDS;
+            const char* rounds = queryParam(query, "rounds", buf, sizeof(buf));
+            ok = ok && (!rounds || parseInt(rounds, 1, 255, v));
+            if (ok) cmd.rounds = static_cast<uint8_t>(v);
+        } else {
+            respond(c, "404 Not Found", "text/plain", "unknown op\n", 11);
+            return;
+        }
+        if (!ok) respond(c, "400 Bad Request", "text/plain", "bad arguments\n", 14);
+        // The result shows up on /events; the timer thread may still refuse it
+        else if (queueCommand(cmd)) respond(c, "202 Accepted", "text/plain", nullptr, 0);
+        else respond(c, "503 Service Unavailable", "text/plain", "busy\n", 5);
+        return;
+    }
+
+    respond(c, "404 Not Found", "text/plain", "not found\n", 10);
+}
+
+void HttpServer::respond(Client& c, const char* status, const char* type, const char* body, size_t bodyLen) {
+    // One request per connection keeps the parser trivial; the page opens one stream
+    c.outPos = 0;
+    c.outLen = static_cast<unsigned>(snprintf(c.out, OUT_BUF,
+        "HTTP/1.1 %s\r\n"
+        "Content-Type: %s\r\n"
+        "Content-Length: %zu\r\n"
+        "Cache-Control: no-store\r\n"
+        "Connection: close\r\n"
+        "\r\n", status, type, bodyLen));
+    c.body = body;
+    c.bodyLen = body ? bodyLen : 0;
+    c.closeAfterWrite = true;
+    pump(c);
+}
+
+bool HttpServer::queueCommand(const CtlCommand& cmd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (inCount_ == QUEUE_DEPTH) return false;
+    inbound_[(inHead_ + inCount_++) % QUEUE_DEPTH] = cmd;
+    return true;
+}
+
+bool HttpServer::fillStream(Client& c) {
+    if (!c.dirty) return false;
+    size_t n = 6;
+    std::memcpy(c.out, "data: ", n);
+    size_t first = n;
+    for (uint64_t m = c.dirty; m; m &= m - 1) {
+        unsigned i = static_cast<unsigned>(__builtin_ctzll(m));
+        c.out[n] = n == first ? '[' : ',';
+        size_t w = appendDelta(c.out + n + 1, OUT_BUF - n - 4, view_[i], c.sent[i]);
+        if (w == 0) continue;
+        n += 1 + w;
+        c.sent[i] = view_[i];
+    }
+    c.dirty = 0;
+    if (n == first) return false;  // Only invisible changes
+    std::memcpy(c.out + n, "]\n\n", 3);
+    c.outPos = 0;
+    c.outLen = static_cast<unsigned>(n + 3);
+    events_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool HttpServer::flushClient(Client& c) {
+    while (c.fd >= 0) {
+        const char* src;
+        size_t len;
+        if (c.outPos < c.outLen) {
+            src = c.out + c.outPos;
+            len = c.outLen - c.outPos;
+        } else if (c.bodyLen) {
+            src = c.body;
+            len = c.bodyLen;
+        } else {
+            return true;
+        }
+        ssize_t w = send(c.fd, src, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return false;  // EPOLLOUT resumes
+            closeClient(c);
+            return false;
+        }
+        if (c.outPos < c.outLen) {
+            c.outPos += static_cast<unsigned>(w);
+        } else {
+            c.body += w;
+            c.bodyLen -= static_cast<size_t>(w);
+        }
+    }
+    return false;
+}
+
+void HttpServer::pump(Client& c) {
+    for (;;) {
+        if (!flushClient(c)) return;  // Blocked or closed
+        if (c.closeAfterWrite) {
+            closeClient(c);
+            return;
+        }
+        if (!c.stream || !fillStream(c)) return;
+    }
+}
+
+void HttpServer::closeClient(Client& c) {
+    if (c.fd < 0) return;
+    if (epollFd_ >= 0) epoll_ctl(epollFd_, EPOLL_CTL_DEL, c.fd, nullptr);
+    close(c.fd);
+    if (c.stream) streams_.fetch_sub(1, std::memory_order_relaxed);
+    c.fd = -1;
+    c.stream = false;
+}
+
+void HttpServer::publish() {
+    uint64_t dirty;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dirty = dirty_;
+        dirty_ = 0;
+        wakePending_ = false;
+        for (uint64_t m = dirty; m; m &= m - 1) {
+            unsigned i = static_cast<unsigned>(__builtin_ctzll(m));
+            view_[i] = latest_[i];
+        }
+    }
+    if (!dirty) return;
+    for (unsigned i = 0; i < MAX_CLIENTS; ++i) {
+        Client& c = clients_[i];
+        if (c.fd < 0 || !c.stream) continue;
+        // A stream still draining its previous message just accumulates; the
+        // next EPOLLOUT edge sends one delta against what it last saw
+        if (c.outPos < c.outLen) coalesced_.fetch_add(1, std::memory_order_relaxed);
+        c.dirty |= dirty;
+        if (c.outPos >= c.outLen) pump(c);
+    }
+}
+
+void HttpServer::keepalive() {
+    uint64_t now = monotonicMs();
+    for (unsigned i = 0; i < MAX_CLIENTS; ++i) {
+        Client& c = clients_[i];
+        if (c.fd < 0) continue;
+        if (!c.stream) {
+            // Never finished sending a request (or reading the reply)
+            if (now - c.openedMs >= KEEPALIVE_MS) closeClient(c);
+        } else if (c.outPos >= c.outLen) {
+            // SSE comment keeps proxies from timing the stream out
+            std::memcpy(c.out, ":\n\n", 3);
+            c.outPos = 0;
+            c.outLen = 3;
+            pump(c);
+        }
+    }
+}
+
+// ============================================================================
+// TIMER THREAD
+// ============================================================================
+void HttpServer::notify(unsigned mat, const DisplayInfo& info) {
+    if (!running_ || mat >= matCount_) return;
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        latest_[mat] = ctlMatState(mat, info);
+        dirty_ |= 1ULL << mat;
+        wake = !wakePending_;
+        if (wake) wakePending_ = true;
+    }
+    if (wake) {
+        uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+    }
+}
+
+unsigned HttpServer::apply(MatHost& host) {
+    if (!running_) return 0;
+    if (!seeded_) {
+        // Streams opened before the first change still get a full picture
+        for (unsigned m = 0; m < matCount_ && m < host.size(); ++m) notify(m, host.timer(m).getDisplayInfo());
+        seeded_ = true;
+    }
+    unsigned ran = 0;
+    for (;;) {
+        CtlCommand cmd;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (inCount_ == 0) break;
+            cmd = inbound_[inHead_];
+            inHead_ = (inHead_ + 1) % QUEUE_DEPTH;
+            --inCount_;
+        }
+        runControlCommand(host, cmd);
+        ++ran;
+    }
+    commands_.fetch_add(ran, std::memory_order_relaxed);
+    return ran;
+}
+
+HttpStats HttpServer::stats() const {
+    HttpStats s{};
+    s.requests = requests_.load(std::memory_order_relaxed);
+    s.streams = streams_.load(std::memory_order_relaxed);
+    s.commands = commands_.load(std::memory_order_relaxed);
+    s.events = events_.load(std::memory_order_relaxed);
+    s.coalesced = coalesced_.load(std::memory_order_relaxed);
+    return s;
+}
+
+} // namespace bjj
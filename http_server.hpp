@@ -0,0 +1,126 @@
+/**
+ * BJJ Gym Timer - HTTP Dashboard Server
+ * Serves a static control page and streams every mat's state over
+ * Server-Sent Events. Each stream only carries the fields that changed since
+ * it was last written to, and a slow client just gets one larger, coalesced
+ * update once its socket drains. All socket I/O runs on one edge-triggered
+ * epoll thread; the timer thread only records the latest state (notify) and
+ * runs queued commands (apply), exactly like ControlServer.
+ *
+ *   GET  /                 control page
+ *   GET  /events           SSE: data: [{"m":0,"st":4,"s":299}, ...]; first an
+ *                          "event: version" with HTTP_STREAM_VERSION. Competition
+ *                          adds sc (scoring) and p1/p2, a1/a2, n1/n2 (points,
+ *                          advantages, penalties) to the mat's fields
+ *   POST /api/<op>?mat=N   op = start | pause | reset | adjust&sec=S |
+ *                          preset&mode=M&rounds=R&work=W&rest=S   (mat=all ok) |
+ *                          result&winner=1|2 (tournament) |
+ *                          score&who=1|2&kind=2|3|4|adv|pen | undo | redo (competition)
+ */
+
+#pragma once
+
+#include "control_protocol.hpp"
+#include "mat_host.hpp"
+#include "timer_logic.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace bjj {
+
+constexpr unsigned HTTP_STREAM_VERSION = 2;  // /events field set; 2: competition score
+
+struct HttpStats {
+    uint32_t requests;      // Parsed HTTP requests
+    uint32_t streams;       // SSE streams currently open
+    uint32_t commands;      // Commands run on the timer thread
+    uint64_t events;        // SSE messages written
+    uint64_t coalesced;     // Wakeups a backed-up stream folded into a later message
+};
+
+class HttpServer {
+public:
+    static constexpr unsigned MAX_CLIENTS = 128;
+    static constexpr unsigned QUEUE_DEPTH = 64;     // Commands in flight
+    static constexpr unsigned IN_BUF = 2048;        // Request head limit
+    static constexpr unsigned OUT_BUF = 8192;       // Fits a full 64-mat snapshot
+    static constexpr unsigned KEEPALIVE_MS = 15000; // SSE comment / idle request timeout
+
+    HttpServer() = default;
+    ~HttpServer() { stop(); }
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    // spec: "PORT" (all interfaces) or "ADDR:PORT"
+    bool start(const std::string& spec, unsigned matCount);
+    void stop();
+    bool isRunning() const { return thread_.joinable(); }
+
+    // Timer thread: run queued commands against the host. Returns commands run.
+    unsigned apply(MatHost& host);
+
+    // Timer thread: a mat's display changed. Only the latest state is kept.
+    void notify(unsigned mat, const DisplayInfo& info);
+
+    HttpStats stats() const;
+
+private:
+    struct Client {
+        int fd = -1;
+        bool stream = false;          // SSE: stays open, receives deltas
+        bool closeAfterWrite = false;
+        uint64_t openedMs = 0;
+        uint64_t dirty = 0;           // Mats changed since the last message
+        unsigned inLen = 0;
+        unsigned outPos = 0, outLen = 0;
+        const char* body = nullptr;   // Static response body sent after out
+        size_t bodyLen = 0;
+        char in[IN_BUF];
+        char out[OUT_BUF];
+        CtlMatState sent[MAX_MATS];   // What this stream last saw, per mat
+    };
+
+    void run();
+    void acceptClients();
+    void readClient(Client& c);
+    void handleRequest(Client& c, char* head);
+    void respond(Client& c, const char* status, const char* type, const char* body, size_t bodyLen);
+    bool queueCommand(const CtlCommand& cmd);
+    bool fillStream(Client& c);
+    bool flushClient(Client& c);
+    void pump(Client& c);
+    void closeClient(Client& c);
+    void publish();
+    void keepalive();
+
+    unsigned matCount_ = 0;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;  // eventfd: timer thread -> I/O thread
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // I/O thread only
+    std::unique_ptr<Client[]> clients_;
+    CtlMatState view_[MAX_MATS] = {};  // Latest state as of the last wakeup
+
+    // Shared, under mutex_
+    mutable std::mutex mutex_;
+    CtlCommand inbound_[QUEUE_DEPTH] = {};
+    unsigned inHead_ = 0, inCount_ = 0;
+    CtlMatState latest_[MAX_MATS] = {};
+    uint64_t dirty_ = 0;
+    bool wakePending_ = false;
+
+    // Timer thread only
+    bool seeded_ = false;
+
+    std::atomic<uint32_t> requests_{0}, streams_{0}, commands_{0};
+    std::atomic<uint64_t> events_{0}, coalesced_{0};
+};
+
+} // namespace bjj
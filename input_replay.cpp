@@ -0,0 +1,232 @@
+/**
+ * BJJ Gym Timer - Deterministic Input Record and Replay Implementation
+ */
+
+#include "input_replay.hpp"
+#include "control_server.hpp"
+#include <cstring>
+#include <ctime>
+
+namespace bjj {
+
+// ============================================================================
+// RECORDER
+// ============================================================================
+bool InputRecorder::open(const std::string& path, MatHost& host) {
+    close();
+    file_ = fopen(path.c_str(), "wbe");
+    if (!file_) {
+        perror("[record] open");
+        return false;
+    }
+    setvbuf(file_, nullptr, _IOFBF, 64 * 1024);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ReplayHeader hdr{};
+    hdr.magic = REPLAY_MAGIC;
+    hdr.version = REPLAY_VERSION;
+    hdr.matCount = static_cast<uint16_t>(host.size());
+    hdr.startMs = host.nowMs();
+    hdr.realtimeMs = static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+    fwrite(&hdr, sizeof(hdr), 1, file_);
+
+    host_ = &host;
+    nowMs_ = lastFlushMs_ = host.nowMs();
+    nowWritten_ = true;  // The header carries it
+    records_ = 0;
+    host.setInputTap(onInput, onPoll, this);
+    setControlTap(onCommand, this);
+    return true;
+}
+
+void InputRecorder::close() {
+    if (!file_) return;
+    // A closing poll at the last clock: replay applies records up to a poll,
+    // so a command after the last one (the final pause or reset) is kept
+    write(REPLAY_POLL, 0, 0, 0, nullptr, 0);
+    host_->setInputTap(nullptr, nullptr, nullptr);
+    setControlTap(nullptr, nullptr);
+    fclose(file_);
+    file_ = nullptr;
+    host_ = nullptr;
+}
+
+void InputRecorder::restore(unsigned mat, const TimerSnapshot& snap, unsigned elapsedTicks, uint32_t firstTickMs) {
+    if (!file_) return;
+    ReplaySnapshot s{};
+    s.state = static_cast<uint8_t>(snap.state);
+    s.mode = static_cast<uint8_t>(snap.mode);
+    s.phase = static_cast<uint8_t>(snap.phase);
+    s.tenSecondPlayed = snap.tenSecondPlayed;
+    s.workSeconds = snap.config.workSeconds;
+    s.restSeconds = snap.config.restSeconds;
+    s.roundCount = snap.config.roundCount;
+    s.compTimeIndex = snap.config.compTimeIndex;
+    s.currentRound = snap.currentRound;
+    s.totalRounds = snap.totalRounds;
+    s.secondsRemaining = snap.secondsRemaining;
+    s.firstTickMs = firstTickMs;
+    for (unsigned a = 0; a < 2; ++a) {
+        s.points[a] = snap.score.points[a];
+        s.advantages[a] = snap.score.advantages[a];
+        s.penalties[a] = snap.score.penalties[a];
+    }
+    syncClock();
+    write(REPLAY_RESTORE, mat, 0, static_cast<int32_t>(elapsedTicks), &s, sizeof(s));
+}
+
+void InputRecorder::onInput(void* ctx, unsigned mat, int delta, uint8_t presses) {
+    static_cast<InputRecorder*>(ctx)->write(REPLAY_INPUT, mat, presses, delta, nullptr, 0);
+}
+
+void InputRecorder::onPoll(void* ctx, uint64_t nowMs, unsigned events) {
+    InputRecorder& r = *static_cast<InputRecorder*>(ctx);
+    r.nowMs_ = nowMs;
+    r.nowWritten_ = events > 0;
+    if (!events) return;
+    r.write(REPLAY_POLL, 0, 0, static_cast<int32_t>(events), nullptr, 0);
+    if (nowMs - r.lastFlushMs_ >= FLUSH_MS) {
+        r.lastFlushMs_ = nowMs;
+        fflush(r.file_);
+    }
+}
+
+void InputRecorder::onCommand(void* ctx, const CtlCommand& cmd) {
+    InputRecorder& r = *static_cast<InputRecorder*>(ctx);
+    r.syncClock();
+    r.write(REPLAY_COMMAND, 0, 0, 0, &cmd, sizeof(cmd));
+}
+
+// Commands and restores act at the last poll's clock: make sure it is on file
+void InputRecorder::syncClock() {
+    if (nowWritten_) return;
+    nowWritten_ = true;
+    write(REPLAY_POLL, 0, 0, 0, nullptr, 0);
+}
+
+void InputRecorder::write(ReplayType type, unsigned mat, uint8_t presses, int32_t arg,
+                          const void* payload, uint8_t size) {
+    ReplayRecord rec{type, static_cast<uint8_t>(mat), presses, size, arg, nowMs_};
+    fwrite(&rec, sizeof(rec), 1, file_);
+    if (size) fwrite(payload, size, 1, file_);
+    ++records_;
+}
+
+// ============================================================================
+// REPLAY
+// ============================================================================
+bool InputReplay::open(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "rbe");
+    if (!f) {
+        perror(path.c_str());
+        return false;
+    }
+    data_.clear();
+    uint8_t buf[64 * 1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data_.insert(data_.end(), buf, buf + n);
+    fclose(f);
+
+    if (data_.size() < sizeof(header_)) {
+        fprintf(stderr, "%s: too short for a recording\n", path.c_str());
+        return false;
+    }
+    std::memcpy(&header_, data_.data(), sizeof(header_));
+    if (header_.magic != REPLAY_MAGIC || header_.version != REPLAY_VERSION ||
+        header_.matCount < 1 || header_.matCount > MAX_MATS) {
+        fprintf(stderr, "%s: not an input recording\n", path.c_str());
+        return false;
+    }
+    pos_ = sizeof(header_);
+    return true;
+}
+
+bool InputReplay::peek(uint64_t& nowMs) const {
+    bool pending = false;
+    for (size_t pos = pos_; pos + sizeof(ReplayRecord) <= data_.size();) {
+        ReplayRecord rec;
+        std::memcpy(&rec, &data_[pos], sizeof(rec));
+        if (pos + sizeof(rec) + rec.size > data_.size()) break;  // Torn tail
+        nowMs = rec.nowMs;
+        if (rec.type == REPLAY_POLL) return true;
+        pending = true;
+        pos += sizeof(rec) + rec.size;
+    }
+    return pending;  // Records after the last poll: step() polls at their clock
+}
+
+bool InputReplay::step(MatHost& host, ReplayStep& out) {
+    out = {};
+    bool applied = false;
+    while (pos_ + sizeof(ReplayRecord) <= data_.size()) {
+        ReplayRecord rec;
+        std::memcpy(&rec, &data_[pos_], sizeof(rec));
+        const uint8_t* payload = &data_[pos_ + sizeof(rec)];
+        if (pos_ + sizeof(rec) + rec.size > data_.size()) break;  // Torn tail
+        pos_ += sizeof(rec) + rec.size;
+        applied = true;
+        out.nowMs = rec.nowMs;
+
+        switch (rec.type) {
+            case REPLAY_INPUT:
+                if (rec.arg) host.postRotate(rec.mat, rec.arg, rec.presses & MatHost::PRESS_COARSE);
+                if (rec.presses & MatHost::PRESS_SHORT) host.postPress(rec.mat, false);
+                if (rec.presses & MatHost::PRESS_DOUBLE) host.postDoublePress(rec.mat);
+                if (rec.presses & MatHost::PRESS_LONG) host.postPress(rec.mat, true);
+                ++out.inputs;
+                break;
+            case REPLAY_COMMAND:
+                if (rec.size == sizeof(CtlCommand)) {
+                    CtlCommand cmd;
+                    std::memcpy(&cmd, payload, sizeof(cmd));
+                    runControlCommand(host, cmd);
+                    ++out.inputs;
+                }
+                break;
+            case REPLAY_RESTORE:
+                // Older recordings stop short: the missing fields read as 0
+                if (rec.size >= REPLAY_SNAPSHOT_V1_SIZE && rec.size <= sizeof(ReplaySnapshot) &&
+                    rec.mat < host.size()) {
+                    ReplaySnapshot s{};
+                    std::memcpy(&s, payload, rec.size);
+                    TimerSnapshot snap;
+                    snap.state = static_cast<TimerState>(s.state);
+                    snap.mode = static_cast<TimerMode>(s.mode);
+                    snap.phase = static_cast<Phase>(s.phase);
+                    snap.tenSecondPlayed = s.tenSecondPlayed;
+                    snap.config.workSeconds = s.workSeconds;
+                    snap.config.restSeconds = s.restSeconds;
+                    snap.config.roundCount = s.roundCount;
+                    snap.config.compTimeIndex = s.compTimeIndex;
+                    snap.currentRound = s.currentRound;
+                    snap.totalRounds = s.totalRounds;
+                    snap.secondsRemaining = s.secondsRemaining;
+                    for (unsigned a = 0; a < 2; ++a) {
+                        snap.score.points[a] = s.points[a];
+                        snap.score.advantages[a] = s.advantages[a];
+                        snap.score.penalties[a] = s.penalties[a];
+                    }
+                    host.timer(rec.mat).restore(snap, static_cast<unsigned>(rec.arg));
+                    host.alignTick(rec.mat, s.firstTickMs);
+                    ++out.inputs;
+                }
+                break;
+            case REPLAY_POLL:
+                out.nowMs = rec.nowMs;
+                out.recordedEvents = static_cast<unsigned>(rec.arg);
+                out.events = host.poll(rec.nowMs);
+                return true;
+            default:
+                break;  // Newer record type: skip its payload
+        }
+    }
+    if (!applied) return false;
+    // No closing poll (a crash, or an older recorder): run the one the
+    // session would have, with nothing recorded to compare it against
+    out.events = host.poll(out.nowMs);
+    out.recordedEvents = out.events;
+    return true;
+}
+
+} // namespace bjj
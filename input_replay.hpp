@@ -0,0 +1,153 @@
+/**
+ * BJJ Gym Timer - Deterministic Input Record and Replay
+ * The recorder captures everything that drives TimerLogic: encoder/SDL input
+ * as MatHost::poll() drains it, remote commands as runControlCommand() runs
+ * them, checkpoint restores, and the host clock of every poll that did
+ * something. TimerLogic and the timing wheel are pure functions of that
+ * stream, so InputReplay feeding it back into a fresh MatHost reproduces the
+ * session exactly - under a virtual clock, in real time or as fast as
+ * possible (see replay.cpp).
+ *
+ * Polls that handled nothing are not written; a command arriving after one
+ * writes that poll's clock first, since the command sees it as "now". close()
+ * ends the file with a poll, so commands after the last one replay too.
+ */
+
+#pragma once
+
+#include "control_protocol.hpp"
+#include "mat_host.hpp"
+#include "timer_logic.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace bjj {
+
+// ============================================================================
+// ON-DISK LAYOUT (little-endian, fixed size - never reorder fields)
+// ============================================================================
+constexpr uint32_t REPLAY_MAGIC   = 0x524A4A42;  // "BJJR"
+constexpr uint16_t REPLAY_VERSION = 1;
+
+struct ReplayHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t matCount;
+    uint64_t startMs;         // Host clock when recording began
+    int64_t  realtimeMs;      // CLOCK_REALTIME then, for humans
+    uint8_t  reserved[8];
+};
+
+enum ReplayType : uint8_t {
+    REPLAY_POLL    = 1,       // arg: events handled
+    REPLAY_INPUT   = 2,       // mat, presses, arg: rotate delta (held: PRESS_COARSE)
+    REPLAY_COMMAND = 3,       // payload: CtlCommand
+    REPLAY_RESTORE = 4,       // mat, arg: elapsed ticks, payload: ReplaySnapshot
+};
+
+struct ReplayRecord {
+    uint8_t  type;            // ReplayType
+    uint8_t  mat;
+    uint8_t  presses;         // MatHost::PRESS_* bits
+    uint8_t  size;            // Payload bytes that follow
+    int32_t  arg;
+    uint64_t nowMs;           // Host clock
+};
+
+struct ReplaySnapshot {
+    uint8_t  state;
+    uint8_t  mode;
+    uint8_t  phase;
+    uint8_t  tenSecondPlayed;
+    uint32_t workSeconds;
+    uint32_t restSeconds;
+    uint32_t roundCount;
+    uint32_t compTimeIndex;
+    uint32_t currentRound;
+    uint32_t totalRounds;
+    uint32_t secondsRemaining;
+    uint32_t firstTickMs;     // MatHost::alignTick; absent (0) in older recordings
+    uint16_t points[2];       // Competition score totals; absent (0-0) in older recordings
+    uint8_t  advantages[2];
+    uint8_t  penalties[2];
+};
+constexpr uint8_t REPLAY_SNAPSHOT_V1_SIZE = 32;  // Oldest accepted: no firstTickMs or score
+
+static_assert(sizeof(ReplayHeader) == 32, "on-disk layout");
+static_assert(sizeof(ReplayRecord) == 16, "on-disk layout");
+static_assert(sizeof(ReplaySnapshot) == 44, "on-disk layout");
+static_assert(sizeof(CtlCommand) == 12, "on-disk layout");
+
+// ============================================================================
+// RECORDER (timer thread)
+// ============================================================================
+class InputRecorder {
+public:
+    static constexpr unsigned FLUSH_MS = 1000;  // Bound on what a crash loses
+
+    InputRecorder() = default;
+    ~InputRecorder() { close(); }
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    // Start recording host: call right after constructing it, before any
+    // restore or poll. Installs the MatHost and control taps.
+    bool open(const std::string& path, MatHost& host);
+    void close();
+    bool isOpen() const { return file_ != nullptr; }
+
+    // After TimerLogic::restore() and MatHost::alignTick() on a recorded host
+    void restore(unsigned mat, const TimerSnapshot& snap, unsigned elapsedTicks, uint32_t firstTickMs);
+
+    uint64_t records() const { return records_; }
+
+private:
+    static void onInput(void* ctx, unsigned mat, int delta, uint8_t presses);
+    static void onPoll(void* ctx, uint64_t nowMs, unsigned events);
+    static void onCommand(void* ctx, const CtlCommand& cmd);
+
+    void syncClock();
+    void write(ReplayType type, unsigned mat, uint8_t presses, int32_t arg, const void* payload, uint8_t size);
+
+    FILE* file_{nullptr};
+    MatHost* host_{nullptr};
+    uint64_t nowMs_{0};       // Last poll's clock
+    bool nowWritten_{true};   // ... already in the file
+    uint64_t lastFlushMs_{0};
+    uint64_t records_{0};
+};
+
+// ============================================================================
+// REPLAY
+// ============================================================================
+struct ReplayStep {
+    uint64_t nowMs;           // Virtual clock of the poll
+    unsigned inputs;          // Input and command records applied before it
+    unsigned recordedEvents;
+    unsigned events;          // As replayed; differs only if behaviour changed
+};
+
+class InputReplay {
+public:
+    // Replay into a fresh MatHost(matCount(), startMs())
+    bool open(const std::string& path);
+    unsigned matCount() const { return header_.matCount; }
+    uint64_t startMs() const { return header_.startMs; }
+    int64_t realtimeMs() const { return header_.realtimeMs; }
+
+    // Clock of the next poll, without applying anything. False at the end.
+    bool peek(uint64_t& nowMs) const;
+    // Apply every record up to and including the next poll. Records after the
+    // last poll are applied and followed by a poll at their clock. False at
+    // the end.
+    bool step(MatHost& host, ReplayStep& out);
+
+private:
+    ReplayHeader header_{};
+    std::vector<uint8_t> data_;
+    size_t pos_{0};
+};
+
+} // namespace bjj
@@ -12,7 +12,12 @@
 /*====================
  * COLOR SETTINGS
  *====================*/
+/* CMake -DBJJ_COLOR_DEPTH=16 renders natively in RGB565 (SDL texture, fbdev) */
+#ifdef BJJ_COLOR_DEPTH
+#define LV_COLOR_DEPTH BJJ_COLOR_DEPTH
+#else
 #define LV_COLOR_DEPTH 32
+#endif
 #define LV_COLOR_16_SWAP 0
 
 /*====================
@@ -32,6 +37,9 @@
 #define LV_DEF_REFR_PERIOD 33
 #define LV_DPI_DEF 130
 
+/* Float coordinates/angles: sub-degree progress arc (ui.cpp ARC_STEPS_PER_DEGREE) */
+#define LV_USE_FLOAT 1
+
 /*====================
  * OS (none - bare metal style)
  *====================*/
@@ -114,10 +122,13 @@
 #define LV_USE_GRID 1
 
 /*====================
- * FONTS - Large clock font
+ * FONTS - ui.cpp picks the size for the display/tile; clocks above 48 px are scaled
  *====================*/
+#define LV_FONT_MONTSERRAT_12 1
 #define LV_FONT_MONTSERRAT_14 1
-#define LV_FONT_MONTSERRAT_28 0
+#define LV_FONT_MONTSERRAT_20 1
+#define LV_FONT_MONTSERRAT_28 1
+#define LV_FONT_MONTSERRAT_36 1
 #define LV_FONT_MONTSERRAT_48 1
 #define LV_FONT_DEFAULT &lv_font_montserrat_48
 
@@ -3,13 +3,17 @@
  */
 
 #include "lvgl_port.hpp"
+#include "perf_trace.hpp"
 #include <lvgl.h>
-#include <lgpio.h>
 #include <atomic>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <cerrno>
 #include <fcntl.h>
+#include <linux/fb.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 #if LV_USE_SDL
@@ -19,27 +23,256 @@
 static lv_display_t* g_disp = nullptr;
 static lv_indev_t* g_indev = nullptr;
 static lv_group_t* g_group = nullptr;
-static int g_gpio_handle = -1;
-static bjj::RotaryEncoder* g_encoder = nullptr;
 
 static std::atomic<int> g_enc_delta{0};
 static std::atomic<bool> g_btn_pressed{false};
-static std::atomic<bool> g_long_press_pending{false};
-static lvgl_encoder_cb_t g_encoder_cb = nullptr;
+static lvgl_sdl_input_cb_t g_sdl_input_cb = nullptr;
+static bool g_blank = false;
 
-static void on_rotate(int delta) {
-    g_enc_delta += delta;
-    if (g_encoder_cb) g_encoder_cb(delta, false, false);
+// Frame timing from display events: RENDER_START..RENDER_READY spans the
+// partial flushes, FLUSH_START..FLUSH_FINISH each flush callback
+struct FrameTiming {
+    lvgl_frame_cb_t cb = nullptr;
+    uint64_t renderStart = 0;
+    uint64_t flushStart = 0;
+    uint64_t flushNs = 0;
+};
+static FrameTiming g_frame;
+
+// ============================================================================
+// FRAMEBUFFER BACK END - /dev/fbN or heap memory, our own flush
+// ============================================================================
+struct MemFb {
+    bool enabled = false;
+    char path[64] = {};
+    lvgl_port_color_t color = LVGL_PORT_COLOR_NATIVE;
+    int fd = -1;
+    uint8_t* mem = nullptr;
+    size_t size = 0;
+    int32_t w = 0, h = 0;
+    uint32_t stride = 0;        // Bytes per framebuffer line
+    int bpp = 0;
+    lv_color_format_t renderFormat = LV_COLOR_FORMAT_XRGB8888;
+    uint8_t* drawBuf[2] = {};
+    uint64_t flushNs = 0;
+    uint32_t flushes = 0;
+    uint64_t bytes = 0;
+};
+static MemFb g_fb;
+
+// 4x4 Bayer matrix, indexed by screen (not area) coordinates so partial flushes tile seamlessly
+static const uint8_t BAYER4[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5},
+};
+
+static void xrgb8888_to_rgb565(const uint8_t* src, uint16_t* dst, int32_t x, int32_t y, int32_t w, bool dither) {
+    const uint8_t* bayer = BAYER4[y & 3];
+    for (int32_t i = 0; i < w; ++i, src += 4) {
+        unsigned b = src[0], g = src[1], r = src[2];
+        if (dither) {
+            // Threshold below one quantisation step: 8 for 5-bit channels, 4 for green
+            unsigned t = bayer[(x + i) & 3];
+            r = r + (t >> 1) > 255 ? 255 : r + (t >> 1);
+            g = g + (t >> 2) > 255 ? 255 : g + (t >> 2);
+            b = b + (t >> 1) > 255 ? 255 : b + (t >> 1);
+        }
+        dst[i] = static_cast<uint16_t>(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+    }
+}
+
+static void memfb_flush_cb(lv_display_t* disp, const lv_area_t* area, uint8_t* px_map) {
+    uint64_t t0 = bjj::monotonicNs();
+    const int32_t w = lv_area_get_width(area);
+    const uint32_t src_stride = lv_draw_buf_width_to_stride(w, g_fb.renderFormat);
+    const uint32_t dst_px = static_cast<uint32_t>(g_fb.bpp / 8);
+    for (int32_t y = area->y1; y <= area->y2 && y < g_fb.h; ++y) {
+        uint8_t* dst = g_fb.mem + y * g_fb.stride + area->x1 * dst_px;
+        if (g_fb.renderFormat == LV_COLOR_FORMAT_RGB565 || g_fb.bpp == 32) {
+            memcpy(dst, px_map, w * dst_px);
+        } else {
+            xrgb8888_to_rgb565(px_map, reinterpret_cast<uint16_t*>(dst), area->x1, y, w,
+                               g_fb.color == LVGL_PORT_COLOR_DITHER);
+        }
+        px_map += src_stride;
+    }
+    g_fb.flushNs += bjj::monotonicNs() - t0;
+    g_fb.flushes++;
+    g_fb.bytes += static_cast<uint64_t>(w) * lv_area_get_height(area) * dst_px;
+    lv_display_flush_ready(disp);
+}
+
+static uint32_t memfb_tick_cb(void) {
+    return static_cast<uint32_t>(bjj::monotonicMs());
+}
+
+static lv_display_t* memfb_create(void) {
+    if (g_fb.path[0]) {
+        g_fb.fd = open(g_fb.path, O_RDWR);
+        if (g_fb.fd < 0) {
+            fprintf(stderr, "[lvgl_port] open %s: %s\n", g_fb.path, strerror(errno));
+            return nullptr;
+        }
+        fb_var_screeninfo vinfo;
+        fb_fix_screeninfo finfo;
+        if (ioctl(g_fb.fd, FBIOGET_VSCREENINFO, &vinfo) != 0 || ioctl(g_fb.fd, FBIOGET_FSCREENINFO, &finfo) != 0) {
+            fprintf(stderr, "[lvgl_port] %s: not a framebuffer\n", g_fb.path);
+            return nullptr;
+        }
+        g_fb.w = vinfo.xres;
+        g_fb.h = vinfo.yres;
+        g_fb.bpp = vinfo.bits_per_pixel;
+        g_fb.stride = finfo.line_length;
+        g_fb.size = finfo.smem_len;
+        void* mem = mmap(nullptr, g_fb.size, PROT_READ | PROT_WRITE, MAP_SHARED, g_fb.fd, 0);
+        if (mem == MAP_FAILED) {
+            fprintf(stderr, "[lvgl_port] mmap %s: %s\n", g_fb.path, strerror(errno));
+            return nullptr;
+        }
+        g_fb.mem = static_cast<uint8_t*>(mem);
+    } else {
+        g_fb.stride = g_fb.w * (g_fb.bpp / 8);
+        g_fb.size = static_cast<size_t>(g_fb.stride) * g_fb.h;
+        g_fb.mem = static_cast<uint8_t*>(calloc(1, g_fb.size));
+        if (!g_fb.mem) return nullptr;
+    }
+    if (g_fb.bpp != 16 && g_fb.bpp != 32) {
+        fprintf(stderr, "[lvgl_port] unsupported framebuffer depth %d\n", g_fb.bpp);
+        return nullptr;
+    }
+
+    g_fb.renderFormat = (g_fb.bpp == 16 && g_fb.color == LVGL_PORT_COLOR_NATIVE)
+                            ? LV_COLOR_FORMAT_RGB565 : LV_COLOR_FORMAT_XRGB8888;
+    lv_tick_set_cb(memfb_tick_cb);
+    lv_display_t* disp = lv_display_create(g_fb.w, g_fb.h);
+    if (!disp) return nullptr;
+    lv_display_set_color_format(disp, g_fb.renderFormat);
+
+    // Two 1/10-screen partial buffers: LVGL renders into one while the other is copied out
+    uint32_t buf_size = lv_draw_buf_width_to_stride(g_fb.w, g_fb.renderFormat) * (g_fb.h / 10 + 1);
+    g_fb.drawBuf[0] = static_cast<uint8_t*>(malloc(buf_size));
+    g_fb.drawBuf[1] = static_cast<uint8_t*>(malloc(buf_size));
+    if (!g_fb.drawBuf[0] || !g_fb.drawBuf[1]) return nullptr;
+    lv_display_set_buffers(disp, g_fb.drawBuf[0], g_fb.drawBuf[1], buf_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(disp, memfb_flush_cb);
+    fprintf(stderr, "[lvgl_port] fb %s %dx%d %d bpp, render %s\n", g_fb.path[0] ? g_fb.path : "(memory)",
+            (int)g_fb.w, (int)g_fb.h, g_fb.bpp,
+            g_fb.renderFormat == LV_COLOR_FORMAT_RGB565 ? "RGB565"
+                : (g_fb.bpp == 32 ? "XRGB8888" : (g_fb.color == LVGL_PORT_COLOR_DITHER ? "XRGB8888 + dither" : "XRGB8888 + convert")));
+    return disp;
+}
+
+static void memfb_release(void) {
+    if (g_fb.mem) {
+        if (g_fb.fd >= 0) munmap(g_fb.mem, g_fb.size);
+        else free(g_fb.mem);
+        g_fb.mem = nullptr;
+    }
+    if (g_fb.fd >= 0) {
+        close(g_fb.fd);
+        g_fb.fd = -1;
+    }
+    for (uint8_t*& buf : g_fb.drawBuf) {
+        free(buf);
+        buf = nullptr;
+    }
+}
+
+extern "C" void lvgl_port_use_fb(const char* path, int32_t w, int32_t h, int bpp, lvgl_port_color_t color) {
+    g_fb.enabled = true;
+    snprintf(g_fb.path, sizeof(g_fb.path), "%s", path ? path : "");
+    g_fb.w = w;
+    g_fb.h = h;
+    g_fb.bpp = bpp;
+    g_fb.color = color;
+}
+
+extern "C" void lvgl_port_fb_stats(uint64_t* flush_ns, uint32_t* flushes, uint64_t* bytes) {
+    if (flush_ns) *flush_ns = g_fb.flushNs;
+    if (flushes) *flushes = g_fb.flushes;
+    if (bytes) *bytes = g_fb.bytes;
+}
+
+static void frame_event_cb(lv_event_t* e) {
+    const uint64_t now = bjj::monotonicNs();
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_RENDER_START:
+            g_frame.renderStart = now;
+            g_frame.flushNs = 0;
+            break;
+        case LV_EVENT_FLUSH_START:
+            g_frame.flushStart = now;
+            break;
+        case LV_EVENT_FLUSH_FINISH:
+            g_frame.flushNs += now - g_frame.flushStart;
+            break;
+        case LV_EVENT_RENDER_READY: {
+            uint64_t total = now - g_frame.renderStart;
+            uint64_t flush = g_frame.flushNs < total ? g_frame.flushNs : total;
+            if (g_frame.cb) g_frame.cb(total - flush, flush);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+extern "C" void lvgl_port_set_frame_cb(lvgl_frame_cb_t cb) {
+    if (!g_disp) return;
+    if (cb && !g_frame.cb) lv_display_add_event_cb(g_disp, frame_event_cb, LV_EVENT_ALL, nullptr);
+    else if (!cb && g_frame.cb) lv_display_remove_event_cb_with_user_data(g_disp, frame_event_cb, nullptr);
+    g_frame.cb = cb;
+}
+
+extern "C" void lvgl_port_set_refresh_period(uint32_t ms) {
+    if (!g_disp) return;
+    if (lv_timer_t* refr = lv_display_get_refr_timer(g_disp)) {
+        lv_timer_set_period(refr, ms);
+        lv_timer_ready(refr);
+    }
+    if (g_indev) {
+        if (lv_timer_t* read = lv_indev_get_read_timer(g_indev)) lv_timer_set_period(read, ms);
+    }
+}
+
+// FBIOBLANK on fd; a driver without blanking gets a black frame instead
+static void fb_blank(int fd, bool blank) {
+    if (ioctl(fd, FBIOBLANK, blank ? FB_BLANK_POWERDOWN : FB_BLANK_UNBLANK) == 0) return;
+    if (blank && g_fb.mem) memset(g_fb.mem, 0, g_fb.size);
+    static bool warned = false;
+    if (!warned) {
+        fprintf(stderr, "[lvgl_port] FBIOBLANK: %s\n", strerror(errno));
+        warned = true;
+    }
 }
 
-static void on_press(bool is_long) {
-    if (is_long) {
-        g_long_press_pending = true;
-        if (g_encoder_cb) g_encoder_cb(0, false, true);
+extern "C" void lvgl_port_set_blank(bool blank) {
+    if (!g_disp) return;
+    if (g_fb.enabled) {
+        if (g_fb.fd >= 0) fb_blank(g_fb.fd, blank);
+        else if (blank && g_fb.mem) memset(g_fb.mem, 0, g_fb.size);
     } else {
-        g_btn_pressed = true;
-        if (g_encoder_cb) g_encoder_cb(0, true, false);
+#if LV_USE_SDL
+        // Black rather than hidden: a hidden window gets no keys to wake it
+        SDL_Renderer* renderer = static_cast<SDL_Renderer*>(lv_sdl_window_get_renderer(g_disp));
+        if (blank && renderer) {
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+            SDL_RenderClear(renderer);
+            SDL_RenderPresent(renderer);
+        }
+#elif LV_USE_LINUX_FBDEV
+        // LVGL's fbdev driver keeps its descriptor to itself
+        int fd = open("/dev/fb0", O_RDWR);
+        if (fd >= 0) {
+            fb_blank(fd, blank);
+            close(fd);
+        }
+#endif
     }
+    g_blank = blank;
+    if (!blank) lv_obj_invalidate(lv_display_get_screen_active(g_disp));
 }
 
 static void encoder_read_cb(lv_indev_t* indev, lv_indev_data_t* data) {
@@ -48,41 +281,47 @@ static void encoder_read_cb(lv_indev_t* indev, lv_indev_data_t* data) {
     data->state = g_btn_pressed.exchange(false) ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
 }
 
-extern "C" int lvgl_port_init(int gpio_handle, lvgl_encoder_cb_t encoder_cb) {
-    g_gpio_handle = gpio_handle;
-    g_encoder_cb = encoder_cb;
-
+extern "C" int lvgl_port_init_display(void) {
     fprintf(stderr, "[lvgl_port] lv_init...\n");
     lv_init();
     fprintf(stderr, "[lvgl_port] lv_init ok\n");
 
+    if (g_fb.enabled) {
+        g_disp = memfb_create();
+        if (!g_disp) {
+            memfb_release();
+            fprintf(stderr, "[lvgl_port] fb create FAILED\n");
+            return -1;
+        }
+    } else {
 #if LV_USE_SDL
-    int32_t win_w = 800;
-    int32_t win_h = 480;
-    SDL_DisplayMode mode;
-    if (SDL_GetCurrentDisplayMode(0, &mode) == 0) {
-        win_w = mode.w;
-        win_h = mode.h;
-    }
-    fprintf(stderr, "[lvgl_port] SDL window create %dx%d...\n", (int)win_w, (int)win_h);
-    g_disp = lv_sdl_window_create(win_w, win_h);
-    if (!g_disp) {
-        fprintf(stderr, "[lvgl_port] SDL create FAILED\n");
-        return -1;
-    }
-    lv_sdl_window_set_title(g_disp, "CATCH JIU JITSU - Timer");
-    lv_sdl_window_set_resizeable(g_disp, true);
-    fprintf(stderr, "[lvgl_port] SDL ok\n");
+        int32_t win_w = 800;
+        int32_t win_h = 480;
+        SDL_DisplayMode mode;
+        if (SDL_GetCurrentDisplayMode(0, &mode) == 0) {
+            win_w = mode.w;
+            win_h = mode.h;
+        }
+        fprintf(stderr, "[lvgl_port] SDL window create %dx%d...\n", (int)win_w, (int)win_h);
+        g_disp = lv_sdl_window_create(win_w, win_h);
+        if (!g_disp) {
+            fprintf(stderr, "[lvgl_port] SDL create FAILED\n");
+            return -1;
+        }
+        lv_sdl_window_set_title(g_disp, "CATCH JIU JITSU - Timer");
+        lv_sdl_window_set_resizeable(g_disp, true);
+        fprintf(stderr, "[lvgl_port] SDL ok\n");
 #elif LV_USE_LINUX_FBDEV
-    fprintf(stderr, "[lvgl_port] fbdev create...\n");
-    g_disp = lv_linux_fbdev_create();
-    if (!g_disp) {
-        fprintf(stderr, "[lvgl_port] fbdev create FAILED\n");
-        return -1;
-    }
-    lv_linux_fbdev_set_file(g_disp, "/dev/fb0");
-    lv_linux_fbdev_set_force_refresh(g_disp, true);
+        fprintf(stderr, "[lvgl_port] fbdev create...\n");
+        g_disp = lv_linux_fbdev_create();
+        if (!g_disp) {
+            fprintf(stderr, "[lvgl_port] fbdev create FAILED\n");
+            return -1;
+        }
+        lv_linux_fbdev_set_file(g_disp, "/dev/fb0");
+        lv_linux_fbdev_set_force_refresh(g_disp, true);
 #endif
+    }
 
     fprintf(stderr, "[lvgl_port] indev create...\n");
     g_indev = lv_indev_create();
@@ -93,21 +332,12 @@ extern "C" int lvgl_port_init(int gpio_handle, lvgl_encoder_cb_t encoder_cb) {
 
     g_group = lv_group_create();
     lv_indev_set_group(g_indev, g_group);
-
-    fprintf(stderr, "[lvgl_port] encoder init...\n");
-    g_encoder = new bjj::RotaryEncoder(on_rotate, on_press);
-    g_encoder->init(gpio_handle);
-    fprintf(stderr, "[lvgl_port] init complete\n");
+    fprintf(stderr, "[lvgl_port] display init complete\n");
 
     return 0;
 }
 
-extern "C" void lvgl_port_deinit(int gpio_handle) {
-    if (g_encoder) {
-        g_encoder->freeGpio(gpio_handle);
-        delete g_encoder;
-        g_encoder = nullptr;
-    }
+extern "C" void lvgl_port_deinit(void) {
     if (g_group) {
         lv_group_delete(g_group);
         g_group = nullptr;
@@ -120,6 +350,7 @@ extern "C" void lvgl_port_deinit(int gpio_handle) {
         lv_display_delete(g_disp);
         g_disp = nullptr;
     }
+    memfb_release();
     lv_deinit();
 }
 
@@ -135,15 +366,81 @@ extern "C" lv_group_t* lvgl_port_get_group(void) {
     return g_group;
 }
 
-extern "C" void lvgl_port_encoder_poll(void) {
-    if (g_encoder) g_encoder->poll();
+extern "C" void lvgl_port_set_sdl_input_cb(lvgl_sdl_input_cb_t cb) {
+    g_sdl_input_cb = cb;
+}
+
+#if LV_USE_SDL
+// One SDL event as virtual-encoder input; false if it is not input
+static bool sdl_input(const SDL_Event& e, int& delta, int& button, bool& long_press, unsigned& select) {
+    switch (e.type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP: {
+            const bool down = e.type == SDL_KEYDOWN;
+            switch (e.key.keysym.sym) {
+                case SDLK_UP: case SDLK_RIGHT:
+                    if (down) delta = 1;  // Held: key repeat keeps turning
+                    return down;
+                case SDLK_DOWN: case SDLK_LEFT:
+                    if (down) delta = -1;
+                    return down;
+                case SDLK_SPACE: case SDLK_RETURN: case SDLK_KP_ENTER:
+                    if (e.key.repeat) return false;
+                    button = down;
+                    return true;
+                case SDLK_ESCAPE:
+                    long_press = down && !e.key.repeat;
+                    return long_press;
+                default:
+                    if (down && e.key.keysym.sym >= SDLK_1 && e.key.keysym.sym <= SDLK_9) {
+                        select = static_cast<unsigned>(e.key.keysym.sym - SDLK_1) + 1;
+                        return true;
+                    }
+                    return false;
+            }
+        }
+        case SDL_MOUSEWHEEL:
+            delta = e.wheel.direction == SDL_MOUSEWHEEL_FLIPPED ? -e.wheel.y : e.wheel.y;
+            return delta != 0;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            if (e.button.button == SDL_BUTTON_LEFT) {
+                button = e.type == SDL_MOUSEBUTTONDOWN;
+                return true;
+            }
+            if (e.button.button == SDL_BUTTON_RIGHT && e.type == SDL_MOUSEBUTTONDOWN) {
+                long_press = true;
+                return true;
+            }
+            return false;
+        default:
+            return false;
+    }
 }
+#endif
 
 extern "C" int lvgl_port_pump_events(void) {
 #if LV_USE_SDL
+    if (g_fb.enabled) return 1;
     SDL_Event e;
+    const uint64_t now_ns = bjj::monotonicNs();
+    const uint32_t now_ticks = SDL_GetTicks();
     while (SDL_PollEvent(&e)) {
         if (e.type == SDL_QUIT) return 0;
+        // Events are drained here before LVGL's SDL driver sees them, so forward resizes;
+        // the UI re-lays itself out from the screen's LV_EVENT_SIZE_CHANGED
+        if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED && g_disp) {
+            lv_display_set_resolution(g_disp, e.window.data1, e.window.data2);
+            if (g_blank) lvgl_port_set_blank(true);
+            continue;
+        }
+        int delta = 0, button = -1;
+        bool long_press = false;
+        unsigned select = 0;
+        if (!g_sdl_input_cb || !sdl_input(e, delta, button, long_press, select)) continue;
+        // Every event type starts with the same timestamp; SDL_GetTicks wraps after 49 days
+        const uint64_t age_ns = static_cast<uint32_t>(now_ticks - e.key.timestamp) * 1000000ULL;
+        g_sdl_input_cb(delta, button, long_press, select, age_ns < now_ns ? now_ns - age_ns : now_ns);
     }
 #endif
     return 1;
@@ -156,11 +453,3 @@ extern "C" void lvgl_port_encoder_add_delta(int delta) {
 extern "C" void lvgl_port_encoder_set_pressed(bool pressed) {
     g_btn_pressed = pressed;
 }
-
-extern "C" bool lvgl_port_encoder_get_long_press_pending(void) {
-    return g_long_press_pending.exchange(false);
-}
-
-extern "C" void lvgl_port_encoder_clear_long_press(void) {
-    g_long_press_pending = false;
-}
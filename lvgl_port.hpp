@@ -1,27 +1,54 @@
 /**
- * LVGL Port - Display + Encoder Input
- * Raspberry Pi: /dev/fb0 + GPIO encoder
+ * LVGL Port - Display
+ * Raspberry Pi: /dev/fb0, desktop: an SDL window. The app polls the GPIO
+ * encoders itself and feeds mat 1's knob to LVGL's focus group through
+ * lvgl_port_encoder_add_delta/set_pressed.
  */
 
 #pragma once
 
-#include "hardware.hpp"
 #include <lvgl.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Encoder event callback: void fn(int delta, bool pressed, bool long_press)
-typedef void (*lvgl_encoder_cb_t)(int delta, bool pressed, bool long_press);
+// How a 16 bpp framebuffer is fed (32 bpp targets always render XRGB8888)
+typedef enum {
+    LVGL_PORT_COLOR_NATIVE = 0,  // Render RGB565 directly, flush is a plain copy
+    LVGL_PORT_COLOR_CONVERT,     // Render XRGB8888, convert on every flush
+    LVGL_PORT_COLOR_DITHER,      // Render XRGB8888, convert with 4x4 ordered dithering
+} lvgl_port_color_t;
 
-// Initialize display (framebuffer) and input (encoder)
-// encoder_cb: called with delta/pressed/long_press - can drive timer logic
+// Use the built-in framebuffer back end instead of SDL. Call before init.
+// path: "/dev/fbN" (size and depth read from the device), or NULL for an
+// in-memory w x h x bpp framebuffer (headless runs, benchmarks).
+void lvgl_port_use_fb(const char* path, int32_t w, int32_t h, int bpp, lvgl_port_color_t color);
+
+// Framebuffer back end flush totals since init
+void lvgl_port_fb_stats(uint64_t* flush_ns, uint32_t* flushes, uint64_t* bytes);
+
+// Called after every refresh that drew something, any back end: time spent
+// rendering and time spent in the flush callback(s). Set after init.
+typedef void (*lvgl_frame_cb_t)(uint64_t render_ns, uint64_t flush_ns);
+void lvgl_port_set_frame_cb(lvgl_frame_cb_t cb);
+
+// Display refresh and encoder read period, ms. Takes effect immediately:
+// the next refresh is due now. Set after init.
+void lvgl_port_set_refresh_period(uint32_t ms);
+
+// Turn the display off (FBIOBLANK on a framebuffer; the SDL window goes black
+// but keeps keyboard focus) or back on; unblanking redraws the whole screen.
+// Stopping LVGL's timers while blank is up to the caller.
+void lvgl_port_set_blank(bool blank);
+
+// Initialize the display and LVGL's encoder input device; no GPIO needed.
 // Returns 0 on success
-int lvgl_port_init(int gpio_handle, lvgl_encoder_cb_t encoder_cb);
+int lvgl_port_init_display(void);
 
 // Cleanup
-void lvgl_port_deinit(int gpio_handle);
+void lvgl_port_deinit(void);
 
 // Get LVGL display (for UI)
 lv_display_t* lvgl_port_get_display(void);
@@ -32,22 +59,24 @@ lv_indev_t* lvgl_port_get_indev(void);
 // Get group for encoder focus (add widgets to this)
 lv_group_t* lvgl_port_get_group(void);
 
-// Must be called every main loop - polls GPIO encoder into LVGL
-void lvgl_port_encoder_poll(void);
-
 // Pump SDL events (when using SDL). Returns 0 if app should quit.
 int lvgl_port_pump_events(void);
 
-// Set encoder delta (from hardware callback)
+// SDL keyboard and mouse as a virtual encoder, one call per event from
+// lvgl_port_pump_events. delta: arrow keys (up/right +1) and wheel notches.
+// button: the knob's button level from space, enter or the left mouse button
+// (1 down, 0 up, -1 unchanged). long_press: escape or the right mouse button.
+// select: digit keys 1-9, else 0. stamp_ns: when SDL queued the event, on the
+// monotonic clock (millisecond resolution).
+typedef void (*lvgl_sdl_input_cb_t)(int delta, int button, bool long_press, unsigned select, uint64_t stamp_ns);
+void lvgl_port_set_sdl_input_cb(lvgl_sdl_input_cb_t cb);
+
+// Set encoder delta (from the app's encoder poll)
 void lvgl_port_encoder_add_delta(int delta);
 
 // Set button state for LVGL (short press = click)
 void lvgl_port_encoder_set_pressed(bool pressed);
 
-// Long press - not fed to LVGL, handled by app
-bool lvgl_port_encoder_get_long_press_pending(void);
-void lvgl_port_encoder_clear_long_press(void);
-
 #ifdef __cplusplus
 }
 #endif
@@ -6,7 +6,24 @@
  */
 
 #include "hardware.hpp"
+#include "alloc_track.hpp"
 #include "timer_logic.hpp"
+#include "checkpoint.hpp"
+#include "audio.hpp"
+#include "control_server.hpp"
+#include "history_log.hpp"
+#include "http_server.hpp"
+#include "input_replay.hpp"
+#include "mat_host.hpp"
+#include "pcm_audio.hpp"
+#include "perf_hud.hpp"
+#include "perf_trace.hpp"
+#include "rotation.hpp"
+#include "session_sync.hpp"
+#include "stall_watchdog.hpp"
+#include "state_export.hpp"
+#include "text_list.hpp"
+#include "tournament.hpp"
 #include <iostream>
 #include <iomanip>
 #include <thread>
@@ -14,6 +31,10 @@
 #include <atomic>
 #include <mutex>
 #include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <string>
 
 using namespace bjj;
@@ -65,20 +86,40 @@ static const char* LED_COLON[] = {"   ", " █ ", "   ", " █ ", "   ", " █ "
 // GLOBAL STATE
 // ============================================================================
 static std::atomic<bool> g_running{true};
-static std::atomic<int> g_rotateDelta{0};
-static std::atomic<bool> g_shortPress{false};
-static std::atomic<bool> g_longPress{false};
 static std::mutex g_displayMutex;
-static Buzzer* g_buzzer = nullptr;
-static TimerLogic* g_timer = nullptr;
 static int g_gpioHandle = -1;
+static bool g_boardDirty = true;
 
-void onRotate(int delta) { g_rotateDelta += delta; }
-void onPress(bool isLong) { isLong ? (void)(g_longPress = true) : (void)(g_shortPress = true); }
+// Per-mat input source and output sinks
+struct MatIO {
+    MatHardware hw;
+    std::unique_ptr<RotaryEncoder> encoder;
+    std::unique_ptr<CuePlayer> cues;
+    Checkpoint checkpoint;
+};
+static MatIO g_io[MAX_MATS];
+static StateExport g_export;
+static ControlServer g_control;
+static HttpServer g_http;
+static SyncLeader g_lead;
+static SyncFollower g_follower;
+static HistoryLog g_history;
+static InputRecorder g_recorder;
+static PcmCuePlayer g_pcm;
+static MatRotation g_rotation[MAX_MATS];
+static Tournament g_tournament;
+static TextList g_pairs;                  // Mat 1's partner list or match, refreshed when it changes
+static const char* g_pairsTitle = "";
+static char g_matchLine[MAX_MATS][64];    // Board: each mat's tournament match
+static PerfHud g_hud;
 
 // ============================================================================
 // RENDER LED CLOCK
 // ============================================================================
+// Padding and box rules written in place: a frame builds no strings
+static void spaces(int n) { for (; n > 0; --n) std::cout << ' '; }
+static void rule(int n) { for (; n > 0; --n) std::cout << "─"; }
+
 void renderClock(unsigned sec, const char* color, std::ostream& out) {
     unsigned m = sec / 60, s = sec % 60;
     int d[] = { static_cast<int>(m/10), static_cast<int>(m%10), static_cast<int>(s/10), static_cast<int>(s%10) };
@@ -94,49 +135,107 @@ void renderClock(unsigned sec, const char* color, std::ostream& out) {
     out << ansi::R;
 }
 
+// Under the clock (single-mat view): pairings in two columns, a match in one
+void renderPairings() {
+    if (g_pairs.empty()) return;
+    std::cout << "\n  " << ansi::YELLOW << ansi::BOLD << g_pairsTitle << ansi::R << "\n";
+    const unsigned rows = g_pairs.size() > 2 ? (g_pairs.size() + 1) / 2 : g_pairs.size();
+    for (unsigned i = 0; i < rows; ++i) {
+        std::cout << "  " << std::left << std::setw(26) << g_pairs[i] << std::right;
+        if (i + rows < g_pairs.size()) std::cout << g_pairs[i + rows];
+        std::cout << "\n";
+    }
+}
+
+// Last lines of every frame, so the rest of the screen does not move
+void renderHud() {
+    if (!g_hud.enabled() || !g_hud.text()[0]) return;
+    std::cout << "\n" << ansi::DIM;
+    for (const char* p = g_hud.text(); *p; ++p) {
+        if (*p == '\n') std::cout << "\n";
+        else {
+            if (p == g_hud.text() || p[-1] == '\n') std::cout << "  ";
+            std::cout << *p;
+        }
+    }
+    std::cout << ansi::R << "\n";
+}
+
 // ============================================================================
 // PROFESSIONAL DISPLAY
 // ============================================================================
 void renderDisplay(const DisplayInfo& info) {
     std::lock_guard<std::mutex> lock(g_displayMutex);
+    const uint64_t t0 = monotonicNs();
     ansi::clear();
     
     const int W = 52;
-    auto line = [W](const std::string& s, int visibleLen = -1) {
-        int v = visibleLen >= 0 ? visibleLen : static_cast<int>(s.size());
+    auto line = [W](const char* s, int visibleLen = -1) {
+        int v = visibleLen >= 0 ? visibleLen : static_cast<int>(std::strlen(s));
         int left = (W - 2 - v) / 2;
         int right = W - 2 - v - left;
         std::cout << " " << ansi::GRAY << "│" << ansi::R;
-        std::cout << std::string(std::max(0, left), ' ') << s << std::string(std::max(0, right), ' ');
+        spaces(left);
+        std::cout << s;
+        spaces(right);
         std::cout << ansi::GRAY << "│" << ansi::R << "\n";
     };
+    auto styled = [&](const char* style, const char* s, int visibleLen = -1) {
+        char buf[160];
+        snprintf(buf, sizeof(buf), "%s%s%s", style, s, ansi::R);
+        line(buf, visibleLen >= 0 ? visibleLen : static_cast<int>(std::strlen(s)));
+    };
     
     auto boxTop = [W]() {
-        std::cout << " " << ansi::GRAY << "┌" << std::string(W-2, '─') << "┐" << ansi::R << "\n";
+        std::cout << " " << ansi::GRAY << "┌";
+        rule(W-2);
+        std::cout << "┐" << ansi::R << "\n";
     };
     auto footer = [W]() {
-        std::cout << " " << ansi::GRAY << "└" << std::string(W-2, '─') << "┘" << ansi::R << "\n";
+        std::cout << " " << ansi::GRAY << "└";
+        rule(W-2);
+        std::cout << "┘" << ansi::R << "\n";
+    };
+    // Competition score under the clock, leader in bold
+    auto score = [&]() {
+        if (!info.scoring) return;
+        char side[2][24];
+        const int leader = info.score.leader();
+        for (unsigned a = 0; a < 2; ++a) {
+            snprintf(side[a], sizeof(side[a]), "%u  A%u P%u", info.score.points[a],
+                     info.score.advantages[a], info.score.penalties[a]);
+        }
+        char s[96];
+        snprintf(s, sizeof(s), "%s%s%s   ·   %s%s%s", leader == 0 ? ansi::BOLD : "", side[0], ansi::R,
+                 leader == 1 ? ansi::BOLD : "", side[1], ansi::R);
+        line("");
+        line(s, static_cast<int>(std::strlen(side[0]) + std::strlen(side[1]) + 7));
     };
     
     // Header
-    std::cout << "\n ";
-    std::cout << ansi::GRAY << "┌" << std::string(W-2, '─') << "┐" << ansi::R << "\n";
+    std::cout << "\n";
+    boxTop();
     std::cout << " " << ansi::GRAY << "│" << ansi::R;
-    std::cout << std::string((W-18)/2, ' ') << ansi::BOLD << ansi::WHITE << "BJJ GYM TIMER" << ansi::R;
-    std::cout << std::string(W-18-(W-18)/2, ' ') << ansi::GRAY << "│" << ansi::R << "\n";
-    std::cout << " " << ansi::GRAY << "└" << std::string(W-2, '─') << "┘" << ansi::R << "\n\n";
+    spaces((W-18)/2);
+    std::cout << ansi::BOLD << ansi::WHITE << "BJJ GYM TIMER" << ansi::R;
+    spaces(W-18-(W-18)/2);
+    std::cout << ansi::GRAY << "│" << ansi::R << "\n";
+    footer();
+    std::cout << "\n";
     
     boxTop();
     switch (info.state) {
         case TimerState::MENU: {
             line("");
-            line(std::string(ansi::DIM) + "Rotate to select  ·  Press to confirm" + ansi::R, 37);
+            styled(ansi::DIM, "Rotate to select  ·  Press to confirm", 37);
             line("");
-            std::string mode = "  " + info.menuLabel + "  ";
+            char mode[LABEL_MAX + 4];
+            snprintf(mode, sizeof(mode), "  %s  ", info.menuLabel);
+            const int mw = static_cast<int>(std::strlen(mode));
             std::cout << " " << ansi::GRAY << "│" << ansi::R;
-            std::cout << std::string((W-2-static_cast<int>(mode.size()))/2, ' ');
+            spaces((W-2-mw)/2);
             std::cout << ansi::BLUE << ansi::BOLD << ansi::INV << mode << ansi::R;
-            std::cout << std::string(W-2-static_cast<int>(mode.size())-(W-2-static_cast<int>(mode.size()))/2, ' ');
+            spaces(W-2-mw-(W-2-mw)/2);
             std::cout << ansi::GRAY << "│" << ansi::R << "\n";
             line("");
             footer();
@@ -147,20 +246,20 @@ void renderDisplay(const DisplayInfo& info) {
         case TimerState::SETUP_REST:
         case TimerState::SETUP_ROUNDS: {
             line("");
-            std::string title;
+            const char* title;
             if (info.state == TimerState::SETUP_WORK) title = "ROUND TIME";
             else if (info.state == TimerState::SETUP_REST) title = "REST TIME";
             else title = (info.mode == TimerMode::DRILLING) ? "INTERVAL PER PERSON" : "NUMBER OF ROUNDS";
             
-            line(std::string(ansi::GRAY) + title + ansi::R, static_cast<int>(title.size()));
+            styled(ansi::GRAY, title);
             line("");
-            line(std::string(ansi::DIM) + "Rotate: change  ·  Press: next  ·  Hold: menu" + ansi::R, 42);
+            styled(ansi::DIM, "Rotate: change  ·  Press: next  ·  Hold: menu", 42);
             line("");
             std::cout << " " << ansi::GRAY << "│" << ansi::R;
-            int vw = static_cast<int>(info.valueLabel.size());
-            std::cout << std::string((W-2-vw)/2, ' ');
+            int vw = static_cast<int>(std::strlen(info.valueLabel));
+            spaces((W-2-vw)/2);
             std::cout << ansi::GREEN << ansi::BOLD << info.valueLabel << ansi::R;
-            std::cout << std::string(W-2-vw-(W-2-vw)/2, ' ');
+            spaces(W-2-vw-(W-2-vw)/2);
             std::cout << ansi::GRAY << "│" << ansi::R << "\n";
             line("");
             footer();
@@ -170,20 +269,32 @@ void renderDisplay(const DisplayInfo& info) {
         case TimerState::PAUSED: {
             line("");
             std::cout << " " << ansi::GRAY << "│" << ansi::R;
-            std::cout << std::string((W-14)/2, ' ') << ansi::RED << ansi::BOLD << "  PAUSED  " << ansi::R;
-            std::cout << std::string(W-14-(W-14)/2, ' ') << ansi::GRAY << "│" << ansi::R << "\n";
+            spaces((W-14)/2);
+            std::cout << ansi::RED << ansi::BOLD << "  PAUSED  " << ansi::R;
+            spaces(W-14-(W-14)/2);
+            std::cout << ansi::GRAY << "│" << ansi::R << "\n";
             line("");
             std::cout << "\n";
             renderClock(info.secondsRemaining, ansi::RED, std::cout);
+            score();
             line("");
-            line(std::string(ansi::DIM) + "Press: resume  ·  Hold 2 sec: menu" + ansi::R, 33);
+            if (info.scoring) {
+                char action[LABEL_MAX + 16];
+                snprintf(action, sizeof(action), "%s%s", ansi::YELLOW, ansi::BOLD);
+                styled(action, info.valueLabel);
+                styled(ansi::DIM, "Rotate: score  ·  Press: apply  ·  Hold: menu", 42);
+            } else {
+                styled(ansi::DIM, "Press: resume  ·  Hold 2 sec: menu", 33);
+            }
             footer();
+            renderPairings();
             break;
         }
         
         case TimerState::RUNNING:
         case TimerState::FINISHED: {
-            std::string phaseTag, phaseColor;
+            const char* phaseTag;
+            const char* phaseColor;
             if (info.phase == Phase::WORK) {
                 phaseTag = " WORK "; phaseColor = ansi::GREEN;
             } else if (info.phase == Phase::REST) {
@@ -192,53 +303,157 @@ void renderDisplay(const DisplayInfo& info) {
                 phaseTag = " SWITCH "; phaseColor = ansi::CYAN;
             }
             
-            std::string roundInfo;
+            char roundInfo[32];
             if (info.totalRounds > 1) {
-                roundInfo = "Round " + std::to_string(info.currentRound) + "/" + std::to_string(info.totalRounds);
+                snprintf(roundInfo, sizeof(roundInfo), "Round %u/%u", info.currentRound, info.totalRounds);
             } else if (info.totalRounds == 1) {
-                roundInfo = "COMPETITION";
+                snprintf(roundInfo, sizeof(roundInfo), "COMPETITION");
             } else {
-                roundInfo = "DRILLING";
+                snprintf(roundInfo, sizeof(roundInfo), "DRILLING");
             }
             
             std::cout << " " << ansi::GRAY << "│" << ansi::R;
-            int rw = static_cast<int>(roundInfo.size()), pw = static_cast<int>(phaseTag.size());
-            std::cout << std::string((W-2-rw-pw-2)/2, ' ');
+            int rw = static_cast<int>(std::strlen(roundInfo)), pw = static_cast<int>(std::strlen(phaseTag));
+            spaces((W-2-rw-pw-2)/2);
             std::cout << ansi::WHITE << roundInfo << ansi::R << "  ";
             std::cout << phaseColor << ansi::BOLD << phaseTag << ansi::R;
-            std::cout << std::string(W-2-rw-pw-2-(W-2-rw-pw-2)/2, ' ');
+            spaces(W-2-rw-pw-2-(W-2-rw-pw-2)/2);
             std::cout << ansi::GRAY << "│" << ansi::R << "\n";
             line("");
             
             const char* clockColor = (info.secondsRemaining <= 10 && info.phase != Phase::REST) ? ansi::RED : ansi::GREEN;
             renderClock(info.secondsRemaining, clockColor, std::cout);
+            score();
             
             if (info.state == TimerState::FINISHED) {
                 line("");
                 std::cout << " " << ansi::GRAY << "│" << ansi::R;
-                std::cout << std::string((W-20)/2, ' ') << ansi::GREEN << ansi::BOLD << " MATCH COMPLETE " << ansi::R;
-                std::cout << std::string(W-20-(W-20)/2, ' ') << ansi::GRAY << "│" << ansi::R << "\n";
+                spaces((W-20)/2);
+                std::cout << ansi::GREEN << ansi::BOLD << " MATCH COMPLETE " << ansi::R;
+                spaces(W-20-(W-20)/2);
+                std::cout << ansi::GRAY << "│" << ansi::R << "\n";
             } else {
-                line(std::string(ansi::DIM) + "Rotate: ±30s  ·  Press: pause  ·  Hold: reset" + ansi::R, 41);
+                styled(ansi::DIM, "Rotate: ±30s  ·  Press: pause  ·  Hold: reset", 41);
             }
             footer();
+            renderPairings();
             break;
         }
     }
     
+    renderHud();
+    const uint64_t t1 = monotonicNs();
+    std::cout << std::flush;
+    g_hud.frame(t1 - t0, monotonicNs() - t1);
+}
+
+// ============================================================================
+// MULTI-MAT BOARD (one row per mat)
+// ============================================================================
+void renderBoard(const DisplayInfo* board, unsigned count) {
+    std::lock_guard<std::mutex> lock(g_displayMutex);
+    const uint64_t t0 = monotonicNs();
+    ansi::clear();
+    std::cout << "\n " << ansi::BOLD << ansi::WHITE << "BJJ GYM TIMER" << ansi::R
+              << ansi::GRAY << "  ·  " << count << " mats" << ansi::R << "\n\n";
+    
+    for (unsigned i = 0; i < count; ++i) {
+        const DisplayInfo& info = board[i];
+        char line[96];
+        const char* color = ansi::GRAY;
+        switch (info.state) {
+            case TimerState::MENU:
+                snprintf(line, sizeof(line), "%-12s select mode", info.menuLabel);
+                break;
+            case TimerState::SETUP_WORK:
+            case TimerState::SETUP_REST:
+            case TimerState::SETUP_ROUNDS:
+                snprintf(line, sizeof(line), "%-12s setup %s", info.menuLabel, info.valueLabel);
+                break;
+            default: {
+                const char* phase = info.phase == Phase::REST ? "REST" : "WORK";
+                if (info.state == TimerState::PAUSED) phase = "PAUSED";
+                else if (info.state == TimerState::FINISHED) phase = "DONE";
+                color = (info.state == TimerState::PAUSED || info.phase == Phase::REST) ? ansi::RED : ansi::GREEN;
+                snprintf(line, sizeof(line), "%-12s R%u/%u  %-6s  %02u:%02u", info.menuLabel,
+                         info.currentRound, info.totalRounds, phase,
+                         info.secondsRemaining / 60, info.secondsRemaining % 60);
+                if (info.scoring) {
+                    size_t n = strlen(line);
+                    snprintf(line + n, sizeof(line) - n, "  %u-%u", info.score.points[0], info.score.points[1]);
+                }
+                break;
+            }
+        }
+        std::cout << "  " << ansi::GRAY << "MAT " << std::setw(2) << (i + 1) << " │ " << ansi::R
+                  << color << line << ansi::R;
+        if (g_matchLine[i][0]) std::cout << "  " << ansi::GRAY << g_matchLine[i] << ansi::R;
+        std::cout << "\n";
+    }
+    renderHud();
+    const uint64_t t1 = monotonicNs();
     std::cout << std::flush;
+    g_hud.frame(t1 - t0, monotonicNs() - t1);
 }
 
 // ============================================================================
-// DISPLAY + AUDIO
+// HOST SINKS - display + audio + checkpoint + history per mat
 // ============================================================================
-void onDisplayEvent(const DisplayInfo& info) {
-    renderDisplay(info);
-    if (!g_buzzer || g_gpioHandle < 0) return;
-    if (info.roundStartDue)      g_buzzer->playStartRound(g_gpioHandle);
-    if (info.tenSecondWarningDue) g_buzzer->play10SecondWarning(g_gpioHandle);
-    if (info.roundEndDue)        g_buzzer->playEndRound(g_gpioHandle);
-    if (info.switchDue)          g_buzzer->playDrillingSwitch(g_gpioHandle);
+// Refresh what a mat lists: its tournament match, else (mat 1) partner pairings
+void showList(unsigned mat) {
+    if (g_tournament.active()) {
+        static TextList lines;
+        g_tournament.describe(mat, lines);
+        snprintf(g_matchLine[mat], sizeof(g_matchLine[mat]), "%s", lines.empty() ? "" : lines[0]);
+        g_boardDirty = true;
+        if (mat == 0) {
+            g_pairs = lines;
+            g_pairsTitle = g_tournament.title(0);
+        }
+    } else if (mat == 0) {
+        g_rotation[0].describe(g_pairs);
+        g_pairsTitle = g_rotation[0].title();
+    }
+}
+
+void onMatDisplay(void* ctx, unsigned mat, const DisplayInfo& info) {
+    const MatHost& host = *static_cast<const MatHost*>(ctx);
+    g_export.publish(mat, info, host.nextTickMs(mat), host.nowMs());
+    g_control.notify(mat, info);
+    g_http.notify(mat, info);
+    g_lead.publish(host, mat);
+    if (host.size() == 1) renderDisplay(info);
+    else g_boardDirty = true;
+}
+
+void onMatCues(void* ctx, unsigned mat, uint8_t cues) {
+    if (g_pcm.isRunning()) g_pcm.play(mat, cues);
+    else if (g_io[mat].cues) g_io[mat].cues->play(cues);
+    g_export.countCues(mat, cues);
+    // Drilling rotates partners on every second switch, after the display update
+    const MatHost& host = *static_cast<const MatHost*>(ctx);
+    if (g_rotation[mat].onCues(cues) && mat == 0) {
+        showList(0);
+        if (host.size() == 1) renderDisplay(host.timer(0).getDisplayInfo());
+    }
+}
+
+void onMatCueSchedule(void*, unsigned mat, uint64_t deadlineMs, uint8_t cues) {
+    if (g_pcm.isRunning()) g_pcm.arm(mat, deadlineMs, cues);
+    else if (g_io[mat].cues) g_io[mat].cues->arm(deadlineMs, cues);
+}
+
+void onMatTransition(void* ctx, unsigned mat, const TimerSnapshot& snap) {
+    const MatHost& host = *static_cast<const MatHost*>(ctx);
+    g_io[mat].checkpoint.save(snap, host.untilTickMs(mat));
+    g_history.record(mat, snap, cueMask(host.timer(mat).getDisplayInfo()));
+    bool listChanged = g_rotation[mat].onTransition(snap);
+    listChanged |= g_tournament.onTransition(mat, snap, host.nowMs());
+    if (listChanged) showList(mat);
+}
+
+bool onMatchResult(void* ctx, unsigned mat, unsigned winner) {
+    return g_tournament.result(*static_cast<MatHost*>(ctx), mat, winner);
 }
 
 void signalHandler(int) { g_running = false; }
@@ -247,6 +462,86 @@ void signalHandler(int) { g_running = false; }
 // MAIN
 // ============================================================================
 int main(int argc, char* argv[]) {
+    std::string checkpointPath = Checkpoint::defaultPath();
+    bool resume = true;
+    std::string historyPath = HistoryLog::defaultPath();
+    std::string shmName = StateExport::defaultName();
+    bool control = false;
+    std::string httpSpec;
+    std::string leadSpec, followSpec;
+    std::string recordPath;
+    std::string audioDevice, sampleDir;
+    std::string rosterPaths[MAX_MATS];
+    RotationRules rotationRules;
+    std::string tournamentPath;
+    TournamentRules tournamentRules;
+    double clockSkewPpm = 0;
+    long clockOffsetMs = 0;
+    unsigned matCount = 1;
+    bool allocReport = false;
+    RotateConfig rotateConfig;
+    WatchdogConfig watchdogConfig;
+    g_io[0].hw.hasEncoder = true;  // Mat 1 uses the default pins
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--checkpoint") && i + 1 < argc) checkpointPath = argv[++i];
+        else if (!strcmp(argv[i], "--no-resume")) resume = false;
+        else if (!strcmp(argv[i], "--history") && i + 1 < argc) historyPath = argv[++i];
+        else if (!strcmp(argv[i], "--no-history")) historyPath.clear();
+        else if (!strcmp(argv[i], "--record") && i + 1 < argc) recordPath = argv[++i];
+        else if (!strcmp(argv[i], "--audio") && i + 1 < argc) audioDevice = argv[++i];
+        else if (!strcmp(argv[i], "--audio-samples") && i + 1 < argc) sampleDir = argv[++i];
+        else if (!strcmp(argv[i], "--roster") && i + 1 < argc) {
+            std::string path;
+            int mat = parseRosterSpec(argv[++i], path);
+            if (mat < 0) {
+                std::cerr << "Bad --roster spec: " << argv[i] << " (want [N:]PATH)\n";
+                return 1;
+            }
+            rosterPaths[mat] = path;
+        }
+        else if (!strcmp(argv[i], "--weight-gap") && i + 1 < argc) rotationRules.maxWeightGapKg = std::strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--belt-gap") && i + 1 < argc) rotationRules.maxBeltGap = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--tournament") && i + 1 < argc) tournamentPath = argv[++i];
+        else if (!strcmp(argv[i], "--rest-gap") && i + 1 < argc) tournamentRules.restGapSec = std::strtoul(argv[++i], nullptr, 10) * 60;
+        else if (!strcmp(argv[i], "--shm") && i + 1 < argc) shmName = argv[++i];
+        else if (!strcmp(argv[i], "--no-shm")) shmName.clear();
+        else if (!strcmp(argv[i], "--control")) control = true;
+        else if (!strcmp(argv[i], "--http") && i + 1 < argc) httpSpec = argv[++i];
+        else if (!strcmp(argv[i], "--lead") && i + 1 < argc) leadSpec = argv[++i];
+        else if (!strcmp(argv[i], "--follow") && i + 1 < argc) followSpec = argv[++i];
+        else if (!strcmp(argv[i], "--clock-skew") && i + 1 < argc) clockSkewPpm = std::strtod(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--clock-offset") && i + 1 < argc) clockOffsetMs = std::strtol(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--hud")) g_hud.setEnabled(true);
+        else if (!strcmp(argv[i], "--accel") && i + 1 < argc) {
+            if (!parseAccelSpec(argv[++i], rotateConfig)) {
+                std::cerr << "Bad --accel spec: " << argv[i] << " (want SETTING:SLOW,FAST,MAX or off)\n";
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--stall-ms") && i + 1 < argc) watchdogConfig.stallMs = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--notify-ms") && i + 1 < argc) watchdogConfig.notifyMs = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--alloc-strict") && i + 1 < argc) {
+            AllocStrict mode;
+            if (!parseAllocStrict(argv[++i], mode)) {
+                std::cerr << "Bad --alloc-strict mode: " << argv[i] << " (want log, abort or off)\n";
+                return 1;
+            }
+            setAllocStrict(mode);
+        }
+        else if (!strcmp(argv[i], "--alloc-report")) allocReport = true;
+        else if (!strcmp(argv[i], "--mats") && i + 1 < argc) matCount = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--mat") && i + 1 < argc) {
+            MatHardware hw;
+            int mat = parseMatSpec(argv[++i], hw);
+            if (mat >= 0) {
+                g_io[mat].hw = hw;
+            } else {
+                std::cerr << "Bad --mat spec: " << argv[i] << " (want N:CLK,DT,SW,BUZZER)\n";
+                return 1;
+            }
+        }
+    }
+    
     std::cout << "BJJ Gym Timer - Initializing...\n";
     
     int h = lgGpiochipOpen(4);
@@ -257,51 +552,250 @@ int main(int argc, char* argv[]) {
     }
     g_gpioHandle = h;
     
-    Buzzer buzzer;
-    buzzer.init(h);
-    g_buzzer = &buzzer;
+    MatHost host(matCount, monotonicMs());
+    host.setRotateConfig(rotateConfig);
+    if (!recordPath.empty() && g_recorder.open(recordPath, host)) {
+        std::cout << "Recording input to " << recordPath << "\n";
+    }
+    if (!audioDevice.empty() && g_pcm.start(audioDevice, sampleDir)) {
+        std::cout << "Audio cues: " << audioDevice << " (" << g_pcm.stats().periodFrames << "-frame periods)\n";
+    }
+    host.setDisplaySink(onMatDisplay, &host);
+    host.setCueSink(onMatCues, &host);
+    host.setCueScheduleSink(onMatCueSchedule, nullptr);
+    
+    for (unsigned i = 0; i < host.size(); ++i) {
+        MatIO& io = g_io[i];
+        if (io.hw.hasEncoder) {
+            io.cues.reset(new CuePlayer(io.hw.buzzerPin));
+            io.cues->start(h);
+            io.encoder.reset(new RotaryEncoder(io.hw.pins));
+            io.encoder->init(h);
+            io.encoder->attachInterrupts();
+        }
+        std::string path = i == 0 ? checkpointPath : checkpointPath + "." + std::to_string(i + 1);
+        if (io.checkpoint.open(path)) {
+            TimerSnapshot snap;
+            unsigned elapsed = 0;
+            uint32_t firstTickMs = 0;
+            if (resume && io.checkpoint.load(snap, elapsed, firstTickMs)) {
+                host.timer(i).restore(snap, elapsed);
+                host.alignTick(i, firstTickMs);
+                g_recorder.restore(i, snap, elapsed, firstTickMs);
+            }
+        }
+    }
+    if (!historyPath.empty()) g_history.open(historyPath);
+    host.setTransitionSink(onMatTransition, &host);
+    for (unsigned i = 0; i < host.size(); ++i) {
+        if (rosterPaths[i].empty() || !g_rotation[i].engine().loadRoster(rosterPaths[i])) continue;
+        g_rotation[i].engine().setRules(rotationRules);
+        std::cout << "Mat " << i + 1 << " roster: " << g_rotation[i].engine().roster().size() << " athletes\n";
+        // A resumed session picks up its pairings where it left off
+        if (g_rotation[i].onTransition(host.timer(i).snapshot()) && i == 0) showList(0);
+    }
+    if (!tournamentPath.empty() && g_tournament.load(tournamentPath, host.size(), tournamentRules, host.nowMs())) {
+        setMatchResultSink(onMatchResult, &host);
+        TournamentStats st = g_tournament.stats();
+        std::cout << "Tournament: " << g_tournament.divisions().size() << " divisions, " << st.matches
+                  << " matches (" << st.done << " decided), planned to end in " << st.projectedEndSec / 60 << " min\n";
+    }
     
-    TimerLogic timer;
-    g_timer = &timer;
-    timer.setEventCallback(onDisplayEvent);
+    if (!shmName.empty() && g_export.open(shmName, host.size())) {
+        for (unsigned i = 0; i < host.size(); ++i) {
+            g_export.publish(i, host.timer(i).getDisplayInfo(), host.nextTickMs(i), host.nowMs());
+        }
+    }
     
-    RotaryEncoder encoder(onRotate, onPress);
-    encoder.init(h);
-    encoder.attachInterrupts();
+    if (control && g_control.start(ControlServer::defaultPath(), host.size())) {
+        std::cout << "Control socket: " << ControlServer::defaultPath() << "\n";
+    }
+    if (!httpSpec.empty() && g_http.start(httpSpec, host.size())) {
+        std::cout << "Dashboard: " << httpSpec << "\n";
+    }
+    if (!leadSpec.empty() && g_lead.start(leadSpec, host.size())) {
+        for (unsigned i = 0; i < host.size(); ++i) g_lead.publish(host, i);
+        std::cout << "Leading followers on " << leadSpec << "\n";
+    }
+    if (!followSpec.empty() && g_follower.start(followSpec, host.size(), clockSkewPpm, clockOffsetMs)) {
+        std::cout << "Following " << followSpec << "\n";
+    }
     
     signal(SIGINT, signalHandler);
     ansi::hideCur();
     
-    onDisplayEvent(timer.getDisplayInfo());
-    
-    auto lastTick = std::chrono::steady_clock::now();
-    auto lastDisplay = lastTick;
+    auto lastDisplay = std::chrono::steady_clock::now();
+    if (host.size() == 1) renderDisplay(host.timer(0).getDisplayInfo());
     
+    DisplayInfo board[MAX_MATS];
+    uint64_t lastSyncReport = monotonicMs();
+    TraceRing trace;
+    StallWatchdog watchdog;
+    const bool watchdogOn = watchdog.start(watchdogConfig, &trace);
+    // From here on every path runs out of buffers sized above
+    setAllocPhase(AllocPhase::STEADY);
     while (g_running) {
+        watchdog.beat();
+        trace.mark("input");
         auto now = std::chrono::steady_clock::now();
-        encoder.poll();
-        
-        int delta = g_rotateDelta.exchange(0);
-        if (delta != 0) timer.onRotate(delta);
-        if (g_shortPress.exchange(false)) timer.onShortPress();
-        if (g_longPress.exchange(false)) timer.onLongPress();
+        g_hud.wakeup();
+        const bool hudChanged = g_hud.update(host, monotonicMs());
+        if (g_follower.isRunning()) {
+            // Display only: the leader's timeline drives every mat, local input is ignored
+            bool dirty = false;
+            for (unsigned i = 0; i < host.size(); ++i) dirty |= g_follower.changed(i, board[i]);
+            if (dirty || hudChanged) {
+                if (host.size() == 1) renderDisplay(board[0]);
+                else renderBoard(board, host.size());
+            }
+            if ((clockSkewPpm != 0 || clockOffsetMs != 0) && monotonicMs() - lastSyncReport >= 5000) {
+                lastSyncReport = monotonicMs();
+                SyncFollowerStats st = g_follower.stats();
+                std::cerr << "sync: skew " << st.skewPpm << " ppm, delay " << st.delayUs << " us, clock error "
+                          << st.errorUs << " us (max " << st.maxErrorUs << ")\n";
+            }
+            trace.mark("sleep");
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        for (unsigned i = 0; i < host.size(); ++i) {
+            if (!g_io[i].encoder) continue;
+            g_io[i].encoder->setPolicy(host.gesturePolicy(i));
+            EncoderEvents ev = g_io[i].encoder->pollEvents();
+            host.postInput(i, ev);
+            // Holding mat 1's knob on the menu (otherwise a no-op) toggles the HUD
+            if (i == 0 && ev.longPress && host.timer(0).getState() == TimerState::MENU) {
+                g_hud.toggle();
+                g_boardDirty = true;
+            }
+        }
         
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTick).count();
-        if (elapsed >= 1000) { lastTick = now; timer.tick(); }
+        trace.mark("host");
+        g_control.apply(host);
+        g_http.apply(host);
+        if (uint64_t called = g_tournament.apply(host)) {
+            for (unsigned i = 0; i < host.size(); ++i) {
+                if (called >> i & 1) showList(i);
+            }
+        }
+        host.poll(monotonicMs());
+        if (hudChanged) g_boardDirty = true;
         
-        elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastDisplay).count();
-        if (elapsed >= 100) { lastDisplay = now; renderDisplay(timer.getDisplayInfo()); }
+        trace.mark("render");
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastDisplay).count();
+        if (elapsed >= 100) {
+            lastDisplay = now;
+            if (host.size() == 1) {
+                renderDisplay(host.timer(0).getDisplayInfo());
+            } else if (g_boardDirty) {
+                g_boardDirty = false;
+                for (unsigned i = 0; i < host.size(); ++i) board[i] = host.timer(i).getDisplayInfo();
+                renderBoard(board, host.size());
+            }
+        }
         
+        trace.mark("sleep");
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
+    setAllocPhase(AllocPhase::SHUTDOWN);
+    watchdog.stop();
     
-    encoder.detachInterrupts();
-    buzzer.silence(g_gpioHandle);
-    encoder.freeGpio(g_gpioHandle);
-    lgGpioFree(g_gpioHandle, bjj::BUZZER_PIN);
+    for (unsigned i = 0; i < host.size(); ++i) {
+        MatIO& io = g_io[i];
+        if (io.encoder) {
+            io.encoder->detachInterrupts();
+            io.encoder->freeGpio(g_gpioHandle);
+            const GestureStats& st = io.encoder->gestureStats();
+            if (st.shortUs.count() || st.longLateUs.count() || st.doubleUs.count() || st.chords) {
+                char line[224];
+                formatGestureStats(line, sizeof(line), st);
+                std::cout << "\nMat " << i + 1 << " gestures: " << line;
+            }
+        }
+        if (g_rotation[i].active()) {
+            RotationStats st = g_rotation[i].engine().stats();
+            std::cout << "\nMat " << i + 1 << " rotation: " << st.rounds << " rounds (max " << st.maxRoundUs
+                      << " us each), " << st.repeats << " repeat pairs, " << st.relaxed << " outside the limits";
+        }
+        if (io.cues) {
+            CueStats st = io.cues->stats();
+            if (st.scheduled) {
+                std::cout << "\nMat " << i + 1 << " cues: " << st.scheduled << " on schedule (onset avg "
+                          << st.avgOnsetUs << " us, max " << st.maxOnsetUs << " us), " << st.immediate << " immediate";
+            }
+            io.cues->stop();
+        }
+        io.checkpoint.close();
+    }
+    if (host.stats().detents) {
+        const MatHostStats& st = host.stats();
+        std::cout << "\nKnobs: " << st.detents << " detents applied as " << st.rotateUpdates
+                  << " updates, steps up to x" << st.maxStep;
+    }
+    if (watchdogOn) {
+        StallStats st = watchdog.stats();
+        std::cout << "\nWatchdog: " << st.stalls << " stalls (" << st.captures << " caught), "
+                  << st.totalStallMs / 1000.0 << " s stalled, longest " << st.maxStallMs << " ms in "
+                  << (st.maxPhase ? st.maxPhase : "-") << ", " << st.notifies << " pings (" << st.notifyErrors
+                  << " failed)";
+    }
+    if (g_tournament.active()) {
+        TournamentStats st = g_tournament.stats();
+        std::cout << "\nTournament: " << st.done << "/" << st.matches << " matches decided, " << st.replans
+                  << " re-plans (max " << st.maxReplanUs << " us)";
+        for (const Division& d : g_tournament.divisions()) {
+            if (d.champion != NO_COMPETITOR) {
+                std::cout << "\n  " << d.name << ": " << g_tournament.competitors()[d.champion].name;
+            }
+        }
+        g_tournament.close();
+    }
+    if (g_pcm.isRunning()) {
+        g_pcm.stop();
+        PcmStats st = g_pcm.stats();
+        std::cout << "\nAudio: " << st.scheduled << " cues on schedule (onset avg " << st.avgOnsetUs << " us, max "
+                  << st.maxOnsetUs << " us), " << st.immediate << " immediate, " << st.dropped << " dropped, "
+                  << st.xruns << " xruns, mix max " << st.maxMixUs << " us";
+    }
+    if (g_recorder.isOpen()) {
+        std::cout << "\nRecorded " << g_recorder.records() << " input records\n";
+        g_recorder.close();
+    }
+    if (g_history.isOpen()) {
+        g_history.close();
+        HistoryStats st = g_history.stats();
+        std::cout << "\nHistory: " << st.records << " records, " << st.syncs << " syncs (max "
+                  << st.maxSyncUs / 1000.0 << " ms), " << st.dropped << " dropped\n";
+    }
+    if (g_control.isRunning()) {
+        CtlStats st = g_control.stats();
+        std::cout << "\nControl: " << st.commands << " commands in " << st.batches << " batches, avg "
+                  << st.avgNs / 1000.0 << " us, max " << st.maxNs / 1000.0 << " us\n";
+        g_control.stop();
+    }
+    if (g_http.isRunning()) {
+        HttpStats st = g_http.stats();
+        std::cout << "\nDashboard: " << st.requests << " requests, " << st.events << " stream messages ("
+                  << st.coalesced << " coalesced), " << st.commands << " commands\n";
+        g_http.stop();
+    }
+    if (g_lead.isRunning()) {
+        SyncLeaderStats st = g_lead.stats();
+        std::cout << "\nSync: " << st.followers << " followers, " << st.timelines << " timelines sent\n";
+        g_lead.stop();
+    }
+    if (g_follower.isRunning()) {
+        SyncFollowerStats st = g_follower.stats();
+        std::cout << "\nSync: offset " << st.offsetUs << " us, skew " << st.skewPpm << " ppm, "
+                  << st.samples << " clock samples, " << st.timelines << " timelines\n";
+        g_follower.stop();
+    }
+    g_export.close();
     lgGpiochipClose(g_gpioHandle);
     ansi::showCur();
     
+    std::cout << "\n" << std::flush;
+    printAllocReport(stdout, "", allocReport);
     std::cout << "\nBJJ Gym Timer - Shutdown complete.\n";
     return 0;
 }
@@ -5,129 +5,632 @@
  */
 
 #include "hardware.hpp"
+#include "alloc_track.hpp"
 #include "timer_logic.hpp"
+#include "checkpoint.hpp"
+#include "audio.hpp"
+#include "control_server.hpp"
+#include "history_log.hpp"
+#include "http_server.hpp"
+#include "input_replay.hpp"
+#include "mat_host.hpp"
+#include "pcm_audio.hpp"
+#include "perf_hud.hpp"
+#include "power_governor.hpp"
 #include "ui.hpp"
 #include "lvgl_port.hpp"
+#include "perf_trace.hpp"
+#include "session_sync.hpp"
+#include "stall_watchdog.hpp"
+#include "state_export.hpp"
+#include "rotation.hpp"
+#include "text_list.hpp"
+#include "tournament.hpp"
 #include <lvgl.h>
 #include <lgpio.h>
 #include <csignal>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
 #include <unistd.h>
 
 using namespace bjj;
 
 static volatile sig_atomic_t g_running = 1;
-static Buzzer* g_buzzer = nullptr;
-static TimerLogic* g_timer = nullptr;
+static MatHost* g_host = nullptr;
 static BJJTimerUI* g_ui = nullptr;
 static int g_gpio_handle = -1;
-static volatile sig_atomic_t g_shutdown_requested = 0;
 
-static void ensure_buzzer_off() {
-    if (g_buzzer && g_gpio_handle >= 0) {
-        g_buzzer->silence(g_gpio_handle);
+// Per-mat input source and output sinks. Mat 1's encoder also feeds LVGL (post_input).
+struct MatIO {
+    MatHardware hw;
+    std::unique_ptr<RotaryEncoder> encoder;
+    std::unique_ptr<CuePlayer> cues;
+    Checkpoint checkpoint;
+};
+static MatIO g_io[MAX_MATS];
+static StateExport g_export;
+static ControlServer g_control;
+static HttpServer g_http;
+static SyncLeader g_lead;
+static SyncFollower g_follower;
+static HistoryLog g_history;
+static InputRecorder g_recorder;
+static PcmCuePlayer g_pcm;
+static MatRotation g_rotation[MAX_MATS];
+static Tournament g_tournament;
+static PerfHud g_hud;
+static PowerGovernor g_power;
+static TraceRing g_trace;
+static StallWatchdog g_watchdog;
+
+// SDL keyboard and mouse: a virtual knob on one mat at a time (digit keys pick it)
+struct SdlKnob {
+    GestureRecognizer gestures;
+    unsigned mat = 0;
+    bool down = false;
+    uint64_t lastUs = 0;        // Samples reach the recogniser in time order
+    LatencyHistogram queueUs;   // SDL queued the event to lvgl_port handing it over
+    uint64_t events = 0;
+};
+static SdlKnob g_sdl;
+
+// The panel's list: its tournament match, else partner pairings
+static void show_list(unsigned mat) {
+    static TextList lines;
+    if (g_tournament.active()) {
+        g_tournament.describe(mat, lines);
+        if (g_ui) g_ui->setPairings(mat, g_tournament.title(mat), lines);
+        return;
     }
+    g_rotation[mat].describe(lines);
+    if (g_ui) g_ui->setPairings(mat, g_rotation[mat].title(), lines);
 }
 
 static void signal_handler(int) {
-    g_shutdown_requested = 1;
     g_running = 0;
 }
 
-static void on_buzzer(const DisplayInfo& info) {
-    if (!g_buzzer || g_gpio_handle < 0) return;
-    if (info.roundStartDue)      g_buzzer->playStartRound(g_gpio_handle);
-    if (info.tenSecondWarningDue) g_buzzer->play10SecondWarning(g_gpio_handle);
-    if (info.roundEndDue)        g_buzzer->playEndRound(g_gpio_handle);
-    if (info.switchDue)          g_buzzer->playDrillingSwitch(g_gpio_handle);
+static void on_mat_display(void*, unsigned mat, const DisplayInfo& info) {
+    g_power.show(mat, info.state, monotonicMs());
+    g_export.publish(mat, info, g_host->nextTickMs(mat), g_host->nowMs());
+    g_control.notify(mat, info);
+    g_http.notify(mat, info);
+    g_lead.publish(*g_host, mat);
+    if (g_ui) g_ui->update(mat, info);
+}
+
+static void on_mat_cues(void*, unsigned mat, uint8_t cues) {
+    if (g_pcm.isRunning()) g_pcm.play(mat, cues);
+    else if (g_io[mat].cues) g_io[mat].cues->play(cues);
+    g_export.countCues(mat, cues);
+    if (g_rotation[mat].onCues(cues)) show_list(mat);
+}
+
+static void on_mat_cue_schedule(void*, unsigned mat, uint64_t deadline_ms, uint8_t cues) {
+    if (g_pcm.isRunning()) g_pcm.arm(mat, deadline_ms, cues);
+    else if (g_io[mat].cues) g_io[mat].cues->arm(deadline_ms, cues);
 }
 
-static void encoder_cb(int delta, bool pressed, bool long_press) {
-    if (!g_timer) return;
+static void on_mat_transition(void*, unsigned mat, const TimerSnapshot& snap) {
+    g_io[mat].checkpoint.save(snap, g_host->untilTickMs(mat));
+    g_history.record(mat, snap, cueMask(g_host->timer(mat).getDisplayInfo()));
+    bool list_changed = g_rotation[mat].onTransition(snap);
+    list_changed |= g_tournament.onTransition(mat, snap, g_host->nowMs());
+    if (list_changed) show_list(mat);
+}
+
+static bool on_match_result(void*, unsigned mat, unsigned winner) {
+    return g_host && g_tournament.result(*g_host, mat, winner);
+}
+
+static bool mat_progress(void*, unsigned mat, uint32_t& remainingMs, uint32_t& spanMs) {
+    if (g_follower.isRunning()) {
+        DisplayInfo info;
+        return g_follower.view(mat, info, remainingMs, spanMs) &&
+               (info.state == TimerState::RUNNING || info.state == TimerState::PAUSED ||
+                info.state == TimerState::FINISHED);
+    }
+    return g_host && g_host->phaseProgress(mat, monotonicMs(), remainingMs, spanMs);
+}
+
+static void on_frame(uint64_t render_ns, uint64_t flush_ns) {
+    g_trace.mark("frame", static_cast<uint32_t>((render_ns + flush_ns) / 1000));
+    g_hud.frame(render_ns, flush_ns);
+}
+
+// One encoder poll's gestures. Mat 1's knob also drives LVGL's focus group.
+static void post_input(unsigned mat, const EncoderEvents& ev) {
+    if (!g_host || !ev.any()) return;
+    if (!g_power.input(monotonicMs())) return;  // Only woke the display
+    if (mat == 0) {
+        lvgl_port_encoder_add_delta(ev.delta + ev.coarseDelta);
+        if (ev.shortPress || ev.doublePress) lvgl_port_encoder_set_pressed(true);
+        // Holding the knob on the menu (otherwise a no-op) toggles the HUD
+        if (ev.longPress && g_host->timer(0).getState() == TimerState::MENU && !g_hud.toggle() && g_ui) {
+            g_ui->setHud(nullptr);
+        }
+    }
+    g_host->postInput(mat, ev);
+}
+
+static void sdl_feed(int delta, uint64_t now_us) {
+    if (now_us < g_sdl.lastUs) now_us = g_sdl.lastUs;
+    g_sdl.lastUs = now_us;
+    g_sdl.gestures.setPolicy(g_host->gesturePolicy(g_sdl.mat));
+    post_input(g_sdl.mat, g_sdl.gestures.feed(delta, g_sdl.down, now_us));
+}
+
+static void sdl_input_cb(int delta, int button, bool long_press, unsigned select, uint64_t stamp_ns) {
+    if (!g_host) return;
+    const uint64_t now = monotonicNs();
+    g_sdl.queueUs.record(now > stamp_ns ? (now - stamp_ns) / 1000 : 0);
+    ++g_sdl.events;
+    if (select) {
+        if (select <= g_host->size() && !g_sdl.down) g_sdl.mat = select - 1;
+        return;
+    }
     if (long_press) {
-        g_timer->onLongPress();
-    } else if (pressed) {
-        g_timer->onShortPress();
-    } else if (delta != 0) {
-        g_timer->onRotate(delta);
+        EncoderEvents ev;
+        ev.longPress = true;
+        post_input(g_sdl.mat, ev);
+        return;
     }
+    if (button >= 0) g_sdl.down = button != 0;
+    sdl_feed(delta, stamp_ns / 1000);
+}
+
+// Apply a new governor level; from is the level it left
+static void apply_power_level(PowerLevel from) {
+    const PowerLevel level = g_power.level();
+    if (level == PowerLevel::BLANK) {
+        lvgl_port_set_blank(true);
+        lv_timer_enable(false);
+        fprintf(stderr, "[bjj_timer_gui] display blanked\n");
+        return;
+    }
+    if (from == PowerLevel::BLANK) {
+        lv_timer_enable(true);
+        lvgl_port_set_blank(false);
+        fprintf(stderr, "[bjj_timer_gui] display on\n");
+    }
+    lvgl_port_set_refresh_period(g_power.refreshMs());
+    if (g_ui) g_ui->setFramePeriod(g_power.refreshMs());
 }
 
 int main(int argc, char* argv[]) {
-    (void)argc;
-    (void)argv;
+    std::string checkpoint_path = Checkpoint::defaultPath();
+    bool resume = true;
+    std::string history_path = HistoryLog::defaultPath();
+    std::string shm_name = StateExport::defaultName();
+    bool control = false;
+    const char* http_spec = nullptr;
+    const char* lead_spec = nullptr;
+    const char* follow_spec = nullptr;
+    const char* record_path = nullptr;
+    const char* audio_device = nullptr;
+    std::string sample_dir;
+    std::string roster_paths[MAX_MATS];
+    RotationRules rotation_rules;
+    const char* tournament_path = nullptr;
+    TournamentRules tournament_rules;
+    double clock_skew_ppm = 0;
+    long clock_offset_ms = 0;
+    unsigned mat_count = 1;
+    const char* fb_path = nullptr;
+    lvgl_port_color_t fb_color = LVGL_PORT_COLOR_NATIVE;
+    bool alloc_report = false;
+    PowerConfig power_cfg;
+    WatchdogConfig watchdog_cfg;
+    watchdog_cfg.prefix = "[bjj_timer_gui] ";
+    RotateConfig rotate_cfg;
+    rotate_cfg.frameMs = LV_DEF_REFR_PERIOD;
+    power_cfg.fullRefreshMs = LV_DEF_REFR_PERIOD;
+    g_io[0].hw.hasEncoder = true;  // Mat 1 uses the default pins
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--checkpoint") && i + 1 < argc) checkpoint_path = argv[++i];
+        else if (!strcmp(argv[i], "--no-resume")) resume = false;
+        else if (!strcmp(argv[i], "--history") && i + 1 < argc) history_path = argv[++i];
+        else if (!strcmp(argv[i], "--no-history")) history_path.clear();
+        else if (!strcmp(argv[i], "--record") && i + 1 < argc) record_path = argv[++i];
+        else if (!strcmp(argv[i], "--audio") && i + 1 < argc) audio_device = argv[++i];
+        else if (!strcmp(argv[i], "--audio-samples") && i + 1 < argc) sample_dir = argv[++i];
+        else if (!strcmp(argv[i], "--roster") && i + 1 < argc) {
+            std::string path;
+            int mat = parseRosterSpec(argv[++i], path);
+            if (mat < 0) {
+                fprintf(stderr, "[bjj_timer_gui] bad --roster spec %s (want [N:]PATH)\n", argv[i]);
+                return 1;
+            }
+            roster_paths[mat] = path;
+        }
+        else if (!strcmp(argv[i], "--weight-gap") && i + 1 < argc) rotation_rules.maxWeightGapKg = std::strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--belt-gap") && i + 1 < argc) rotation_rules.maxBeltGap = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--tournament") && i + 1 < argc) tournament_path = argv[++i];
+        else if (!strcmp(argv[i], "--rest-gap") && i + 1 < argc) tournament_rules.restGapSec = std::strtoul(argv[++i], nullptr, 10) * 60;
+        else if (!strcmp(argv[i], "--shm") && i + 1 < argc) shm_name = argv[++i];
+        else if (!strcmp(argv[i], "--no-shm")) shm_name.clear();
+        else if (!strcmp(argv[i], "--control")) control = true;
+        else if (!strcmp(argv[i], "--http") && i + 1 < argc) http_spec = argv[++i];
+        else if (!strcmp(argv[i], "--lead") && i + 1 < argc) lead_spec = argv[++i];
+        else if (!strcmp(argv[i], "--follow") && i + 1 < argc) follow_spec = argv[++i];
+        else if (!strcmp(argv[i], "--clock-skew") && i + 1 < argc) clock_skew_ppm = std::strtod(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--clock-offset") && i + 1 < argc) clock_offset_ms = std::strtol(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--fb") && i + 1 < argc) fb_path = argv[++i];
+        else if (!strcmp(argv[i], "--color") && i + 1 < argc) {
+            const char* c = argv[++i];
+            fb_color = !strcmp(c, "dither") ? LVGL_PORT_COLOR_DITHER
+                     : !strcmp(c, "convert") ? LVGL_PORT_COLOR_CONVERT : LVGL_PORT_COLOR_NATIVE;
+        }
+        else if (!strcmp(argv[i], "--hud")) g_hud.setEnabled(true);
+        else if (!strcmp(argv[i], "--accel") && i + 1 < argc) {
+            if (!parseAccelSpec(argv[++i], rotate_cfg)) {
+                fprintf(stderr, "[bjj_timer_gui] bad --accel spec %s (want SETTING:SLOW,FAST,MAX or off)\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--low-refresh") && i + 1 < argc) power_cfg.lowRefreshMs = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--blank-after") && i + 1 < argc) {
+            power_cfg.blankAfterMs = static_cast<uint32_t>(std::strtod(argv[++i], nullptr) * 60000);
+        }
+        else if (!strcmp(argv[i], "--stall-ms") && i + 1 < argc) watchdog_cfg.stallMs = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--notify-ms") && i + 1 < argc) watchdog_cfg.notifyMs = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--alloc-strict") && i + 1 < argc) {
+            AllocStrict mode;
+            if (!parseAllocStrict(argv[++i], mode)) {
+                fprintf(stderr, "[bjj_timer_gui] bad --alloc-strict mode %s (want log, abort or off)\n", argv[i]);
+                return 1;
+            }
+            setAllocStrict(mode);
+        }
+        else if (!strcmp(argv[i], "--alloc-report")) alloc_report = true;
+        else if (!strcmp(argv[i], "--mats") && i + 1 < argc) mat_count = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--mat") && i + 1 < argc) {
+            MatHardware hw;
+            int mat = parseMatSpec(argv[++i], hw);
+            if (mat < 0) {
+                fprintf(stderr, "[bjj_timer_gui] bad --mat spec %s (want N:CLK,DT,SW,BUZZER)\n", argv[i]);
+                return 1;
+            }
+            g_io[mat].hw = hw;
+        }
+    }
+    if (mat_count > MAX_PANELS) {
+        fprintf(stderr, "[bjj_timer_gui] showing %u of %u mats (max %u panels)\n", MAX_PANELS, mat_count, MAX_PANELS);
+        mat_count = MAX_PANELS;
+    }
 
+    StartupProfile profile;
     fprintf(stderr, "[bjj_timer_gui] Starting...\n");
-    int h = lgGpiochipOpen(4);
-    if (h < 0) h = lgGpiochipOpen(0);
-    if (h < 0) {
-        fprintf(stderr, "[bjj_timer_gui] GPIO init FAILED\n");
-        return 1;
-    }
-    g_gpio_handle = h;
-    fprintf(stderr, "[bjj_timer_gui] GPIO ok (handle=%d)\n", h);
 
-    Buzzer buzzer;
-    buzzer.init(h);
-    g_buzzer = &buzzer;
-    fprintf(stderr, "[bjj_timer_gui] buzzer test...\n");
-    buzzer.tone(h, Tones::AIR_HORN_HIGH, 120);
-    buzzer.silence(h);
+    // GPIO claim + buzzer self-test overlap with LVGL/display bring-up below
+    int h = -1;
+    std::thread gpio_init([&]() {
+        h = lgGpiochipOpen(4);
+        if (h < 0) h = lgGpiochipOpen(0);
+        if (h < 0) return;
+        for (unsigned i = 0; i < mat_count; ++i) {
+            MatIO& io = g_io[i];
+            if (!io.hw.hasEncoder) continue;
+            io.cues.reset(new CuePlayer(io.hw.buzzerPin));
+            io.cues->start(h);
+        }
+        profile.mark("gpio claim");
+        if (g_io[0].cues) {
+            g_io[0].cues->buzzer().tone(h, Tones::AIR_HORN_HIGH, 120);
+            g_io[0].cues->buzzer().silence(h);
+        }
+        profile.mark("buzzer self-test");
+    });
 
-    TimerLogic timer;
-    g_timer = &timer;
+    MatHost host(mat_count, monotonicMs());
+    host.setRotateConfig(rotate_cfg);
+    g_host = &host;
+    if (record_path && g_recorder.open(record_path, host)) {
+        fprintf(stderr, "[bjj_timer_gui] recording input to %s\n", record_path);
+    }
+    if (audio_device && g_pcm.start(audio_device, sample_dir)) {
+        fprintf(stderr, "[bjj_timer_gui] audio cues on %s (%u-frame periods)\n", audio_device,
+                g_pcm.stats().periodFrames);
+    }
+    for (unsigned i = 0; i < host.size(); ++i) {
+        std::string path = i == 0 ? checkpoint_path : checkpoint_path + "." + std::to_string(i + 1);
+        if (!g_io[i].checkpoint.open(path)) continue;
+        TimerSnapshot snap;
+        unsigned elapsed = 0;
+        uint32_t first_tick_ms = 0;
+        if (resume && g_io[i].checkpoint.load(snap, elapsed, first_tick_ms)) {
+            host.timer(i).restore(snap, elapsed);
+            host.alignTick(i, first_tick_ms);
+            g_recorder.restore(i, snap, elapsed, first_tick_ms);
+            fprintf(stderr, "[bjj_timer_gui] mat %u resumed (%us since checkpoint)\n", i + 1, elapsed);
+        }
+    }
+    if (!history_path.empty()) g_history.open(history_path);
+    host.setTransitionSink(on_mat_transition, nullptr);
+    profile.mark("checkpoint restore");
+
+    if (!shm_name.empty() && g_export.open(shm_name, host.size())) {
+        for (unsigned i = 0; i < host.size(); ++i) {
+            g_export.publish(i, host.timer(i).getDisplayInfo(), host.nextTickMs(i), host.nowMs());
+        }
+    }
 
-    if (lvgl_port_init(h, encoder_cb) != 0) {
+    if (fb_path) lvgl_port_use_fb(fb_path, 0, 0, 0, fb_color);
+    if (lvgl_port_init_display() != 0) {
         fprintf(stderr, "[bjj_timer_gui] LVGL init FAILED\n");
-        lgGpiochipClose(h);
+        gpio_init.join();
+        for (MatIO& io : g_io) io.cues.reset();
+        if (h >= 0) lgGpiochipClose(h);
         return 1;
     }
+    profile.mark("lvgl + display");
     fprintf(stderr, "[bjj_timer_gui] LVGL/display ok\n");
 
     g_ui = new BJJTimerUI();
-    g_ui->setTimerLogic(&timer);
-    g_ui->setBuzzerCallback(on_buzzer);
-    g_ui->create(nullptr);
+    g_ui->create(nullptr, host.size());
+    g_ui->setProgressSource(mat_progress, nullptr);
+    lvgl_port_set_frame_cb(on_frame);
+    lvgl_port_set_sdl_input_cb(sdl_input_cb);
+    profile.mark("menu built");
 
-    timer.setEventCallback([](const DisplayInfo& info) {
-        if (g_ui) g_ui->update(info);
-    });
+    host.setDisplaySink(on_mat_display, nullptr);
 
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
-    DisplayInfo initial_info = timer.getDisplayInfo();
-    on_buzzer(initial_info);
-    g_ui->update(initial_info);
-    timer.clearAudioFlags();
-
+    for (unsigned i = 0; i < host.size(); ++i) {
+        if (!roster_paths[i].empty() && g_rotation[i].engine().loadRoster(roster_paths[i])) {
+            g_rotation[i].engine().setRules(rotation_rules);
+            fprintf(stderr, "[bjj_timer_gui] mat %u roster: %zu athletes\n", i + 1,
+                    g_rotation[i].engine().roster().size());
+            // A resumed session picks up its pairings where it left off
+            if (g_rotation[i].onTransition(host.timer(i).snapshot())) show_list(i);
+        }
+        g_ui->update(i, host.timer(i).getDisplayInfo());
+    }
+    if (tournament_path && g_tournament.load(tournament_path, host.size(), tournament_rules, host.nowMs())) {
+        setMatchResultSink(on_match_result, nullptr);
+        TournamentStats st = g_tournament.stats();
+        fprintf(stderr, "[bjj_timer_gui] tournament: %zu divisions, %u matches (%u decided), planned to end in %u min\n",
+                g_tournament.divisions().size(), st.matches, st.done, st.projectedEndSec / 60);
+    }
     lv_refr_now(NULL);
+    profile.mark("first frame");
+
+    gpio_init.join();
+    if (h < 0) {
+        fprintf(stderr, "[bjj_timer_gui] GPIO init FAILED\n");
+        delete g_ui;
+        g_ui = nullptr;
+        lvgl_port_deinit();
+        return 1;
+    }
+    g_gpio_handle = h;
+    fprintf(stderr, "[bjj_timer_gui] GPIO ok (handle=%d)\n", h);
+    // Every knob, mat 1's included, is polled here so its gestures see the mat's screen
+    for (unsigned i = 0; i < host.size(); ++i) {
+        MatIO& io = g_io[i];
+        if (!io.hw.hasEncoder) continue;
+        io.encoder.reset(new RotaryEncoder(io.hw.pins));
+        io.encoder->init(h);
+    }
+    profile.mark("encoder claim");
+    profile.print("bjj_timer_gui", "first frame", 200.0);
+
+    host.setCueSink(on_mat_cues, nullptr);
+    host.setCueScheduleSink(on_mat_cue_schedule, nullptr);
+    if (control && g_control.start(ControlServer::defaultPath(), host.size())) {
+        fprintf(stderr, "[bjj_timer_gui] control socket %s\n", ControlServer::defaultPath().c_str());
+    }
+    if (http_spec && g_http.start(http_spec, host.size())) {
+        fprintf(stderr, "[bjj_timer_gui] dashboard on %s\n", http_spec);
+    }
+    if (lead_spec && g_lead.start(lead_spec, host.size())) {
+        for (unsigned i = 0; i < host.size(); ++i) g_lead.publish(host, i);
+        fprintf(stderr, "[bjj_timer_gui] leading followers on %s\n", lead_spec);
+    }
+    if (follow_spec && g_follower.start(follow_spec, host.size(), clock_skew_ppm, clock_offset_ms)) {
+        fprintf(stderr, "[bjj_timer_gui] following %s\n", follow_spec);
+    }
 
+    const bool watchdog = g_watchdog.start(watchdog_cfg, &g_trace);
+    if (watchdog && g_watchdog.notifyMs()) {
+        fprintf(stderr, "[bjj_timer_gui] systemd watchdog ping every %u ms\n", g_watchdog.notifyMs());
+    }
     fprintf(stderr, "[bjj_timer_gui] Main loop running (Ctrl+C to exit)\n");
+    // From here on every path runs out of buffers sized above
+    setAllocPhase(AllocPhase::STEADY);
+    if (power_cfg.lowRefreshMs < power_cfg.fullRefreshMs) power_cfg.lowRefreshMs = power_cfg.fullRefreshMs;
+    g_power.configure(power_cfg, monotonicMs());
     unsigned loop_count = 0;
     while (g_running) {
+        g_watchdog.beat();
+        g_trace.mark("input");
         if (!lvgl_port_pump_events()) g_running = 0;
-        lvgl_port_encoder_poll();
-        lv_timer_handler();
-        usleep(5000);
-        if (g_shutdown_requested) {
-            ensure_buzzer_off();
+        sdl_feed(0, monotonicNs() / 1000);  // Held-key long press, double-press window
+        for (unsigned i = 0; i < host.size(); ++i) {
+            if (!g_io[i].encoder) continue;
+            g_io[i].encoder->setPolicy(host.gesturePolicy(i));
+            post_input(i, g_io[i].encoder->pollEvents());
+        }
+        g_trace.mark("host");
+        if (g_follower.isRunning()) {
+            // Display only: the leader's timeline drives every panel
+            DisplayInfo info;
+            for (unsigned i = 0; i < host.size(); ++i) {
+                if (!g_follower.changed(i, info)) continue;
+                g_power.show(i, info.state, monotonicMs());
+                g_ui->update(i, info);
+            }
+            if ((clock_skew_ppm != 0 || clock_offset_ms != 0) && loop_count % 1000 == 0) {
+                SyncFollowerStats st = g_follower.stats();
+                fprintf(stderr, "[bjj_timer_gui] sync: skew %.1f ppm, delay %u us, clock error %lld us (max %lld)\n",
+                        st.skewPpm, st.delayUs, static_cast<long long>(st.errorUs),
+                        static_cast<long long>(st.maxErrorUs));
+            }
+        } else {
+            g_control.apply(host);
+            g_http.apply(host);
+            if (uint64_t called = g_tournament.apply(host)) {
+                for (unsigned i = 0; i < host.size(); ++i) {
+                    if (called >> i & 1) show_list(i);
+                }
+            }
+            host.poll(monotonicMs());
         }
+        const PowerLevel level = g_power.level();
+        if (g_power.update(monotonicMs())) apply_power_level(level);
+        // Blank: LVGL's timers are stopped, the loop only polls input
+        g_trace.mark("lvgl");
+        if (g_power.level() != PowerLevel::BLANK) lv_timer_handler();
+        g_power.wakeup();
+        g_hud.wakeup();
+        if (g_hud.enabled() && g_hud.due(monotonicMs())) {
+            lv_mem_monitor_t mon;
+            lv_mem_monitor(&mon);
+            g_hud.setMemory(static_cast<uint32_t>(mon.total_size - mon.free_size),
+                            static_cast<uint32_t>(mon.total_size), mon.frag_pct);
+        }
+        if (g_hud.update(host, monotonicMs())) g_ui->setHud(g_hud.text());
+        g_trace.mark("sleep");
+        usleep(g_power.loopSleepUs());
         if (++loop_count % 2000 == 0) {
-            fprintf(stderr, "[bjj_timer_gui] alive (%u)\n", loop_count);
+            AllocStats st = allocStats();
+            fprintf(stderr, "[bjj_timer_gui] alive (%u), heap %.1f KiB live, %llu steady-state allocs\n", loop_count,
+                    st.liveBytes / 1024.0, static_cast<unsigned long long>(st.phase[1].allocs));
         }
     }
+    setAllocPhase(AllocPhase::SHUTDOWN);
+    g_watchdog.stop();
+    g_power.finish(monotonicMs());
+    if (g_power.level() == PowerLevel::BLANK) {
+        lv_timer_enable(true);
+        lvgl_port_set_blank(false);
+    }
 
     delete g_ui;
     g_ui = nullptr;
-    g_buzzer = nullptr;
-    g_timer = nullptr;
+    g_host = nullptr;
 
-    ensure_buzzer_off();
-    lgGpioFree(h, BUZZER_PIN);
-    lvgl_port_deinit(h);
+    for (unsigned i = 0; i < host.size(); ++i) {
+        MatIO& io = g_io[i];
+        if (io.encoder) {
+            io.encoder->freeGpio(h);
+            const GestureStats& st = io.encoder->gestureStats();
+            if (st.shortUs.count() || st.longLateUs.count() || st.doubleUs.count() || st.chords) {
+                char line[224];
+                formatGestureStats(line, sizeof(line), st);
+                fprintf(stderr, "[bjj_timer_gui] mat %u gestures: %s\n", i + 1, line);
+            }
+        }
+        if (g_rotation[i].active()) {
+            RotationStats st = g_rotation[i].engine().stats();
+            fprintf(stderr, "[bjj_timer_gui] mat %u rotation: %u rounds (max %u us each), %u repeat pairs, "
+                    "%u outside the limits\n", i + 1, st.rounds, st.maxRoundUs, st.repeats, st.relaxed);
+        }
+        if (io.cues) {
+            CueStats st = io.cues->stats();
+            if (st.scheduled) {
+                fprintf(stderr, "[bjj_timer_gui] mat %u cues: %u on schedule (onset avg %u us, max %u us), %u immediate\n",
+                        i + 1, st.scheduled, st.avgOnsetUs, st.maxOnsetUs, st.immediate);
+            }
+            io.cues->stop();
+        }
+        io.checkpoint.close();
+    }
+    if (g_sdl.events) {
+        const GestureStats& st = g_sdl.gestures.stats();
+        char line[224];
+        formatGestureStats(line, sizeof(line), st);
+        fprintf(stderr, "[bjj_timer_gui] keyboard/mouse: %llu events (queued p99 %.1f ms), %s\n",
+                static_cast<unsigned long long>(g_sdl.events), g_sdl.queueUs.percentile(99) / 1000.0, line);
+    }
+    if (host.stats().detents) {
+        const MatHostStats& st = host.stats();
+        fprintf(stderr, "[bjj_timer_gui] knobs: %llu detents applied as %llu updates, steps up to x%u\n",
+                static_cast<unsigned long long>(st.detents), static_cast<unsigned long long>(st.rotateUpdates),
+                st.maxStep);
+    }
+    if (watchdog) {
+        StallStats st = g_watchdog.stats();
+        fprintf(stderr, "[bjj_timer_gui] watchdog: %u stalls (%u caught), %.1f s stalled, longest %u ms in %s, "
+                "%u pings (%u failed)\n", st.stalls, st.captures, st.totalStallMs / 1000.0, st.maxStallMs,
+                st.maxPhase ? st.maxPhase : "-", st.notifies, st.notifyErrors);
+    }
+    if (g_tournament.active()) {
+        TournamentStats st = g_tournament.stats();
+        fprintf(stderr, "[bjj_timer_gui] tournament: %u/%u matches decided, %u re-plans (max %u us)\n",
+                st.done, st.matches, st.replans, st.maxReplanUs);
+        for (const Division& d : g_tournament.divisions()) {
+            if (d.champion != NO_COMPETITOR) {
+                fprintf(stderr, "[bjj_timer_gui]   %s: %s\n", d.name.c_str(),
+                        g_tournament.competitors()[d.champion].name.c_str());
+            }
+        }
+        g_tournament.close();
+    }
+    if (g_pcm.isRunning()) {
+        g_pcm.stop();
+        PcmStats st = g_pcm.stats();
+        fprintf(stderr, "[bjj_timer_gui] audio: %u cues on schedule (onset avg %u us, max %u us), %u immediate, "
+                "%u dropped, %u xruns, mix max %u us\n", st.scheduled, st.avgOnsetUs, st.maxOnsetUs,
+                st.immediate, st.dropped, st.xruns, st.maxMixUs);
+    }
+    if (g_recorder.isOpen()) {
+        fprintf(stderr, "[bjj_timer_gui] recorded %llu input records\n",
+                static_cast<unsigned long long>(g_recorder.records()));
+        g_recorder.close();
+    }
+    if (g_history.isOpen()) {
+        g_history.close();
+        HistoryStats st = g_history.stats();
+        fprintf(stderr, "[bjj_timer_gui] history: %llu records, %u syncs (max %.1f ms), %u dropped\n",
+                static_cast<unsigned long long>(st.records), st.syncs, st.maxSyncUs / 1000.0, st.dropped);
+    }
+    if (g_control.isRunning()) {
+        CtlStats st = g_control.stats();
+        fprintf(stderr, "[bjj_timer_gui] control: %u commands, %u batches, avg %.1f us, max %.1f us\n",
+                st.commands, st.batches, st.avgNs / 1000.0, st.maxNs / 1000.0);
+        g_control.stop();
+    }
+    if (g_http.isRunning()) {
+        HttpStats st = g_http.stats();
+        fprintf(stderr, "[bjj_timer_gui] dashboard: %u requests, %llu stream messages (%llu coalesced), %u commands\n",
+                st.requests, static_cast<unsigned long long>(st.events),
+                static_cast<unsigned long long>(st.coalesced), st.commands);
+        g_http.stop();
+    }
+    if (g_lead.isRunning()) {
+        SyncLeaderStats st = g_lead.stats();
+        fprintf(stderr, "[bjj_timer_gui] sync: %u followers, %llu timelines sent\n",
+                st.followers, static_cast<unsigned long long>(st.timelines));
+        g_lead.stop();
+    }
+    if (g_follower.isRunning()) {
+        SyncFollowerStats st = g_follower.stats();
+        fprintf(stderr, "[bjj_timer_gui] sync: offset %lld us, skew %.1f ppm, %u clock samples, %u timelines\n",
+                static_cast<long long>(st.offsetUs), st.skewPpm, st.samples, st.timelines);
+        g_follower.stop();
+    }
+    g_export.close();
+    for (unsigned l = 0; l < POWER_LEVEL_COUNT; ++l) {
+        const PowerLevelStats& st = g_power.stats(static_cast<PowerLevel>(l));
+        if (st.wallMs == 0) continue;
+        fprintf(stderr, "[bjj_timer_gui] power %s: %.1f min in %u spells, CPU %.2f%%, %.0f wakeups/s\n",
+                powerLevelName(static_cast<PowerLevel>(l)), st.wallMs / 60000.0, st.entries,
+                st.cpuUs / (st.wallMs * 10.0), st.wakeups * 1000.0 / st.wallMs);
+    }
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    fprintf(stderr, "[bjj_timer_gui] LV_MEM: max %.1f of %.1f KiB used\n", mon.max_used / 1024.0,
+            mon.total_size / 1024.0);
+    lvgl_port_deinit();
     lgGpiochipClose(h);
+    printAllocReport(stderr, "[bjj_timer_gui] ", alloc_report);
 
     return 0;
 }
@@ -0,0 +1,320 @@
+/**
+ * BJJ Gym Timer - Multi-Mat Host Implementation
+ */
+
+#include "mat_host.hpp"
+#include "audio.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace bjj {
+
+int parseMatSpec(const char* spec, MatHardware& hw) {
+    unsigned n, clk, dt, sw, buzz;
+    if (sscanf(spec, "%u:%u,%u,%u,%u", &n, &clk, &dt, &sw, &buzz) != 5 || n < 1 || n > MAX_MATS) {
+        return -1;
+    }
+    hw.hasEncoder = true;
+    hw.pins = EncoderPins{clk, dt, sw};
+    hw.buzzerPin = buzz;
+    return static_cast<int>(n - 1);
+}
+
+bool parseAccelSpec(const char* spec, RotateConfig& cfg) {
+    static const char* const NAMES[ACCEL_SETTING_COUNT] = {nullptr, "work", "rest", "rounds", "adjust"};
+    if (!strcmp(spec, "off")) {
+        for (AccelCurve& c : cfg.curve) c.maxStep = 1;
+        return true;
+    }
+    const char* colon = strchr(spec, ':');
+    if (!colon) return false;
+    for (unsigned i = 1; i < ACCEL_SETTING_COUNT; ++i) {
+        if (strncmp(spec, NAMES[i], colon - spec) || NAMES[i][colon - spec]) continue;
+        AccelCurve c;
+        if (sscanf(colon + 1, "%f,%f,%u", &c.slowDps, &c.fastDps, &c.maxStep) != 3 ||
+            c.slowDps < 0 || c.fastDps < c.slowDps || c.maxStep < 1) {
+            return false;
+        }
+        cfg.curve[i] = c;
+        return true;
+    }
+    return false;
+}
+
+static unsigned clampMatCount(unsigned count) {
+    return count < 1 ? 1 : (count > MAX_MATS ? MAX_MATS : count);
+}
+
+MatHost::MatHost(unsigned count, uint64_t nowMs)
+    : mats_(new Mat[clampMatCount(count)]),
+      count_(clampMatCount(count)),
+      wheel_(nowMs),
+      nowMs_(nowMs) {
+    for (unsigned i = 0; i < count_; ++i) {
+        Mat& m = mats_[i];
+        m.host = this;
+        m.index = i;
+        m.tick.fn = onTick;
+        m.tick.ctx = &m;
+        m.timer.setEventCallback(onDisplay, &m);
+        m.timer.setTransitionCallback(onTimerTransition, &m);
+    }
+}
+
+void MatHost::onDisplay(void* ctx, const DisplayInfo& info) {
+    Mat& m = *static_cast<Mat*>(ctx);
+    MatHost& host = *m.host;
+    if (host.displaySink_) host.displaySink_(host.displayCtx_, m.index, info);
+}
+
+void MatHost::onTimerTransition(void* ctx, const TimerSnapshot& snap) {
+    Mat& m = *static_cast<Mat*>(ctx);
+    m.host->onTransition(m, snap);
+}
+
+void MatHost::postRotate(unsigned mat, int delta, bool coarse) {
+    if (mat >= count_ || delta == 0) return;
+    Mat& m = mats_[mat];
+    uint64_t none = 0;
+    m.postedNs.compare_exchange_strong(none, monotonicNs(), std::memory_order_relaxed);
+    (coarse ? m.rotateCoarse : m.rotate).fetch_add(delta, std::memory_order_relaxed);
+    pendingMask_.fetch_or(1ULL << mat, std::memory_order_release);
+}
+
+void MatHost::postPress(unsigned mat, bool isLong) {
+    if (mat >= count_) return;
+    Mat& m = mats_[mat];
+    uint64_t none = 0;
+    m.postedNs.compare_exchange_strong(none, monotonicNs(), std::memory_order_relaxed);
+    m.presses.fetch_or(isLong ? PRESS_LONG : PRESS_SHORT, std::memory_order_relaxed);
+    pendingMask_.fetch_or(1ULL << mat, std::memory_order_release);
+}
+
+void MatHost::postDoublePress(unsigned mat) {
+    if (mat >= count_) return;
+    Mat& m = mats_[mat];
+    uint64_t none = 0;
+    m.postedNs.compare_exchange_strong(none, monotonicNs(), std::memory_order_relaxed);
+    m.presses.fetch_or(PRESS_DOUBLE, std::memory_order_relaxed);
+    pendingMask_.fetch_or(1ULL << mat, std::memory_order_release);
+}
+
+void MatHost::postInput(unsigned mat, const EncoderEvents& ev) {
+    postRotate(mat, ev.coarseDelta, true);
+    postRotate(mat, ev.delta);
+    if (ev.shortPress) postPress(mat, false);
+    if (ev.doublePress) postDoublePress(mat);
+    if (ev.longPress) postPress(mat, true);
+}
+
+GesturePolicy MatHost::gesturePolicy(unsigned mat) const {
+    GesturePolicy p;
+    if (mat >= count_) return p;
+    switch (mats_[mat].timer.getState()) {
+        case TimerState::RUNNING:
+            p.shortOnDown = true;
+            break;
+        case TimerState::MENU:
+        case TimerState::SETUP_WORK:
+        case TimerState::SETUP_REST:
+        case TimerState::SETUP_ROUNDS:
+            p.doubleMs = DOUBLE_PRESS_MS;
+            break;
+        default:
+            break;
+    }
+    return p;
+}
+
+unsigned MatHost::poll(uint64_t nowMs) {
+    if (nowMs > nowMs_) nowMs_ = nowMs;
+    unsigned events = 0;
+
+    // Input: only mats that actually posted something
+    uint64_t pending = pendingMask_.exchange(0, std::memory_order_acquire);
+    uint64_t held = 0;
+    while (pending) {
+        unsigned i = static_cast<unsigned>(__builtin_ctzll(pending));
+        pending &= pending - 1;
+        Mat& m = mats_[i];
+        // Before the input itself: a post racing this poll stamps the next one
+        uint64_t posted = m.postedNs.exchange(0, std::memory_order_relaxed);
+        int coarse = m.rotateCoarse.exchange(0, std::memory_order_relaxed);
+        int delta = m.rotate.exchange(0, std::memory_order_relaxed);
+        uint8_t presses = m.presses.exchange(0, std::memory_order_relaxed);
+        if ((delta != 0 || coarse != 0) && !presses && nowMs_ < m.nextRotateMs) {
+            // Mid-frame turn: put it back for the frame's end. A press never
+            // waits, and takes any held turn with it so the order holds.
+            m.rotateCoarse.fetch_add(coarse, std::memory_order_relaxed);
+            m.rotate.fetch_add(delta, std::memory_order_relaxed);
+            uint64_t none = 0;
+            m.postedNs.compare_exchange_strong(none, posted, std::memory_order_relaxed);
+            held |= 1ULL << i;
+            continue;
+        }
+        if (delta != 0 || coarse != 0) m.nextRotateMs = nowMs_ + rotate_.frameMs;
+        if (delta != 0) delta = accelerate(m, delta);
+        if (inputTap_) {
+            if (coarse != 0) inputTap_(tapCtx_, i, coarse, PRESS_COARSE);
+            if (delta != 0 || presses) inputTap_(tapCtx_, i, delta, presses);
+        }
+        // A coarse turn happens with the button held, before its release
+        if (coarse != 0) m.timer.onCoarseRotate(coarse);
+        if (delta != 0) m.timer.onRotate(delta);
+        if (presses & PRESS_SHORT) m.timer.onShortPress();
+        if (presses & PRESS_DOUBLE) m.timer.onDoublePress();
+        if (presses & PRESS_LONG) m.timer.onLongPress();
+        dispatchCues(m);
+        if (posted) {
+            uint64_t now = monotonicNs();
+            stats_.inputUs.record(now > posted ? (now - posted) / 1000 : 0);
+        }
+        ++events;
+    }
+    if (held) pendingMask_.fetch_or(held, std::memory_order_release);
+
+    // Ticks: only entries that are due
+    events += wheel_.advance(nowMs_);
+    if (pollTap_) pollTap_(tapCtx_, nowMs_, events);
+    return events;
+}
+
+AccelSetting MatHost::accelSetting(const Mat& m) const {
+    const bool comp = m.timer.getMode() == TimerMode::COMPETITION;
+    switch (m.timer.getState()) {
+        case TimerState::SETUP_WORK:
+            return comp ? AccelSetting::NONE : AccelSetting::WORK;
+        case TimerState::SETUP_REST:
+            return AccelSetting::REST;
+        case TimerState::SETUP_ROUNDS:
+            return m.timer.getMode() == TimerMode::DRILLING ? AccelSetting::WORK : AccelSetting::ROUNDS;
+        case TimerState::RUNNING:
+            return AccelSetting::ADJUST;
+        case TimerState::PAUSED:
+            return comp ? AccelSetting::NONE : AccelSetting::ADJUST;
+        default:
+            return AccelSetting::NONE;
+    }
+}
+
+// Detents applied at nowMs_ to the delta the timer sees
+int MatHost::accelerate(Mat& m, int detents) {
+    const uint64_t gap = nowMs_ - m.lastRotateMs;
+    const unsigned n = static_cast<unsigned>(std::abs(detents));
+    const float v = n * 1000.0f / static_cast<float>(gap > rotate_.frameMs ? gap : (rotate_.frameMs ? rotate_.frameMs : 1));
+    m.velocity = gap >= ACCEL_IDLE_MS ? v : (m.velocity + v) / 2;
+    m.lastRotateMs = nowMs_;
+    stats_.detents += n;
+    ++stats_.rotateUpdates;
+
+    const AccelCurve& c = rotate_.curve[static_cast<unsigned>(accelSetting(m))];
+    unsigned step = 1;
+    if (c.maxStep > 1 && m.velocity > c.slowDps) {
+        float f = c.fastDps > c.slowDps ? (m.velocity - c.slowDps) / (c.fastDps - c.slowDps) : 1.0f;
+        if (f > 1.0f) f = 1.0f;
+        step = 1 + static_cast<unsigned>((c.maxStep - 1) * f + 0.5f);
+    }
+    if (step > stats_.maxStep) stats_.maxStep = step;
+    return detents * static_cast<int>(step);
+}
+
+uint64_t MatHost::nextTickMs(unsigned mat) const {
+    if (mat >= count_ || !mats_[mat].tick.armed) return 0;
+    return mats_[mat].tick.deadlineMs;
+}
+
+uint32_t MatHost::untilTickMs(unsigned mat) const {
+    const uint64_t tick = nextTickMs(mat);
+    if (!tick) return 0;
+    if (tick <= nowMs_) return 1;
+    return tick - nowMs_ < TICK_MS ? static_cast<uint32_t>(tick - nowMs_) : TICK_MS;
+}
+
+void MatHost::alignTick(unsigned mat, uint32_t inMs) {
+    if (mat >= count_ || inMs == 0) return;
+    Mat& m = mats_[mat];
+    if (!m.tick.armed) return;
+    wheel_.cancel(m.tick);
+    wheel_.schedule(m.tick, nowMs_ + inMs);
+    publishCueSchedule(m);
+}
+
+bool MatHost::phaseProgress(unsigned mat, uint64_t nowMs, uint32_t& remainingMs, uint32_t& spanMs) const {
+    if (mat >= count_) return false;
+    const Mat& m = mats_[mat];
+    const TimerState state = m.timer.getState();
+    if (state != TimerState::RUNNING && state != TimerState::PAUSED && state != TimerState::FINISHED) {
+        return false;
+    }
+    unsigned total = m.timer.getPhaseTotalSeconds();
+    spanMs = (total + 1) * TICK_MS;
+    if (state == TimerState::FINISHED) {
+        remainingMs = 0;
+        return true;
+    }
+    // Paused (no tick armed): the start of the current second, where resume picks up
+    uint32_t untilTick = TICK_MS;
+    if (m.tick.armed) {
+        untilTick = m.tick.deadlineMs > nowMs ? static_cast<uint32_t>(m.tick.deadlineMs - nowMs) : 0;
+        if (untilTick > TICK_MS) untilTick = TICK_MS;
+    }
+    remainingMs = m.timer.getSecondsRemaining() * TICK_MS + untilTick;
+    if (remainingMs > spanMs) remainingMs = spanMs;  // Time added while running
+    return true;
+}
+
+void MatHost::onTick(void* ctx, uint64_t deadlineMs, uint64_t nowMs) {
+    Mat& m = *static_cast<Mat*>(ctx);
+    MatHostStats& st = m.host->stats_;
+    uint32_t late = nowMs > deadlineMs ? static_cast<uint32_t>(nowMs - deadlineMs) : 0;
+    ++st.ticks;
+    st.tickLateMs += late;
+    if (late > st.maxTickLateMs) st.maxTickLateMs = late;
+    st.tickLateUs.record(static_cast<uint64_t>(late) * 1000);
+    // Re-arm before ticking so sinks see the next deadline; a tick that ends the
+    // session cancels it again through onTransition. Scheduling from the deadline,
+    // not from now, keeps late loops from accumulating drift.
+    m.host->wheel_.schedule(m.tick, deadlineMs + TICK_MS);
+    m.timer.tick();
+    m.host->dispatchCues(m);
+    m.host->publishCueSchedule(m);
+}
+
+void MatHost::onTransition(Mat& m, const TimerSnapshot& snap) {
+    if (snap.state == TimerState::RUNNING) {
+        // Entering or resuming RUNNING starts a fresh second; onTick re-arms itself
+        if (!m.tick.armed) wheel_.schedule(m.tick, nowMs_ + TICK_MS);
+    } else {
+        wheel_.cancel(m.tick);
+    }
+    publishCueSchedule(m);
+    if (transitionSink_) transitionSink_(transitionCtx_, m.index, snap);
+}
+
+void MatHost::dispatchCues(Mat& m) {
+    uint8_t cues = cueMask(m.timer.getDisplayInfo());
+    if (!cues) return;
+    if (cueSink_) cueSink_(cueCtx_, m.index, cues);
+    m.timer.clearAudioFlags();
+}
+
+void MatHost::publishCueSchedule(Mat& m) {
+    if (!scheduleSink_) return;
+    uint64_t deadline = 0;
+    uint8_t cues = 0;
+    CueForecast f;
+    if (m.tick.armed && m.timer.nextCue(f)) {
+        deadline = m.tick.deadlineMs + static_cast<uint64_t>(f.ticks - 1) * TICK_MS;
+        if (f.roundStart)       cues |= CUE_ROUND_START;
+        if (f.tenSecondWarning) cues |= CUE_TEN_SECOND;
+        if (f.roundEnd)         cues |= CUE_ROUND_END;
+        if (f.switchPartner)    cues |= CUE_SWITCH;
+    }
+    if (deadline == m.cueDeadlineMs && cues == m.cueBits) return;
+    m.cueDeadlineMs = deadline;
+    m.cueBits = cues;
+    scheduleSink_(scheduleCtx_, m.index, deadline, cues);
+}
+
+} // namespace bjj
@@ -0,0 +1,207 @@
+/**
+ * BJJ Gym Timer - Multi-Mat Host
+ * Runs N independent TimerLogic instances in one process, all ticked by a
+ * single shared timing wheel. Idle mats cost nothing per loop; a running mat
+ * costs one wheel entry per second.
+ */
+
+#pragma once
+
+#include "hardware.hpp"
+#include "perf_trace.hpp"
+#include "timer_logic.hpp"
+#include "timing_wheel.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace bjj {
+
+constexpr unsigned MAX_MATS = 64;      // Pending-input mask is one 64-bit word
+constexpr unsigned TICK_MS  = 1000;
+
+// Per-mat hardware binding (input source + buzzer sink)
+struct MatHardware {
+    bool hasEncoder{false};
+    EncoderPins pins;
+    unsigned buzzerPin{BUZZER_PIN};
+};
+
+// Knob acceleration: which setting a turn edits picks the curve
+enum class AccelSetting : uint8_t {
+    NONE,       // Menu, competition match time, score actions: one per detent
+    WORK,       // Work time, drilling interval
+    REST,
+    ROUNDS,
+    ADJUST,     // Running/paused time
+};
+constexpr unsigned ACCEL_SETTING_COUNT = 5;
+constexpr unsigned ACCEL_IDLE_MS = 250;   // A gap this long starts a new spin
+
+// Detents per second to step multiplier: 1 up to slowDps, then rising
+// linearly to maxStep at fastDps and above
+struct AccelCurve {
+    float slowDps;
+    float fastDps;
+    unsigned maxStep;       // 1: no acceleration
+};
+
+// Turns are applied at most once per frameMs: the first detent of a spin at
+// once, the rest summed into one delta per frame and scaled by the spin's
+// velocity, so the display updates once per frame however fast the knob goes
+struct RotateConfig {
+    unsigned frameMs{33};
+    AccelCurve curve[ACCEL_SETTING_COUNT] = {
+        {0, 0, 1},          // NONE
+        {5, 25, 8},         // WORK: 15 s up to 2 min per detent
+        {5, 25, 4},         // REST
+        {8, 30, 2},         // ROUNDS
+        {0, 0, 1},          // ADJUST
+    };
+
+    // Every turn as posted, unscaled (replay: records hold applied deltas)
+    static RotateConfig raw() {
+        RotateConfig c;
+        c.frameMs = 0;
+        for (AccelCurve& a : c.curve) a.maxStep = 1;
+        return c;
+    }
+};
+
+// "SETTING:SLOW,FAST,MAX" (work, rest, rounds, adjust) or "off". False if malformed.
+bool parseAccelSpec(const char* spec, RotateConfig& cfg);
+
+// Cumulative since start; copy to take a window (perf HUD)
+struct MatHostStats {
+    uint64_t ticks;
+    uint64_t tickLateMs;         // Sum over ticks of fire time - deadline
+    uint32_t maxTickLateMs;
+    LatencyHistogram tickLateUs;  // The same lateness as a distribution (ms resolution)
+    LatencyHistogram inputUs;    // Posted to applied, one sample per mat per poll
+    uint64_t detents;            // Turns posted...
+    uint64_t rotateUpdates;      // ...and the coalesced deltas they were applied as
+    uint32_t maxStep;            // Largest acceleration multiplier used
+};
+
+// Parse "N:CLK,DT,SW,BUZZER" (N is 1-based). Returns the 0-based mat index, or -1.
+int parseMatSpec(const char* spec, MatHardware& hw);
+
+class MatHost {
+public:
+    using DisplaySink    = void (*)(void* ctx, unsigned mat, const DisplayInfo& info);
+    using CueSink        = void (*)(void* ctx, unsigned mat, uint8_t cues);
+    using TransitionSink = void (*)(void* ctx, unsigned mat, const TimerSnapshot& snap);
+    // The next cue a running mat will raise and when (host clock), republished
+    // whenever that changes; cues == 0 means none pending. Lets audio arm a cue
+    // ahead of the tick that raises it, which runs late by the loop period.
+    using CueScheduleSink = void (*)(void* ctx, unsigned mat, uint64_t deadlineMs, uint8_t cues);
+
+    // Record/replay taps (see input_replay.hpp): the input poll() drained for a
+    // mat, just before applying it, then the poll's clock and event count
+    using InputTap = void (*)(void* ctx, unsigned mat, int delta, uint8_t presses);
+    using PollTap  = void (*)(void* ctx, uint64_t nowMs, unsigned events);
+
+    // PRESS_COARSE marks an input record whose delta was turned with the button held
+    enum : uint8_t { PRESS_SHORT = 1, PRESS_LONG = 2, PRESS_DOUBLE = 4, PRESS_COARSE = 8 };
+
+    MatHost(unsigned count, uint64_t nowMs);
+    MatHost(const MatHost&) = delete;
+    MatHost& operator=(const MatHost&) = delete;
+
+    unsigned size() const { return count_; }
+    TimerLogic& timer(unsigned mat) { return mats_[mat].timer; }
+    const TimerLogic& timer(unsigned mat) const { return mats_[mat].timer; }
+
+    // --- Output sinks (set once at init) ---
+    void setDisplaySink(DisplaySink fn, void* ctx) { displaySink_ = fn; displayCtx_ = ctx; }
+    void setCueSink(CueSink fn, void* ctx) { cueSink_ = fn; cueCtx_ = ctx; }
+    void setTransitionSink(TransitionSink fn, void* ctx) { transitionSink_ = fn; transitionCtx_ = ctx; }
+    void setCueScheduleSink(CueScheduleSink fn, void* ctx) { scheduleSink_ = fn; scheduleCtx_ = ctx; }
+    void setInputTap(InputTap input, PollTap poll, void* ctx) { inputTap_ = input; pollTap_ = poll; tapCtx_ = ctx; }
+
+    // --- Input (any thread) - applied on the next poll() ---
+    void postRotate(unsigned mat, int delta, bool coarse = false);
+    void postPress(unsigned mat, bool isLong);
+    void postDoublePress(unsigned mat);
+    void postInput(unsigned mat, const EncoderEvents& ev);  // Everything one encoder poll recognised
+
+    // How the mat's encoder should resolve presses on its current screen:
+    // pause at press-down while running, double press to start from a menu
+    GesturePolicy gesturePolicy(unsigned mat) const;
+
+    // Apply posted input and fire due ticks. Returns the number of events handled.
+    unsigned poll(uint64_t nowMs);
+
+    // After driving timer(mat) directly on the host thread: play any cues it raised
+    void flushCues(unsigned mat) { if (mat < count_) dispatchCues(mats_[mat]); }
+
+    // Host clock as of the last poll(); nextTickMs() is on the same clock
+    uint64_t nowMs() const { return nowMs_; }
+
+    // Scheduled time of the mat's next tick, or 0 if it is not running
+    uint64_t nextTickMs(unsigned mat) const;
+    // From the last poll to that tick, 1..TICK_MS; 0 if it is not running
+    uint32_t untilTickMs(unsigned mat) const;
+
+    // After TimerLogic::restore(): move the running mat's next tick to inMs
+    // from the last poll (it restarts a full second), keeping a resumed
+    // session's position within the second. inMs == 0: leave it.
+    void alignTick(unsigned mat, uint32_t inMs);
+
+    // Millisecond-resolution position in the current phase, for smooth progress
+    // displays. A phase of N seconds spans N+1 ticks. False unless the mat is
+    // RUNNING, PAUSED or FINISHED.
+    bool phaseProgress(unsigned mat, uint64_t nowMs, uint32_t& remainingMs, uint32_t& spanMs) const;
+
+    // Host thread only
+    const MatHostStats& stats() const { return stats_; }
+    void setRotateConfig(const RotateConfig& cfg) { rotate_ = cfg; }
+
+private:
+    struct Mat {
+        MatHost* host{nullptr};
+        unsigned index{0};
+        TimerLogic timer;
+        TimingWheel::Entry tick;
+        std::atomic<int> rotate{0};
+        std::atomic<int> rotateCoarse{0};
+        std::atomic<uint8_t> presses{0};
+        std::atomic<uint64_t> postedNs{0};  // Oldest input not applied yet
+        uint64_t cueDeadlineMs{0};  // Last published schedule
+        uint8_t cueBits{0};
+        uint64_t nextRotateMs{0};   // Turns before this wait for the frame to end
+        uint64_t lastRotateMs{0};
+        float velocity{0};          // Detents per second, smoothed over the spin
+    };
+
+    static void onTick(void* ctx, uint64_t deadlineMs, uint64_t nowMs);
+    static void onDisplay(void* ctx, const DisplayInfo& info);
+    static void onTimerTransition(void* ctx, const TimerSnapshot& snap);
+    void onTransition(Mat& m, const TimerSnapshot& snap);
+    void dispatchCues(Mat& m);
+    void publishCueSchedule(Mat& m);
+    AccelSetting accelSetting(const Mat& m) const;
+    int accelerate(Mat& m, int detents);
+
+    std::unique_ptr<Mat[]> mats_;
+    unsigned count_;
+    TimingWheel wheel_;
+    uint64_t nowMs_;
+    std::atomic<uint64_t> pendingMask_{0};
+    MatHostStats stats_{};
+    RotateConfig rotate_;
+
+    DisplaySink displaySink_{nullptr};
+    void* displayCtx_{nullptr};
+    CueSink cueSink_{nullptr};
+    void* cueCtx_{nullptr};
+    TransitionSink transitionSink_{nullptr};
+    void* transitionCtx_{nullptr};
+    CueScheduleSink scheduleSink_{nullptr};
+    void* scheduleCtx_{nullptr};
+    InputTap inputTap_{nullptr};
+    PollTap pollTap_{nullptr};
+    void* tapCtx_{nullptr};
+};
+
+} // namespace bjj
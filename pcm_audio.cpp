@@ -0,0 +1,372 @@
+/**
+ * BJJ Gym Timer - PCM Cue Playback Implementation
+ */
+
+#include "pcm_audio.hpp"
+#include "hardware.hpp"
+#include "perf_trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+#if BJJ_WITH_ALSA
+#include <alsa/asoundlib.h>
+#endif
+
+namespace bjj {
+
+const char* const CUE_SAMPLE_NAMES[4] = {"round_start.wav", "ten_second.wav", "round_end.wav", "switch.wav"};
+
+// ============================================================================
+// SAMPLES
+// ============================================================================
+namespace {
+
+struct ToneStep {
+    unsigned freq;            // 0: gap
+    unsigned ms;
+};
+
+// The buzzer patterns from hardware.hpp, in CUE_SAMPLE_NAMES order
+const ToneStep PATTERN_START[]  = {{Tones::AIR_HORN_HIGH, 400}, {0, 150}, {Tones::AIR_HORN_HIGH, 400}};
+const ToneStep PATTERN_TEN[]    = {{Tones::WARNING_LOW, 120}, {0, 120}, {Tones::WARNING_LOW, 120}, {0, 120},
+                                   {Tones::WARNING_LOW, 120}, {0, 120}};
+const ToneStep PATTERN_END[]    = {{Tones::END_BUZZER, 2000}};
+const ToneStep PATTERN_SWITCH[] = {{Tones::SWITCH_CHIRP, 80}, {0, 60}, {Tones::SWITCH_CHIRP, 80}};
+
+template <size_t N>
+void synthesise(const ToneStep (&steps)[N], unsigned rate, std::vector<int16_t>& out) {
+    const double AMPLITUDE = 0.45 * 32767;
+    const unsigned fade = rate / 250;  // 4 ms ramps: no clicks at the edges
+    out.clear();
+    for (const ToneStep& s : steps) {
+        const unsigned n = s.ms * rate / 1000;
+        for (unsigned i = 0; i < n; ++i) {
+            double v = 0;
+            if (s.freq) {
+                // Fundamental plus a third harmonic: buzzer-like, not a pure sine
+                double ph = 2 * M_PI * s.freq * i / rate;
+                v = (std::sin(ph) + std::sin(3 * ph) / 3) * 0.75;
+                unsigned edge = std::min(i, n - 1 - i);
+                if (edge < fade) v *= static_cast<double>(edge) / fade;
+            }
+            out.push_back(static_cast<int16_t>(std::lround(v * AMPLITUDE)));
+        }
+    }
+}
+
+uint32_t le32(const uint8_t* p) { return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24; }
+uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | p[1] << 8); }
+
+// 16-bit PCM WAV -> mono at rate (channels averaged, linear resampling)
+bool decodeWav(const std::string& path, unsigned rate, std::vector<int16_t>& out) {
+    FILE* f = fopen(path.c_str(), "rbe");
+    if (!f) return false;
+    std::vector<uint8_t> data;
+    uint8_t buf[64 * 1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+    fclose(f);
+
+    if (data.size() < 12 || memcmp(&data[0], "RIFF", 4) || memcmp(&data[8], "WAVE", 4)) {
+        fprintf(stderr, "[audio] %s: not a WAV file\n", path.c_str());
+        return false;
+    }
+    unsigned channels = 0, srcRate = 0, bits = 0;
+    const uint8_t* pcm = nullptr;
+    size_t pcmBytes = 0;
+    for (size_t pos = 12; pos + 8 <= data.size();) {
+        uint32_t size = le32(&data[pos + 4]);
+        const uint8_t* body = &data[pos + 8];
+        size_t avail = std::min<size_t>(size, data.size() - pos - 8);
+        if (!memcmp(&data[pos], "fmt ", 4) && avail >= 16) {
+            uint16_t format = le16(body);
+            channels = le16(body + 2);
+            srcRate = le32(body + 4);
+            bits = le16(body + 14);
+            if (format != 1 && format != 0xFFFE) bits = 0;  // PCM or WAVE_FORMAT_EXTENSIBLE only
+        } else if (!memcmp(&data[pos], "data", 4)) {
+            pcm = body;
+            pcmBytes = avail;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    if (!pcm || bits != 16 || !channels || !srcRate) {
+        fprintf(stderr, "[audio] %s: need 16-bit PCM\n", path.c_str());
+        return false;
+    }
+
+    const size_t frames = pcmBytes / (2 * channels);
+    std::vector<int32_t> mono(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        int32_t sum = 0;
+        for (unsigned c = 0; c < channels; ++c) sum += static_cast<int16_t>(le16(pcm + (i * channels + c) * 2));
+        mono[i] = sum / static_cast<int32_t>(channels);
+    }
+    const size_t outFrames = frames * rate / srcRate;
+    out.resize(outFrames);
+    for (size_t i = 0; i < outFrames; ++i) {
+        double src = static_cast<double>(i) * srcRate / rate;
+        size_t j = static_cast<size_t>(src);
+        double t = src - j;
+        int32_t a = mono[j], b = j + 1 < frames ? mono[j + 1] : a;
+        out[i] = static_cast<int16_t>(std::lround(a + (b - a) * t));
+    }
+    return true;
+}
+
+} // namespace
+
+// ============================================================================
+// MIXER
+// ============================================================================
+void CueMixer::load(const std::string& dir, unsigned rate, unsigned channels, unsigned maxFrames) {
+    rate_ = rate;
+    channels_ = channels;
+    acc_.assign(maxFrames, 0);
+    for (unsigned i = 0; i < 4; ++i) {
+        if (!dir.empty() && decodeWav(dir + "/" + CUE_SAMPLE_NAMES[i], rate, samples_[i])) continue;
+        switch (i) {
+            case 0: synthesise(PATTERN_START, rate, samples_[i]); break;
+            case 1: synthesise(PATTERN_TEN, rate, samples_[i]); break;
+            case 2: synthesise(PATTERN_END, rate, samples_[i]); break;
+            default: synthesise(PATTERN_SWITCH, rate, samples_[i]); break;
+        }
+    }
+}
+
+void CueMixer::push(const Trigger& t) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == RING_SIZE) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring_[head & (RING_SIZE - 1)] = t;
+    head_.store(head + 1, std::memory_order_release);
+}
+
+void CueMixer::play(unsigned mat, uint8_t cues) {
+    if (cues && mat < MAX_MATS) push({monotonicNs(), static_cast<uint8_t>(mat), cues, false});
+}
+
+void CueMixer::arm(unsigned mat, uint64_t deadlineMs, uint8_t cues) {
+    if (mat < MAX_MATS) push({deadlineMs * 1000000ULL, static_cast<uint8_t>(mat), cues, true});
+}
+
+// Cue bits in CuePlayer::playPattern() order, one after the other
+void CueMixer::start(uint8_t cues, uint32_t offset) {
+    for (unsigned bit = 0; bit < 4; ++bit) {
+        if (!(cues & (1u << bit)) || samples_[bit].empty()) continue;
+        Voice* v = std::find_if(voices_, voices_ + MAX_VOICES, [](const Voice& x) { return !x.data; });
+        if (v == voices_ + MAX_VOICES) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        *v = {samples_[bit].data(), static_cast<uint32_t>(samples_[bit].size()), 0, offset};
+        offset += v->length;
+    }
+}
+
+void CueMixer::noteOnset(uint32_t us) {
+    scheduled_.fetch_add(1, std::memory_order_relaxed);
+    lastOnsetUs_.store(us, std::memory_order_relaxed);
+    if (us > maxOnsetUs_.load(std::memory_order_relaxed)) maxOnsetUs_.store(us, std::memory_order_relaxed);
+    onsetSumUs_.fetch_add(us, std::memory_order_relaxed);
+}
+
+void CueMixer::noteMixUs(uint32_t us) {
+    if (us > maxMixUs_.load(std::memory_order_relaxed)) maxMixUs_.store(us, std::memory_order_relaxed);
+}
+
+void CueMixer::render(int16_t* out, unsigned frames, uint64_t periodNs) {
+    if (frames > acc_.size()) frames = static_cast<unsigned>(acc_.size());  // Sized by load()
+
+    // Triggers raised since the last period
+    const uint32_t head = head_.load(std::memory_order_acquire);
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    for (; tail != head; ++tail) {
+        const Trigger& t = ring_[tail & (RING_SIZE - 1)];
+        MatCues& m = mats_[t.mat];
+        if (t.armed) {
+            m.armedNs = t.ns;
+            m.armedCues = t.cues;
+            continue;
+        }
+        uint8_t cues = t.cues;
+        // The tick raising an armed cue comes just after it started
+        uint64_t since = t.ns > m.playedNs ? t.ns - m.playedNs : m.playedNs - t.ns;
+        if (m.playedCues && since < MATCH_MS * 1000000ULL) {
+            cues &= ~m.playedCues;
+            m.playedCues = 0;
+        }
+        // ... unless it is still armed (audio thread stalled): play it now instead
+        if (m.armedCues && m.armedNs <= t.ns) m.armedCues = 0;
+        if (cues) {
+            start(cues, 0);
+            immediate_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    tail_.store(tail, std::memory_order_release);
+
+    // Armed cues whose deadline falls in (or before) this period
+    const uint64_t endNs = periodNs + static_cast<uint64_t>(frames) * 1000000000ULL / rate_;
+    for (MatCues& m : mats_) {
+        if (!m.armedCues || m.armedNs >= endNs) continue;
+        uint32_t offset = 0;
+        if (m.armedNs > periodNs) offset = static_cast<uint32_t>((m.armedNs - periodNs) * rate_ / 1000000000ULL);
+        uint64_t startNs = periodNs + static_cast<uint64_t>(offset) * 1000000000ULL / rate_;
+        noteOnset(static_cast<uint32_t>((startNs > m.armedNs ? startNs - m.armedNs : m.armedNs - startNs) / 1000));
+        start(m.armedCues, offset);
+        m.playedNs = m.armedNs;
+        m.playedCues = m.armedCues;
+        m.armedCues = 0;
+    }
+
+    // Mix
+    int32_t* acc = acc_.data();
+    std::fill(acc, acc + frames, 0);
+    for (Voice& v : voices_) {
+        if (!v.data) continue;
+        unsigned i = std::min<uint32_t>(v.wait, frames);
+        v.wait -= i;
+        unsigned n = std::min<uint32_t>(frames - i, v.length - v.pos);
+        const int16_t* src = v.data + v.pos;
+        for (unsigned k = 0; k < n; ++k) acc[i + k] += src[k];
+        v.pos += n;
+        if (v.pos == v.length) v.data = nullptr;
+    }
+    for (unsigned f = 0; f < frames; ++f) {
+        int16_t s = static_cast<int16_t>(std::max(-32768, std::min(32767, acc[f])));
+        for (unsigned c = 0; c < channels_; ++c) *out++ = s;
+    }
+}
+
+PcmStats CueMixer::stats() const {
+    PcmStats st{};
+    st.scheduled = scheduled_.load(std::memory_order_relaxed);
+    st.immediate = immediate_.load(std::memory_order_relaxed);
+    st.lastOnsetUs = lastOnsetUs_.load(std::memory_order_relaxed);
+    st.maxOnsetUs = maxOnsetUs_.load(std::memory_order_relaxed);
+    st.avgOnsetUs = st.scheduled ? static_cast<uint32_t>(onsetSumUs_.load(std::memory_order_relaxed) / st.scheduled) : 0;
+    st.dropped = dropped_.load(std::memory_order_relaxed);
+    st.xruns = xruns_.load(std::memory_order_relaxed);
+    st.maxMixUs = maxMixUs_.load(std::memory_order_relaxed);
+    st.rate = rate_;
+    return st;
+}
+
+// ============================================================================
+// PCM CUE PLAYER
+// ============================================================================
+PcmStats PcmCuePlayer::stats() const {
+    PcmStats st = mixer_.stats();
+    st.periodFrames = periodFrames_;
+    return st;
+}
+
+#if BJJ_WITH_ALSA
+
+bool PcmCuePlayer::start(const std::string& device, const std::string& sampleDir) {
+    if (isRunning()) return true;
+    int err = snd_pcm_open(&pcm_, device.c_str(), SND_PCM_STREAM_PLAYBACK, 0);
+    if (err < 0) {
+        fprintf(stderr, "[audio] %s: %s\n", device.c_str(), snd_strerror(err));
+        pcm_ = nullptr;
+        return false;
+    }
+    err = snd_pcm_set_params(pcm_, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED, CHANNELS, RATE,
+                             1, LATENCY_US);
+    snd_pcm_uframes_t buffer = 0, period = 0;
+    if (err >= 0) err = snd_pcm_get_params(pcm_, &buffer, &period);
+    if (err < 0 || !period) {
+        fprintf(stderr, "[audio] %s: %s\n", device.c_str(), err < 0 ? snd_strerror(err) : "no period size");
+        snd_pcm_close(pcm_);
+        pcm_ = nullptr;
+        return false;
+    }
+    periodFrames_ = static_cast<unsigned>(period);
+    bufferFrames_ = static_cast<unsigned>(buffer);
+
+    // Everything the audio thread touches is allocated here
+    mixer_.load(sampleDir, RATE, CHANNELS, periodFrames_);
+    buffer_.assign(periodFrames_ * CHANNELS, 0);
+    quit_ = false;
+    thread_ = std::thread(&PcmCuePlayer::run, this);
+    return true;
+}
+
+void PcmCuePlayer::stop() {
+    if (!thread_.joinable()) return;
+    quit_ = true;
+    thread_.join();
+    snd_pcm_drop(pcm_);
+    snd_pcm_close(pcm_);
+    pcm_ = nullptr;
+}
+
+void PcmCuePlayer::run() {
+    // Best effort: needs CAP_SYS_NICE or an rtprio limit, harmless without
+    sched_param sp{};
+    sp.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+
+    const uint64_t periodNs = static_cast<uint64_t>(periodFrames_) * 1000000000ULL / RATE;
+    const uint64_t bufferNs = static_cast<uint64_t>(bufferFrames_) * 1000000000ULL / RATE;
+    uint64_t nextNs = 0;  // When the next frame written will be heard
+    while (!quit_.load(std::memory_order_relaxed)) {
+        uint64_t now = monotonicNs();
+        snd_pcm_sframes_t delay = 0;
+        if (snd_pcm_delay(pcm_, &delay) == 0 && delay > 0) {
+            nextNs = now + static_cast<uint64_t>(delay) * 1000000000ULL / RATE;
+        } else if (nextNs < now) {
+            nextNs = now;  // Start, or after an underrun
+        }
+        mixer_.render(buffer_.data(), periodFrames_, nextNs);
+        mixer_.noteMixUs(static_cast<uint32_t>((monotonicNs() - now) / 1000));
+
+        const int16_t* p = buffer_.data();
+        snd_pcm_uframes_t left = periodFrames_;
+        while (left && !quit_.load(std::memory_order_relaxed)) {
+            snd_pcm_sframes_t n = snd_pcm_writei(pcm_, p, left);
+            if (n == -EAGAIN) continue;
+            if (n < 0) {
+                mixer_.countXrun();
+                if (snd_pcm_recover(pcm_, static_cast<int>(n), 1) < 0) return;
+                continue;
+            }
+            p += n * CHANNELS;
+            left -= static_cast<snd_pcm_uframes_t>(n);
+        }
+        nextNs += periodNs;
+
+        // Plugins that never block (null, file) would run ahead of the
+        // clock: keep them at most one device buffer ahead, like hardware
+        now = monotonicNs();
+        if (nextNs > now + bufferNs) {
+            uint64_t wake = nextNs - bufferNs;
+            struct timespec ts;
+            ts.tv_sec = static_cast<time_t>(wake / 1000000000ULL);
+            ts.tv_nsec = static_cast<long>(wake % 1000000000ULL);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+        }
+    }
+}
+
+#else
+
+bool PcmCuePlayer::start(const std::string&, const std::string&) {
+    fprintf(stderr, "[audio] built without ALSA (make ALSA=1, or cmake -DBJJ_WITH_ALSA=ON)\n");
+    return false;
+}
+
+void PcmCuePlayer::stop() {}
+
+void PcmCuePlayer::run() {}
+
+#endif
+
+} // namespace bjj
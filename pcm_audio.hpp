@@ -0,0 +1,160 @@
+/**
+ * BJJ Gym Timer - PCM Cue Playback (ALSA)
+ * Plays the cues as audio samples through a speaker instead of the GPIO
+ * buzzers: one output device shared by every mat, overlapping cues mixed.
+ *
+ * All samples are decoded (or synthesised from the buzzer patterns) into
+ * memory at start(). The audio thread then only drains a lock-free trigger
+ * ring, mixes into a preallocated period buffer and writes it: no locks,
+ * allocation or file I/O, so a slow disk or a busy timer thread can never
+ * cause an underrun. Armed cues start on the exact frame their deadline
+ * falls on, using the device delay to map frames to CLOCK_MONOTONIC.
+ *
+ * Built with ALSA only when enabled (make ALSA=1, cmake -DBJJ_WITH_ALSA=ON);
+ * otherwise start() reports that and fails. CueMixer has no ALSA dependency.
+ */
+
+#pragma once
+
+#include "audio.hpp"
+#include "mat_host.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct _snd_pcm;
+
+namespace bjj {
+
+// Cue sample files looked up in the sample directory, by cue bit
+// (round_start.wav, ten_second.wav, round_end.wav, switch.wav)
+extern const char* const CUE_SAMPLE_NAMES[4];
+
+struct PcmStats {
+    uint32_t scheduled;       // Started on their armed deadline's frame
+    uint32_t immediate;
+    uint32_t lastOnsetUs;     // Scheduled: |start frame time - deadline|
+    uint32_t maxOnsetUs;
+    uint32_t avgOnsetUs;
+    uint32_t dropped;         // Triggers lost to a full ring or no free voice
+    uint32_t xruns;
+    uint32_t maxMixUs;        // Slowest period render
+    unsigned rate;
+    unsigned periodFrames;
+};
+
+// ============================================================================
+// MIXER - samples + voices, rendered one period at a time
+// ============================================================================
+class CueMixer {
+public:
+    static constexpr unsigned MAX_VOICES = 16;
+    static constexpr unsigned RING_SIZE = 64;    // Power of two
+    static constexpr unsigned MATCH_MS = CuePlayer::MATCH_MS;
+
+    // Decode DIR/<CUE_SAMPLE_NAMES> (16-bit PCM WAV, any rate or channel
+    // count) to mono at rate; cues without a file get the buzzer pattern
+    // synthesised. Empty dir: synthesise all. Call before the audio thread.
+    void load(const std::string& dir, unsigned rate, unsigned channels, unsigned maxFrames);
+
+    // Producer side, single thread (the timer thread's cue sinks)
+    void play(unsigned mat, uint8_t cues);
+    void arm(unsigned mat, uint64_t deadlineMs, uint8_t cues);
+
+    // Consumer side (audio thread): frames of interleaved S16 for the period
+    // whose first frame plays at periodNs (monotonicNs() clock)
+    void render(int16_t* out, unsigned frames, uint64_t periodNs);
+
+    PcmStats stats() const;
+    void countXrun() { xruns_.fetch_add(1, std::memory_order_relaxed); }
+    void noteMixUs(uint32_t us);
+
+private:
+    struct Trigger {
+        uint64_t ns;          // Armed: deadline; play: when raised
+        uint8_t mat;
+        uint8_t cues;
+        bool armed;
+    };
+    struct Voice {
+        const int16_t* data;
+        uint32_t length;
+        uint32_t pos;
+        uint32_t wait;        // Frames of silence before the first sample
+    };
+    struct MatCues {
+        uint64_t armedNs;
+        uint8_t armedCues;
+        uint64_t playedNs;    // Last armed cue started, for the tick raising it
+        uint8_t playedCues;
+    };
+
+    void push(const Trigger& t);
+    void start(uint8_t cues, uint32_t offset);
+    void noteOnset(uint32_t us);
+
+    unsigned rate_{48000};
+    unsigned channels_{2};
+    std::vector<int16_t> samples_[4];
+    std::vector<int32_t> acc_;
+
+    // Trigger ring: head_ written by the producer, tail_ by the audio thread
+    Trigger ring_[RING_SIZE];
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+
+    // Audio thread only
+    Voice voices_[MAX_VOICES]{};
+    MatCues mats_[MAX_MATS]{};
+
+    std::atomic<uint32_t> scheduled_{0};
+    std::atomic<uint32_t> immediate_{0};
+    std::atomic<uint32_t> lastOnsetUs_{0};
+    std::atomic<uint32_t> maxOnsetUs_{0};
+    std::atomic<uint64_t> onsetSumUs_{0};
+    std::atomic<uint32_t> dropped_{0};
+    std::atomic<uint32_t> xruns_{0};
+    std::atomic<uint32_t> maxMixUs_{0};
+};
+
+// ============================================================================
+// PCM CUE PLAYER - one ALSA playback device, one audio thread
+// ============================================================================
+class PcmCuePlayer {
+public:
+    static constexpr unsigned RATE = 48000;
+    static constexpr unsigned CHANNELS = 2;
+    static constexpr unsigned LATENCY_US = 10000;  // Device buffer; ALSA picks a quarter as the period
+
+    PcmCuePlayer() = default;
+    ~PcmCuePlayer() { stop(); }
+    PcmCuePlayer(const PcmCuePlayer&) = delete;
+    PcmCuePlayer& operator=(const PcmCuePlayer&) = delete;
+
+    // Open device ("default", "plughw:1,0", "null", "file:FILE=out.raw"),
+    // load the samples and start the audio thread
+    bool start(const std::string& device, const std::string& sampleDir);
+    void stop();
+    bool isRunning() const { return thread_.joinable(); }
+
+    // Same contract as CuePlayer, per mat; timer thread only
+    void play(unsigned mat, uint8_t cues) { mixer_.play(mat, cues); }
+    void arm(unsigned mat, uint64_t deadlineMs, uint8_t cues) { mixer_.arm(mat, deadlineMs, cues); }
+
+    PcmStats stats() const;
+
+private:
+    void run();
+
+    CueMixer mixer_;
+    _snd_pcm* pcm_{nullptr};
+    unsigned periodFrames_{0};
+    unsigned bufferFrames_{0};
+    std::vector<int16_t> buffer_;
+    std::thread thread_;
+    std::atomic<bool> quit_{false};
+};
+
+} // namespace bjj
@@ -0,0 +1,86 @@
+/**
+ * BJJ Gym Timer - Performance HUD Implementation
+ */
+
+#include "perf_hud.hpp"
+#include <cstdio>
+
+namespace bjj {
+
+void PerfHud::setEnabled(bool on) {
+    if (on == enabled_) return;
+    enabled_ = on;
+    // Start from a clean window on the next update()
+    windowStartMs_ = 0;
+    text_[0] = '\0';
+}
+
+void PerfHud::frame(uint64_t renderNs, uint64_t flushNs) {
+    if (!enabled_) return;
+    ++frames_;
+    renderNs_ += renderNs;
+    flushNs_ += flushNs;
+    if (renderNs + flushNs > maxFrameNs_) maxFrameNs_ = renderNs + flushNs;
+}
+
+void PerfHud::setMemory(uint32_t used, uint32_t total, uint8_t fragPct) {
+    sample_.memUsed = used;
+    sample_.memTotal = total;
+    sample_.memFragPct = fragPct;
+}
+
+bool PerfHud::update(const MatHost& host, uint64_t nowMs) {
+    if (!enabled_) return false;
+    const MatHostStats& st = host.stats();
+    if (windowStartMs_ == 0 || nowMs < windowStartMs_) {
+        startWindow(st, nowMs);
+        return false;
+    }
+    const uint64_t span = nowMs - windowStartMs_;
+    if (span < WINDOW_MS) return false;
+
+    sample_.fps = static_cast<float>(frames_ * 1000.0 / span);
+    sample_.renderUs = frames_ ? static_cast<uint32_t>(renderNs_ / frames_ / 1000) : 0;
+    sample_.flushUs = frames_ ? static_cast<uint32_t>(flushNs_ / frames_ / 1000) : 0;
+    sample_.maxFrameUs = static_cast<uint32_t>(maxFrameNs_ / 1000);
+    const uint64_t ticks = st.ticks - ticks_;
+    sample_.tickDriftMs = ticks ? static_cast<uint32_t>((st.tickLateMs - tickLateMs_) / ticks) : 0;
+    sample_.maxTickDriftMs = static_cast<uint32_t>(st.tickLateUs.percentile(100.0, &tickBase_) / 1000);
+    sample_.inputs = static_cast<uint32_t>(st.inputUs.count() - inputBase_.count());
+    sample_.inputP99Us = static_cast<uint32_t>(st.inputUs.percentile(99.0, &inputBase_));
+    sample_.wakeups = static_cast<uint32_t>(wakeups_ * 1000ULL / span);
+    format();
+    startWindow(st, nowMs);
+    return true;
+}
+
+void PerfHud::startWindow(const MatHostStats& st, uint64_t nowMs) {
+    windowStartMs_ = nowMs;
+    wakeups_ = frames_ = 0;
+    renderNs_ = flushNs_ = maxFrameNs_ = 0;
+    ticks_ = st.ticks;
+    tickLateMs_ = st.tickLateMs;
+    tickBase_ = st.tickLateUs;
+    inputBase_ = st.inputUs;
+}
+
+void PerfHud::format() {
+    const HudSample& s = sample_;
+    int n = snprintf(text_, sizeof(text_), "FPS %.1f  render %.2f ms  flush %.2f ms (max %.1f)\n",
+                     s.fps, s.renderUs / 1000.0, s.flushUs / 1000.0, s.maxFrameUs / 1000.0);
+    if (n < 0 || n >= static_cast<int>(sizeof(text_))) return;
+    int m = s.inputs
+        ? snprintf(text_ + n, sizeof(text_) - n, "tick drift %u ms (max %u)  input p99 %.1f ms\n",
+                   s.tickDriftMs, s.maxTickDriftMs, s.inputP99Us / 1000.0)
+        : snprintf(text_ + n, sizeof(text_) - n, "tick drift %u ms (max %u)  input -\n",
+                   s.tickDriftMs, s.maxTickDriftMs);
+    if (m < 0 || (n += m) >= static_cast<int>(sizeof(text_))) return;
+    if (s.memTotal) {
+        snprintf(text_ + n, sizeof(text_) - n, "wakeups %u/s  LV_MEM %u/%u KiB, %u%% frag", s.wakeups,
+                 s.memUsed / 1024, s.memTotal / 1024, s.memFragPct);
+    } else {
+        snprintf(text_ + n, sizeof(text_) - n, "wakeups %u/s", s.wakeups);
+    }
+}
+
+} // namespace bjj
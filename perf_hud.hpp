@@ -0,0 +1,79 @@
+/**
+ * BJJ Gym Timer - Performance HUD
+ * Live numbers for telling a stutter's cause apart in class: frame rate,
+ * render and flush time, tick drift, input latency p99, main-loop wakeups
+ * per second and (GUI) the LVGL memory pool.
+ *
+ * The front end feeds it frames and wakeups as they happen and calls
+ * update() once per loop; every WINDOW_MS it closes a window and rebuilds
+ * text(). Everything between windows is a few counter bumps, and the text
+ * changes once a second, so the HUD costs one small redraw per second.
+ */
+
+#pragma once
+
+#include "mat_host.hpp"
+#include "perf_trace.hpp"
+#include <cstdint>
+
+namespace bjj {
+
+// One closed window
+struct HudSample {
+    float fps;
+    uint32_t renderUs;          // Per frame, average
+    uint32_t flushUs;
+    uint32_t maxFrameUs;        // Render + flush, worst frame
+    uint32_t tickDriftMs;       // Tick fired after its deadline, average
+    uint32_t maxTickDriftMs;
+    uint32_t inputP99Us;        // 0: no input this window
+    uint32_t inputs;
+    uint32_t wakeups;           // Per second
+    uint32_t memUsed;           // LVGL pool bytes; memTotal 0: not reported
+    uint32_t memTotal;
+    uint8_t memFragPct;
+};
+
+class PerfHud {
+public:
+    static constexpr unsigned WINDOW_MS = 1000;
+    static constexpr unsigned TEXT_MAX = 160;
+
+    bool enabled() const { return enabled_; }
+    void setEnabled(bool on);
+    bool toggle() { setEnabled(!enabled_); return enabled_; }
+
+    // As they happen (host thread)
+    void wakeup() { ++wakeups_; }
+    void frame(uint64_t renderNs, uint64_t flushNs);
+    void setMemory(uint32_t used, uint32_t total, uint8_t fragPct);
+
+    // update() at nowMs will close the window: sample anything costly now
+    bool due(uint64_t nowMs) const { return windowStartMs_ != 0 && nowMs >= windowStartMs_ + WINDOW_MS; }
+    // Once per loop: true when a window closed and text() changed
+    bool update(const MatHost& host, uint64_t nowMs);
+
+    const HudSample& sample() const { return sample_; }
+    // Three lines, '\n'-separated
+    const char* text() const { return text_; }
+
+private:
+    void startWindow(const MatHostStats& st, uint64_t nowMs);
+    void format();
+
+    bool enabled_{false};
+    uint64_t windowStartMs_{0};
+    uint32_t wakeups_{0};
+    uint32_t frames_{0};
+    uint64_t renderNs_{0};
+    uint64_t flushNs_{0};
+    uint64_t maxFrameNs_{0};
+    uint64_t ticks_{0};             // Host totals at the window start
+    uint64_t tickLateMs_{0};
+    LatencyHistogram tickBase_;
+    LatencyHistogram inputBase_;
+    HudSample sample_{};
+    char text_[TEXT_MAX] = {};
+};
+
+} // namespace bjj
@@ -0,0 +1,194 @@
+/**
+ * BJJ Gym Timer - Lightweight Performance Tracing
+ * Monotonic timestamps, startup phase profiling and a trace ring (header-only)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+namespace bjj {
+
+inline uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+inline uint64_t monotonicMs() {
+    return monotonicNs() / 1000000ULL;
+}
+
+// Milliseconds since this process was exec'd (kernel start time, USER_HZ resolution).
+// Returns -1 if /proc is unavailable.
+inline double msSinceExec() {
+    FILE* f = std::fopen("/proc/self/stat", "r");
+    if (!f) return -1.0;
+    char buf[1024] = {};
+    size_t n = std::fread(buf, 1, sizeof(buf) - 1, f);
+    std::fclose(f);
+    buf[n] = '\0';
+    const char* p = std::strrchr(buf, ')');  // comm may contain spaces
+    if (!p) return -1.0;
+    unsigned long long startTicks = 0;
+    // Field 22 (starttime) is the 20th field after the closing paren
+    int field = 0;
+    for (const char* q = p + 1; *q; ++q) {
+        if (*q == ' ' && ++field == 20) {
+            startTicks = std::strtoull(q + 1, nullptr, 10);
+            break;
+        }
+    }
+    if (field != 20) return -1.0;
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    double nowMs = ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+    return nowMs - startTicks * 1000.0 / sysconf(_SC_CLK_TCK);
+}
+
+// ============================================================================
+// STARTUP PROFILE - named phase marks, printed once the first frame is up
+// ============================================================================
+class StartupProfile {
+public:
+    static constexpr unsigned MAX_MARKS = 24;
+
+    StartupProfile() : origin_(monotonicNs()), originSinceExec_(msSinceExec()) {}
+
+    // Record the end of a phase. Thread-safe enough for distinct marks from
+    // a couple of init threads: each claims a slot with an atomic increment.
+    void mark(const char* name) {
+        unsigned i = __atomic_fetch_add(&count_, 1u, __ATOMIC_RELAXED);
+        if (i >= MAX_MARKS) return;
+        marks_[i].name = name;
+        marks_[i].ns = monotonicNs();
+    }
+
+    double elapsedMs() const { return (monotonicNs() - origin_) / 1e6; }
+
+    // Print every mark, then check the time from exec to budgetMark against budgetMs
+    void print(const char* tag, const char* budgetMark, double budgetMs) const {
+        unsigned n = count_ < MAX_MARKS ? count_ : MAX_MARKS;
+        double budgetAt = -1.0;
+        for (unsigned i = 0; i < n; ++i) {
+            double ms = (marks_[i].ns - origin_) / 1e6;
+            fprintf(stderr, "[%s] startup %-20s %7.1f ms\n", tag, marks_[i].name, ms);
+            if (std::strcmp(marks_[i].name, budgetMark) == 0) budgetAt = ms;
+        }
+        if (budgetAt < 0) return;
+        double sinceExec = budgetAt + (originSinceExec_ > 0 ? originSinceExec_ : 0);
+        fprintf(stderr, "[%s] startup %s at %.1f ms after exec (budget %.0f ms)%s\n", tag, budgetMark,
+                sinceExec, budgetMs, sinceExec > budgetMs ? " - OVER BUDGET" : "");
+    }
+
+private:
+    struct Mark {
+        const char* name;
+        uint64_t ns;
+    };
+    uint64_t origin_;
+    double originSinceExec_;
+    Mark marks_[MAX_MARKS]{};
+    unsigned count_{0};
+};
+
+// ============================================================================
+// LATENCY HISTOGRAM - log-linear, fixed size, for percentiles without sorting
+// ============================================================================
+// Four buckets per power of two (each at most 25% wide), exact below 4 us.
+// Plain counters: copy it to start a window and pass the copy as `base`.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB = 4;
+    static constexpr unsigned BUCKETS = 32 * SUB;  // Up to ~2^33 us
+
+    void record(uint64_t us) {
+        ++counts_[bucket(us)];
+        ++total_;
+    }
+    uint64_t count() const { return total_; }
+
+    // Upper bound of the bucket holding the p-th percentile (0-100) of the
+    // samples recorded since `base` was copied (all samples if null); 0 if none
+    uint64_t percentile(double p, const LatencyHistogram* base = nullptr) const {
+        uint64_t n = total_ - (base ? base->total_ : 0);
+        if (n == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(n) + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > n) rank = n;
+        uint64_t seen = 0;
+        for (unsigned b = 0; b < BUCKETS; ++b) {
+            seen += counts_[b] - (base ? base->counts_[b] : 0);
+            if (seen >= rank) return upper(b);
+        }
+        return upper(BUCKETS - 1);
+    }
+
+    static unsigned bucket(uint64_t us) {
+        if (us < SUB) return static_cast<unsigned>(us);
+        unsigned msb = 63u - static_cast<unsigned>(__builtin_clzll(us));
+        unsigned b = (msb - 1) * SUB + static_cast<unsigned>((us >> (msb - 2)) & (SUB - 1));
+        return b < BUCKETS ? b : BUCKETS - 1;
+    }
+    static uint64_t upper(unsigned b) {
+        if (b < SUB) return b;
+        unsigned shift = b / SUB - 1;
+        return ((SUB + b % SUB + 1ULL) << shift) - 1;
+    }
+
+private:
+    uint32_t counts_[BUCKETS]{};
+    uint64_t total_{0};
+};
+
+// ============================================================================
+// TRACE RING - the last few named marks of one thread, for post-mortems
+// ============================================================================
+// One writer (the main loop); mark() is a clock read and three stores. Any
+// thread may copy the ring: exact while the writer is stuck, and at worst one
+// torn mark while it runs.
+struct TraceMark {
+    uint64_t ns;
+    const char* name;   // String literal
+    uint32_t arg;
+};
+
+class TraceRing {
+public:
+    static constexpr unsigned SIZE = 128;  // Power of two
+
+    void mark(const char* name, uint32_t arg = 0) {
+        const unsigned i = __atomic_load_n(&head_, __ATOMIC_RELAXED);
+        TraceMark& m = marks_[i % SIZE];
+        m.ns = monotonicNs();
+        m.name = name;
+        m.arg = arg;
+        __atomic_store_n(&head_, i + 1, __ATOMIC_RELEASE);
+    }
+
+    // Copy the newest marks (up to max), oldest first. Returns the number copied.
+    unsigned recent(TraceMark* out, unsigned max) const {
+        const unsigned head = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+        unsigned n = head < SIZE ? head : SIZE;
+        if (n > max) n = max;
+        for (unsigned k = 0; k < n; ++k) out[k] = marks_[(head - n + k) % SIZE];
+        return n;
+    }
+
+    // The newest mark's name, or null before the first
+    const char* last() const {
+        const unsigned head = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+        return head ? marks_[(head - 1) % SIZE].name : nullptr;
+    }
+
+private:
+    TraceMark marks_[SIZE]{};
+    unsigned head_{0};
+};
+
+} // namespace bjj
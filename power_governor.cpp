@@ -0,0 +1,74 @@
+/**
+ * BJJ Gym Timer - Display Power Governor Implementation
+ */
+
+#include "power_governor.hpp"
+#include <ctime>
+
+namespace bjj {
+
+constexpr unsigned PowerGovernor::LOOP_SLEEP_US[POWER_LEVEL_COUNT];
+
+static uint64_t processCpuUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+const char* powerLevelName(PowerLevel level) {
+    switch (level) {
+        case PowerLevel::FULL:  return "full";
+        case PowerLevel::LOW:   return "low";
+        case PowerLevel::BLANK: return "blank";
+    }
+    return "?";
+}
+
+void PowerGovernor::configure(const PowerConfig& cfg, uint64_t nowMs) {
+    cfg_ = cfg;
+    level_ = PowerLevel::FULL;
+    lastActivityMs_ = nowMs;
+    levelStartMs_ = nowMs;
+    levelStartCpuUs_ = processCpuUs();
+    wakeups_ = 0;
+    stats_[static_cast<unsigned>(level_)].entries++;
+}
+
+void PowerGovernor::show(unsigned mat, TimerState state, uint64_t nowMs) {
+    if (mat >= MAX_MATS || state == shown_[mat]) return;
+    if (shown_[mat] == TimerState::RUNNING) --running_;
+    if (state == TimerState::RUNNING) ++running_;
+    shown_[mat] = state;
+    lastActivityMs_ = nowMs;
+}
+
+bool PowerGovernor::input(uint64_t nowMs) {
+    lastActivityMs_ = nowMs;
+    return level_ != PowerLevel::BLANK;
+}
+
+bool PowerGovernor::update(uint64_t nowMs) {
+    const uint64_t idle = nowMs > lastActivityMs_ ? nowMs - lastActivityMs_ : 0;
+    PowerLevel next;
+    if (running_ > 0 || idle < cfg_.holdMs) next = PowerLevel::FULL;
+    else if (cfg_.blankAfterMs != 0 && idle >= cfg_.blankAfterMs) next = PowerLevel::BLANK;
+    else next = PowerLevel::LOW;
+    if (next == level_) return false;
+    account(nowMs);
+    level_ = next;
+    stats_[static_cast<unsigned>(level_)].entries++;
+    return true;
+}
+
+void PowerGovernor::account(uint64_t nowMs) {
+    const uint64_t cpu = processCpuUs();
+    PowerLevelStats& st = stats_[static_cast<unsigned>(level_)];
+    st.wallMs += nowMs > levelStartMs_ ? nowMs - levelStartMs_ : 0;
+    st.cpuUs += cpu - levelStartCpuUs_;
+    st.wakeups += wakeups_;
+    levelStartMs_ = nowMs;
+    levelStartCpuUs_ = cpu;
+    wakeups_ = 0;
+}
+
+} // namespace bjj
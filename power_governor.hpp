@@ -0,0 +1,87 @@
+/**
+ * BJJ Gym Timer - Display Power Governor
+ * Picks how hard the GUI works from what the mats are doing:
+ *   FULL   a mat is RUNNING, or input / a state change arrived in the last
+ *          holdMs: refresh at the LVGL default period, poll input every 5 ms
+ *   LOW    menus, setup, paused or finished timers: slow refresh
+ *   BLANK  nothing running and idle for blankAfterMs: the display is off,
+ *          LVGL's timers are stopped and the loop only polls the encoders
+ *
+ * The front end reports state changes and input as they happen, calls
+ * update() once per loop and applies the level when it changes. Wall time,
+ * process CPU time and loop wakeups are charged to the level they were
+ * spent in, for the exit report.
+ */
+
+#pragma once
+
+#include "mat_host.hpp"
+#include "timer_logic.hpp"
+#include <cstdint>
+
+namespace bjj {
+
+enum class PowerLevel : uint8_t { FULL, LOW, BLANK };
+constexpr unsigned POWER_LEVEL_COUNT = 3;
+
+const char* powerLevelName(PowerLevel level);
+
+struct PowerConfig {
+    uint32_t fullRefreshMs = 33;    // LV_DEF_REFR_PERIOD
+    uint32_t lowRefreshMs = 250;
+    uint32_t holdMs = 5000;         // FULL after input or a state change
+    uint32_t blankAfterMs = 0;      // Idle time before BLANK; 0: never blank
+};
+
+struct PowerLevelStats {
+    uint64_t wallMs;
+    uint64_t cpuUs;                 // Process CPU time, all threads
+    uint64_t wakeups;               // Main-loop iterations
+    uint32_t entries;
+};
+
+class PowerGovernor {
+public:
+    // Main-loop sleep per level. BLANK still polls often enough to catch the
+    // first encoder edge well inside one frame period.
+    static constexpr unsigned LOOP_SLEEP_US[POWER_LEVEL_COUNT] = {5000, 5000, 10000};
+
+    void configure(const PowerConfig& cfg, uint64_t nowMs);
+    const PowerConfig& config() const { return cfg_; }
+
+    // A panel showed info (display sink or follower); ticks of the same state
+    // are not activity, a new state is
+    void show(unsigned mat, TimerState state, uint64_t nowMs);
+
+    // Encoder input on any mat. false: it only woke the blanked display and
+    // should not reach the timer.
+    bool input(uint64_t nowMs);
+
+    void wakeup() { ++wakeups_; }
+
+    // Once per loop: true when level() changed
+    bool update(uint64_t nowMs);
+
+    PowerLevel level() const { return level_; }
+    uint32_t refreshMs() const { return level_ == PowerLevel::FULL ? cfg_.fullRefreshMs : cfg_.lowRefreshMs; }
+    unsigned loopSleepUs() const { return LOOP_SLEEP_US[static_cast<unsigned>(level_)]; }
+
+    // Charge the time since the last level change to the current level
+    void finish(uint64_t nowMs) { account(nowMs); }
+    const PowerLevelStats& stats(PowerLevel level) const { return stats_[static_cast<unsigned>(level)]; }
+
+private:
+    void account(uint64_t nowMs);
+
+    PowerConfig cfg_;
+    PowerLevel level_{PowerLevel::FULL};
+    TimerState shown_[MAX_MATS] = {};
+    unsigned running_{0};           // Mats shown RUNNING
+    uint64_t lastActivityMs_{0};
+    uint64_t levelStartMs_{0};
+    uint64_t levelStartCpuUs_{0};
+    uint64_t wakeups_{0};
+    PowerLevelStats stats_[POWER_LEVEL_COUNT] = {};
+};
+
+} // namespace bjj
@@ -0,0 +1,138 @@
+/**
+ * BJJ Gym Timer - Offscreen Render Benchmark
+ * Renders the real UI into an in-memory framebuffer and compares render and
+ * flush time for XRGB8888 against the RGB565 paths (native, converted, dithered).
+ *
+ * Usage: ./bjj_render_bench [--size WxH] [--mats N] [--frames N]
+ */
+
+#include "lvgl_port.hpp"
+#include "mat_host.hpp"
+#include "perf_trace.hpp"
+#include "ui.hpp"
+#include <lvgl.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace bjj;
+
+struct BenchCase {
+    const char* name;
+    int bpp;
+    lvgl_port_color_t color;
+};
+
+static const BenchCase CASES[] = {
+    {"xrgb8888 -> fb32",        32, LVGL_PORT_COLOR_NATIVE},
+    {"xrgb8888 -> fb16 convert", 16, LVGL_PORT_COLOR_CONVERT},
+    {"rgb565 native -> fb16",   16, LVGL_PORT_COLOR_NATIVE},
+    {"xrgb8888 -> fb16 dither", 16, LVGL_PORT_COLOR_DITHER},
+};
+
+static MatHost* g_host = nullptr;
+static BJJTimerUI* g_ui = nullptr;
+static uint64_t g_virtual_ms = 0;
+
+static void on_display(void*, unsigned mat, const DisplayInfo& info) {
+    g_ui->update(mat, info);
+}
+
+static bool on_progress(void*, unsigned mat, uint32_t& remainingMs, uint32_t& spanMs) {
+    return g_host->phaseProgress(mat, g_virtual_ms, remainingMs, spanMs);
+}
+
+// Time one lv_refr_now(); returns total ns and adds the flush share to flush_ns
+static uint64_t timed_refresh(uint64_t& flush_ns) {
+    uint64_t before;
+    lvgl_port_fb_stats(&before, nullptr, nullptr);
+    uint64_t t0 = monotonicNs();
+    lv_refr_now(NULL);
+    uint64_t total = monotonicNs() - t0;
+    uint64_t after;
+    lvgl_port_fb_stats(&after, nullptr, nullptr);
+    flush_ns += after - before;
+    return total;
+}
+
+static int run_case(const BenchCase& c, int32_t w, int32_t h, unsigned mats, unsigned frames) {
+    lvgl_port_use_fb(nullptr, w, h, c.bpp, c.color);
+    if (lvgl_port_init_display() != 0) return 1;
+
+    MatHost host(mats, 0);
+    BJJTimerUI ui;
+    g_host = &host;
+    g_ui = &ui;
+    ui.create(nullptr, host.size());
+    ui.setProgressSource(on_progress, nullptr);
+    host.setDisplaySink(on_display, nullptr);
+
+    // Every mat straight into a running sparring session (mode, work, rest, rounds)
+    for (unsigned i = 0; i < host.size(); ++i) {
+        for (int p = 0; p < 4; ++p) {
+            host.postPress(i, false);
+            host.poll(0);
+        }
+    }
+
+    // Full-screen frames: raw fill + flush bandwidth
+    uint64_t full_ns = 0, full_flush_ns = 0;
+    const unsigned full_frames = 30;
+    for (unsigned i = 0; i < full_frames; ++i) {
+        lv_obj_invalidate(lv_screen_active());
+        full_ns += timed_refresh(full_flush_ns);
+    }
+
+    // Steady state: clocks tick, arcs animate at ~30 fps of virtual time
+    uint64_t frame_ns = 0, frame_flush_ns = 0, bytes_before, bytes_after;
+    lvgl_port_fb_stats(nullptr, nullptr, &bytes_before);
+    for (unsigned i = 0; i < frames; ++i) {
+        g_virtual_ms += LV_DEF_REFR_PERIOD;
+        host.poll(g_virtual_ms);
+        ui.animate();
+        frame_ns += timed_refresh(frame_flush_ns);
+    }
+    lvgl_port_fb_stats(nullptr, nullptr, &bytes_after);
+
+    printf("%-26s %9.2f %9.2f %10.1f %10.1f %12.0f\n", c.name,
+           (full_ns - full_flush_ns) / 1e6 / full_frames, full_flush_ns / 1e6 / full_frames,
+           (frame_ns - frame_flush_ns) / 1e3 / frames, frame_flush_ns / 1e3 / frames,
+           double(bytes_after - bytes_before) / frames);
+    fflush(stdout);
+
+    g_ui = nullptr;
+    g_host = nullptr;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int w = 800, h = 480;
+    unsigned mats = 1, frames = 900;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--size") && i + 1 < argc) sscanf(argv[++i], "%dx%d", &w, &h);
+        else if (!strcmp(argv[i], "--mats") && i + 1 < argc) mats = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc) frames = std::strtoul(argv[++i], nullptr, 10);
+    }
+    if (frames == 0) frames = 1;
+
+    printf("%dx%d, %u mat(s), %u animated frames\n", w, h, mats, frames);
+    printf("%-26s %9s %9s %10s %10s %12s\n", "", "full ms", "flush ms", "frame us", "flush us", "bytes/frame");
+
+    // One process per case: LVGL and the UI's shared styles are process-global
+    int rc = 0;
+    for (const BenchCase& c : CASES) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            freopen("/dev/null", "w", stderr);
+            _exit(run_case(c, w, h, mats, frames));
+        }
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "[bjj_render_bench] %s failed\n", c.name);
+            rc = 1;
+        }
+    }
+    return rc;
+}
@@ -0,0 +1,192 @@
+/**
+ * BJJ Gym Timer - Input Replay
+ * Feeds a recording (--record) back through MatHost and TimerLogic under a
+ * virtual clock and writes a deterministic trace of everything the displays
+ * and buzzers were told, so two builds can be diffed line by line. Timing
+ * stats go to stderr. Built with BJJ_REPLAY_UI (CMake), every poll also
+ * drives the real UI into an offscreen framebuffer and times the render.
+ *
+ * Usage: ./bjj_replay RECORDING [--realtime] [--trace PATH] [--no-trace]
+ */
+
+#include "input_replay.hpp"
+#include "mat_host.hpp"
+#include "perf_trace.hpp"
+#if BJJ_REPLAY_UI
+#include "lvgl_port.hpp"
+#include "ui.hpp"
+#include <lvgl.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace bjj;
+
+static FILE* g_trace = nullptr;
+static MatHost* g_host = nullptr;
+static uint64_t g_originMs = 0;
+#if BJJ_REPLAY_UI
+static BJJTimerUI* g_ui = nullptr;
+#endif
+
+static const char* stateName(TimerState s) {
+    static const char* NAMES[] = {"MENU", "SETUP_WORK", "SETUP_REST", "SETUP_ROUNDS", "RUNNING", "PAUSED", "FINISHED"};
+    unsigned i = static_cast<unsigned>(s);
+    return i < sizeof(NAMES) / sizeof(NAMES[0]) ? NAMES[i] : "?";
+}
+
+static const char* phaseName(Phase p) {
+    static const char* NAMES[] = {"WORK", "REST", "SWITCH"};
+    unsigned i = static_cast<unsigned>(p);
+    return i < 3 ? NAMES[i] : "?";
+}
+
+// Trace times are virtual, relative to the start of the recording
+static unsigned long long traceMs() {
+    return static_cast<unsigned long long>(g_host->nowMs() - g_originMs);
+}
+
+static void on_display(void*, unsigned mat, const DisplayInfo& info) {
+    if (g_trace) {
+        fprintf(g_trace, "%9llu mat %u display %s %s round %u/%u %us setup %u [%s|%s]\n", traceMs(), mat + 1,
+                stateName(info.state), phaseName(info.phase), info.currentRound, info.totalRounds,
+                info.secondsRemaining, info.setupValue, info.menuLabel, info.valueLabel);
+    }
+#if BJJ_REPLAY_UI
+    g_ui->update(mat, info);
+#endif
+}
+
+static void on_cues(void*, unsigned mat, uint8_t cues) {
+    if (g_trace) fprintf(g_trace, "%9llu mat %u cues 0x%x\n", traceMs(), mat + 1, cues);
+}
+
+static void on_schedule(void*, unsigned mat, uint64_t deadlineMs, uint8_t cues) {
+    if (!g_trace) return;
+    fprintf(g_trace, "%9llu mat %u cue schedule 0x%x at %llu\n", traceMs(), mat + 1, cues,
+            cues ? static_cast<unsigned long long>(deadlineMs - g_originMs) : 0ULL);
+}
+
+static void on_transition(void*, unsigned mat, const TimerSnapshot& snap) {
+    if (!g_trace) return;
+    uint64_t next = g_host->nextTickMs(mat);
+    fprintf(g_trace, "%9llu mat %u transition %s %s round %u/%u %us next tick +%llu\n", traceMs(), mat + 1,
+            stateName(snap.state), phaseName(snap.phase), snap.currentRound, snap.totalRounds,
+            snap.secondsRemaining, next ? static_cast<unsigned long long>(next - g_host->nowMs()) : 0ULL);
+}
+
+#if BJJ_REPLAY_UI
+static bool on_progress(void*, unsigned mat, uint32_t& remainingMs, uint32_t& spanMs) {
+    return g_host->phaseProgress(mat, g_host->nowMs(), remainingMs, spanMs);
+}
+#endif
+
+static void printPercentiles(const char* what, std::vector<uint64_t>& ns) {
+    if (ns.empty()) return;
+    std::sort(ns.begin(), ns.end());
+    uint64_t sum = 0;
+    for (uint64_t v : ns) sum += v;
+    fprintf(stderr, "[bjj_replay] %-7s avg %8.1f us  p50 %8.1f us  p99 %8.1f us  max %8.1f us\n", what,
+            sum / 1e3 / ns.size(), ns[ns.size() / 2] / 1e3, ns[ns.size() * 99 / 100] / 1e3, ns.back() / 1e3);
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = nullptr;
+    const char* tracePath = nullptr;
+    bool realtime = false, trace = true;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--realtime")) realtime = true;
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc) tracePath = argv[++i];
+        else if (!strcmp(argv[i], "--no-trace")) trace = false;
+        else if (argv[i][0] != '-' && !path) path = argv[i];
+        else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "Usage: %s RECORDING [--realtime] [--trace PATH] [--no-trace]\n", argv[0]);
+        return 2;
+    }
+
+    InputReplay replay;
+    if (!replay.open(path)) return 1;
+    if (trace) {
+        g_trace = tracePath ? fopen(tracePath, "w") : stdout;
+        if (!g_trace) {
+            perror(tracePath);
+            return 1;
+        }
+    }
+
+    MatHost host(replay.matCount(), replay.startMs());
+    g_host = &host;
+    g_originMs = replay.startMs();
+    host.setDisplaySink(on_display, nullptr);
+    host.setCueSink(on_cues, nullptr);
+    host.setTransitionSink(on_transition, nullptr);
+    host.setCueScheduleSink(on_schedule, nullptr);
+    host.setRotateConfig(RotateConfig::raw());  // Recorded turns are already coalesced and scaled
+
+#if BJJ_REPLAY_UI
+    lvgl_port_use_fb(nullptr, 800, 480, BJJ_COLOR_DEPTH, LVGL_PORT_COLOR_NATIVE);
+    if (lvgl_port_init_display() != 0) {
+        fprintf(stderr, "[bjj_replay] offscreen display init failed\n");
+        return 1;
+    }
+    BJJTimerUI ui;
+    g_ui = &ui;
+    ui.create(nullptr, host.size() > MAX_PANELS ? MAX_PANELS : host.size());
+    ui.setProgressSource(on_progress, nullptr);
+    std::vector<uint64_t> renderNs;
+#endif
+
+    std::vector<uint64_t> stepNs;
+    unsigned long long inputs = 0, events = 0, diverged = 0;
+    const uint64_t wallStart = monotonicNs();
+    ReplayStep step;
+    uint64_t nextMs;
+    while (replay.peek(nextMs)) {
+        if (realtime) {
+            // Pace virtual time against the wall clock
+            uint64_t dueNs = wallStart + (nextMs - replay.startMs()) * 1000000ULL;
+            uint64_t now = monotonicNs();
+            if (dueNs > now) std::this_thread::sleep_for(std::chrono::nanoseconds(dueNs - now));
+        }
+        uint64_t t0 = monotonicNs();
+        if (!replay.step(host, step)) break;
+        stepNs.push_back(monotonicNs() - t0);
+        inputs += step.inputs;
+        events += step.events;
+        if (step.events != step.recordedEvents) {
+            ++diverged;
+            if (g_trace) {
+                fprintf(g_trace, "%9llu diverged: %u events, recorded %u\n", traceMs(), step.events,
+                        step.recordedEvents);
+            }
+        }
+#if BJJ_REPLAY_UI
+        ui.animate();
+        t0 = monotonicNs();
+        lv_refr_now(NULL);
+        renderNs.push_back(monotonicNs() - t0);
+#endif
+    }
+    const double wallMs = (monotonicNs() - wallStart) / 1e6;
+    const double virtualMs = static_cast<double>(host.nowMs() - replay.startMs());
+    if (g_trace && g_trace != stdout) fclose(g_trace);
+
+    fprintf(stderr, "[bjj_replay] %zu polls, %llu inputs, %llu events, %llu diverged\n", stepNs.size(), inputs,
+            events, diverged);
+    fprintf(stderr, "[bjj_replay] %.1f s of session in %.1f ms (%.0fx)\n", virtualMs / 1000, wallMs,
+            wallMs > 0 ? virtualMs / wallMs : 0.0);
+    printPercentiles("logic", stepNs);
+#if BJJ_REPLAY_UI
+    printPercentiles("render", renderNs);
+#endif
+    return diverged ? 3 : 0;
+}
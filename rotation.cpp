@@ -0,0 +1,305 @@
+/**
+ * BJJ Gym Timer - Partner Rotation Implementation
+ */
+
+#include "rotation.hpp"
+#include "audio.hpp"
+#include "mat_host.hpp"
+#include "perf_trace.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace bjj {
+
+// ============================================================================
+// ROSTER
+// ============================================================================
+static std::string trim(const std::string& s) {
+    size_t b = 0, e = s.size();
+    while (b < e && std::isspace(static_cast<unsigned char>(s[b]))) ++b;
+    while (e > b && std::isspace(static_cast<unsigned char>(s[e - 1]))) --e;
+    return s.substr(b, e - b);
+}
+
+static uint8_t parseBelt(const std::string& s) {
+    static const char* NAMES[] = {"white", "blue", "purple", "brown", "black"};
+    for (unsigned i = 0; i < 5; ++i) {
+        if (!strcasecmp(s.c_str(), NAMES[i])) return static_cast<uint8_t>(i);
+    }
+    if (s.size() == 1 && s[0] >= '0' && s[0] <= '4') return static_cast<uint8_t>(s[0] - '0');
+    return BELT_UNKNOWN;
+}
+
+int parseRosterSpec(const char* spec, std::string& path) {
+    char* end;
+    unsigned long mat = std::strtoul(spec, &end, 10);
+    if (end == spec || *end != ':') {
+        path = spec;
+        return 0;
+    }
+    path = end + 1;
+    if (mat < 1 || mat > MAX_MATS || path.empty()) return -1;
+    return static_cast<int>(mat - 1);
+}
+
+bool PartnerRotation::loadRoster(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "re");
+    if (!f) {
+        perror(path.c_str());
+        return false;
+    }
+    std::vector<Athlete> athletes;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (char* hash = strchr(line, '#')) *hash = '\0';
+        std::string fields[3];
+        unsigned n = 0;
+        for (char* p = line; n < 3; ++n) {
+            char* comma = strchr(p, ',');
+            if (comma) *comma = '\0';
+            fields[n] = trim(p);
+            if (!comma) break;
+            p = comma + 1;
+        }
+        if (fields[0].empty()) continue;
+        Athlete a;
+        a.name = fields[0];
+        if (!fields[1].empty()) a.weightKg = std::strtof(fields[1].c_str(), nullptr);
+        if (!fields[2].empty()) a.belt = parseBelt(fields[2]);
+        athletes.push_back(std::move(a));
+    }
+    fclose(f);
+    if (athletes.size() < 2) {
+        fprintf(stderr, "%s: need at least two athletes\n", path.c_str());
+        return false;
+    }
+    setRoster(std::move(athletes));
+    return true;
+}
+
+void PartnerRotation::setRoster(std::vector<Athlete> athletes) {
+    if (athletes.size() > MAX_ATHLETES) {
+        fprintf(stderr, "[rotation] roster truncated to %u athletes\n", MAX_ATHLETES);
+        athletes.resize(MAX_ATHLETES);
+    }
+    athletes_ = std::move(athletes);
+    buildFeasible();
+    begin(0);
+}
+
+void PartnerRotation::setRules(const RotationRules& rules) {
+    rules_ = rules;
+    buildFeasible();
+    begin(0);
+}
+
+// Unknown weight or belt fits any limit
+void PartnerRotation::buildFeasible() {
+    const unsigned n = static_cast<unsigned>(athletes_.size());
+    stride_ = (n + 63) / 64;
+    feasible_.assign(n * stride_, 0);
+    std::vector<unsigned> options(n, 0);
+    for (unsigned i = 0; i < n; ++i) {
+        const Athlete& a = athletes_[i];
+        for (unsigned j = 0; j < n; ++j) {
+            const Athlete& b = athletes_[j];
+            if (i == j) continue;
+            if (rules_.maxWeightGapKg > 0 && a.weightKg > 0 && b.weightKg > 0 &&
+                std::fabs(a.weightKg - b.weightKg) > rules_.maxWeightGapKg) continue;
+            if (rules_.maxBeltGap > 0 && a.belt != BELT_UNKNOWN && b.belt != BELT_UNKNOWN &&
+                static_cast<unsigned>(std::abs(a.belt - b.belt)) > rules_.maxBeltGap) continue;
+            feasible_[i * stride_ + j / 64] |= 1ULL << (j % 64);
+            ++options[i];
+        }
+    }
+    // Athletes with the fewest possible partners choose first
+    order_.resize(n);
+    for (unsigned i = 0; i < n; ++i) order_[i] = static_cast<uint16_t>(i);
+    std::stable_sort(order_.begin(), order_.end(), [&](uint16_t x, uint16_t y) {
+        if (options[x] != options[y]) return options[x] < options[y];
+        return athletes_[x].weightKg < athletes_[y].weightKg;
+    });
+}
+
+// ============================================================================
+// ROUNDS
+// ============================================================================
+void PartnerRotation::begin(unsigned rounds) {
+    const unsigned n = static_cast<unsigned>(athletes_.size());
+    lastMet_.assign(static_cast<size_t>(n) * n, 0);
+    byes_.assign(n, 0);
+    lastBye_.assign(n, 0);
+    taken_.assign(n, 0);
+    perRound_ = (n + 1) / 2;
+    generated_ = 0;
+    pairs_.resize(static_cast<size_t>(perRound_) * ROUND_RING);
+    stats_ = {};
+    if (n < 2) return;
+    while (generated_ < std::min(rounds, ROUND_RING)) generate();
+}
+
+const Pairing* PartnerRotation::round(unsigned r, unsigned& count) {
+    count = 0;
+    if (athletes_.size() < 2) return nullptr;
+    if (r + ROUND_RING < generated_) return nullptr;
+    while (generated_ <= r) generate();
+    count = perRound_;
+    return &pairs_[static_cast<size_t>(r % ROUND_RING) * perRound_];
+}
+
+void PartnerRotation::generate() {
+    const uint64_t t0 = monotonicNs();
+    const unsigned r = generated_;
+    const unsigned n = static_cast<unsigned>(athletes_.size());
+    Pairing* out = &pairs_[static_cast<size_t>(r % ROUND_RING) * perRound_];
+    if (rules_.constrained()) generateMatched(r, out);
+    else generateRoundRobin(r, out);
+
+    const uint16_t stamp = static_cast<uint16_t>(std::min(r + 1, 0xFFFFu));
+    for (unsigned k = 0; k < perRound_; ++k) {
+        const Pairing& p = out[k];
+        if (p.b == NO_PARTNER) {
+            ++byes_[p.a];
+            lastBye_[p.a] = stamp;
+            continue;
+        }
+        uint16_t& met = lastMet_[static_cast<size_t>(p.a) * n + p.b];
+        if (met) ++stats_.repeats;
+        if (!feasible(p.a, p.b)) ++stats_.relaxed;
+        met = lastMet_[static_cast<size_t>(p.b) * n + p.a] = stamp;
+    }
+    ++generated_;
+    ++stats_.rounds;
+    stats_.lastRoundUs = static_cast<uint32_t>((monotonicNs() - t0) / 1000);
+    stats_.maxRoundUs = std::max(stats_.maxRoundUs, stats_.lastRoundUs);
+}
+
+// Circle method: athlete 0 stays put, the rest rotate one seat per round.
+// An odd roster gets a ghost seat; whoever faces it sits out.
+void PartnerRotation::generateRoundRobin(unsigned r, Pairing* out) {
+    const unsigned n = static_cast<unsigned>(athletes_.size());
+    const unsigned m = n + (n & 1);
+    auto seat = [&](unsigned p) { return p == 0 ? 0u : 1 + (p - 1 + r) % (m - 1); };
+    unsigned k = 0;
+    Pairing bye{0, 0};
+    bool hasBye = false;
+    for (unsigned i = 0; i < m / 2; ++i) {
+        unsigned a = seat(i), b = seat(m - 1 - i);
+        if (a == n || b == n) {
+            bye = {static_cast<uint16_t>(a == n ? b : a), NO_PARTNER};
+            hasBye = true;
+        } else {
+            out[k++] = {static_cast<uint16_t>(a), static_cast<uint16_t>(b)};
+        }
+    }
+    if (hasBye) out[k] = bye;
+}
+
+unsigned PartnerRotation::pickBye(unsigned r) const {
+    const unsigned n = static_cast<unsigned>(athletes_.size());
+    unsigned best = r % n;
+    for (unsigned k = 1; k < n; ++k) {
+        unsigned i = (r + k) % n;
+        if (byes_[i] < byes_[best] || (byes_[i] == byes_[best] && lastBye_[i] < lastBye_[best])) best = i;
+    }
+    return best;
+}
+
+// Greedy: most constrained athlete first, partner who fits the limits and
+// was met longest ago (never is best), closest weight breaking ties
+void PartnerRotation::generateMatched(unsigned r, Pairing* out) {
+    const unsigned n = static_cast<unsigned>(athletes_.size());
+    std::fill(taken_.begin(), taken_.end(), 0);
+    unsigned k = 0;
+    if (n & 1) {
+        unsigned bye = pickBye(r);
+        taken_[bye] = 1;
+        out[perRound_ - 1] = {static_cast<uint16_t>(bye), NO_PARTNER};
+    }
+    for (uint16_t i : order_) {
+        if (taken_[i]) continue;
+        taken_[i] = 1;
+        const uint16_t* met = &lastMet_[static_cast<size_t>(i) * n];
+        const float w = athletes_[i].weightKg;
+        unsigned best = n;
+        uint16_t bestMet = 0;
+        float bestGap = 0;
+        for (int pass = 0; pass < 2 && best == n; ++pass) {
+            // Second pass only when nobody within the limits is left
+            for (unsigned j = 0; j < n; ++j) {
+                if (taken_[j] || (pass == 0 && !feasible(i, j))) continue;
+                float gap = w > 0 && athletes_[j].weightKg > 0 ? std::fabs(w - athletes_[j].weightKg) : 0;
+                if (best == n || met[j] < bestMet || (met[j] == bestMet && gap < bestGap)) {
+                    best = j;
+                    bestMet = met[j];
+                    bestGap = gap;
+                }
+            }
+        }
+        taken_[best] = 1;
+        out[k++] = {i, static_cast<uint16_t>(best)};
+    }
+}
+
+void PartnerRotation::describe(unsigned r, TextList& out) {
+    out.clear();
+    unsigned count;
+    const Pairing* p = round(r, count);
+    const Pairing* bye = nullptr;
+    for (unsigned k = 0; k < count; ++k) {
+        if (p[k].b == NO_PARTNER) bye = &p[k];
+        else out.add("%s - %s", athletes_[p[k].a].name.c_str(), athletes_[p[k].b].name.c_str());
+    }
+    if (bye) out.add("%s sits out", athletes_[bye->a].name.c_str());
+}
+
+// ============================================================================
+// MAT ROTATION
+// ============================================================================
+bool MatRotation::onTransition(const TimerSnapshot& snap) {
+    if (!active()) return false;
+    if (snap.state != TimerState::RUNNING && snap.state != TimerState::PAUSED) {
+        live_ = false;
+        return show(-1);
+    }
+    if (!live_) {
+        // Session start, or the first transition after a resume
+        live_ = true;
+        mode_ = snap.mode;
+        switches_ = 0;
+        engine_.begin(snap.mode == TimerMode::SPARRING ? snap.totalRounds : DRILLING_PLAN);
+    }
+    switch (snap.mode) {
+        case TimerMode::SPARRING:
+            if (snap.phase == Phase::REST) return show(static_cast<int>(snap.currentRound));
+            return show(snap.currentRound <= 1 ? 0 : -1);
+        case TimerMode::DRILLING:
+            return show(switches_ == 0 ? 0 : (switches_ & 1) ? static_cast<int>(switches_ / 2 + 1) : -1);
+        default:
+            return show(-1);  // Competition: one match, no rotation
+    }
+}
+
+bool MatRotation::onCues(uint8_t cues) {
+    if (!live_ || mode_ != TimerMode::DRILLING || !(cues & CUE_SWITCH)) return false;
+    ++switches_;
+    return show((switches_ & 1) ? static_cast<int>(switches_ / 2 + 1) : -1);
+}
+
+bool MatRotation::show(int round) {
+    if (round == shown_) return false;
+    shown_ = round;
+    return true;
+}
+
+void MatRotation::describe(TextList& out) {
+    out.clear();
+    if (shown_ >= 0) engine_.describe(static_cast<unsigned>(shown_), out);
+}
+
+} // namespace bjj
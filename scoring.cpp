@@ -0,0 +1,77 @@
+/**
+ * BJJ Gym Timer - Competition Scoring Implementation
+ */
+
+#include "scoring.hpp"
+
+namespace bjj {
+
+int ScoreTotals::leader() const {
+    if (points[0] != points[1]) return points[0] > points[1] ? 0 : 1;
+    if (advantages[0] != advantages[1]) return advantages[0] > advantages[1] ? 0 : 1;
+    if (penalties[0] != penalties[1]) return penalties[0] < penalties[1] ? 0 : 1;
+    return -1;
+}
+
+void ScoreLog::clear(const ScoreTotals& base) {
+    count_ = 0;
+    applied_ = stacked_ = 0;
+    totals_ = base;
+}
+
+bool ScoreLog::append(const ScoreEvent& e) {
+    if (count_ >= CAPACITY) return false;
+    log_[count_++] = e;
+    return true;
+}
+
+void ScoreLog::apply(const ScoreEvent& e, int sign) {
+    const unsigned a = e.athlete;
+    switch (e.kind) {
+        case ScoreKind::POINTS_2: totals_.points[a] = static_cast<uint16_t>(totals_.points[a] + 2 * sign); break;
+        case ScoreKind::POINTS_3: totals_.points[a] = static_cast<uint16_t>(totals_.points[a] + 3 * sign); break;
+        case ScoreKind::POINTS_4: totals_.points[a] = static_cast<uint16_t>(totals_.points[a] + 4 * sign); break;
+        case ScoreKind::ADVANTAGE: totals_.advantages[a] = static_cast<uint8_t>(totals_.advantages[a] + sign); break;
+        case ScoreKind::PENALTY: totals_.penalties[a] = static_cast<uint8_t>(totals_.penalties[a] + sign); break;
+    }
+}
+
+bool ScoreLog::add(unsigned athlete, ScoreKind kind, unsigned secondsRemaining) {
+    if (athlete > 1 || static_cast<unsigned>(kind) >= SCORE_KIND_COUNT) return false;
+    const uint16_t index = static_cast<uint16_t>(count_);
+    if (!append({ScoreOp::SCORE, static_cast<uint8_t>(athlete), kind, 0, index,
+                 static_cast<uint16_t>(secondsRemaining)})) {
+        return false;
+    }
+    apply(log_[index], 1);
+    // A new score drops whatever could have been redone
+    stack_[applied_++] = index;
+    stacked_ = applied_;
+    return true;
+}
+
+bool ScoreLog::undo(unsigned secondsRemaining) {
+    if (!canUndo()) return false;
+    const uint16_t target = stack_[applied_ - 1];
+    if (!append({ScoreOp::UNDO, log_[target].athlete, log_[target].kind, 0, target,
+                 static_cast<uint16_t>(secondsRemaining)})) {
+        return false;
+    }
+    --applied_;
+    apply(log_[target], -1);
+    return true;
+}
+
+bool ScoreLog::redo(unsigned secondsRemaining) {
+    if (!canRedo()) return false;
+    const uint16_t target = stack_[applied_];
+    if (!append({ScoreOp::REDO, log_[target].athlete, log_[target].kind, 0, target,
+                 static_cast<uint16_t>(secondsRemaining)})) {
+        return false;
+    }
+    ++applied_;
+    apply(log_[target], 1);
+    return true;
+}
+
+} // namespace bjj
@@ -0,0 +1,81 @@
+/**
+ * BJJ Gym Timer - Competition Scoring
+ * Points, advantages and penalties for the two athletes of a competition
+ * match, kept as an append-only event log: every score, undo and redo is
+ * one entry stamped with the match clock, so the log replays to the same
+ * totals and shows who scored what when. Totals are updated in place, and
+ * undo/redo move a cursor over the stack of applied scores: O(1) each.
+ *
+ * Fixed capacity, no allocation - a match that somehow logs more than
+ * CAPACITY entries refuses further input rather than growing.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace bjj {
+
+enum class ScoreKind : uint8_t {
+    POINTS_2,    // Takedown, sweep, knee on belly
+    POINTS_3,    // Guard pass
+    POINTS_4,    // Mount, back control
+    ADVANTAGE,
+    PENALTY,
+};
+constexpr unsigned SCORE_KIND_COUNT = 5;
+
+enum class ScoreOp : uint8_t { SCORE, UNDO, REDO };
+
+// Running totals, athlete 0 = listed first
+struct ScoreTotals {
+    uint16_t points[2]{0, 0};
+    uint8_t advantages[2]{0, 0};
+    uint8_t penalties[2]{0, 0};
+
+    // Points, then advantages, then fewer penalties: 0 or 1, -1 if level
+    int leader() const;
+};
+
+struct ScoreEvent {
+    ScoreOp op;
+    uint8_t athlete;              // SCORE
+    ScoreKind kind;               // SCORE
+    uint8_t reserved;
+    uint16_t target;              // UNDO/REDO: index of the SCORE entry
+    uint16_t secondsRemaining;    // Match clock when entered
+};
+
+class ScoreLog {
+public:
+    static constexpr unsigned CAPACITY = 256;
+
+    // New match; base is where the totals start (a resumed match)
+    void clear(const ScoreTotals& base = ScoreTotals{});
+
+    // false when full, or nothing to undo/redo
+    bool add(unsigned athlete, ScoreKind kind, unsigned secondsRemaining);
+    bool undo(unsigned secondsRemaining);
+    bool redo(unsigned secondsRemaining);
+
+    const ScoreTotals& totals() const { return totals_; }
+    bool canUndo() const { return applied_ > 0; }
+    bool canRedo() const { return applied_ < stacked_; }
+
+    unsigned size() const { return count_; }
+    const ScoreEvent& event(unsigned i) const { return log_[i]; }
+
+private:
+    bool append(const ScoreEvent& e);
+    void apply(const ScoreEvent& e, int sign);
+
+    ScoreEvent log_[CAPACITY];
+    unsigned count_{0};
+    // SCORE entry indices: [0, applied_) count, [applied_, stacked_) can be redone
+    uint16_t stack_[CAPACITY];
+    unsigned applied_{0};
+    unsigned stacked_{0};
+    ScoreTotals totals_;
+};
+
+} // namespace bjj
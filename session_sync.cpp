@@ -0,0 +1,583 @@
+/**
+ * BJJ Gym Timer - Leader/Follower Display Sync Implementation
+ */
+
+#include "session_sync.hpp"
+#include "perf_trace.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace bjj {
+
+static constexpr uint64_t TAG_SOCKET = 0;
+static constexpr uint64_t TAG_WAKE   = 1;
+
+static constexpr int64_t  EPOCH_TOLERANCE_US = 2000;  // Below this the leader's tick jitter is noise
+static constexpr double   MAX_SKEW = 500e-6;          // Crystal oscillators are within ~100 ppm
+static constexpr uint64_t MIN_FIT_SPAN_US = 2000000;
+
+static uint64_t monotonicUs() {
+    return monotonicNs() / 1000ULL;
+}
+
+static size_t timelineBytes(const SyncTimeline& t) {
+    return offsetof(SyncTimeline, segments) + t.count * sizeof(SyncSegment);
+}
+
+static bool validHeader(const SyncHeader& h, size_t len) {
+    return len >= sizeof(SyncHeader) && h.magic == SYNC_MAGIC && h.version == SYNC_VERSION;
+}
+
+// "PORT", "ADDR:PORT" or "HOST[:PORT]" into an IPv4 address
+static bool parseEndpoint(const std::string& spec, bool passive, sockaddr_in& out) {
+    std::string host = spec, port = std::to_string(SYNC_DEFAULT_PORT);
+    size_t colon = spec.rfind(':');
+    if (colon != std::string::npos) {
+        host = spec.substr(0, colon);
+        port = spec.substr(colon + 1);
+    } else if (passive) {
+        host.clear();
+        port = spec;
+    }
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &res) != 0 || !res) {
+        return false;
+    }
+    std::memcpy(&out, res->ai_addr, sizeof(out));
+    freeaddrinfo(res);
+    return true;
+}
+
+// ============================================================================
+// CLOCK ESTIMATOR
+// ============================================================================
+void ClockEstimator::reset() {
+    *this = ClockEstimator();
+}
+
+void ClockEstimator::addSample(uint64_t t1, uint64_t t2, uint64_t t3, uint64_t t4) {
+    int64_t offset = (static_cast<int64_t>(t2 - t1) + static_cast<int64_t>(t3 - t4)) / 2;
+    int64_t delay = static_cast<int64_t>(t4 - t1) - static_cast<int64_t>(t3 - t2);
+    if (delay < 0) delay = 0;
+    lastDelay_ = static_cast<uint32_t>(delay);
+    ++samples_;
+
+    raw_[rawNext_] = {offset, lastDelay_, t1 + (t4 - t1) / 2};
+    rawNext_ = (rawNext_ + 1) % FILTER;
+    if (rawCount_ < FILTER) ++rawCount_;
+
+    // Clock filter: the lowest-delay exchange of the recent few has the least
+    // queuing asymmetry, so only it feeds the model
+    const Raw* best = &raw_[0];
+    for (unsigned i = 1; i < rawCount_; ++i) {
+        if (raw_[i].delay < best->delay) best = &raw_[i];
+    }
+    if (best->local <= lastPointLocal_) return;
+    lastPointLocal_ = best->local;
+    points_[pointNext_] = {best->local, best->offset};
+    pointNext_ = (pointNext_ + 1) % FIT;
+    if (pointCount_ < FIT) ++pointCount_;
+    fit();
+}
+
+void ClockEstimator::fit() {
+    const Point& newest = points_[(pointNext_ + FIT - 1) % FIT];
+    const Point& oldest = points_[pointCount_ < FIT ? 0 : pointNext_];
+    refLocal_ = newest.local;
+    if (pointCount_ < 2 || newest.local - oldest.local < MIN_FIT_SPAN_US) {
+        refOffset_ = static_cast<double>(newest.offset);
+        skew_ = 0;
+        return;
+    }
+    // Least squares of offset against local time, relative to the newest point
+    double sx = 0, sy = 0;
+    for (unsigned i = 0; i < pointCount_; ++i) {
+        sx += -static_cast<double>(newest.local - points_[i].local);
+        sy += static_cast<double>(points_[i].offset - newest.offset);
+    }
+    double mx = sx / pointCount_, my = sy / pointCount_;
+    double sxx = 0, sxy = 0;
+    for (unsigned i = 0; i < pointCount_; ++i) {
+        double x = -static_cast<double>(newest.local - points_[i].local) - mx;
+        double y = static_cast<double>(points_[i].offset - newest.offset) - my;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    double slope = sxx > 0 ? sxy / sxx : 0;
+    if (slope > MAX_SKEW) slope = MAX_SKEW;
+    if (slope < -MAX_SKEW) slope = -MAX_SKEW;
+    skew_ = slope;
+    // Fitted line evaluated at the newest point (x = 0)
+    refOffset_ = static_cast<double>(newest.offset) + my - slope * mx;
+}
+
+int64_t ClockEstimator::offsetUs(uint64_t localUs) const {
+    double dt = static_cast<double>(static_cast<int64_t>(localUs - refLocal_));
+    return static_cast<int64_t>(refOffset_ + skew_ * dt);
+}
+
+// ============================================================================
+// LEADER
+// ============================================================================
+bool SyncLeader::start(const std::string& spec, unsigned matCount) {
+    stop();
+    sockaddr_in addr{};
+    if (!parseEndpoint(spec, true, addr)) {
+        fprintf(stderr, "[sync] bad leader address: %s\n", spec.c_str());
+        return false;
+    }
+    fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        perror("[sync] bind");
+        if (fd_ >= 0) close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.u64 = TAG_SOCKET;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd_, &ev);
+    ev.data.u64 = TAG_WAKE;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+
+    matCount_ = matCount < MAX_MATS ? matCount : MAX_MATS;
+    session_ = static_cast<uint32_t>(getpid()) * 2654435761u ^ static_cast<uint32_t>(monotonicNs());
+    followerCount_ = 0;
+    dirty_ = 0;
+    for (unsigned m = 0; m < MAX_MATS; ++m) {
+        SyncTimeline& t = compiled_[m];
+        std::memset(&t, 0, sizeof(t));
+        t.hdr = {SYNC_MAGIC, SYNC_VERSION, SYNC_TIMELINE, session_};
+        t.mat = static_cast<uint8_t>(m);
+        latest_[m] = t;
+    }
+    running_ = true;
+    thread_ = std::thread(&SyncLeader::run, this);
+    return true;
+}
+
+void SyncLeader::stop() {
+    if (thread_.joinable()) {
+        running_ = false;
+        uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+        thread_.join();
+    }
+    if (fd_ >= 0) close(fd_);
+    if (wakeFd_ >= 0) close(wakeFd_);
+    if (epollFd_ >= 0) close(epollFd_);
+    fd_ = wakeFd_ = epollFd_ = -1;
+}
+
+void SyncLeader::publish(const MatHost& host, unsigned mat) {
+    if (!running_ || mat >= matCount_) return;
+    const TimerLogic& timer = host.timer(mat);
+    DisplayInfo info = timer.getDisplayInfo();
+
+    SyncTimeline t;
+    std::memset(&t, 0, sizeof(t));
+    t.hdr = {SYNC_MAGIC, SYNC_VERSION, SYNC_TIMELINE, session_};
+    t.mat = static_cast<uint8_t>(mat);
+    t.state = static_cast<uint8_t>(info.state);
+    t.mode = static_cast<uint8_t>(info.mode);
+    t.totalRounds = static_cast<uint16_t>(info.totalRounds);
+    t.secondsRemaining = info.secondsRemaining;
+    t.setupValue = info.setupValue;
+    snprintf(t.menuLabel, sizeof(t.menuLabel), "%.*s", static_cast<int>(sizeof(t.menuLabel) - 1), info.menuLabel);
+    snprintf(t.valueLabel, sizeof(t.valueLabel), "%.*s", static_cast<int>(sizeof(t.valueLabel) - 1), info.valueLabel);
+    t.scoring = info.scoring;
+    if (info.scoring) {
+        for (unsigned a = 0; a < 2; ++a) {
+            t.points[a] = info.score.points[a];
+            t.advantages[a] = info.score.advantages[a];
+            t.penalties[a] = info.score.penalties[a];
+        }
+    }
+
+    TimelineSegment segs[SYNC_MAX_SEGMENTS];
+    bool repeats = false;
+    t.count = static_cast<uint16_t>(timer.compileTimeline(segs, SYNC_MAX_SEGMENTS, repeats));
+    t.repeats = repeats;
+    if (t.count == 0) {
+        // No live session: one segment just carries what to show
+        segs[0] = {info.phase, info.currentRound, info.phaseTotalSeconds};
+        t.count = 1;
+    }
+    for (unsigned i = 0; i < t.count; ++i) {
+        t.segments[i] = {static_cast<uint8_t>(segs[i].phase), 0,
+                         static_cast<uint16_t>(segs[i].round), segs[i].seconds};
+    }
+    // The deadline, not the poll time, so the epoch does not wander with loop jitter
+    if (info.state == TimerState::RUNNING && host.nextTickMs(mat)) {
+        t.epochUs = (host.nextTickMs(mat) + static_cast<uint64_t>(info.secondsRemaining) * TICK_MS) * 1000ULL;
+    }
+
+    if (info.state == TimerState::RUNNING) t.secondsRemaining = 0;  // Implied by the epoch
+
+    // Plain ticks leave the timeline as it was; only real changes go out now
+    SyncTimeline& prev = compiled_[mat];
+    int64_t drift = static_cast<int64_t>(t.epochUs - prev.epochUs);
+    if ((t.epochUs == 0) == (prev.epochUs == 0) && drift <= EPOCH_TOLERANCE_US && drift >= -EPOCH_TOLERANCE_US) {
+        t.epochUs = prev.epochUs;
+    }
+    t.version = prev.version;
+    if (std::memcmp(&t, &prev, timelineBytes(t)) == 0) return;
+    t.version = prev.version + 1;
+    prev = t;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        latest_[mat] = t;
+        dirty_ |= 1ULL << mat;
+    }
+    uint64_t one = 1;
+    (void)!write(wakeFd_, &one, sizeof(one));
+}
+
+void SyncLeader::run() {
+    epoll_event events[4];
+    uint64_t nextRefresh = monotonicMs() + REFRESH_MS;
+    while (running_) {
+        uint64_t now = monotonicMs();
+        int timeout = nextRefresh > now ? static_cast<int>(nextRefresh - now) : 0;
+        int n = epoll_wait(epollFd_, events, 4, timeout);
+        if (n < 0 && errno != EINTR) break;
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.u64 == TAG_SOCKET) {
+                receive();
+            } else {
+                uint64_t v;
+                while (read(wakeFd_, &v, sizeof(v)) > 0) {}
+                uint64_t dirty;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    dirty = dirty_;
+                    dirty_ = 0;
+                }
+                if (dirty) sendTimelines(dirty);
+            }
+        }
+        now = monotonicMs();
+        if (now >= nextRefresh) {
+            nextRefresh = now + REFRESH_MS;
+            // Drop followers that stopped pinging, then resend everything
+            for (unsigned i = 0; i < followerCount_;) {
+                if (now - followers_[i].lastSeenMs > FOLLOWER_TTL_MS) followers_[i] = followers_[--followerCount_];
+                else ++i;
+            }
+            followersSeen_.store(followerCount_, std::memory_order_relaxed);
+            sendTimelines(matCount_ >= 64 ? ~0ULL : (1ULL << matCount_) - 1);
+        }
+    }
+}
+
+void SyncLeader::receive() {
+    for (;;) {
+        SyncClock msg;
+        sockaddr_in from{};
+        socklen_t fromLen = sizeof(from);
+        ssize_t len = recvfrom(fd_, &msg, sizeof(msg), 0, reinterpret_cast<sockaddr*>(&from), &fromLen);
+        uint64_t t2 = monotonicUs();
+        if (len < 0) return;
+        if (!validHeader(msg.hdr, static_cast<size_t>(len)) || msg.hdr.type != SYNC_PING ||
+            static_cast<size_t>(len) != sizeof(msg)) {
+            continue;
+        }
+
+        unsigned i = 0;
+        while (i < followerCount_ && std::memcmp(&followers_[i].addr, &from, sizeof(from)) != 0) ++i;
+        bool joined = i == followerCount_;
+        if (joined) {
+            if (followerCount_ == MAX_FOLLOWERS) continue;
+            followers_[followerCount_++].addr = from;
+            followersSeen_.store(followerCount_, std::memory_order_relaxed);
+        }
+        followers_[i].lastSeenMs = t2 / 1000;
+
+        msg.hdr.type = SYNC_PONG;
+        msg.hdr.session = session_;
+        msg.t2 = t2;
+        msg.t3 = monotonicUs();
+        sendto(fd_, &msg, sizeof(msg), 0, reinterpret_cast<sockaddr*>(&from), sizeof(from));
+        pongs_.fetch_add(1, std::memory_order_relaxed);
+        if (joined) sendTimelines(matCount_ >= 64 ? ~0ULL : (1ULL << matCount_) - 1);
+    }
+}
+
+void SyncLeader::sendTimelines(uint64_t mask) {
+    for (uint64_t m = mask; m; m &= m - 1) {
+        unsigned mat = static_cast<unsigned>(__builtin_ctzll(m));
+        if (mat >= matCount_) break;
+        SyncTimeline t;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            t = latest_[mat];
+        }
+        for (unsigned i = 0; i < followerCount_; ++i) {
+            sendto(fd_, &t, timelineBytes(t), 0, reinterpret_cast<const sockaddr*>(&followers_[i].addr),
+                   sizeof(followers_[i].addr));
+            sent_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+SyncLeaderStats SyncLeader::stats() const {
+    SyncLeaderStats s{};
+    s.followers = followersSeen_.load(std::memory_order_relaxed);
+    s.pongs = pongs_.load(std::memory_order_relaxed);
+    s.timelines = sent_.load(std::memory_order_relaxed);
+    return s;
+}
+
+// ============================================================================
+// FOLLOWER
+// ============================================================================
+bool SyncFollower::start(const std::string& leader, unsigned matCount, double skewPpm, int64_t offsetMs) {
+    stop();
+    sockaddr_in addr{};
+    if (!parseEndpoint(leader, false, addr)) {
+        fprintf(stderr, "[sync] cannot resolve leader: %s\n", leader.c_str());
+        return false;
+    }
+    fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        perror("[sync] connect");
+        if (fd_ >= 0) close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.u64 = TAG_SOCKET;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd_, &ev);
+    ev.data.u64 = TAG_WAKE;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+
+    matCount_ = matCount < MAX_MATS ? matCount : MAX_MATS;
+    skew_ = skewPpm * 1e-6;
+    offsetUs_ = offsetMs * 1000;
+    baseUs_ = monotonicUs();
+    clock_.reset();
+    session_ = 0;
+    received_ = 0;
+    maxErrorUs_ = 0;
+    for (bool& h : have_) h = false;
+    for (DisplayInfo& d : shown_) {
+        d = DisplayInfo();
+        d.secondsRemaining = ~0u;  // Forces the first changed()
+    }
+    running_ = true;
+    thread_ = std::thread(&SyncFollower::run, this);
+    return true;
+}
+
+void SyncFollower::stop() {
+    if (thread_.joinable()) {
+        running_ = false;
+        uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+        thread_.join();
+    }
+    if (fd_ >= 0) close(fd_);
+    if (wakeFd_ >= 0) close(wakeFd_);
+    if (epollFd_ >= 0) close(epollFd_);
+    fd_ = wakeFd_ = epollFd_ = -1;
+}
+
+uint64_t SyncFollower::localUs() const {
+    uint64_t real = monotonicUs();
+    return real + offsetUs_ + static_cast<int64_t>(static_cast<double>(real - baseUs_) * skew_);
+}
+
+void SyncFollower::run() {
+    epoll_event events[4];
+    unsigned pings = 0;
+    uint64_t nextPing = monotonicMs();
+    while (running_) {
+        uint64_t now = monotonicMs();
+        if (now >= nextPing) {
+            sendPing();
+            // A quick burst fills the clock filter, then one exchange a second tracks skew
+            nextPing = now + (++pings < ClockEstimator::FILTER ? PING_FAST_MS : PING_MS);
+        }
+        int n = epoll_wait(epollFd_, events, 4, static_cast<int>(nextPing - now));
+        if (n < 0 && errno != EINTR) break;
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.u64 == TAG_SOCKET) receive();
+            else {
+                uint64_t v;
+                while (read(wakeFd_, &v, sizeof(v)) > 0) {}
+            }
+        }
+    }
+}
+
+void SyncFollower::sendPing() {
+    SyncClock msg{};
+    msg.hdr = {SYNC_MAGIC, SYNC_VERSION, SYNC_PING, 0};
+    msg.t1 = localUs();
+    send(fd_, &msg, sizeof(msg), 0);  // ECONNREFUSED until the leader is up: retried next time
+}
+
+void SyncFollower::receive() {
+    for (;;) {
+        SyncTimeline buf;
+        ssize_t len = recv(fd_, &buf, sizeof(buf), 0);
+        uint64_t t4 = localUs();
+        if (len < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            continue;  // ICMP error from an earlier ping
+        }
+        if (!validHeader(buf.hdr, static_cast<size_t>(len))) continue;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (buf.hdr.session != session_) {
+            // Leader restarted: its clock samples and timelines are stale
+            session_ = buf.hdr.session;
+            clock_.reset();
+            for (bool& h : have_) h = false;
+        }
+        if (buf.hdr.type == SYNC_PONG && static_cast<size_t>(len) == sizeof(SyncClock)) {
+            SyncClock c;
+            std::memcpy(&c, &buf, sizeof(c));
+            clock_.addSample(c.t1, c.t2, c.t3, t4);
+        } else if (buf.hdr.type == SYNC_TIMELINE && static_cast<size_t>(len) >= offsetof(SyncTimeline, segments) &&
+                   buf.count <= SYNC_MAX_SEGMENTS && static_cast<size_t>(len) == timelineBytes(buf) &&
+                   buf.mat < matCount_) {
+            SyncTimeline& t = timelines_[buf.mat];
+            if (have_[buf.mat] && static_cast<int32_t>(buf.version - t.version) <= 0) continue;
+            std::memcpy(&t, &buf, static_cast<size_t>(len));
+            have_[buf.mat] = true;
+            ++received_;
+        }
+    }
+}
+
+bool SyncFollower::view(unsigned mat, DisplayInfo& info, uint32_t& remainingMs, uint32_t& spanMs) {
+    if (mat >= matCount_) return false;
+    SyncTimeline t;
+    int64_t offset;
+    uint64_t local = localUs();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!have_[mat] || !clock_.valid()) return false;
+        const SyncTimeline& src = timelines_[mat];
+        std::memcpy(&t, &src, timelineBytes(src));
+        offset = clock_.offsetUs(local);
+        if (skew_ != 0 || offsetUs_ != 0) {
+            // Same machine as the leader: the real monotonic clock is the truth
+            int64_t err = static_cast<int64_t>(local + offset - monotonicUs());
+            if (err < 0) err = -err;
+            if (clock_.samples() >= ClockEstimator::FILTER && err > maxErrorUs_) maxErrorUs_ = err;
+        }
+    }
+
+    info = DisplayInfo();
+    remainingMs = 0;
+    info.state = static_cast<TimerState>(t.state);
+    info.mode = static_cast<TimerMode>(t.mode);
+    info.totalRounds = t.totalRounds;
+    info.setupValue = t.setupValue;
+    snprintf(info.menuLabel, sizeof(info.menuLabel), "%.*s", static_cast<int>(sizeof(t.menuLabel)), t.menuLabel);
+    snprintf(info.valueLabel, sizeof(info.valueLabel), "%.*s", static_cast<int>(sizeof(t.valueLabel)), t.valueLabel);
+    info.secondsRemaining = t.secondsRemaining;
+    info.scoring = t.scoring;
+    for (unsigned a = 0; a < 2; ++a) {
+        info.score.points[a] = t.points[a];
+        info.score.advantages[a] = t.advantages[a];
+        info.score.penalties[a] = t.penalties[a];
+    }
+    const SyncSegment* seg = t.count ? &t.segments[0] : nullptr;
+
+    if (info.state == TimerState::RUNNING && seg && t.epochUs) {
+        // Walk the timeline forward to the leader's present
+        int64_t now = static_cast<int64_t>(local) + offset;
+        int64_t end = static_cast<int64_t>(t.epochUs);
+        unsigned i = 0;
+        bool finished = false;
+        while (now >= end) {
+            if (i + 1 < t.count) {
+                ++i;
+            } else if (!t.repeats) {
+                finished = true;
+                break;
+            }
+            int64_t span = (static_cast<int64_t>(t.segments[i].seconds) + 1) * 1000000;
+            if (t.repeats && i + 1 == t.count && now - end >= span) {
+                end += (now - end) / span * span;  // Skip whole repeats at once
+            }
+            end += span;
+        }
+        seg = &t.segments[i];
+        if (finished) {
+            info.state = TimerState::FINISHED;
+            info.secondsRemaining = 0;
+        } else {
+            info.secondsRemaining = static_cast<unsigned>((end - now) / 1000000);
+            remainingMs = static_cast<uint32_t>((end - now) / 1000);
+        }
+    }
+    if (seg) {
+        info.phase = static_cast<Phase>(seg->phase);
+        info.currentRound = seg->round;
+        info.phaseTotalSeconds = seg->seconds;
+    }
+
+    spanMs = (info.phaseTotalSeconds + 1) * TICK_MS;
+    if (info.state == TimerState::FINISHED) remainingMs = 0;
+    else if (info.state == TimerState::PAUSED) remainingMs = info.secondsRemaining * TICK_MS + TICK_MS;
+    else if (info.state != TimerState::RUNNING) remainingMs = 0;
+    if (remainingMs > spanMs) remainingMs = spanMs;
+    return true;
+}
+
+bool SyncFollower::changed(unsigned mat, DisplayInfo& info) {
+    uint32_t remainingMs, spanMs;
+    if (!view(mat, info, remainingMs, spanMs)) return false;
+    DisplayInfo& last = shown_[mat];
+    if (info.state == last.state && info.mode == last.mode && info.phase == last.phase &&
+        info.currentRound == last.currentRound && info.totalRounds == last.totalRounds &&
+        info.secondsRemaining == last.secondsRemaining && info.setupValue == last.setupValue &&
+        info.scoring == last.scoring && !std::memcmp(&info.score, &last.score, sizeof(info.score)) &&
+        !strcmp(info.menuLabel, last.menuLabel) && !strcmp(info.valueLabel, last.valueLabel)) {
+        return false;
+    }
+    last = info;
+    return true;
+}
+
+SyncFollowerStats SyncFollower::stats() {
+    SyncFollowerStats s{};
+    uint64_t local = localUs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    s.synced = clock_.valid();
+    s.offsetUs = clock_.offsetUs(local);
+    s.skewPpm = clock_.skewPpm();
+    s.delayUs = clock_.delayUs();
+    s.samples = clock_.samples();
+    s.timelines = received_;
+    s.errorUs = static_cast<int64_t>(local + s.offsetUs - monotonicUs());
+    s.maxErrorUs = maxErrorUs_;
+    return s;
+}
+
+} // namespace bjj
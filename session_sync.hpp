@@ -0,0 +1,259 @@
+/**
+ * BJJ Gym Timer - Leader/Follower Display Sync over UDP
+ * Extra displays around one mat follow a leader instead of running their own
+ * timers. The leader sends each mat's compiled session timeline (the current
+ * phase plus every phase still to come) with an epoch: the leader-clock time
+ * at which the current phase ends. Followers estimate the leader's clock with
+ * NTP-style ping/pong exchanges (offset plus skew) and work out the remaining
+ * time locally every frame, so nothing is relayed per tick and a dropped
+ * packet costs nothing until the session actually changes.
+ *
+ *   follower -> leader : SYNC_PING     t1                (follower clock)
+ *   leader -> follower : SYNC_PONG     t1, t2, t3        (leader receive/send)
+ *   leader -> follower : SYNC_TIMELINE on change, and every second per mat
+ *
+ * All timestamps are CLOCK_MONOTONIC microseconds, little-endian on the wire.
+ */
+
+#pragma once
+
+#include "mat_host.hpp"
+#include "timer_logic.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <thread>
+
+namespace bjj {
+
+constexpr uint16_t SYNC_MAGIC        = 0x5342;  // "BS"
+constexpr uint8_t  SYNC_VERSION      = 2;       // 2: timelines carry the score
+constexpr uint16_t SYNC_DEFAULT_PORT = 47474;
+constexpr unsigned SYNC_MAX_SEGMENTS = 48;      // 20 rounds of work + rest, with room
+
+enum SyncType : uint8_t {
+    SYNC_PING     = 1,
+    SYNC_PONG     = 2,
+    SYNC_TIMELINE = 3,
+};
+
+#pragma pack(push, 1)
+struct SyncHeader {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t type;
+    uint32_t session;       // Random per leader run: followers reset on change
+};
+
+struct SyncClock {
+    SyncHeader hdr;
+    uint64_t t1;            // Follower send
+    uint64_t t2;            // Leader receive
+    uint64_t t3;            // Leader send
+};
+
+struct SyncSegment {
+    uint8_t phase;          // Phase
+    uint8_t reserved;
+    uint16_t round;
+    uint32_t seconds;       // Phase length
+};
+
+struct SyncTimeline {
+    SyncHeader hdr;
+    uint32_t version;       // Per mat, bumped on every change (UDP may reorder)
+    uint8_t mat;
+    uint8_t state;          // TimerState
+    uint8_t mode;           // TimerMode
+    uint8_t repeats;        // Last segment repeats until stopped (drilling)
+    uint16_t totalRounds;
+    uint16_t count;         // Segments that follow
+    uint32_t secondsRemaining;  // Current segment while not RUNNING (else see epochUs)
+    uint32_t setupValue;
+    uint64_t epochUs;       // Leader clock: end of segment 0 (RUNNING only)
+    char menuLabel[16];
+    char valueLabel[16];
+    uint16_t points[2];     // Competition score, athletes 1 and 2; 0 unless scoring
+    uint8_t advantages[2];
+    uint8_t penalties[2];
+    uint8_t scoring;        // Competition match on screen: show the score
+    uint8_t reserved2[3];
+    SyncSegment segments[SYNC_MAX_SEGMENTS];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(SyncHeader) == 8, "wire layout");
+static_assert(sizeof(SyncClock) == 32, "wire layout");
+static_assert(sizeof(SyncSegment) == 8, "wire layout");
+
+// Leader-clock model built from ping/pong samples: offset at a reference
+// point plus a linear skew, fitted over the best (lowest-delay) samples
+class ClockEstimator {
+public:
+    static constexpr unsigned FILTER = 8;   // Raw samples per min-delay pick
+    static constexpr unsigned FIT = 32;     // Filtered points in the skew fit
+
+    void reset();
+    // t1/t4 on the local clock, t2/t3 on the leader's
+    void addSample(uint64_t t1, uint64_t t2, uint64_t t3, uint64_t t4);
+
+    bool valid() const { return pointCount_ > 0; }
+    int64_t offsetUs(uint64_t localUs) const;  // leader - local at localUs
+    double skewPpm() const { return -skew_ * 1e6; }  // Local clock rate vs. the leader
+    uint32_t delayUs() const { return lastDelay_; }
+    uint32_t samples() const { return samples_; }
+
+private:
+    struct Raw { int64_t offset; uint32_t delay; uint64_t local; };
+    struct Point { uint64_t local; int64_t offset; };
+
+    void fit();
+
+    Raw raw_[FILTER] = {};
+    unsigned rawCount_ = 0, rawNext_ = 0;
+    Point points_[FIT] = {};
+    unsigned pointCount_ = 0, pointNext_ = 0;
+    uint64_t lastPointLocal_ = 0;
+
+    uint64_t refLocal_ = 0;
+    double refOffset_ = 0;
+    double skew_ = 0;       // d(offset)/d(local)
+    uint32_t lastDelay_ = 0;
+    uint32_t samples_ = 0;
+};
+
+struct SyncLeaderStats {
+    uint32_t followers;
+    uint32_t pongs;
+    uint64_t timelines;     // Timeline packets sent (all followers)
+};
+
+class SyncLeader {
+public:
+    static constexpr unsigned MAX_FOLLOWERS = 16;
+    static constexpr unsigned REFRESH_MS = 1000;    // Resend every mat this often
+    static constexpr unsigned FOLLOWER_TTL_MS = 10000;
+
+    SyncLeader() = default;
+    ~SyncLeader() { stop(); }
+    SyncLeader(const SyncLeader&) = delete;
+    SyncLeader& operator=(const SyncLeader&) = delete;
+
+    // spec: "PORT" (all interfaces) or "ADDR:PORT"
+    bool start(const std::string& spec, unsigned matCount);
+    void stop();
+    bool isRunning() const { return thread_.joinable(); }
+
+    // Timer thread: recompile a mat's timeline after a display change. Plain
+    // ticks leave it unchanged, so only real changes are sent immediately.
+    void publish(const MatHost& host, unsigned mat);
+
+    SyncLeaderStats stats() const;
+
+private:
+    struct Follower {
+        sockaddr_in addr;
+        uint64_t lastSeenMs = 0;
+    };
+
+    void run();
+    void receive();
+    void sendTimelines(uint64_t mask);
+
+    unsigned matCount_ = 0;
+    uint32_t session_ = 0;
+    int fd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // I/O thread only
+    Follower followers_[MAX_FOLLOWERS];
+    unsigned followerCount_ = 0;
+
+    // Timer thread only
+    SyncTimeline compiled_[MAX_MATS];
+
+    // Shared, under mutex_
+    mutable std::mutex mutex_;
+    SyncTimeline latest_[MAX_MATS];
+    uint64_t dirty_ = 0;
+
+    std::atomic<uint32_t> pongs_{0}, followersSeen_{0};
+    std::atomic<uint64_t> sent_{0};
+};
+
+struct SyncFollowerStats {
+    bool synced;
+    int64_t offsetUs;
+    double skewPpm;
+    uint32_t delayUs;
+    uint32_t samples;
+    uint32_t timelines;
+    int64_t errorUs;        // Estimate vs. true leader clock; loopback with injected skew only
+    int64_t maxErrorUs;
+};
+
+class SyncFollower {
+public:
+    static constexpr unsigned PING_FAST_MS = 100;   // First FILTER pings
+    static constexpr unsigned PING_MS = 1000;
+
+    SyncFollower() = default;
+    ~SyncFollower() { stop(); }
+    SyncFollower(const SyncFollower&) = delete;
+    SyncFollower& operator=(const SyncFollower&) = delete;
+
+    // leader: "HOST[:PORT]". skewPpm/offsetMs distort this side's clock so a
+    // leader and followers on one machine behave like separate boards.
+    bool start(const std::string& leader, unsigned matCount, double skewPpm = 0, int64_t offsetMs = 0);
+    void stop();
+    bool isRunning() const { return thread_.joinable(); }
+
+    // The mat as the leader shows it right now. remainingMs/spanMs follow the
+    // MatHost::phaseProgress convention. False until a timeline has arrived.
+    bool view(unsigned mat, DisplayInfo& info, uint32_t& remainingMs, uint32_t& spanMs);
+
+    // Main thread: view() that only returns true when something visible changed
+    // since the last call, for displays that redraw on change
+    bool changed(unsigned mat, DisplayInfo& info);
+
+    // Follower clock (monotonic, plus any injected skew/offset)
+    uint64_t localUs() const;
+
+    SyncFollowerStats stats();
+
+private:
+    void run();
+    void sendPing();
+    void receive();
+
+    unsigned matCount_ = 0;
+    int fd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // Main thread only
+    DisplayInfo shown_[MAX_MATS];
+
+    // Injected clock error (test only)
+    double skew_ = 0;
+    int64_t offsetUs_ = 0;
+    uint64_t baseUs_ = 0;
+
+    // Shared, under mutex_
+    std::mutex mutex_;
+    ClockEstimator clock_;
+    uint32_t session_ = 0;
+    SyncTimeline timelines_[MAX_MATS];
+    bool have_[MAX_MATS] = {};
+    uint32_t received_ = 0;
+    int64_t maxErrorUs_ = 0;
+};
+
+} // namespace bjj
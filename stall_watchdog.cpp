@@ -0,0 +1,224 @@
+/**
+ * BJJ Gym Timer - Main-Loop Stall Watchdog Implementation
+ */
+
+#include "stall_watchdog.hpp"
+#include "alloc_track.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <execinfo.h>
+#include <unistd.h>
+
+namespace bjj {
+
+const int StallWatchdog::STACK_SIGNAL = SIGURG;
+
+namespace {
+
+// The stack capture: the handler runs on the stuck thread and answers the
+// request it finds. One watchdog per process.
+void* g_frames[StallWatchdog::STACK_FRAMES];
+std::atomic<int> g_frameCount{0};
+std::atomic<unsigned> g_requested{0};
+std::atomic<unsigned> g_captured{0};
+
+void captureStack(int) {
+    const int saved = errno;
+    const unsigned seq = g_requested.load(std::memory_order_acquire);
+    g_frameCount.store(backtrace(g_frames, StallWatchdog::STACK_FRAMES), std::memory_order_relaxed);
+    g_captured.store(seq, std::memory_order_release);
+    errno = saved;
+}
+
+} // namespace
+
+bool StallWatchdog::start(const WatchdogConfig& cfg, const TraceRing* trace) {
+    if (isRunning()) return true;
+    cfg_ = cfg;
+    trace_ = trace;
+    watched_ = pthread_self();
+    stallNs_ = static_cast<uint64_t>(cfg.stallMs) * 1000000ULL;
+    notifyMs_ = 0;
+    if (openNotify()) {
+        notifyMs_ = cfg.notifyMs;
+        const char* usec = getenv("WATCHDOG_USEC");
+        const char* pid = getenv("WATCHDOG_PID");
+        if (!notifyMs_ && usec && (!pid || strtol(pid, nullptr, 10) == getpid())) {
+            notifyMs_ = static_cast<uint32_t>(strtoull(usec, nullptr, 10) / 2000);
+        }
+    }
+    if (!stallNs_ && !notifyMs_) {
+        if (notifyFd_ >= 0) ::close(notifyFd_);
+        notifyFd_ = -1;
+        return false;
+    }
+    if (stallNs_) {
+        // backtrace() loads its unwinder on first use; do that now, not in the handler
+        void* frame;
+        backtrace(&frame, 1);
+        struct sigaction sa {};
+        sa.sa_handler = captureStack;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        sigaction(STACK_SIGNAL, &sa, nullptr);
+    }
+    lastBeatNs_.store(monotonicNs(), std::memory_order_relaxed);
+    stopping_ = false;
+    if (notifyFd_ >= 0) notify("READY=1");
+    thread_ = std::thread(&StallWatchdog::run, this);
+    return true;
+}
+
+void StallWatchdog::stop() {
+    if (!isRunning()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    if (notifyFd_ >= 0) {
+        notify("STOPPING=1");
+        ::close(notifyFd_);
+        notifyFd_ = -1;
+    }
+}
+
+StallStats StallWatchdog::stats() const {
+    StallStats st{};
+    st.stalls = stalls_.load(std::memory_order_relaxed);
+    st.captures = captures_.load(std::memory_order_relaxed);
+    st.totalStallMs = totalStallNs_.load(std::memory_order_relaxed) / 1000000ULL;
+    st.maxStallMs = static_cast<uint32_t>(maxStallNs_.load(std::memory_order_relaxed) / 1000000ULL);
+    st.maxPhase = maxPhase_.load(std::memory_order_relaxed);
+    st.notifies = notifies_.load(std::memory_order_relaxed);
+    st.notifyErrors = notifyErrors_.load(std::memory_order_relaxed);
+    return st;
+}
+
+// Watched thread, after a long gap: charge it to the phase that took longest
+void StallWatchdog::countStall(uint64_t gapNs) {
+    stalls_.fetch_add(1, std::memory_order_relaxed);
+    totalStallNs_.fetch_add(gapNs, std::memory_order_relaxed);
+    if (gapNs <= maxStallNs_.load(std::memory_order_relaxed)) return;
+    maxStallNs_.store(gapNs, std::memory_order_relaxed);
+    const char* phase = nullptr;
+    if (trace_) {
+        TraceMark marks[TraceRing::SIZE];
+        const unsigned n = trace_->recent(marks, TraceRing::SIZE);
+        const uint64_t end = lastBeatNs_.load(std::memory_order_relaxed);
+        uint64_t longest = 0;
+        for (unsigned i = 0; i < n; ++i) {
+            const uint64_t next = i + 1 < n ? marks[i + 1].ns : end;
+            if (next + gapNs < end) continue;  // Before the gap
+            if (next - marks[i].ns > longest) {
+                longest = next - marks[i].ns;
+                phase = marks[i].name;
+            }
+        }
+    }
+    maxPhase_.store(phase, std::memory_order_relaxed);
+}
+
+void StallWatchdog::run() {
+    // Check four times per threshold: a stall is caught within 1.25x stallMs
+    uint32_t checkMs = stallNs_ ? std::max<uint32_t>(cfg_.stallMs / 4, 5) : UINT32_MAX;
+    // Pings at most 1.5x notifyMs apart, well inside systemd's timeout
+    if (notifyMs_ && notifyMs_ / 2 < checkMs) checkMs = std::max<uint32_t>(notifyMs_ / 2, 1);
+    const uint64_t freshNs = stallNs_ ? stallNs_ : static_cast<uint64_t>(notifyMs_) * 2000000ULL;
+    uint64_t stuckBeat = 0;       // Heartbeat the current stall started from; 0: none
+    uint64_t lastNotify = 0;
+    unsigned seq = 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        cv_.wait_for(lock, std::chrono::milliseconds(checkMs));
+        if (stopping_) break;
+        const uint64_t now = monotonicNs();
+        const uint64_t beat = lastBeatNs_.load(std::memory_order_acquire);
+        const uint64_t age = now > beat ? now - beat : 0;
+
+        if (stuckBeat && beat != stuckBeat) {
+            char line[160];
+            writeErr(line, snprintf(line, sizeof(line), "%sstall: main loop back after %.0f ms\n", cfg_.prefix,
+                                    (beat - stuckBeat) / 1e6), sizeof(line));
+            stuckBeat = 0;
+        }
+        if (stallNs_ && !stuckBeat && age >= stallNs_) {
+            stuckBeat = beat;
+            lock.unlock();
+            report(beat, now, ++seq);
+            lock.lock();
+        }
+        if (notifyMs_ && age < freshNs && now - lastNotify >= notifyMs_ * 1000000ULL) {
+            lastNotify = now;
+            notify("WATCHDOG=1");
+        }
+    }
+}
+
+// Watchdog thread, once per stall in progress
+void StallWatchdog::report(uint64_t beatNs, uint64_t nowNs, unsigned seq) {
+    captures_.fetch_add(1, std::memory_order_relaxed);
+    char line[256];
+    char where[160];
+    const char* phase = trace_ ? trace_->last() : nullptr;
+    writeErr(line, snprintf(line, sizeof(line), "%sstall: main loop blocked %.0f ms in %s (threshold %u ms)\n",
+                            cfg_.prefix, (nowNs - beatNs) / 1e6, phase ? phase : "?", cfg_.stallMs), sizeof(line));
+
+    g_requested.store(seq, std::memory_order_release);
+    bool captured = pthread_kill(watched_, STACK_SIGNAL) == 0;
+    for (unsigned waited = 0; captured && g_captured.load(std::memory_order_acquire) != seq; ++waited) {
+        if (waited == CAPTURE_WAIT_MS) captured = false;
+        else usleep(1000);
+    }
+    if (captured) {
+        // Frame 0 is the handler, frame 1 the kernel's signal trampoline
+        const int count = g_frameCount.load(std::memory_order_relaxed);
+        for (int i = 2; i < count; ++i) {
+            describeCodeAddress(g_frames[i], where, sizeof(where));
+            writeErr(line, snprintf(line, sizeof(line), "%sstall:   at %s\n", cfg_.prefix, where), sizeof(line));
+        }
+    } else {
+        writeErr(line, snprintf(line, sizeof(line), "%sstall:   no stack (thread in uninterruptible sleep?)\n",
+                                cfg_.prefix), sizeof(line));
+    }
+
+    if (!trace_) return;
+    TraceMark marks[REPORT_MARKS];
+    const unsigned n = trace_->recent(marks, REPORT_MARKS);
+    for (unsigned i = 0; i < n; ++i) {
+        const double ago = (static_cast<int64_t>(marks[i].ns) - static_cast<int64_t>(nowNs)) / 1e6;
+        const int len = marks[i].arg
+            ? snprintf(line, sizeof(line), "%sstall:   %9.1f ms  %s %u\n", cfg_.prefix, ago, marks[i].name, marks[i].arg)
+            : snprintf(line, sizeof(line), "%sstall:   %9.1f ms  %s\n", cfg_.prefix, ago, marks[i].name);
+        writeErr(line, len, sizeof(line));
+    }
+}
+
+// $NOTIFY_SOCKET: a path, or @name in the abstract namespace
+bool StallWatchdog::openNotify() {
+    const char* path = getenv("NOTIFY_SOCKET");
+    if (!path || (path[0] != '/' && path[0] != '@')) return false;
+    const size_t len = strlen(path);
+    if (len >= sizeof(notifyAddr_.sun_path)) return false;
+    notifyAddr_ = {};
+    notifyAddr_.sun_family = AF_UNIX;
+    memcpy(notifyAddr_.sun_path, path, len);
+    if (path[0] == '@') notifyAddr_.sun_path[0] = '\0';
+    notifyLen_ = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + len);
+    notifyFd_ = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    return notifyFd_ >= 0;
+}
+
+void StallWatchdog::notify(const char* msg) {
+    const ssize_t n = sendto(notifyFd_, msg, strlen(msg), MSG_DONTWAIT | MSG_NOSIGNAL,
+                             reinterpret_cast<const struct sockaddr*>(&notifyAddr_), notifyLen_);
+    if (n < 0) notifyErrors_.fetch_add(1, std::memory_order_relaxed);
+    else if (!strcmp(msg, "WATCHDOG=1")) notifies_.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace bjj
@@ -0,0 +1,121 @@
+/**
+ * BJJ Gym Timer - Main-Loop Stall Watchdog
+ * The main loop calls beat() once per iteration and marks its phases in a
+ * TraceRing. A watchdog thread checks the heartbeat; when it is older than
+ * stallMs the loop is stuck (a blocking buzzer cue, an SD card write, a full
+ * LVGL redraw) and the thread reports once per stall:
+ *   - the phase the loop is stuck in and for how long so far
+ *   - the main thread's stack, captured by the main thread itself from a
+ *     STACK_SIGNAL handler (backtrace), resolved here with dladdr
+ *   - the trace ring's last REPORT_MARKS marks
+ * and a line with the full length once the loop is back. Every gap between
+ * beats of stallMs or more is counted by beat() itself, caught in the act or
+ * not. The capture signal uses SA_RESTART, but a sleep that does not retry
+ * on EINTR (usleep) ends early when it is the call that stalled.
+ *
+ * Under systemd (Type=notify, WatchdogSec=) the thread also sends READY=1
+ * and then WATCHDOG=1 to $NOTIFY_SOCKET every half $WATCHDOG_USEC, but only
+ * while the heartbeat is fresh: a hung loop stops the pings and systemd
+ * restarts the service.
+ *
+ * Reports go straight to fd 2 from stack buffers: the stuck thread may hold
+ * stdio's lock, and the steady state does not allocate.
+ */
+
+#pragma once
+
+#include "perf_trace.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <mutex>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+
+namespace bjj {
+
+struct WatchdogConfig {
+    uint32_t stallMs = 1000;       // Heartbeat age that counts as a stall; 0: no stall detection
+    uint32_t notifyMs = 0;         // WATCHDOG=1 interval; 0: half $WATCHDOG_USEC, if systemd set it
+    const char* prefix = "";       // Report line prefix
+};
+
+struct StallStats {
+    uint32_t stalls;               // Gaps between beats of stallMs or more
+    uint32_t captures;             // Stalls caught in progress (stack + trace reported)
+    uint64_t totalStallMs;
+    uint32_t maxStallMs;
+    const char* maxPhase;          // Trace mark the longest stall followed
+    uint32_t notifies;             // WATCHDOG=1 sent
+    uint32_t notifyErrors;
+};
+
+class StallWatchdog {
+public:
+    static constexpr unsigned STACK_FRAMES = 24;
+    static constexpr unsigned REPORT_MARKS = 16;
+    static constexpr unsigned CAPTURE_WAIT_MS = 100;  // For the stuck thread to run the signal handler
+    static const int STACK_SIGNAL;                     // SIGURG: ignored by default, unused here
+
+    StallWatchdog() = default;
+    ~StallWatchdog() { stop(); }
+    StallWatchdog(const StallWatchdog&) = delete;
+    StallWatchdog& operator=(const StallWatchdog&) = delete;
+
+    // Call from the thread to watch, right before its loop. trace: its marks.
+    // false if there is nothing to do (no stall detection, no notify socket).
+    bool start(const WatchdogConfig& cfg, const TraceRing* trace);
+    void stop();
+    bool isRunning() const { return thread_.joinable(); }
+
+    // Once per loop iteration, on the watched thread
+    void beat() {
+        const uint64_t now = monotonicNs();
+        const uint64_t gap = now - lastBeatNs_.load(std::memory_order_relaxed);
+        lastBeatNs_.store(now, std::memory_order_release);
+        if (stallNs_ && gap >= stallNs_) countStall(gap);
+    }
+
+    // Notify interval in effect, ms (0: not notifying)
+    uint32_t notifyMs() const { return notifyMs_; }
+
+    StallStats stats() const;
+
+private:
+    void run();
+    void countStall(uint64_t gapNs);
+    void report(uint64_t beatNs, uint64_t nowNs, unsigned seq);
+    bool openNotify();
+    void notify(const char* msg);
+
+    WatchdogConfig cfg_;
+    const TraceRing* trace_ = nullptr;
+    pthread_t watched_{};
+    uint64_t stallNs_ = 0;
+    uint32_t notifyMs_ = 0;
+    int notifyFd_ = -1;
+    struct sockaddr_un notifyAddr_ {};
+    socklen_t notifyLen_ = 0;
+    std::thread thread_;
+
+    // Written by the watched thread (beat), read by any
+    std::atomic<uint64_t> lastBeatNs_{0};
+    std::atomic<uint32_t> stalls_{0};
+    std::atomic<uint64_t> totalStallNs_{0};
+    std::atomic<uint64_t> maxStallNs_{0};
+    std::atomic<const char*> maxPhase_{nullptr};
+
+    // Written by the watchdog thread
+    std::atomic<uint32_t> captures_{0};
+    std::atomic<uint32_t> notifies_{0};
+    std::atomic<uint32_t> notifyErrors_{0};
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+} // namespace bjj
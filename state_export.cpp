@@ -0,0 +1,242 @@
+/**
+ * BJJ Gym Timer - Shared-Memory State Export Implementation
+ */
+
+#include "state_export.hpp"
+#include "audio.hpp"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bjj {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit int");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared atomics must be lock-free");
+
+static size_t headerBytes() {
+    return (sizeof(SharedStateHeader) + alignof(SharedMatState) - 1) & ~(alignof(SharedMatState) - 1);
+}
+
+// Shared (not PRIVATE) futex ops: waiters live in other processes
+static long futexWait(std::atomic<uint32_t>* addr, uint32_t val, const timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, val, timeout, nullptr, 0);
+}
+
+static long futexWake(std::atomic<uint32_t>* addr) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// ============================================================================
+// WRITER
+// ============================================================================
+std::string StateExport::defaultName() {
+    const char* env = std::getenv("BJJ_SHM");
+    return (env && *env) ? env : "/bjj_timer";
+}
+
+bool StateExport::open(const std::string& name, unsigned matCount) {
+    close();
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        perror("[state_export] shm_open");
+        return false;
+    }
+    size_t size = headerBytes() + sizeof(SharedMatState) * matCount;
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        perror("[state_export] ftruncate");
+        ::close(fd);
+        return false;
+    }
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        perror("[state_export] mmap");
+        return false;
+    }
+
+    // Invalidate first so readers attached to a previous run re-check the layout
+    header_ = static_cast<SharedStateHeader*>(mem);
+    __atomic_store_n(&header_->magic, 0u, __ATOMIC_RELEASE);
+    std::memset(static_cast<uint8_t*>(mem) + sizeof(uint32_t), 0, size - sizeof(uint32_t));
+    header_->version = STATE_EXPORT_VERSION;
+    header_->headerSize = static_cast<uint32_t>(headerBytes());
+    header_->matStride = sizeof(SharedMatState);
+    header_->matCount = matCount;
+    header_->pid = static_cast<uint32_t>(getpid());
+    header_->alive.store(1, std::memory_order_relaxed);
+    __atomic_store_n(&header_->magic, STATE_EXPORT_MAGIC, __ATOMIC_RELEASE);
+
+    name_ = name;
+    size_ = size;
+    return true;
+}
+
+void StateExport::close() {
+    if (!header_) return;
+    header_->alive.store(0, std::memory_order_release);
+    wakeReaders();
+    munmap(header_, size_);
+    shm_unlink(name_.c_str());
+    header_ = nullptr;
+    size_ = 0;
+}
+
+SharedMatState* StateExport::mat(unsigned i) const {
+    return reinterpret_cast<SharedMatState*>(reinterpret_cast<uint8_t*>(header_) + headerBytes()) + i;
+}
+
+void StateExport::publish(unsigned i, const DisplayInfo& info, uint64_t nextTickMs, uint64_t nowMs) {
+    if (!header_ || i >= header_->matCount) return;
+    SharedMatState* m = mat(i);
+    uint32_t seq = m->seq.load(std::memory_order_relaxed);
+    m->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m->state = static_cast<uint8_t>(info.state);
+    m->mode = static_cast<uint8_t>(info.mode);
+    m->phase = static_cast<uint8_t>(info.phase);
+    m->currentRound = info.currentRound;
+    m->totalRounds = info.totalRounds;
+    m->secondsRemaining = info.secondsRemaining;
+    m->phaseTotalSeconds = info.phaseTotalSeconds;
+    // Same convention as MatHost::phaseProgress: the current second ends at the next
+    // tick, and a paused mat sits at the start of the second it will resume
+    uint32_t fraction = 0;
+    if (info.state == TimerState::PAUSED) fraction = 1000;
+    else if (nextTickMs > nowMs) fraction = static_cast<uint32_t>(nextTickMs - nowMs);
+    m->remainingMs = info.secondsRemaining * 1000 + fraction;
+    m->publishedMs = nowMs;
+    m->nextTickMs = nextTickMs;
+    for (unsigned a = 0; a < 2; ++a) {
+        m->points[a] = info.score.points[a];
+        m->advantages[a] = info.score.advantages[a];
+        m->penalties[a] = info.score.penalties[a];
+    }
+
+    m->seq.store(seq + 2, std::memory_order_release);
+    wakeReaders();
+}
+
+void StateExport::countCues(unsigned i, uint8_t cues) {
+    if (!header_ || i >= header_->matCount || !cues) return;
+    SharedMatState* m = mat(i);
+    uint32_t seq = m->seq.load(std::memory_order_relaxed);
+    m->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    if (cues & CUE_ROUND_START) m->cueCounts[0]++;
+    if (cues & CUE_TEN_SECOND)  m->cueCounts[1]++;
+    if (cues & CUE_ROUND_END)   m->cueCounts[2]++;
+    if (cues & CUE_SWITCH)      m->cueCounts[3]++;
+    m->seq.store(seq + 2, std::memory_order_release);
+    wakeReaders();
+}
+
+void StateExport::wakeReaders() {
+    // seq_cst on both sides: the bump must be visible before waiters is read, and a
+    // reader's waiters increment before it sleeps (otherwise a wake can be lost)
+    header_->changeSeq.fetch_add(1);
+    // The syscall is only paid when somebody is actually blocked
+    if (header_->waiters.load() != 0) futexWake(&header_->changeSeq);
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+bool StateExportReader::open(const std::string& name) {
+    close();
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SharedStateHeader)) {
+        ::close(fd);
+        return false;
+    }
+    // Read-write only because waiting registers in `waiters`; records are never written
+    void* mem = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) return false;
+    SharedStateHeader* h = static_cast<SharedStateHeader*>(mem);
+    if (__atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != STATE_EXPORT_MAGIC ||
+        h->version != STATE_EXPORT_VERSION || h->matStride != sizeof(SharedMatState) ||
+        h->headerSize + static_cast<size_t>(h->matStride) * h->matCount > static_cast<size_t>(st.st_size)) {
+        munmap(mem, st.st_size);
+        return false;
+    }
+    header_ = h;
+    size_ = st.st_size;
+    return true;
+}
+
+void StateExportReader::close() {
+    if (!header_) return;
+    munmap(header_, size_);
+    header_ = nullptr;
+    size_ = 0;
+}
+
+unsigned StateExportReader::matCount() const {
+    return header_ ? header_->matCount : 0;
+}
+
+bool StateExportReader::writerAlive() const {
+    return header_ && header_->alive.load(std::memory_order_acquire) != 0 &&
+           __atomic_load_n(&header_->magic, __ATOMIC_ACQUIRE) == STATE_EXPORT_MAGIC;
+}
+
+uint32_t StateExportReader::changeSeq() const {
+    return header_ ? header_->changeSeq.load(std::memory_order_acquire) : 0;
+}
+
+const SharedMatState* StateExportReader::mat(unsigned i) const {
+    return reinterpret_cast<const SharedMatState*>(reinterpret_cast<const uint8_t*>(header_) + header_->headerSize) + i;
+}
+
+bool StateExportReader::read(unsigned i, MatStateView& out) const {
+    if (!header_ || i >= header_->matCount) return false;
+    const SharedMatState* m = mat(i);
+    // Bounded: a writer killed mid-update leaves seq odd for good
+    for (int tries = 0; tries < 10000; ++tries) {
+        uint32_t s1 = m->seq.load(std::memory_order_acquire);
+        if (s1 & 1) continue;
+        out.state = static_cast<TimerState>(m->state);
+        out.mode = static_cast<TimerMode>(m->mode);
+        out.phase = static_cast<Phase>(m->phase);
+        out.currentRound = m->currentRound;
+        out.totalRounds = m->totalRounds;
+        out.secondsRemaining = m->secondsRemaining;
+        out.phaseTotalSeconds = m->phaseTotalSeconds;
+        out.remainingMs = m->remainingMs;
+        out.publishedMs = m->publishedMs;
+        out.nextTickMs = m->nextTickMs;
+        std::memcpy(out.cueCounts, m->cueCounts, sizeof(out.cueCounts));
+        for (unsigned a = 0; a < 2; ++a) {
+            out.score.points[a] = m->points[a];
+            out.score.advantages[a] = m->advantages[a];
+            out.score.penalties[a] = m->penalties[a];
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m->seq.load(std::memory_order_relaxed) == s1) return true;
+    }
+    return false;
+}
+
+uint32_t StateExportReader::wait(uint32_t lastSeq, unsigned timeoutMs) const {
+    if (!header_) return lastSeq;
+    uint32_t seq = header_->changeSeq.load(std::memory_order_acquire);
+    if (seq != lastSeq) return seq;
+    timespec ts{static_cast<time_t>(timeoutMs / 1000), static_cast<long>(timeoutMs % 1000) * 1000000L};
+    header_->waiters.fetch_add(1);
+    futexWait(&header_->changeSeq, lastSeq, &ts);
+    header_->waiters.fetch_sub(1);
+    return header_->changeSeq.load(std::memory_order_acquire);
+}
+
+} // namespace bjj
@@ -0,0 +1,123 @@
+/**
+ * BJJ Gym Timer - Shared-Memory State Export
+ * Publishes every mat's timer state into a POSIX shared-memory segment so local
+ * scoreboards and stream overlays can mirror it with zero-copy reads. Each mat
+ * record is guarded by a seqlock; a process-shared futex wakes blocked readers.
+ */
+
+#pragma once
+
+#include "timer_logic.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace bjj {
+
+constexpr uint32_t STATE_EXPORT_MAGIC   = 0x534A4A42;  // "BJJS"
+constexpr uint32_t STATE_EXPORT_VERSION = 1;
+
+// One mat. Readers copy the payload between two equal, even seq reads.
+struct alignas(64) SharedMatState {
+    std::atomic<uint32_t> seq;        // Odd while the writer is mid-update
+    uint8_t state;                    // TimerState
+    uint8_t mode;                     // TimerMode
+    uint8_t phase;                    // Phase
+    uint8_t reserved;
+    uint32_t currentRound;
+    uint32_t totalRounds;
+    uint32_t secondsRemaining;
+    uint32_t phaseTotalSeconds;
+    uint32_t remainingMs;             // As of publishedMs
+    uint64_t publishedMs;             // CLOCK_MONOTONIC
+    uint64_t nextTickMs;              // CLOCK_MONOTONIC, 0 unless running: extrapolate between ticks
+    uint32_t cueCounts[4];            // Round start, ten-second, round end, switch
+    uint16_t points[2];               // Competition score, athlete listed first/second
+    uint8_t advantages[2];
+    uint8_t penalties[2];
+};
+
+struct SharedStateHeader {
+    uint32_t magic;                   // Written last: segment is valid once set
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t matStride;
+    uint32_t matCount;
+    uint32_t pid;
+    std::atomic<uint32_t> alive;      // 0 after the writer shuts down
+    std::atomic<uint32_t> changeSeq;  // Bumped after every publish; futex word
+    std::atomic<uint32_t> waiters;    // Readers blocked on changeSeq
+};
+
+// Plain copy of one mat's record
+struct MatStateView {
+    TimerState state;
+    TimerMode mode;
+    Phase phase;
+    unsigned currentRound;
+    unsigned totalRounds;
+    unsigned secondsRemaining;
+    unsigned phaseTotalSeconds;
+    uint32_t remainingMs;
+    uint64_t publishedMs;
+    uint64_t nextTickMs;
+    uint32_t cueCounts[4];
+    ScoreTotals score;
+};
+
+// Writer side (the timer process)
+class StateExport {
+public:
+    StateExport() = default;
+    ~StateExport() { close(); }
+    StateExport(const StateExport&) = delete;
+    StateExport& operator=(const StateExport&) = delete;
+
+    bool open(const std::string& name, unsigned matCount);
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+
+    // nextTickMs: MatHost::nextTickMs() for the mat; nowMs on the same clock
+    void publish(unsigned mat, const DisplayInfo& info, uint64_t nextTickMs, uint64_t nowMs);
+    void countCues(unsigned mat, uint8_t cues);
+
+    // $BJJ_SHM or /bjj_timer
+    static std::string defaultName();
+
+private:
+    SharedMatState* mat(unsigned i) const;
+    void wakeReaders();
+
+    std::string name_;
+    SharedStateHeader* header_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Reader side (overlays, hallway display)
+class StateExportReader {
+public:
+    StateExportReader() = default;
+    ~StateExportReader() { close(); }
+    StateExportReader(const StateExportReader&) = delete;
+    StateExportReader& operator=(const StateExportReader&) = delete;
+
+    bool open(const std::string& name);
+    void close();
+    unsigned matCount() const;
+    bool writerAlive() const;
+    uint32_t changeSeq() const;
+
+    bool read(unsigned mat, MatStateView& out) const;
+
+    // Block until changeSeq differs from lastSeq or timeoutMs passes; returns the current seq
+    uint32_t wait(uint32_t lastSeq, unsigned timeoutMs) const;
+
+private:
+    const SharedMatState* mat(unsigned i) const;
+
+    SharedStateHeader* header_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace bjj
@@ -0,0 +1,110 @@
+/**
+ * BJJ Gym Timer - Leader/Follower Sync Check
+ * Runs a leader and followers over loopback in one process, each follower
+ * with an injected clock error (--clock-skew/--clock-offset in the apps), and
+ * a running session on the leader. Every frame each follower's view of the
+ * leader clock is compared with the real monotonic clock; the run fails
+ * (exit 1) if any follower is off by more than one display frame, or never
+ * synced and received a timeline.
+ *
+ * Usage: ./bjj_sync_check [--port N] [--seconds S] [--frame-ms MS]
+ *                         [--follower SKEW_PPM:OFFSET_MS]...
+ */
+
+#include "mat_host.hpp"
+#include "perf_trace.hpp"
+#include "session_sync.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace bjj;
+
+static constexpr unsigned MAX_CHECK_FOLLOWERS = 8;
+
+struct FollowerSpec {
+    double skewPpm;
+    long offsetMs;
+};
+
+static SyncLeader g_lead;
+
+static void onDisplay(void* ctx, unsigned mat, const DisplayInfo&) {
+    g_lead.publish(*static_cast<const MatHost*>(ctx), mat);
+}
+
+int main(int argc, char* argv[]) {
+    unsigned port = SYNC_DEFAULT_PORT + 1;  // Clear of a leader running on this machine
+    unsigned seconds = 20;
+    unsigned frameMs = 33;  // LV_DEF_REFR_PERIOD
+    FollowerSpec specs[MAX_CHECK_FOLLOWERS];
+    unsigned count = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--port") && i + 1 < argc) port = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--frame-ms") && i + 1 < argc) frameMs = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--follower") && i + 1 < argc && count < MAX_CHECK_FOLLOWERS) {
+            FollowerSpec& f = specs[count];
+            if (sscanf(argv[++i], "%lf:%ld", &f.skewPpm, &f.offsetMs) != 2) {
+                fprintf(stderr, "Bad --follower spec: %s (want SKEW_PPM:OFFSET_MS)\n", argv[i]);
+                return 2;
+            }
+            ++count;
+        } else {
+            fprintf(stderr, "Usage: %s [--port N] [--seconds S] [--frame-ms MS] [--follower SKEW_PPM:OFFSET_MS]...\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (!count) {
+        // A fast and a slow crystal, both well past what real boards drift
+        specs[count++] = {200, 5000};
+        specs[count++] = {-150, -3000};
+    }
+
+    const std::string endpoint = "127.0.0.1:" + std::to_string(port);
+    MatHost host(1, monotonicMs());
+    host.setDisplaySink(onDisplay, &host);
+    if (!g_lead.start(endpoint, host.size())) return 1;
+    std::unique_ptr<SyncFollower> followers[MAX_CHECK_FOLLOWERS];
+    for (unsigned f = 0; f < count; ++f) {
+        followers[f].reset(new SyncFollower());
+        if (!followers[f]->start(endpoint, host.size(), specs[f].skewPpm, specs[f].offsetMs)) return 1;
+    }
+    host.timer(0).start();
+    g_lead.publish(host, 0);
+
+    const uint64_t endMs = monotonicMs() + seconds * 1000ULL;
+    while (monotonicMs() < endMs) {
+        host.poll(monotonicMs());
+        // view() measures each follower's clock error as it draws
+        for (unsigned f = 0; f < count; ++f) {
+            DisplayInfo info;
+            uint32_t remainingMs, spanMs;
+            followers[f]->view(0, info, remainingMs, spanMs);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(frameMs));
+    }
+
+    bool ok = true;
+    for (unsigned f = 0; f < count; ++f) {
+        SyncFollowerStats st = followers[f]->stats();
+        followers[f]->stop();
+        const bool pass = st.synced && st.timelines > 0 && st.maxErrorUs <= frameMs * 1000LL;
+        ok &= pass;
+        printf("follower %u: injected %+.0f ppm %+ld ms, estimated %+.1f ppm, delay %u us, clock error %lld us "
+               "(max %lld, limit %u) - %s\n",
+               f + 1, specs[f].skewPpm, specs[f].offsetMs, st.skewPpm, st.delayUs,
+               static_cast<long long>(st.errorUs), static_cast<long long>(st.maxErrorUs), frameMs * 1000,
+               !st.synced || !st.timelines ? "FAIL (never synced)" : pass ? "ok" : "FAIL");
+    }
+    SyncLeaderStats ls = g_lead.stats();
+    g_lead.stop();
+    printf("leader: %u followers, %u pongs, %llu timelines sent\n", ls.followers, ls.pongs,
+           static_cast<unsigned long long>(ls.timelines));
+    return ok ? 0 : 1;
+}
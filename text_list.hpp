@@ -0,0 +1,64 @@
+/**
+ * BJJ Gym Timer - Fixed Text List
+ * A short list of display lines (partner pairings, a tournament match) in
+ * one fixed buffer, so refreshing what a screen lists never touches the
+ * heap. Lines that do not fit are dropped and counted (header-only).
+ */
+
+#pragma once
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace bjj {
+
+class TextList {
+public:
+    static constexpr unsigned MAX_LINES = 256;   // A full roster's pairings
+    static constexpr unsigned BYTES = 16384;
+
+    void clear() { count_ = used_ = dropped_ = 0; }
+
+    // printf-style; false (line dropped) when the list is full
+    __attribute__((format(printf, 2, 3)))
+    bool add(const char* fmt, ...) {
+        if (count_ >= MAX_LINES || used_ >= BYTES) return drop();
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(buf_ + used_, BYTES - used_, fmt, ap);
+        va_end(ap);
+        if (n < 0 || used_ + static_cast<unsigned>(n) >= BYTES) return drop();
+        offset_[count_++] = static_cast<uint16_t>(used_);
+        used_ += static_cast<unsigned>(n) + 1;
+        return true;
+    }
+
+    unsigned size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    unsigned dropped() const { return dropped_; }
+    const char* operator[](unsigned i) const { return buf_ + offset_[i]; }
+
+    // Only the used part of the buffer
+    TextList& operator=(const TextList& o) {
+        if (this == &o) return *this;
+        std::memcpy(buf_, o.buf_, o.used_);
+        std::memcpy(offset_, o.offset_, o.count_ * sizeof(offset_[0]));
+        count_ = o.count_;
+        used_ = o.used_;
+        dropped_ = o.dropped_;
+        return *this;
+    }
+
+private:
+    bool drop() { ++dropped_; return false; }
+
+    char buf_[BYTES];
+    uint16_t offset_[MAX_LINES];
+    unsigned count_{0};
+    unsigned used_{0};
+    unsigned dropped_{0};
+};
+
+} // namespace bjj
@@ -5,13 +5,20 @@
 #include "timer_logic.hpp"
 #include "hardware.hpp"
 #include <algorithm>
-#include <sstream>
+#include <cstdio>
+#include <cstring>
 
 namespace bjj {
 
+static const char* const SCORE_ACTION_LABELS[SCORE_ACTION_COUNT] = {
+    "RESUME",
+    "1: +2", "1: +3", "1: +4", "1: ADV", "1: PEN",
+    "2: +2", "2: +3", "2: +4", "2: ADV", "2: PEN",
+    "UNDO", "REDO",
+};
+
 TimerLogic::TimerLogic() {
     totalRounds_ = config_.roundCount;
-    menuLabel_ = "SPARRING";  // Default mode
 }
 
 unsigned TimerLogic::getWorkSeconds() const {
@@ -32,6 +39,7 @@ void TimerLogic::enterMenu() {
         case TimerMode::DRILLING:   menuLabel_ = "DRILLING"; break;
         case TimerMode::COMPETITION: menuLabel_ = "COMPETITION"; break;
     }
+    notifyTransition();
     notifyDisplay();
 }
 
@@ -42,12 +50,14 @@ void TimerLogic::enterSetupWork() {
     } else {
         setupValue_ = config_.workSeconds;
     }
+    notifyTransition();
     notifyDisplay();
 }
 
 void TimerLogic::enterSetupRest() {
     state_ = TimerState::SETUP_REST;
     setupValue_ = config_.restSeconds;
+    notifyTransition();
     notifyDisplay();
 }
 
@@ -58,6 +68,7 @@ void TimerLogic::enterSetupRounds() {
     } else {
         setupValue_ = config_.roundCount;
     }
+    notifyTransition();
     notifyDisplay();
 }
 
@@ -85,17 +96,23 @@ void TimerLogic::enterRunning() {
     roundEndDue_ = false;
     switchDue_ = false;
     tenSecondWarningDue_ = false;
+    score_.clear();
+    scoreAction_ = 0;
+    notifyTransition();
     notifyDisplay();
 }
 
 void TimerLogic::enterPaused() {
     state_ = TimerState::PAUSED;
+    scoreAction_ = 0;
+    notifyTransition();
     notifyDisplay();
 }
 
 void TimerLogic::enterFinished() {
     state_ = TimerState::FINISHED;
     roundEndDue_ = true;  // Final buzzer
+    notifyTransition();
     notifyDisplay();
 }
 
@@ -110,10 +127,11 @@ void TimerLogic::advanceMenu(int delta) {
         case TimerMode::DRILLING:   menuLabel_ = "DRILLING"; break;
         case TimerMode::COMPETITION: menuLabel_ = "COMPETITION"; break;
     }
+    notifyTransition();
     notifyDisplay();
 }
 
-void TimerLogic::advanceSetupWork(int delta) {
+void TimerLogic::advanceSetupWork(int delta, unsigned step) {
     if (mode_ == TimerMode::COMPETITION) {
         int idx = static_cast<int>(config_.compTimeIndex) + delta;
         if (idx < 0) idx = COMPETITION_COUNT - 1;
@@ -121,25 +139,27 @@ void TimerLogic::advanceSetupWork(int delta) {
         config_.compTimeIndex = idx;
         setupValue_ = config_.compTimeIndex;
     } else {
-        int val = static_cast<int>(config_.workSeconds) + delta * ROUND_INCREMENT;
+        int val = static_cast<int>(config_.workSeconds) + delta * static_cast<int>(step);
         val = std::max(60, std::min(3600, val));
         config_.workSeconds = val;
         setupValue_ = config_.workSeconds;
     }
+    notifyTransition();
     notifyDisplay();
 }
 
-void TimerLogic::advanceSetupRest(int delta) {
-    int val = static_cast<int>(config_.restSeconds) + delta * ROUND_INCREMENT;
+void TimerLogic::advanceSetupRest(int delta, unsigned step) {
+    int val = static_cast<int>(config_.restSeconds) + delta * static_cast<int>(step);
     val = std::max(0, std::min(600, val));
     config_.restSeconds = val;
     setupValue_ = config_.restSeconds;
+    notifyTransition();
     notifyDisplay();
 }
 
-void TimerLogic::advanceSetupRounds(int delta) {
+void TimerLogic::advanceSetupRounds(int delta, unsigned step) {
     if (mode_ == TimerMode::DRILLING) {
-        int val = static_cast<int>(config_.workSeconds) + delta * ROUND_INCREMENT;
+        int val = static_cast<int>(config_.workSeconds) + delta * static_cast<int>(step);
         val = std::max(30, std::min(600, val));
         config_.workSeconds = val;
         setupValue_ = config_.workSeconds;
@@ -149,36 +169,53 @@ void TimerLogic::advanceSetupRounds(int delta) {
         config_.roundCount = val;
         setupValue_ = config_.roundCount;
     }
+    notifyTransition();
     notifyDisplay();
 }
 
-void TimerLogic::adjustRunningTime(int delta) {
-    int adj = delta * RUNTIME_ADJUST;
-    int s = static_cast<int>(secondsRemaining_.load()) + adj;
+void TimerLogic::adjustRunningTime(int seconds) {
+    int s = static_cast<int>(secondsRemaining_.load()) + seconds;
     s = std::max(0, std::min(3600, s));
     secondsRemaining_ = s;
     lastSecondsRemaining_ = s;
     if (s <= 10) tenSecondPlayed_ = true;
+    notifyTransition();
     notifyDisplay();
 }
 
 void TimerLogic::onRotate(int delta) {
+    rotate(delta, ROUND_INCREMENT, RUNTIME_ADJUST);
+}
+
+void TimerLogic::onCoarseRotate(int delta) {
+    // Paused competition: the chord picks a score action, a plain turn still adjusts the clock
+    if (state_ == TimerState::PAUSED && mode_ == TimerMode::COMPETITION) {
+        int a = (static_cast<int>(scoreAction_) + delta) % static_cast<int>(SCORE_ACTION_COUNT);
+        scoreAction_ = static_cast<unsigned>(a < 0 ? a + static_cast<int>(SCORE_ACTION_COUNT) : a);
+        notifyDisplay();
+        return;
+    }
+    rotate(delta, COARSE_INCREMENT, COARSE_INCREMENT);
+}
+
+// Round counts and the menu step by one either way
+void TimerLogic::rotate(int delta, unsigned setupStep, unsigned runStep) {
     switch (state_) {
         case TimerState::MENU:
             advanceMenu(delta);
             break;
         case TimerState::SETUP_WORK:
-            advanceSetupWork(delta);
+            advanceSetupWork(delta, setupStep);
             break;
         case TimerState::SETUP_REST:
-            advanceSetupRest(delta);
+            advanceSetupRest(delta, setupStep);
             break;
         case TimerState::SETUP_ROUNDS:
-            advanceSetupRounds(delta);
+            advanceSetupRounds(delta, setupStep);
             break;
-        case TimerState::RUNNING:
         case TimerState::PAUSED:
-            adjustRunningTime(delta);
+        case TimerState::RUNNING:
+            adjustRunningTime(delta * static_cast<int>(runStep));
             break;
         default:
             break;
@@ -204,7 +241,15 @@ void TimerLogic::onShortPress() {
             enterPaused();
             break;
         case TimerState::PAUSED:
+            if (scoreAction_ != 0) {
+                // Stay paused: the referee may have more to enter
+                runScoreAction(scoreAction_);
+                scoreAction_ = 0;
+                notifyDisplay();
+                break;
+            }
             state_ = TimerState::RUNNING;
+            notifyTransition();
             notifyDisplay();
             break;
         case TimerState::MENU:
@@ -219,6 +264,21 @@ void TimerLogic::onShortPress() {
     
 }
 
+void TimerLogic::onDoublePress() {
+    switch (state_) {
+        case TimerState::MENU:
+        case TimerState::SETUP_WORK:
+        case TimerState::SETUP_REST:
+        case TimerState::SETUP_ROUNDS:
+            start();  // Skip the remaining setup screens
+            break;
+        default:
+            onShortPress();
+            onShortPress();
+            break;
+    }
+}
+
 void TimerLogic::onLongPress() {
     if (state_ == TimerState::RUNNING || state_ == TimerState::PAUSED || 
         state_ == TimerState::FINISHED) {
@@ -229,6 +289,91 @@ void TimerLogic::onLongPress() {
     }
 }
 
+bool TimerLogic::start() {
+    switch (state_) {
+        case TimerState::PAUSED:
+            state_ = TimerState::RUNNING;
+            notifyTransition();
+            notifyDisplay();
+            return true;
+        case TimerState::RUNNING:
+            return false;
+        default:
+            enterRunning();
+            return true;
+    }
+}
+
+bool TimerLogic::pause() {
+    if (state_ != TimerState::RUNNING) return false;
+    enterPaused();
+    return true;
+}
+
+bool TimerLogic::adjustSeconds(int delta) {
+    if (state_ != TimerState::RUNNING && state_ != TimerState::PAUSED) return false;
+    adjustRunningTime(delta);
+    return true;
+}
+
+bool TimerLogic::loadPreset(TimerMode mode, const TimerConfig& config) {
+    if (state_ == TimerState::RUNNING || state_ == TimerState::PAUSED) return false;
+    if (static_cast<unsigned>(mode) > static_cast<unsigned>(TimerMode::COMPETITION) ||
+        config.compTimeIndex >= COMPETITION_COUNT) {
+        return false;
+    }
+    // Same ranges the encoder setup screens allow
+    mode_ = mode;
+    config_.restSeconds = std::min(600u, config.restSeconds);
+    config_.roundCount = std::max(1u, std::min(20u, config.roundCount));
+    config_.compTimeIndex = config.compTimeIndex;
+    config_.workSeconds = mode == TimerMode::DRILLING ? std::max(30u, std::min(600u, config.workSeconds))
+                                                      : std::max(60u, std::min(3600u, config.workSeconds));
+    enterMenu();
+    return true;
+}
+
+void TimerLogic::reset() {
+    enterMenu();
+}
+
+bool TimerLogic::scoringOpen() const {
+    return mode_ == TimerMode::COMPETITION &&
+           (state_ == TimerState::RUNNING || state_ == TimerState::PAUSED || state_ == TimerState::FINISHED);
+}
+
+// Score and clock go out in one display update, so they never disagree on screen
+void TimerLogic::scoreChanged() {
+    notifyTransition();
+    notifyDisplay();
+}
+
+bool TimerLogic::score(unsigned athlete, ScoreKind kind) {
+    if (!scoringOpen() || !score_.add(athlete, kind, secondsRemaining_.load())) return false;
+    scoreChanged();
+    return true;
+}
+
+bool TimerLogic::undoScore() {
+    if (!scoringOpen() || !score_.undo(secondsRemaining_.load())) return false;
+    scoreChanged();
+    return true;
+}
+
+bool TimerLogic::redoScore() {
+    if (!scoringOpen() || !score_.redo(secondsRemaining_.load())) return false;
+    scoreChanged();
+    return true;
+}
+
+bool TimerLogic::runScoreAction(unsigned action) {
+    if (action == 0 || action >= SCORE_ACTION_COUNT) return false;
+    if (action == SCORE_ACTION_COUNT - 2) return undoScore();
+    if (action == SCORE_ACTION_COUNT - 1) return redoScore();
+    const unsigned k = action - 1;
+    return score(k / SCORE_KIND_COUNT, static_cast<ScoreKind>(k % SCORE_KIND_COUNT));
+}
+
 void TimerLogic::tick() {
     if (state_ != TimerState::RUNNING) return;
     
@@ -241,33 +386,11 @@ void TimerLogic::tick() {
     }
     
     if (sec == 0) {
-        if (mode_ == TimerMode::DRILLING) {
-            switchDue_ = true;
-            secondsRemaining_ = config_.workSeconds;  // Next person's turn
-            tenSecondPlayed_ = false;
-        } else if (mode_ == TimerMode::SPARRING) {
-            if (phase_ == Phase::WORK) {
-                roundEndDue_ = true;
-                if (currentRound_ >= totalRounds_) {
-                    enterFinished();
-                    return;
-                }
-                phase_ = Phase::REST;
-                secondsRemaining_ = getRestSeconds();
-                tenSecondPlayed_ = false;
-            } else {
-                roundEndDue_ = true;
-                currentRound_++;
-                phase_ = Phase::WORK;
-                secondsRemaining_ = getWorkSeconds();
-                roundStartDue_ = true;
-                tenSecondPlayed_ = false;
-            }
-        } else {
-            // Competition - single round
+        if (!advancePhase()) {
             enterFinished();
             return;
         }
+        notifyTransition();
     } else {
         secondsRemaining_--;
     }
@@ -276,6 +399,88 @@ void TimerLogic::tick() {
     notifyDisplay();
 }
 
+bool TimerLogic::advancePhase() {
+    if (mode_ == TimerMode::DRILLING) {
+        switchDue_ = true;
+        secondsRemaining_ = config_.workSeconds;  // Next person's turn
+        tenSecondPlayed_ = false;
+        return true;
+    }
+    if (mode_ == TimerMode::SPARRING) {
+        roundEndDue_ = true;
+        if (phase_ == Phase::WORK) {
+            if (currentRound_ >= totalRounds_) return false;
+            phase_ = Phase::REST;
+            secondsRemaining_ = getRestSeconds();
+        } else {
+            currentRound_++;
+            phase_ = Phase::WORK;
+            secondsRemaining_ = getWorkSeconds();
+            roundStartDue_ = true;
+        }
+        tenSecondPlayed_ = false;
+        return true;
+    }
+    return false;  // Competition - single round
+}
+
+TimerSnapshot TimerLogic::snapshot() const {
+    TimerSnapshot snap;
+    snap.state = state_;
+    snap.mode = mode_;
+    snap.phase = phase_;
+    snap.config = config_;
+    snap.currentRound = currentRound_;
+    snap.totalRounds = totalRounds_;
+    snap.secondsRemaining = secondsRemaining_.load();
+    snap.tenSecondPlayed = tenSecondPlayed_;
+    snap.score = score_.totals();
+    return snap;
+}
+
+void TimerLogic::restore(const TimerSnapshot& snap, unsigned elapsedSeconds) {
+    mode_ = snap.mode;
+    phase_ = snap.phase;
+    config_ = snap.config;
+    if (config_.compTimeIndex >= COMPETITION_COUNT) config_.compTimeIndex = 0;
+    currentRound_ = snap.currentRound;
+    totalRounds_ = snap.totalRounds;
+    secondsRemaining_ = snap.secondsRemaining;
+    tenSecondPlayed_ = snap.tenSecondPlayed;
+    state_ = snap.state;
+    score_.clear(snap.score);  // Totals only: undo starts from here
+    scoreAction_ = 0;
+    
+    switch (state_) {
+        case TimerState::MENU:         enterMenu(); return;
+        case TimerState::SETUP_WORK:   enterSetupWork(); return;
+        case TimerState::SETUP_REST:   enterSetupRest(); return;
+        case TimerState::SETUP_ROUNDS: enterSetupRounds(); return;
+        default: break;
+    }
+    
+    if (state_ == TimerState::RUNNING) {
+        // Replay missed boundaries: a phase of N seconds ends on tick N+1
+        unsigned sec = secondsRemaining_.load();
+        while (elapsedSeconds > sec) {
+            elapsedSeconds -= sec + 1;
+            if (!advancePhase()) {
+                state_ = TimerState::FINISHED;
+                sec = elapsedSeconds = 0;
+                break;
+            }
+            sec = secondsRemaining_.load();
+        }
+        secondsRemaining_ = sec - elapsedSeconds;
+        if (secondsRemaining_.load() < TEN_SECOND_MARK) tenSecondPlayed_ = true;
+    }
+    
+    lastSecondsRemaining_ = secondsRemaining_.load();
+    clearAudioFlags();  // Missed cues are not replayed on resume
+    notifyTransition();
+    notifyDisplay();
+}
+
 DisplayInfo TimerLogic::getDisplayInfo() const {
     DisplayInfo info;
     info.state = state_;
@@ -284,44 +489,92 @@ DisplayInfo TimerLogic::getDisplayInfo() const {
     info.currentRound = currentRound_;
     info.totalRounds = totalRounds_;
     info.secondsRemaining = secondsRemaining_.load();
-    info.phaseTotalSeconds = (phase_ == Phase::REST) ? getRestSeconds() : getWorkSeconds();
-    info.menuLabel = menuLabel_;
-    info.valueLabel = valueLabel_;
+    info.phaseTotalSeconds = getPhaseTotalSeconds();
+    snprintf(info.menuLabel, sizeof(info.menuLabel), "%s", menuLabel_);
+    memcpy(info.valueLabel, valueLabel_, sizeof(info.valueLabel));
     info.setupValue = setupValue_;
     info.tenSecondWarningDue = tenSecondWarningDue_;
     info.roundStartDue = roundStartDue_;
     info.roundEndDue = roundEndDue_;
     info.switchDue = switchDue_;
+    info.scoring = scoringOpen();
+    info.score = score_.totals();
     return info;
 }
 
+unsigned TimerLogic::compileTimeline(TimelineSegment* out, unsigned max, bool& repeats) const {
+    repeats = mode_ == TimerMode::DRILLING;
+    if ((state_ != TimerState::RUNNING && state_ != TimerState::PAUSED) || max == 0) return 0;
+    
+    unsigned n = 0;
+    out[n++] = {phase_, currentRound_, getPhaseTotalSeconds()};
+    if (mode_ != TimerMode::SPARRING) return n;  // Competition: one match; drilling: repeats
+    
+    // Same order as advancePhase(): rest between rounds, none after the last
+    Phase phase = phase_;
+    unsigned round = currentRound_;
+    while (n < max) {
+        if (phase == Phase::WORK) {
+            if (round >= totalRounds_) break;
+            phase = Phase::REST;
+            out[n++] = {phase, round, getRestSeconds()};
+        } else {
+            phase = Phase::WORK;
+            out[n++] = {phase, ++round, getWorkSeconds()};
+        }
+    }
+    return n;
+}
+
+bool TimerLogic::nextCue(CueForecast& out) const {
+    out = CueForecast{};
+    if (state_ != TimerState::RUNNING) return false;
+    
+    // Tick k (1-based) sees sec - (k - 1): same checks as tick()
+    unsigned sec = secondsRemaining_.load();
+    if (!tenSecondPlayed_ && sec >= TEN_SECOND_MARK) {
+        out.ticks = sec - TEN_SECOND_MARK + 1;
+        out.tenSecondWarning = true;
+        return true;
+    }
+    out.ticks = sec + 1;
+    // Same outcomes as advancePhase() / enterFinished()
+    if (mode_ == TimerMode::DRILLING) {
+        out.switchPartner = true;
+    } else {
+        out.roundEnd = true;
+        out.roundStart = mode_ == TimerMode::SPARRING && phase_ == Phase::REST;
+    }
+    return true;
+}
+
 void TimerLogic::notifyDisplay() {
     // Build value labels for setup screens
+    char* out = valueLabel_;
+    const size_t size = sizeof(valueLabel_);
     if (state_ == TimerState::SETUP_WORK) {
         if (mode_ == TimerMode::COMPETITION) {
-            unsigned mins = COMPETITION_TIMES[config_.compTimeIndex] / 60;
-            valueLabel_ = std::to_string(mins) + " min";
+            snprintf(out, size, "%u min", COMPETITION_TIMES[config_.compTimeIndex] / 60);
         } else {
-            unsigned m = config_.workSeconds / 60;
-            unsigned s = config_.workSeconds % 60;
-            valueLabel_ = std::to_string(m) + ":" + (s < 10 ? "0" : "") + std::to_string(s);
+            snprintf(out, size, "%u:%02u", config_.workSeconds / 60, config_.workSeconds % 60);
         }
     } else if (state_ == TimerState::SETUP_REST) {
-        unsigned m = config_.restSeconds / 60;
-        unsigned s = config_.restSeconds % 60;
-        valueLabel_ = std::to_string(m) + ":" + (s < 10 ? "0" : "") + std::to_string(s);
+        snprintf(out, size, "%u:%02u", config_.restSeconds / 60, config_.restSeconds % 60);
     } else if (state_ == TimerState::SETUP_ROUNDS) {
         if (mode_ == TimerMode::DRILLING) {
-            unsigned m = config_.workSeconds / 60;
-            unsigned s = config_.workSeconds % 60;
-            valueLabel_ = std::to_string(m) + ":" + (s < 10 ? "0" : "") + std::to_string(s) + " each";
+            snprintf(out, size, "%u:%02u each", config_.workSeconds / 60, config_.workSeconds % 60);
         } else {
-            valueLabel_ = std::to_string(config_.roundCount) + " rounds";
+            snprintf(out, size, "%u rounds", config_.roundCount);
         }
+    } else if (state_ == TimerState::PAUSED && mode_ == TimerMode::COMPETITION) {
+        snprintf(out, size, "%s", SCORE_ACTION_LABELS[scoreAction_]);
     }
     
-    DisplayInfo info = getDisplayInfo();
-    if (eventCb_) eventCb_(info);
+    if (eventCb_) eventCb_(eventCtx_, getDisplayInfo());
+}
+
+void TimerLogic::notifyTransition() {
+    if (transitionCb_) transitionCb_(transitionCtx_, snapshot());
 }
 
 void TimerLogic::playAudioEvents() {
@@ -5,10 +5,9 @@
 
 #pragma once
 
+#include "scoring.hpp"
 #include <cstdint>
 #include <atomic>
-#include <functional>
-#include <string>
 
 namespace bjj {
 
@@ -45,7 +44,13 @@ constexpr unsigned DEFAULT_REST_SEC  = 60;    // 1 min
 constexpr unsigned DEFAULT_ROUNDS    = 5;
 constexpr unsigned ROUND_INCREMENT   = 15;    // 15s for setup
 constexpr unsigned RUNTIME_ADJUST    = 30;    // 30s when running
+constexpr unsigned COARSE_INCREMENT  = 60;    // 1 min, knob turned while held
 constexpr unsigned TEN_SECOND_MARK   = 10;
+constexpr unsigned LABEL_MAX         = 24;    // Menu/value label, with the terminator
+
+// Competition, paused: rotating picks one of these, press applies it.
+// 0 resumes, then athlete 1's and athlete 2's scores (ScoreKind order), undo, redo.
+constexpr unsigned SCORE_ACTION_COUNT = 1 + 2 * SCORE_KIND_COUNT + 2;
 
 // ============================================================================
 // TIMER CONFIGURATION
@@ -70,14 +75,52 @@ struct DisplayInfo {
     unsigned secondsRemaining{0};
     unsigned phaseTotalSeconds{300};  // Total for current phase (for arc progress)
     
-    std::string menuLabel;
-    std::string valueLabel;
+    char menuLabel[LABEL_MAX] = {};
+    char valueLabel[LABEL_MAX] = {};
     unsigned setupValue{0};
     
     bool tenSecondWarningDue{false};
     bool roundStartDue{false};
     bool roundEndDue{false};
     bool switchDue{false};
+    
+    bool scoring{false};  // Competition match on screen: show score
+    ScoreTotals score;
+};
+
+// ============================================================================
+// TIMER SNAPSHOT (restorable engine state, no derived labels)
+// ============================================================================
+struct TimerSnapshot {
+    TimerState state{TimerState::MENU};
+    TimerMode mode{TimerMode::SPARRING};
+    Phase phase{Phase::WORK};
+    TimerConfig config;
+    unsigned currentRound{0};
+    unsigned totalRounds{0};
+    unsigned secondsRemaining{0};
+    bool tenSecondPlayed{false};
+    ScoreTotals score;
+};
+
+// ============================================================================
+// SESSION TIMELINE (one phase still to run; see TimerLogic::compileTimeline)
+// ============================================================================
+struct TimelineSegment {
+    Phase phase{Phase::WORK};
+    unsigned round{0};
+    unsigned seconds{0};  // Phase length; the phase shows seconds..0, i.e. seconds+1 ticks
+};
+
+// ============================================================================
+// CUE FORECAST (the next cue a running session raises; see TimerLogic::nextCue)
+// ============================================================================
+struct CueForecast {
+    unsigned ticks{0};    // tick() calls until it is raised: 1 = the next one
+    bool tenSecondWarning{false};
+    bool roundStart{false};
+    bool roundEnd{false};
+    bool switchPartner{false};
 };
 
 // ============================================================================
@@ -85,23 +128,58 @@ struct DisplayInfo {
 // ============================================================================
 class TimerLogic {
 public:
-    using EventCallback = std::function<void(const DisplayInfo&)>;
+    using EventCallback = void (*)(void* ctx, const DisplayInfo& info);
+    using TransitionCallback = void (*)(void* ctx, const TimerSnapshot& snap);
     
     TimerLogic();
     
     // --- State Machine Inputs ---
     void onRotate(int delta);
+    void onCoarseRotate(int delta);  // Times in COARSE_INCREMENT steps; paused competition: score action
     void onShortPress();
     void onLongPress();
+    void onDoublePress();            // MENU/SETUP: start now; otherwise two short presses
     void tick();  // Call every second from main loop
     
+    // --- Remote control (control socket, dashboard) - false if not applicable now ---
+    bool start();                  // MENU/SETUP/FINISHED: run current config; PAUSED: resume
+    bool pause();                  // RUNNING -> PAUSED
+    bool adjustSeconds(int delta); // RUNNING/PAUSED: add/remove time
+    bool loadPreset(TimerMode mode, const TimerConfig& config);  // Not while a session is live
+    void reset();                  // Back to MENU
+    
+    // --- Competition scoring (RUNNING/PAUSED/FINISHED) - false if not a competition now ---
+    bool score(unsigned athlete, ScoreKind kind);
+    bool undoScore();
+    bool redoScore();
+    const ScoreLog& scoreLog() const { return score_; }
+    
     // --- Getters ---
     DisplayInfo getDisplayInfo() const;
     TimerState getState() const { return state_; }
     TimerMode getMode() const { return mode_; }
+    Phase getPhase() const { return phase_; }
+    unsigned getSecondsRemaining() const { return secondsRemaining_; }
+    unsigned getPhaseTotalSeconds() const { return phase_ == Phase::REST ? getRestSeconds() : getWorkSeconds(); }
     void clearAudioFlags();
     
-    void setEventCallback(EventCallback cb) { eventCb_ = std::move(cb); }
+    // RUNNING/PAUSED: the current phase followed by every phase still to come.
+    // Drilling repeats its interval until stopped (repeats = true). Returns the
+    // number of segments written, 0 when no session is live.
+    unsigned compileTimeline(TimelineSegment* out, unsigned max, bool& repeats) const;
+    
+    // RUNNING only: which cue flags tick() will raise next and on which tick,
+    // so audio can be armed before the boundary instead of after it
+    bool nextCue(CueForecast& out) const;
+    
+    // --- Persistence ---
+    TimerSnapshot snapshot() const;
+    // Restore state, then silently fast-forward a RUNNING session by elapsedSeconds
+    void restore(const TimerSnapshot& snap, unsigned elapsedSeconds);
+    
+    void setEventCallback(EventCallback fn, void* ctx) { eventCb_ = fn; eventCtx_ = ctx; }
+    // Fired on state/phase/round/config changes only - not on plain ticks
+    void setTransitionCallback(TransitionCallback fn, void* ctx) { transitionCb_ = fn; transitionCtx_ = ctx; }
     
 private:
     void enterMenu();
@@ -113,12 +191,18 @@ private:
     void enterFinished();
     
     void advanceMenu(int delta);
-    void advanceSetupWork(int delta);
-    void advanceSetupRest(int delta);
-    void advanceSetupRounds(int delta);
-    void adjustRunningTime(int delta);
+    void rotate(int delta, unsigned setupStep, unsigned runStep);
+    void advanceSetupWork(int delta, unsigned step);
+    void advanceSetupRest(int delta, unsigned step);
+    void advanceSetupRounds(int delta, unsigned step);
+    void adjustRunningTime(int seconds);
+    bool scoringOpen() const;
+    bool runScoreAction(unsigned action);
+    void scoreChanged();
     
+    bool advancePhase();  // Phase boundary; returns false when session finished
     void notifyDisplay();
+    void notifyTransition();
     void playAudioEvents();
     
     unsigned getWorkSeconds() const;
@@ -135,14 +219,19 @@ private:
     unsigned lastSecondsRemaining_{0};
     
     bool tenSecondPlayed_{false};
-    std::string menuLabel_;
-    std::string valueLabel_;
+    const char* menuLabel_{"SPARRING"};
+    char valueLabel_[LABEL_MAX] = {};
     unsigned setupValue_{0};
     bool tenSecondWarningDue_{false};
     bool roundStartDue_{false};
     bool roundEndDue_{false};
     bool switchDue_{false};
-    EventCallback eventCb_;
+    ScoreLog score_;
+    unsigned scoreAction_{0};  // Paused competition: SCORE_ACTION_COUNT cursor
+    EventCallback eventCb_{nullptr};
+    void* eventCtx_{nullptr};
+    TransitionCallback transitionCb_{nullptr};
+    void* transitionCtx_{nullptr};
 };
 
 } // namespace bjj
@@ -0,0 +1,70 @@
+/**
+ * BJJ Gym Timer - Hashed Timing Wheel Implementation
+ */
+
+#include "timing_wheel.hpp"
+
+namespace bjj {
+
+TimingWheel::TimingWheel(uint64_t nowMs) : currentMs_(nowMs) {}
+
+void TimingWheel::link(Entry& e) {
+    // Past deadlines land in the next slot to be visited
+    uint64_t when = e.deadlineMs > currentMs_ ? e.deadlineMs : currentMs_ + 1;
+    e.slot = static_cast<unsigned>(when & SLOT_MASK);
+    Entry*& head = slots_[e.slot];
+    e.prev = nullptr;
+    e.next = head;
+    if (head) head->prev = &e;
+    head = &e;
+}
+
+void TimingWheel::schedule(Entry& e, uint64_t deadlineMs) {
+    cancel(e);
+    e.deadlineMs = deadlineMs;
+    e.armed = true;
+    ++armed_;
+    link(e);
+}
+
+void TimingWheel::cancel(Entry& e) {
+    if (!e.armed) return;
+    if (e.prev) e.prev->next = e.next;
+    else slots_[e.slot] = e.next;
+    if (e.next) e.next->prev = e.prev;
+    e.prev = e.next = nullptr;
+    e.armed = false;
+    --armed_;
+}
+
+unsigned TimingWheel::advance(uint64_t nowMs) {
+    if (nowMs <= currentMs_) return 0;
+    unsigned fired = 0;
+    // A full revolution visits every slot once; more would revisit the same lists
+    uint64_t steps = nowMs - currentMs_;
+    if (steps > SLOT_COUNT) steps = SLOT_COUNT;
+    uint64_t start = currentMs_ + 1;
+    currentMs_ = nowMs;
+
+    for (uint64_t t = start; t < start + steps; ++t) {
+        Entry* e = slots_[t & SLOT_MASK];
+        while (e) {
+            Entry* next = e->next;
+            if (e->deadlineMs <= nowMs) {
+                // Unlink first so the callback can reschedule the same entry
+                if (e->prev) e->prev->next = e->next;
+                else slots_[t & SLOT_MASK] = e->next;
+                if (e->next) e->next->prev = e->prev;
+                e->prev = e->next = nullptr;
+                e->armed = false;
+                --armed_;
+                ++fired;
+                if (e->fn) e->fn(e->ctx, e->deadlineMs, nowMs);
+            }
+            e = next;
+        }
+    }
+    return fired;
+}
+
+} // namespace bjj
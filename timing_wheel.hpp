@@ -0,0 +1,53 @@
+/**
+ * BJJ Gym Timer - Hashed Timing Wheel
+ * One wheel drives every timer instance: advancing costs O(elapsed slots +
+ * due entries), independent of how many instances are idle or far from due.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace bjj {
+
+class TimingWheel {
+public:
+    static constexpr unsigned SLOT_COUNT = 2048;  // 1 ms slots, ~2 s horizon
+    static constexpr unsigned SLOT_MASK  = SLOT_COUNT - 1;
+
+    using FireCallback = void (*)(void* ctx, uint64_t deadlineMs, uint64_t nowMs);
+
+    // Intrusive entry - owned by the caller, never allocated by the wheel
+    struct Entry {
+        FireCallback fn{nullptr};
+        void* ctx{nullptr};
+        uint64_t deadlineMs{0};
+        Entry* prev{nullptr};
+        Entry* next{nullptr};
+        unsigned slot{0};
+        bool armed{false};
+    };
+
+    explicit TimingWheel(uint64_t nowMs);
+
+    // (Re)arm an entry; deadlines in the past fire on the next advance()
+    void schedule(Entry& e, uint64_t deadlineMs);
+    void cancel(Entry& e);
+
+    // Fire every entry with deadline <= nowMs. A callback may reschedule or
+    // cancel its own entry, but must not cancel other entries.
+    // Returns the number of entries fired.
+    unsigned advance(uint64_t nowMs);
+
+    uint64_t now() const { return currentMs_; }
+    unsigned armedCount() const { return armed_; }
+
+private:
+    void link(Entry& e);
+
+    Entry* slots_[SLOT_COUNT]{};
+    uint64_t currentMs_;
+    unsigned armed_{0};
+};
+
+} // namespace bjj
@@ -0,0 +1,487 @@
+/**
+ * BJJ Gym Timer - Tournament Brackets and Mat Scheduler Implementation
+ */
+
+#include "tournament.hpp"
+#include "control_server.hpp"
+#include "perf_trace.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unordered_map>
+
+namespace bjj {
+
+// ============================================================================
+// LOAD
+// ============================================================================
+static std::string trim(const char* b, const char* e) {
+    while (b < e && std::isspace(static_cast<unsigned char>(*b))) ++b;
+    while (e > b && std::isspace(static_cast<unsigned char>(e[-1]))) --e;
+    return std::string(b, e);
+}
+
+bool Tournament::load(const std::string& path, unsigned matCount, const TournamentRules& rules, uint64_t nowMs) {
+    close();
+    FILE* f = fopen(path.c_str(), "re");
+    if (!f) {
+        perror(path.c_str());
+        return false;
+    }
+    std::unordered_map<std::string, uint16_t> persons;
+    char line[256];
+    unsigned lineNo = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f)) {
+        ++lineNo;
+        if (char* hash = strchr(line, '#')) *hash = '\0';
+        std::string text = trim(line, line + strlen(line));
+        if (text.empty()) continue;
+        if (text[0] == '[') {
+            // "[Name, minutes]"
+            size_t bracket = text.find(']');
+            size_t comma = bracket != std::string::npos ? text.rfind(',', bracket) : std::string::npos;
+            Division d;
+            if (bracket != std::string::npos) {
+                d.name = trim(text.c_str() + 1, text.c_str() + (comma != std::string::npos ? comma : bracket));
+            }
+            ok = !d.name.empty();
+            if (ok && comma != std::string::npos) {
+                unsigned sec = static_cast<unsigned>(std::strtoul(text.c_str() + comma + 1, nullptr, 10)) * 60;
+                ok = false;
+                for (unsigned i = 0; i < COMPETITION_COUNT; ++i) {
+                    if (COMPETITION_TIMES[i] == sec) {
+                        d.compTimeIndex = i;
+                        ok = true;
+                    }
+                }
+            }
+            if (!ok) fprintf(stderr, "%s:%u: want [Division, 5|6|8|10]\n", path.c_str(), lineNo);
+            divisions_.push_back(std::move(d));
+            continue;
+        }
+        if (divisions_.empty() || competitors_.size() >= MAX_COMPETITORS) {
+            fprintf(stderr, "%s:%u: %s\n", path.c_str(), lineNo,
+                    divisions_.empty() ? "competitor before the first [division]" : "too many competitors");
+            ok = false;
+            break;
+        }
+        auto it = persons.emplace(text, static_cast<uint16_t>(persons.size())).first;
+        competitors_.push_back({text, static_cast<uint16_t>(divisions_.size() - 1), it->second});
+    }
+    fclose(f);
+    if (!ok) {
+        divisions_.clear();
+        competitors_.clear();
+        return false;
+    }
+
+    rules_ = rules;
+    matCount_ = std::min(matCount, MAX_MATS);
+    originMs_ = nowMs;
+    originWall_ = time(nullptr);
+    for (unsigned i = 0; i < MAX_MATS; ++i) current_[i] = NO_MATCH;
+    free_ = matCount_ >= 64 ? ~0ULL : (1ULL << matCount_) - 1;
+    personFreeSec_.assign(persons.size(), 0);
+    personPlan_.resize(persons.size());
+    build();
+    if (matches_.empty()) {
+        fprintf(stderr, "%s: no division has two competitors\n", path.c_str());
+        close();
+        return false;
+    }
+
+    // Results so far, in the order they were entered
+    std::string logPath = path + ".results";
+    if (FILE* r = fopen(logPath.c_str(), "re")) {
+        unsigned m, winner;
+        while (fscanf(r, "%u %u", &m, &winner) == 2) {
+            if (m < matches_.size() && matches_[m].state != MatchState::DONE && matches_[m].known() &&
+                (winner == 1 || winner == 2)) {
+                decide(m, winner, false);
+            }
+        }
+        fclose(r);
+    }
+    results_ = fopen(logPath.c_str(), "ae");
+    if (!results_) perror(logPath.c_str());
+    replan(nowMs);
+    return true;
+}
+
+void Tournament::close() {
+    if (results_) fclose(results_);
+    results_ = nullptr;
+    divisions_.clear();
+    competitors_.clear();
+    matches_.clear();
+    free_ = 0;
+    stats_ = {};
+}
+
+// ============================================================================
+// BRACKETS
+// ============================================================================
+void Tournament::build() {
+    std::vector<std::vector<uint16_t>> entrants(divisions_.size());
+    for (size_t i = 0; i < competitors_.size(); ++i) {
+        entrants[competitors_[i].division].push_back(static_cast<uint16_t>(i));
+    }
+    for (size_t d = 0; d < divisions_.size(); ++d) buildDivision(static_cast<uint16_t>(d), entrants[d]);
+
+    const size_t n = matches_.size();
+    released_.reserve(n);
+    avail_.reserve(n);
+    waiting_.resize(n);
+    readyAt_.resize(n);
+    plannedEnd_.resize(n);
+}
+
+// Seeds are placed so 1 and 2 can only meet in the final; positions past the
+// entrant count are byes, which fall to the top seeds
+void Tournament::buildDivision(uint16_t d, const std::vector<uint16_t>& entrants) {
+    Division& div = divisions_[d];
+    const unsigned n = static_cast<unsigned>(entrants.size());
+    if (n < 2) {
+        if (n) div.champion = entrants[0];
+        return;
+    }
+    unsigned rounds = 0;
+    while ((1u << rounds) < n) ++rounds;
+    std::vector<unsigned> order{0};
+    while (order.size() < (1u << rounds)) {
+        const unsigned k = static_cast<unsigned>(order.size());
+        std::vector<unsigned> next;
+        for (unsigned s : order) {
+            next.push_back(s);
+            next.push_back(2 * k - 1 - s);
+        }
+        order.swap(next);
+    }
+
+    struct Slot {
+        uint16_t who;
+        uint32_t match;
+        bool empty() const { return who == NO_COMPETITOR && match == NO_MATCH; }
+    };
+    std::vector<Slot> level(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        level[i] = {order[i] < n ? entrants[order[i]] : NO_COMPETITOR, NO_MATCH};
+    }
+    const unsigned span = COMPETITION_TIMES[div.compTimeIndex] + std::max(rules_.restGapSec, rules_.turnoverSec);
+    for (unsigned r = 0; r < rounds; ++r) {
+        std::vector<Slot> up(level.size() / 2);
+        for (size_t i = 0; i < up.size(); ++i) {
+            const Slot& x = level[2 * i];
+            const Slot& y = level[2 * i + 1];
+            if (x.empty() || y.empty()) {
+                up[i] = x.empty() ? y : x;  // Bye
+                continue;
+            }
+            const uint32_t id = static_cast<uint32_t>(matches_.size());
+            Match m;
+            m.division = d;
+            m.round = static_cast<uint8_t>(r);
+            m.priority = (rounds - r) * span;
+            const Slot* s[2] = {&x, &y};
+            for (unsigned k = 0; k < 2; ++k) {
+                m.who[k] = s[k]->who;
+                m.feed[k] = s[k]->match;
+                if (s[k]->match != NO_MATCH) {
+                    matches_[s[k]->match].next = id;
+                    matches_[s[k]->match].nextSlot = static_cast<uint8_t>(k);
+                }
+            }
+            matches_.push_back(m);
+            up[i] = {NO_COMPETITOR, id};
+        }
+        level.swap(up);
+    }
+    div.rounds = rounds;
+    div.final = level[0].match;
+}
+
+void Tournament::ended(uint32_t m, uint64_t nowMs) {
+    Match& x = matches_[m];
+    x.endSec = secondsAt(nowMs);
+    for (uint16_t c : x.who) {
+        uint32_t& until = personFreeSec_[competitors_[c].person];
+        until = std::max(until, x.endSec + rules_.restGapSec);
+    }
+}
+
+void Tournament::decide(uint32_t m, unsigned winner, bool log) {
+    Match& x = matches_[m];
+    x.winner = x.who[winner - 1];
+    x.state = MatchState::DONE;
+    if (log && results_) {
+        fprintf(results_, "%u %u\n", m, winner);
+        fflush(results_);
+    }
+    if (x.next != NO_MATCH) matches_[x.next].who[x.nextSlot] = x.winner;
+    else divisions_[x.division].champion = x.winner;
+}
+
+// ============================================================================
+// SCHEDULE
+// ============================================================================
+// List schedule of the PENDING matches over the mats, starting from what is
+// on them now: the earliest free mat takes the highest-priority match that
+// is ready by then, or idles until the first one is
+void Tournament::replan(uint64_t nowMs) {
+    if (!active()) return;
+    const uint64_t t0 = monotonicNs();
+    const uint32_t now = nowSec_ = secondsAt(nowMs);
+    const uint32_t rest = rules_.restGapSec;
+    uint32_t matFree[MAX_MATS];
+    uint32_t projected = now;
+    std::copy(personFreeSec_.begin(), personFreeSec_.end(), personPlan_.begin());
+
+    auto occupy = [&](const Match& x, uint32_t end) {
+        for (uint16_t c : x.who) {
+            if (c == NO_COMPETITOR) continue;
+            uint32_t& until = personPlan_[competitors_[c].person];
+            until = std::max(until, end + rest);
+        }
+        projected = std::max(projected, end);
+    };
+    auto readiness = [&](uint32_t m) {
+        const Match& x = matches_[m];
+        uint32_t r = now;
+        for (unsigned s = 0; s < 2; ++s) {
+            if (x.who[s] != NO_COMPETITOR) r = std::max(r, personPlan_[competitors_[x.who[s]].person]);
+            else if (x.feed[s] != NO_MATCH) r = std::max(r, plannedEnd_[x.feed[s]] + rest);
+        }
+        return r;
+    };
+    // Running matches first: a called one waits out their athletes' rest
+    for (int pass = 0; pass < 2; ++pass) {
+        for (unsigned k = 0; k < matCount_; ++k) {
+            if (!pass) matFree[k] = now;
+            const uint32_t c = current_[k];
+            if (c == NO_MATCH || (matches_[c].state == MatchState::LIVE) != !pass) continue;
+            Match& x = matches_[c];
+            uint32_t end;
+            if (x.state == MatchState::LIVE) {
+                end = std::max(now, x.startSec + duration(x));
+            } else {
+                const uint32_t start = readiness(c);
+                if (start / 60 != x.plannedStart / 60) moved_ |= 1ULL << k;
+                x.plannedStart = start;
+                end = start + duration(x);
+            }
+            plannedEnd_[c] = end;
+            occupy(x, end);
+            matFree[k] = end + rules_.turnoverSec;
+        }
+    }
+
+    released_.clear();
+    avail_.clear();
+    auto laterReady = [&](uint32_t a, uint32_t b) {
+        return readyAt_[a] != readyAt_[b] ? readyAt_[a] > readyAt_[b] : a > b;
+    };
+    auto lowerPriority = [&](uint32_t a, uint32_t b) {
+        return matches_[a].priority != matches_[b].priority ? matches_[a].priority < matches_[b].priority : a > b;
+    };
+    auto release = [&](uint32_t m) {
+        readyAt_[m] = readiness(m);
+        released_.push_back(m);
+        std::push_heap(released_.begin(), released_.end(), laterReady);
+    };
+
+    const uint32_t n = static_cast<uint32_t>(matches_.size());
+    for (uint32_t m = 0; m < n; ++m) {
+        const Match& x = matches_[m];
+        if (x.state == MatchState::ENDED || x.state == MatchState::DONE) plannedEnd_[m] = x.endSec;
+        if (x.state != MatchState::PENDING) continue;
+        waiting_[m] = 0;
+        for (uint32_t f : x.feed) {
+            if (f != NO_MATCH && matches_[f].state == MatchState::PENDING) ++waiting_[m];
+        }
+    }
+    for (uint32_t m = 0; m < n; ++m) {
+        if (matches_[m].state == MatchState::PENDING && !waiting_[m]) release(m);
+    }
+
+    while (!released_.empty() || !avail_.empty()) {
+        const unsigned k = static_cast<unsigned>(std::min_element(matFree, matFree + matCount_) - matFree);
+        uint32_t t = matFree[k];
+        if (avail_.empty() && readyAt_[released_.front()] > t) t = readyAt_[released_.front()];
+        while (!released_.empty() && readyAt_[released_.front()] <= t) {
+            std::pop_heap(released_.begin(), released_.end(), laterReady);
+            avail_.push_back(released_.back());
+            released_.pop_back();
+            std::push_heap(avail_.begin(), avail_.end(), lowerPriority);
+        }
+        std::pop_heap(avail_.begin(), avail_.end(), lowerPriority);
+        const uint32_t m = avail_.back();
+        avail_.pop_back();
+        // Someone in two divisions may have been planned elsewhere since release
+        const uint32_t r = readiness(m);
+        if (r > t) {
+            readyAt_[m] = r;
+            released_.push_back(m);
+            std::push_heap(released_.begin(), released_.end(), laterReady);
+            continue;
+        }
+        Match& x = matches_[m];
+        x.mat = static_cast<uint8_t>(k);
+        x.plannedStart = t;
+        plannedEnd_[m] = t + duration(x);
+        occupy(x, plannedEnd_[m]);
+        matFree[k] = plannedEnd_[m] + rules_.turnoverSec;
+        if (x.next != NO_MATCH && matches_[x.next].state == MatchState::PENDING && !--waiting_[x.next]) {
+            release(x.next);
+        }
+    }
+
+    stats_.projectedEndSec = projected;
+    ++stats_.replans;
+    stats_.lastReplanUs = static_cast<uint32_t>((monotonicNs() - t0) / 1000);
+    stats_.maxReplanUs = std::max(stats_.maxReplanUs, stats_.lastReplanUs);
+}
+
+// The mat's earliest planned match with both athletes known; one waiting on
+// a result is skipped rather than holding the mat
+uint32_t Tournament::pickNext(unsigned mat) const {
+    uint32_t best = NO_MATCH;
+    for (uint32_t m = 0; m < matches_.size(); ++m) {
+        const Match& x = matches_[m];
+        if (x.state != MatchState::PENDING || x.mat != mat || !x.known()) continue;
+        if (best == NO_MATCH || x.plannedStart < matches_[best].plannedStart) best = m;
+    }
+    return best;
+}
+
+// ============================================================================
+// MATS
+// ============================================================================
+uint64_t Tournament::apply(MatHost& host) {
+    if (!free_) return 0;
+    replan(host.nowMs());
+    uint64_t changed = moved_;
+    moved_ = 0;
+    for (unsigned k = 0; k < matCount_; ++k) {
+        const uint64_t bit = 1ULL << k;
+        if (!(free_ & bit)) continue;
+        free_ &= ~bit;
+        TimerState st = host.timer(k).getState();
+        if (current_[k] != NO_MATCH || st == TimerState::RUNNING || st == TimerState::PAUSED) continue;
+        const uint32_t m = pickNext(k);
+        if (m == NO_MATCH) continue;
+        Match& x = matches_[m];
+        x.state = MatchState::CALLED;
+        current_[k] = m;
+        // Through the control path, so a recording replays the same loads
+        CtlCommand cmd{};
+        cmd.op = CTL_OP_LOAD_PRESET;
+        cmd.mat = static_cast<uint8_t>(k);
+        cmd.mode = static_cast<uint8_t>(TimerMode::COMPETITION);
+        cmd.rounds = 1;
+        cmd.arg = static_cast<int32_t>(duration(x));
+        runControlCommand(host, cmd);
+        changed |= bit;
+    }
+    return changed;
+}
+
+bool Tournament::onTransition(unsigned mat, const TimerSnapshot& snap, uint64_t nowMs) {
+    if (!active() || mat >= matCount_) return false;
+    const bool live = snap.state == TimerState::RUNNING || snap.state == TimerState::PAUSED;
+    const uint32_t c = current_[mat];
+    if (c == NO_MATCH) {
+        if (!live) free_ |= 1ULL << mat;
+        return false;
+    }
+    Match& x = matches_[c];
+    if (live && x.state == MatchState::CALLED) {
+        x.state = MatchState::LIVE;
+        x.startSec = secondsAt(nowMs);
+        return true;
+    }
+    if (snap.state == TimerState::FINISHED && x.state == MatchState::LIVE) {
+        x.state = MatchState::ENDED;
+        ended(c, nowMs);
+        current_[mat] = NO_MATCH;
+        free_ |= 1ULL << mat;
+        return true;
+    }
+    if (!live && x.state == MatchState::LIVE) {
+        x.state = MatchState::CALLED;  // Reset by hand: the match is still to fight
+        return true;
+    }
+    return false;
+}
+
+bool Tournament::result(MatHost& host, unsigned mat, unsigned winner) {
+    if (!active() || mat >= matCount_ || (winner != 1 && winner != 2)) return false;
+    uint32_t target = NO_MATCH;
+    for (uint32_t m = 0; m < matches_.size(); ++m) {
+        const Match& x = matches_[m];
+        if (x.state != MatchState::ENDED || x.mat != mat) continue;
+        if (target == NO_MATCH || x.endSec < matches_[target].endSec) target = m;
+    }
+    if (target == NO_MATCH) {
+        // Submission: end the running match now
+        target = current_[mat];
+        if (target == NO_MATCH || matches_[target].state != MatchState::LIVE) return false;
+        ended(target, host.nowMs());
+        current_[mat] = NO_MATCH;
+        CtlCommand cmd{};
+        cmd.op = CTL_OP_RESET;
+        cmd.mat = static_cast<uint8_t>(mat);
+        runControlCommand(host, cmd);
+    }
+    decide(target, winner, true);
+    // The winner's next match may be all an idle mat was waiting for
+    for (unsigned k = 0; k < matCount_; ++k) {
+        if (current_[k] == NO_MATCH) free_ |= 1ULL << k;
+    }
+    return true;
+}
+
+// ============================================================================
+// DISPLAY
+// ============================================================================
+const char* Tournament::roundName(const Match& m, char* buf, size_t size) const {
+    const unsigned left = divisions_[m.division].rounds - m.round;
+    if (left == 1) return "Final";
+    if (left == 2) return "Semi-final";
+    if (left == 3) return "Quarter-final";
+    snprintf(buf, size, "Round of %u", 1u << left);
+    return buf;
+}
+
+const char* Tournament::title(unsigned mat) const {
+    if (!active() || mat >= matCount_ || current_[mat] == NO_MATCH) return "";
+    return matches_[current_[mat]].state == MatchState::LIVE ? "MATCH" : "NEXT MATCH";
+}
+
+void Tournament::describe(unsigned mat, TextList& out) const {
+    out.clear();
+    if (!active() || mat >= matCount_ || current_[mat] == NO_MATCH) return;
+    const Match& x = matches_[current_[mat]];
+    char text[32];
+    out.add("%s vs %s", competitors_[x.who[0]].name.c_str(), competitors_[x.who[1]].name.c_str());
+    out.add("%s - %s", divisions_[x.division].name.c_str(), roundName(x, text, sizeof(text)));
+    if (x.state == MatchState::CALLED && x.plannedStart > nowSec_) {
+        // Someone is still resting
+        time_t at = originWall_ + x.plannedStart;
+        struct tm local;
+        strftime(text, sizeof(text), "Not before %H:%M", localtime_r(&at, &local));
+        out.add("%s", text);
+    }
+}
+
+TournamentStats Tournament::stats() const {
+    TournamentStats s = stats_;
+    s.matches = static_cast<uint32_t>(matches_.size());
+    s.done = 0;
+    for (const Match& m : matches_) s.done += m.state == MatchState::DONE;
+    return s;
+}
+
+} // namespace bjj
@@ -0,0 +1,170 @@
+/**
+ * BJJ Gym Timer - Tournament Brackets and Mat Scheduler
+ * Single-elimination brackets per division (seeded in file order, top seeds
+ * get the byes), every match assigned a mat and a start time so the event
+ * ends as early as possible while nobody fights again within the rest gap.
+ *
+ * The plan is a list schedule: whenever a mat frees up it takes the ready
+ * match with the longest chain still behind it to its division's final, so
+ * big brackets start first and finals are not left waiting. Finished and
+ * running matches are fixed; only the unstarted tail is re-planned, on every
+ * match end and result, which absorbs overruns and early submissions. That
+ * is O(m log m) in the matches left - about 0.1 ms for 500 competitors.
+ *
+ * When a mat's timer reaches FINISHED its next match is loaded as a
+ * competition preset. Results come in over the control socket or dashboard
+ * (CTL_OP_RESULT); a result for a running match (submission) ends it. Results
+ * are appended to PATH.results and replayed on the next load, so a restart
+ * keeps the bracket.
+ */
+
+#pragma once
+
+#include "mat_host.hpp"
+#include "text_list.hpp"
+#include "timer_logic.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace bjj {
+
+constexpr unsigned MAX_COMPETITORS = 4096;
+constexpr uint32_t NO_MATCH = 0xFFFFFFFF;
+constexpr uint16_t NO_COMPETITOR = 0xFFFF;
+constexpr unsigned DEFAULT_REST_GAP_SEC = 600;
+constexpr unsigned TURNOVER_SEC = 60;     // Calling the next pair onto a freed mat
+
+enum class MatchState : uint8_t {
+    PENDING,     // Not on a mat yet
+    CALLED,      // Loaded into its mat's timer
+    LIVE,        // Timer running or paused
+    ENDED,       // Clock ran out, waiting for the result
+    DONE,        // Winner known
+};
+
+struct Division {
+    std::string name;
+    unsigned compTimeIndex{0};       // COMPETITION_TIMES
+    unsigned rounds{0};              // Bracket depth; 0: a single entrant
+    uint32_t final{NO_MATCH};
+    uint16_t champion{NO_COMPETITOR};
+};
+
+struct Competitor {
+    std::string name;
+    uint16_t division;
+    uint16_t person;                 // Same name in two divisions: same person
+};
+
+struct Match {
+    uint16_t division;
+    uint8_t round;                   // 0: first round of the division
+    MatchState state{MatchState::PENDING};
+    uint16_t who[2]{NO_COMPETITOR, NO_COMPETITOR};
+    uint32_t feed[2]{NO_MATCH, NO_MATCH};  // Slot filled by that match's winner
+    uint32_t next{NO_MATCH};
+    uint8_t nextSlot{0};
+    uint16_t winner{NO_COMPETITOR};
+    uint8_t mat{0};
+    uint32_t priority{0};            // Seconds of chain left to the final, this match included
+    uint32_t plannedStart{0};        // Seconds since the event opened
+    uint32_t startSec{0};            // Actual, once LIVE
+    uint32_t endSec{0};              // Actual, once ENDED/DONE
+
+    bool known() const { return who[0] != NO_COMPETITOR && who[1] != NO_COMPETITOR; }
+};
+
+struct TournamentRules {
+    unsigned restGapSec{DEFAULT_REST_GAP_SEC};   // Between one match's end and the next start
+    unsigned turnoverSec{TURNOVER_SEC};
+};
+
+struct TournamentStats {
+    uint32_t matches;
+    uint32_t done;
+    uint32_t replans;
+    uint32_t lastReplanUs;
+    uint32_t maxReplanUs;
+    uint32_t projectedEndSec;        // Planned end of the last match, since the event opened
+};
+
+class Tournament {
+public:
+    Tournament() = default;
+    ~Tournament() { close(); }
+    Tournament(const Tournament&) = delete;
+    Tournament& operator=(const Tournament&) = delete;
+
+    // "[Division name, minutes]" starts a division (minutes: 5, 6, 8 or 10),
+    // then one competitor per line, best seed first; '#' starts a comment.
+    // Opens PATH.results and replays it. nowMs is the host clock.
+    bool load(const std::string& path, unsigned matCount, const TournamentRules& rules, uint64_t nowMs);
+    void close();
+    bool active() const { return !matches_.empty(); }
+
+    const std::vector<Division>& divisions() const { return divisions_; }
+    const std::vector<Competitor>& competitors() const { return competitors_; }
+    const std::vector<Match>& matches() const { return matches_; }
+
+    // Feed every transition of every mat; true when what the mat shows changed
+    bool onTransition(unsigned mat, const TimerSnapshot& snap, uint64_t nowMs);
+
+    // winner: 1 or 2, the athlete listed first or second. Applies to the
+    // mat's oldest match still waiting for one, else its running match,
+    // which then ends. False if the mat has neither.
+    bool result(MatHost& host, unsigned mat, unsigned winner);
+
+    // Timer thread, before host.poll(): load the next match onto every free
+    // mat. Returns a mask of the mats whose shown match changed.
+    uint64_t apply(MatHost& host);
+
+    // Re-plan the matches not on a mat yet (apply() and result() do this)
+    void replan(uint64_t nowMs);
+
+    // What the mat shows: "NEXT MATCH" before the start, "MATCH" while it
+    // runs; "Ana vs Bruno", division and round, and "Not before 14:05" while
+    // an athlete is still within the rest gap
+    const char* title(unsigned mat) const;
+    void describe(unsigned mat, TextList& out) const;
+
+    TournamentStats stats() const;
+
+private:
+    void build();
+    void buildDivision(uint16_t d, const std::vector<uint16_t>& entrants);
+    void ended(uint32_t m, uint64_t nowMs);
+    void decide(uint32_t m, unsigned winner, bool log);
+    uint32_t pickNext(unsigned mat) const;
+    uint32_t secondsAt(uint64_t nowMs) const { return static_cast<uint32_t>((nowMs - originMs_) / 1000); }
+    unsigned duration(const Match& m) const { return COMPETITION_TIMES[divisions_[m.division].compTimeIndex]; }
+    // "Final", "Semi-final", ... "Round of 16" into buf
+    const char* roundName(const Match& m, char* buf, size_t size) const;
+
+    std::vector<Division> divisions_;
+    std::vector<Competitor> competitors_;
+    std::vector<Match> matches_;
+    std::vector<uint32_t> personFreeSec_;   // Earliest next start by the rest gap, from actual ends
+    TournamentRules rules_;
+    unsigned matCount_{0};
+    uint64_t originMs_{0};
+    time_t originWall_{0};
+    uint32_t nowSec_{0};                    // As of the last replan()
+    uint32_t current_[MAX_MATS];            // Match on the mat's timer, NO_MATCH if none
+    uint64_t free_{0};                      // Mats with nothing loaded, waiting for apply()
+    uint64_t moved_{0};                     // Mats whose called match was re-timed
+    FILE* results_{nullptr};
+
+    // replan() scratch, sized once at load
+    std::vector<uint32_t> released_;        // Heap on ready time
+    std::vector<uint32_t> avail_;           // Heap on priority
+    std::vector<uint8_t> waiting_;          // Feeders not planned yet
+    std::vector<uint32_t> readyAt_;
+    std::vector<uint32_t> plannedEnd_;
+    std::vector<uint32_t> personPlan_;
+    TournamentStats stats_{};
+};
+
+} // namespace bjj
@@ -6,157 +6,430 @@
 #include "hardware.hpp"
 #include "lvgl_port.hpp"
 #include <lvgl.h>
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
+#include <initializer_list>
 
 namespace bjj {
 
-BJJTimerUI::BJJTimerUI() = default;
+// ============================================================================
+// SHARED STYLES - initialised once, referenced by every panel
+// ============================================================================
+namespace {
+
+struct UiStyles {
+    bool ready = false;
+    lv_style_t screen;      // Transparent, borderless view container
+    lv_style_t tile;        // Split-screen tile background + divider
+    lv_style_t textSmall;
+    lv_style_t textLarge;
+    lv_style_t textClock;
+    lv_style_t arcTrack;
+    lv_style_t arcIndicator;
+};
+
+UiStyles g_styles;
+
+void initStyles() {
+    if (g_styles.ready) return;
+    g_styles.ready = true;
+
+    lv_style_init(&g_styles.screen);
+    lv_style_set_bg_opa(&g_styles.screen, LV_OPA_TRANSP);
+    lv_style_set_border_width(&g_styles.screen, 0);
+
+    lv_style_init(&g_styles.tile);
+    lv_style_set_bg_color(&g_styles.tile, lv_color_hex(THEME_BG));
+    lv_style_set_bg_opa(&g_styles.tile, LV_OPA_COVER);
+    lv_style_set_border_width(&g_styles.tile, 1);
+    lv_style_set_border_color(&g_styles.tile, lv_color_hex(THEME_GRAY));
+    lv_style_set_radius(&g_styles.tile, 0);
+    lv_style_set_pad_all(&g_styles.tile, 0);
+
+    lv_style_init(&g_styles.textSmall);
+    lv_style_set_text_font(&g_styles.textSmall, &lv_font_montserrat_14);
+
+    lv_style_init(&g_styles.textLarge);
+    lv_style_set_text_font(&g_styles.textLarge, &lv_font_montserrat_48);
+
+    lv_style_init(&g_styles.textClock);
+    lv_style_set_text_font(&g_styles.textClock, &lv_font_montserrat_48);
+    lv_style_set_transform_pivot_x(&g_styles.textClock, LV_PCT(50));
+    lv_style_set_transform_pivot_y(&g_styles.textClock, LV_PCT(50));
+
+    lv_style_init(&g_styles.arcTrack);
+    lv_style_set_arc_width(&g_styles.arcTrack, 12);
+    lv_style_set_arc_color(&g_styles.arcTrack, lv_color_hex(THEME_GRAY));
+    lv_style_set_bg_opa(&g_styles.arcTrack, LV_OPA_TRANSP);
+    lv_style_set_border_width(&g_styles.arcTrack, 0);
+
+    lv_style_init(&g_styles.arcIndicator);
+    lv_style_set_arc_width(&g_styles.arcIndicator, 12);
+}
 
-BJJTimerUI::~BJJTimerUI() {
-    if (tickTimer_) lv_timer_del(tickTimer_);
+// Fonts and arc width are shared by every panel, so a resize restyles them once
+void applyStyleLayout(const PanelLayout& l) {
+    lv_style_set_text_font(&g_styles.textSmall, l.fontSmall);
+    lv_style_set_text_font(&g_styles.textLarge, l.fontLarge);
+    lv_style_set_text_font(&g_styles.textClock, l.fontClock);
+    lv_style_set_transform_scale(&g_styles.textClock, l.clockScale);
+    lv_style_set_arc_width(&g_styles.arcTrack, l.arcWidth);
+    lv_style_set_arc_width(&g_styles.arcIndicator, l.arcWidth);
+    for (lv_style_t* st : {&g_styles.textSmall, &g_styles.textLarge, &g_styles.textClock,
+                           &g_styles.arcTrack, &g_styles.arcIndicator}) {
+        lv_obj_report_style_change(st);
+    }
 }
 
-void BJJTimerUI::create(lv_obj_t* parent) {
-    lv_obj_t* root = parent ? parent : lv_screen_active();
-    if (!root) return;
+struct FontSize {
+    int32_t px;
+    const lv_font_t* font;
+};
+
+const FontSize FONTS[] = {
+    {12, &lv_font_montserrat_12}, {14, &lv_font_montserrat_14}, {20, &lv_font_montserrat_20},
+    {28, &lv_font_montserrat_28}, {36, &lv_font_montserrat_36}, {48, &lv_font_montserrat_48},
+};
+
+// Largest built-in font not taller than px (the smallest if none fit)
+const FontSize& pickFont(int32_t px) {
+    const FontSize* best = &FONTS[0];
+    for (const FontSize& f : FONTS) {
+        if (f.px <= px) best = &f;
+    }
+    return *best;
+}
 
-    // Main container - full screen, dark bg
-    lv_obj_set_style_bg_color(root, lv_color_hex(THEME_BG), 0);
-    lv_obj_set_style_bg_opa(root, LV_OPA_COVER, 0);
+} // namespace
+
+PanelLayout computePanelLayout(int32_t w, int32_t h, bool compact) {
+    // Uniform scale (1/256 units) against the size the original offsets were drawn for
+    const int32_t refW = compact ? 400 : 800;
+    const int32_t refH = compact ? 240 : 480;
+    const int32_t s = std::max<int32_t>(64, std::min(w * 256 / refW, h * 256 / refH));
+    auto S = [s](int32_t v) { return v * s / 256; };
+
+    PanelLayout l{};
+    l.fontSmall = pickFont(S(14)).font;
+    l.fontLarge = pickFont(S(48)).font;
+    const FontSize& clock = pickFont(S(48));
+    l.fontClock = clock.font;
+    // Glyph scaling costs a layer per redraw, so only use it past the largest font
+    l.clockScale = S(48) > clock.px ? S(48) * 256 / clock.px : 256;
+    l.arcWidth = std::max<int32_t>(4, S(12));
+    l.letterSpace = S(4);
+
+    const int32_t minSide = std::min(w, h);
+    if (compact) {
+        l.headerX = S(8);
+        l.headerY = S(6);
+        l.menuTitleY = h / 8;
+        l.rollerY = S(10);
+        l.setupTitleY = h / 4;
+        l.arcSize = minSide * 7 / 10;
+        const int32_t half = lv_font_get_line_height(l.fontSmall) / 2;
+        l.phaseY = h / 2 - l.arcSize / 4 - half;
+        l.roundY = h / 2 + l.arcSize / 4 - half;
+    } else {
+        l.headerX = 0;
+        l.headerY = S(20);
+        l.menuTitleY = S(100);
+        l.rollerY = S(20);
+        l.setupTitleY = S(140);
+        l.arcSize = std::min(S(280), minSide * 9 / 10);
+        l.phaseY = S(90);
+        l.roundY = S(110);
+    }
+    return l;
+}
 
-    // Create screens first (below header)
-    screenMenu_ = lv_obj_create(root);
-    lv_obj_set_size(screenMenu_, LV_PCT(100), LV_PCT(100));
-    lv_obj_clear_flag(screenMenu_, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_opa(screenMenu_, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_border_width(screenMenu_, 0, 0);
-    lv_obj_set_style_pad_all(screenMenu_, 0, 0);
+// ============================================================================
+// TIMER PANEL
+// ============================================================================
+TimerPanel::TimerPanel(lv_obj_t* parent, const PanelArea& area, const PanelLayout& layout,
+                       unsigned matIndex, bool compact)
+    : area_(area), layout_(layout), matIndex_(matIndex), compact_(compact) {
+    initStyles();
+
+    container_ = lv_obj_create(parent);
+    lv_obj_set_pos(container_, area.x, area.y);
+    lv_obj_set_size(container_, area.w, area.h);
+    lv_obj_clear_flag(container_, LV_OBJ_FLAG_SCROLLABLE);
+    if (compact_) {
+        lv_obj_add_style(container_, &g_styles.tile, 0);
+    } else {
+        lv_obj_add_style(container_, &g_styles.screen, 0);
+        lv_obj_set_style_pad_all(container_, 0, 0);
+    }
+
+    // Only the menu is needed for the first frame; setup/running are built on first use
+    buildMenuScreen();
+
+    // Header (created after the screens so it stays on top)
+    headerLabel_ = lv_label_create(container_);
+    lv_obj_set_style_text_color(headerLabel_, lv_color_hex(THEME_GOLD), 0);
+    if (compact_) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "MAT %u", matIndex_ + 1);
+        lv_label_set_text(headerLabel_, buf);
+        lv_obj_add_style(headerLabel_, &g_styles.textSmall, 0);
+    } else {
+        lv_label_set_text(headerLabel_, "CATCH JIU JITSU");
+        lv_obj_add_style(headerLabel_, &g_styles.textLarge, 0);
+    }
+    layoutHeader();
+
+    // Initial screen: menu
+    currentScreen_ = 1;
+}
+
+TimerPanel::~TimerPanel() {
+    if (container_) lv_obj_delete(container_);
+}
+
+void TimerPanel::applyLayout(const PanelArea& area, const PanelLayout& layout) {
+    area_ = area;
+    layout_ = layout;
+    lv_obj_set_pos(container_, area.x, area.y);
+    lv_obj_set_size(container_, area.w, area.h);
+    layoutHeader();
+    layoutMenu();
+    layoutSetup();
+    layoutRunning();
+}
+
+void TimerPanel::layoutHeader() {
+    if (compact_) {
+        lv_obj_align(headerLabel_, LV_ALIGN_TOP_LEFT, layout_.headerX, layout_.headerY);
+    } else {
+        lv_obj_set_style_text_letter_space(headerLabel_, layout_.letterSpace, 0);
+        lv_obj_align(headerLabel_, LV_ALIGN_TOP_MID, 0, layout_.headerY);
+    }
+}
+
+void TimerPanel::layoutMenu() {
+    if (!screenMenu_) return;
+    lv_obj_align(menuTitle_, LV_ALIGN_TOP_MID, 0, layout_.menuTitleY);
+    lv_obj_align(modeRoller_, LV_ALIGN_CENTER, 0, layout_.rollerY);
+}
+
+void TimerPanel::layoutSetup() {
+    if (!screenSetup_) return;
+    lv_obj_align(setupTitleLabel_, LV_ALIGN_TOP_MID, 0, layout_.setupTitleY);
+    lv_obj_align(valueLabel_, LV_ALIGN_CENTER, 0, 0);
+}
+
+void TimerPanel::layoutRunning() {
+    if (!screenRunning_) return;
+    if (pairs_.empty()) {
+        lv_obj_set_size(progressArc_, layout_.arcSize, layout_.arcSize);
+        lv_obj_center(progressArc_);
+        lv_obj_center(clockLabel_);
+        lv_obj_align(phaseLabel_, LV_ALIGN_TOP_MID, 0, layout_.phaseY);
+        lv_obj_align(roundLabel_, LV_ALIGN_TOP_MID, 0, layout_.roundY);
+        lv_obj_align_to(scoreLabel_[0], progressArc_, LV_ALIGN_OUT_LEFT_MID, -layout_.arcWidth, 0);
+        lv_obj_align_to(scoreLabel_[1], progressArc_, LV_ALIGN_OUT_RIGHT_MID, layout_.arcWidth, 0);
+        lv_obj_add_flag(pairTitle_, LV_OBJ_FLAG_HIDDEN);
+        for (lv_obj_t* col : pairColumns_) lv_obj_add_flag(col, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
+
+    // Arc, clock and labels move left; the partner list takes the rest
+    const int32_t margin = layout_.arcWidth;
+    const int32_t arc = std::min(layout_.arcSize, area_.w * 2 / 5);
+    lv_obj_set_size(progressArc_, arc, arc);
+    lv_obj_align(progressArc_, LV_ALIGN_LEFT_MID, margin, 0);
+    lv_obj_align_to(clockLabel_, progressArc_, LV_ALIGN_CENTER, 0, 0);
+    lv_obj_align_to(phaseLabel_, progressArc_, LV_ALIGN_CENTER, 0, -arc / 4);
+    lv_obj_align_to(roundLabel_, progressArc_, LV_ALIGN_CENTER, 0, arc / 4);
+    // The list has the right-hand side: the score goes under the arc
+    lv_obj_align_to(scoreLabel_[0], progressArc_, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 0);
+    lv_obj_align_to(scoreLabel_[1], progressArc_, LV_ALIGN_OUT_BOTTOM_RIGHT, 0, 0);
+
+    const int32_t line = lv_font_get_line_height(layout_.fontSmall);
+    const int32_t x = arc + 2 * margin;
+    const int32_t w = area_.w - x - margin;
+    const int32_t top = layout_.headerY + lv_font_get_line_height(compact_ ? layout_.fontSmall : layout_.fontLarge);
+    lv_label_set_text(pairTitle_, pairTitleText_);
+    lv_obj_set_pos(pairTitle_, x, top);
+    lv_obj_remove_flag(pairTitle_, LV_OBJ_FLAG_HIDDEN);
+
+    // As many columns as the longest pair allows; a column taller than the
+    // screen scrolls
+    size_t longest = 0;
+    for (unsigned i = 0; i < pairs_.size(); ++i) longest = std::max(longest, strlen(pairs_[i]));
+    const int32_t glyph = std::max<int32_t>(1, lv_font_get_glyph_width(layout_.fontSmall, '0', 0));
+    const int32_t colW = static_cast<int32_t>(longest + 2) * glyph;
+    const unsigned cols = static_cast<unsigned>(std::max<int32_t>(1, std::min<int32_t>(MAX_PAIR_COLUMNS, w / colW)));
+    const size_t rows = (pairs_.size() + cols - 1) / cols;
+    const int32_t y = top + line * 3 / 2;
+    for (unsigned c = 0; c < MAX_PAIR_COLUMNS; ++c) {
+        lv_obj_t* col = pairColumns_[c];
+        if (c >= cols || c * rows >= pairs_.size()) {
+            lv_obj_add_flag(col, LV_OBJ_FLAG_HIDDEN);
+            continue;
+        }
+        // Joined in place: the lines fit in TextList::BYTES, so their column does too
+        static char text[TextList::BYTES];
+        size_t n = 0;
+        for (size_t i = c * rows; i < std::min<size_t>(pairs_.size(), (c + 1) * rows); ++i) {
+            n += snprintf(text + n, sizeof(text) - n, i > c * rows ? "\n%s" : "%s", pairs_[static_cast<unsigned>(i)]);
+        }
+        lv_label_set_text(col, text);
+        lv_obj_set_pos(col, x + static_cast<int32_t>(c) * w / static_cast<int32_t>(cols), y);
+        lv_obj_set_size(col, w / static_cast<int32_t>(cols), area_.h - y - margin);
+        lv_obj_remove_flag(col, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+void TimerPanel::setPairings(const char* title, const TextList& pairs) {
+    if (pairs.empty() && pairs_.empty()) return;
+    snprintf(pairTitleText_, sizeof(pairTitleText_), "%s", title ? title : "");
+    pairs_ = pairs;
+    layoutRunning();  // Not built yet: applied when it is
+}
 
-    screenSetup_ = lv_obj_create(root);
-    lv_obj_set_size(screenSetup_, LV_PCT(100), LV_PCT(100));
-    lv_obj_clear_flag(screenSetup_, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_opa(screenSetup_, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_border_width(screenSetup_, 0, 0);
+lv_obj_t* TimerPanel::createScreen() {
+    lv_obj_t* scr = lv_obj_create(container_);
+    lv_obj_set_size(scr, LV_PCT(100), LV_PCT(100));
+    lv_obj_clear_flag(scr, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_style(scr, &g_styles.screen, 0);
+    // Keep lazily-built screens below the header
+    if (headerLabel_) lv_obj_move_background(scr);
+    return scr;
+}
 
-    screenRunning_ = lv_obj_create(root);
-    lv_obj_set_size(screenRunning_, LV_PCT(100), LV_PCT(100));
-    lv_obj_clear_flag(screenRunning_, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_opa(screenRunning_, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_border_width(screenRunning_, 0, 0);
+void TimerPanel::buildMenuScreen() {
+    screenMenu_ = createScreen();
+    lv_obj_set_style_pad_all(screenMenu_, 0, 0);
 
     // Menu: mode roller
-    lv_obj_t* menuTitle = lv_label_create(screenMenu_);
-    lv_label_set_text(menuTitle, "Select Mode");
-    lv_obj_set_style_text_color(menuTitle, lv_color_hex(THEME_GRAY), 0);
-    lv_obj_align(menuTitle, LV_ALIGN_TOP_MID, 0, 100);
+    menuTitle_ = lv_label_create(screenMenu_);
+    lv_label_set_text(menuTitle_, "Select Mode");
+    lv_obj_set_style_text_color(menuTitle_, lv_color_hex(THEME_GRAY), 0);
+    lv_obj_add_style(menuTitle_, compact_ ? &g_styles.textSmall : &g_styles.textLarge, 0);
 
     modeRoller_ = lv_roller_create(screenMenu_);
     lv_roller_set_options(modeRoller_, "SPARRING\nDRILLING\nCOMPETITION", LV_ROLLER_MODE_NORMAL);
     lv_roller_set_visible_row_count(modeRoller_, 3);
     lv_obj_set_style_text_color(modeRoller_, lv_color_hex(THEME_GOLD), LV_PART_SELECTED);
     lv_obj_set_style_text_color(modeRoller_, lv_color_hex(THEME_WHITE), 0);
-    lv_obj_set_style_text_font(modeRoller_, &lv_font_montserrat_48, 0);
-    lv_obj_align(modeRoller_, LV_ALIGN_CENTER, 0, 20);
-    lv_group_add_obj(lvgl_port_get_group(), modeRoller_);
+    lv_obj_add_style(modeRoller_, compact_ ? &g_styles.textSmall : &g_styles.textLarge, 0);
+    if (matIndex_ == 0) lv_group_add_obj(lvgl_port_get_group(), modeRoller_);
+    layoutMenu();
+}
+
+void TimerPanel::buildSetupScreen() {
+    screenSetup_ = createScreen();
 
     // Setup: title + value
     setupTitleLabel_ = lv_label_create(screenSetup_);
     lv_label_set_text(setupTitleLabel_, "Work Time");
     lv_obj_set_style_text_color(setupTitleLabel_, lv_color_hex(THEME_WHITE), 0);
-    lv_obj_set_style_text_font(setupTitleLabel_, &lv_font_montserrat_14, 0);
-    lv_obj_align(setupTitleLabel_, LV_ALIGN_TOP_MID, 0, 140);
+    lv_obj_add_style(setupTitleLabel_, &g_styles.textSmall, 0);
 
     valueLabel_ = lv_label_create(screenSetup_);
     lv_label_set_text(valueLabel_, "5:00");
     lv_obj_set_style_text_color(valueLabel_, lv_color_hex(THEME_GOLD), 0);
-    lv_obj_set_style_text_font(valueLabel_, &lv_font_montserrat_48, 0);
-    lv_obj_align(valueLabel_, LV_ALIGN_CENTER, 0, 0);
+    lv_obj_add_style(valueLabel_, &g_styles.textClock, 0);
+    layoutSetup();
+}
+
+void TimerPanel::buildRunningScreen() {
+    screenRunning_ = createScreen();
 
     // Running: arc + clock
-    int arcSize = 280;
     progressArc_ = lv_arc_create(screenRunning_);
-    lv_obj_set_size(progressArc_, arcSize, arcSize);
-    lv_obj_center(progressArc_);
-    lv_arc_set_range(progressArc_, 0, 100);
-    lv_arc_set_value(progressArc_, 100);
+    // Angles are set directly (not via the 0-100 value) for sub-degree steps;
+    // lv_arc invalidates only the slice between the old and new end angle
+    lv_arc_set_mode(progressArc_, LV_ARC_MODE_NORMAL);
     lv_arc_set_bg_angles(progressArc_, 0, 360);
+    lv_arc_set_angles(progressArc_, 0, 360);
     lv_arc_set_rotation(progressArc_, 270);
-    lv_obj_set_style_arc_width(progressArc_, 12, LV_PART_MAIN);
-    lv_obj_set_style_arc_width(progressArc_, 12, LV_PART_INDICATOR);
-    lv_obj_set_style_arc_color(progressArc_, lv_color_hex(THEME_GRAY), LV_PART_MAIN);
+    lv_obj_add_style(progressArc_, &g_styles.arcTrack, LV_PART_MAIN);
+    lv_obj_add_style(progressArc_, &g_styles.arcIndicator, LV_PART_INDICATOR);
     lv_obj_set_style_arc_color(progressArc_, lv_color_hex(THEME_GREEN), LV_PART_INDICATOR);
-    lv_obj_set_style_bg_opa(progressArc_, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_border_width(progressArc_, 0, 0);
     lv_obj_remove_flag(progressArc_, LV_OBJ_FLAG_CLICKABLE);
 
     clockLabel_ = lv_label_create(screenRunning_);
     lv_label_set_text(clockLabel_, "05:00");
     lv_obj_set_style_text_color(clockLabel_, lv_color_hex(THEME_WHITE), 0);
-    lv_obj_set_style_text_font(clockLabel_, &lv_font_montserrat_48, 0);
-    lv_obj_center(clockLabel_);
+    lv_obj_add_style(clockLabel_, &g_styles.textClock, 0);
 
     phaseLabel_ = lv_label_create(screenRunning_);
     lv_label_set_text(phaseLabel_, "WORK");
     lv_obj_set_style_text_color(phaseLabel_, lv_color_hex(THEME_GREEN), 0);
-    lv_obj_set_style_text_font(phaseLabel_, &lv_font_montserrat_14, 0);
-    lv_obj_align(phaseLabel_, LV_ALIGN_TOP_MID, 0, 90);
+    lv_obj_add_style(phaseLabel_, &g_styles.textSmall, 0);
 
     roundLabel_ = lv_label_create(screenRunning_);
     lv_label_set_text(roundLabel_, "Round 1/5");
     lv_obj_set_style_text_color(roundLabel_, lv_color_hex(THEME_GOLD), 0);
-    lv_obj_set_style_text_font(roundLabel_, &lv_font_montserrat_14, 0);
-    lv_obj_align(roundLabel_, LV_ALIGN_TOP_MID, 0, 110);
-
-    // Header - "CATCH JIU JITSU" (created last so it stays on top)
-    headerLabel_ = lv_label_create(root);
-    lv_label_set_text(headerLabel_, "CATCH JIU JITSU");
-    lv_obj_set_style_text_color(headerLabel_, lv_color_hex(THEME_GOLD), 0);
-    lv_obj_set_style_text_font(headerLabel_, &lv_font_montserrat_48, 0);
-    lv_obj_set_style_text_letter_space(headerLabel_, 4, 0);
-    lv_obj_align(headerLabel_, LV_ALIGN_TOP_MID, 0, 20);
+    lv_obj_add_style(roundLabel_, &g_styles.textSmall, 0);
+
+    // Competition score, hidden outside a match
+    for (lv_obj_t*& score : scoreLabel_) {
+        score = lv_label_create(screenRunning_);
+        lv_obj_set_style_text_align(score, LV_TEXT_ALIGN_CENTER, 0);
+        lv_obj_set_style_text_color(score, lv_color_hex(THEME_WHITE), 0);
+        lv_obj_add_style(score, &g_styles.textSmall, 0);
+        lv_obj_add_flag(score, LV_OBJ_FLAG_HIDDEN);
+    }
 
-    // Initial screen: menu
-    lv_obj_add_flag(screenSetup_, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_add_flag(screenRunning_, LV_OBJ_FLAG_HIDDEN);
-    currentScreen_ = 1;
+    // Partner list (rest screen), hidden until there is one
+    pairTitle_ = lv_label_create(screenRunning_);
+    lv_obj_set_style_text_color(pairTitle_, lv_color_hex(THEME_GOLD), 0);
+    lv_obj_add_style(pairTitle_, &g_styles.textSmall, 0);
+    for (lv_obj_t*& col : pairColumns_) {
+        col = lv_label_create(screenRunning_);
+        lv_label_set_long_mode(col, LV_LABEL_LONG_MODE_SCROLL_CIRCULAR);
+        lv_obj_set_style_text_color(col, lv_color_hex(THEME_WHITE), 0);
+        lv_obj_add_style(col, &g_styles.textSmall, 0);
+    }
+    layoutRunning();
+}
 
-    // Tick timer - drives timer logic and UI update
-    tickTimer_ = lv_timer_create(tickTimerCb, 1000, this);
+void TimerPanel::setText(lv_obj_t* label, char* cache, size_t cacheSize, const char* text) {
+    if (std::strncmp(cache, text, cacheSize) == 0) return;
+    const size_t len = strnlen(text, cacheSize - 1);
+    std::memcpy(cache, text, len);
+    cache[len] = '\0';
+    lv_label_set_text(label, text);
 }
 
-void BJJTimerUI::tickTimerCb(lv_timer_t* t) {
-    BJJTimerUI* ui = static_cast<BJJTimerUI*>(lv_timer_get_user_data(t));
-    if (!ui->timer_) return;
-    ui->timer_->tick();
-    DisplayInfo info = ui->timer_->getDisplayInfo();
-    ui->update(info);
-    if (ui->buzzerCb_) ui->buzzerCb_(info);
-    ui->timer_->clearAudioFlags();
+void TimerPanel::setTextColor(lv_obj_t* obj, uint32_t& cache, uint32_t color) {
+    if (cache == color) return;
+    cache = color;
+    lv_obj_set_style_text_color(obj, lv_color_hex(color), 0);
 }
 
-void BJJTimerUI::update(const DisplayInfo& info) {
+void TimerPanel::update(const DisplayInfo& info) {
     char buf[32];
 
     switch (info.state) {
-        case TimerState::MENU:
+        case TimerState::MENU: {
             showScreen(1);
-            if (info.mode == TimerMode::SPARRING) lv_roller_set_selected(modeRoller_, 0, LV_ANIM_OFF);
-            else if (info.mode == TimerMode::DRILLING) lv_roller_set_selected(modeRoller_, 1, LV_ANIM_OFF);
-            else lv_roller_set_selected(modeRoller_, 2, LV_ANIM_OFF);
+            int idx = info.mode == TimerMode::SPARRING ? 0 : (info.mode == TimerMode::DRILLING ? 1 : 2);
+            if (idx != rollerIndex_) {
+                rollerIndex_ = idx;
+                lv_roller_set_selected(modeRoller_, idx, LV_ANIM_OFF);
+            }
             break;
+        }
 
         case TimerState::SETUP_WORK:
         case TimerState::SETUP_REST:
         case TimerState::SETUP_ROUNDS:
             showScreen(2);
-            lv_label_set_text(valueLabel_, info.valueLabel.c_str());
+            setText(valueLabel_, valueText_, sizeof(valueText_), info.valueLabel);
             if (info.state == TimerState::SETUP_WORK)
-                lv_label_set_text(setupTitleLabel_, info.mode == TimerMode::COMPETITION ? "Match Time" : "Work Time");
+                setText(setupTitleLabel_, titleText_, sizeof(titleText_),
+                        info.mode == TimerMode::COMPETITION ? "Match Time" : "Work Time");
             else if (info.state == TimerState::SETUP_REST)
-                lv_label_set_text(setupTitleLabel_, "Rest Time");
+                setText(setupTitleLabel_, titleText_, sizeof(titleText_), "Rest Time");
             else
-                lv_label_set_text(setupTitleLabel_, info.mode == TimerMode::DRILLING ? "Interval" : "Rounds");
+                setText(setupTitleLabel_, titleText_, sizeof(titleText_),
+                        info.mode == TimerMode::DRILLING ? "Interval" : "Rounds");
             break;
 
         case TimerState::RUNNING:
@@ -164,69 +437,240 @@ void BJJTimerUI::update(const DisplayInfo& info) {
         case TimerState::FINISHED:
             showScreen(3);
             snprintf(buf, sizeof(buf), "%02u:%02u", info.secondsRemaining / 60, info.secondsRemaining % 60);
-            lv_label_set_text(clockLabel_, buf);
+            setText(clockLabel_, clockText_, sizeof(clockText_), buf);
 
             if (info.state == TimerState::PAUSED) {
-                lv_label_set_text(phaseLabel_, "PAUSED");
-                lv_obj_set_style_text_color(phaseLabel_, lv_color_hex(THEME_RED), 0);
+                setText(phaseLabel_, phaseText_, sizeof(phaseText_), "PAUSED");
+                setTextColor(phaseLabel_, phaseColor_, THEME_RED);
             } else {
                 if (info.phase == Phase::WORK) {
-                    lv_label_set_text(phaseLabel_, "WORK");
-                    lv_obj_set_style_text_color(phaseLabel_, lv_color_hex(THEME_GREEN), 0);
+                    setText(phaseLabel_, phaseText_, sizeof(phaseText_), "WORK");
+                    setTextColor(phaseLabel_, phaseColor_, THEME_GREEN);
                 } else if (info.phase == Phase::REST) {
-                    lv_label_set_text(phaseLabel_, "REST");
-                    lv_obj_set_style_text_color(phaseLabel_, lv_color_hex(THEME_RED), 0);
+                    setText(phaseLabel_, phaseText_, sizeof(phaseText_), "REST");
+                    setTextColor(phaseLabel_, phaseColor_, THEME_RED);
                 } else {
-                    lv_label_set_text(phaseLabel_, "SWITCH!");
-                    lv_obj_set_style_text_color(phaseLabel_, lv_color_hex(THEME_GOLD), 0);
+                    setText(phaseLabel_, phaseText_, sizeof(phaseText_), "SWITCH!");
+                    setTextColor(phaseLabel_, phaseColor_, THEME_GOLD);
                 }
             }
 
-            if (info.totalRounds > 1) {
+            if (info.scoring && info.state == TimerState::PAUSED) {
+                // The encoder is picking a score action
+                snprintf(buf, sizeof(buf), "%s", info.valueLabel);
+            } else if (info.totalRounds > 1) {
                 snprintf(buf, sizeof(buf), "Round %u/%u", info.currentRound, info.totalRounds);
             } else if (info.totalRounds == 1) {
                 snprintf(buf, sizeof(buf), "COMPETITION");
             } else {
                 snprintf(buf, sizeof(buf), "DRILLING");
             }
-            lv_label_set_text(roundLabel_, buf);
+            setText(roundLabel_, roundText_, sizeof(roundText_), buf);
 
-            unsigned total = info.phaseTotalSeconds;
-            if (total == 0) total = 60;
-            updateArc(info.secondsRemaining, total, info.phase == Phase::REST);
-            updateClock(info.secondsRemaining, info.phase == Phase::REST,
-                       info.secondsRemaining <= 10 && info.phase != Phase::REST);
+            if (!smoothArc_) {
+                unsigned total = info.phaseTotalSeconds;
+                if (total == 0) total = 60;
+                updateArc(info.secondsRemaining, total);
+            }
+            updateArcColor(info.phase == Phase::REST);
+            updateClock(info.phase == Phase::REST,
+                        info.secondsRemaining <= 10 && info.phase != Phase::REST);
+            updateScore(info);
             break;
     }
 }
 
-void BJJTimerUI::showScreen(int id) {
+void TimerPanel::showScreen(int id) {
     if (id == currentScreen_) return;
     currentScreen_ = id;
-    lv_obj_add_flag(screenMenu_, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_add_flag(screenSetup_, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_add_flag(screenRunning_, LV_OBJ_FLAG_HIDDEN);
+    if (id == 2 && !screenSetup_) buildSetupScreen();
+    if (id == 3 && !screenRunning_) buildRunningScreen();
+    for (lv_obj_t* scr : {screenMenu_, screenSetup_, screenRunning_}) {
+        if (scr) lv_obj_add_flag(scr, LV_OBJ_FLAG_HIDDEN);
+    }
     if (id == 1) lv_obj_remove_flag(screenMenu_, LV_OBJ_FLAG_HIDDEN);
     else if (id == 2) lv_obj_remove_flag(screenSetup_, LV_OBJ_FLAG_HIDDEN);
     else lv_obj_remove_flag(screenRunning_, LV_OBJ_FLAG_HIDDEN);
 }
 
-void BJJTimerUI::updateClock(unsigned sec, bool isRest, bool warn10) {
-    if (warn10)
-        lv_obj_set_style_text_color(clockLabel_, lv_color_hex(THEME_RED), 0);
-    else if (isRest)
-        lv_obj_set_style_text_color(clockLabel_, lv_color_hex(THEME_RED), 0);
-    else
-        lv_obj_set_style_text_color(clockLabel_, lv_color_hex(THEME_WHITE), 0);
+void TimerPanel::updateClock(bool isRest, bool warn10) {
+    setTextColor(clockLabel_, clockColor_, (warn10 || isRest) ? THEME_RED : THEME_WHITE);
+}
+
+void TimerPanel::setProgress(uint32_t remainingMs, uint32_t spanMs) {
+    if (currentScreen_ == 3) updateArc(remainingMs, spanMs);
+}
+
+void TimerPanel::updateArc(uint32_t remaining, uint32_t span) {
+    if (span == 0) return;
+    if (remaining > span) remaining = span;
+    int32_t steps = static_cast<int32_t>(uint64_t(remaining) * 360 * ARC_STEPS_PER_DEGREE / span);
+    if (steps == arcSteps_) return;
+    arcSteps_ = steps;
+    lv_arc_set_end_angle(progressArc_, static_cast<lv_value_precise_t>(steps) / ARC_STEPS_PER_DEGREE);
+}
+
+void TimerPanel::updateArcColor(bool isRest) {
+    uint32_t color = isRest ? THEME_RED : THEME_GREEN;
+    if (color != arcColor_) {
+        arcColor_ = color;
+        lv_obj_set_style_arc_color(progressArc_, lv_color_hex(color), LV_PART_INDICATOR);
+    }
+}
+
+void TimerPanel::updateScore(const DisplayInfo& info) {
+    if (info.scoring != scoreShown_) {
+        scoreShown_ = info.scoring;
+        for (lv_obj_t* score : scoreLabel_) {
+            if (scoreShown_) lv_obj_remove_flag(score, LV_OBJ_FLAG_HIDDEN);
+            else lv_obj_add_flag(score, LV_OBJ_FLAG_HIDDEN);
+        }
+    }
+    if (!scoreShown_) return;
+    const int leader = info.score.leader();
+    char buf[16];
+    for (unsigned a = 0; a < 2; ++a) {
+        snprintf(buf, sizeof(buf), "%u\nA%u P%u", info.score.points[a],
+                 info.score.advantages[a], info.score.penalties[a]);
+        setText(scoreLabel_[a], scoreText_[a], sizeof(scoreText_[a]), buf);
+        setTextColor(scoreLabel_[a], scoreColor_[a], leader == static_cast<int>(a) ? THEME_GOLD : THEME_WHITE);
+    }
+}
+
+// ============================================================================
+// TIMER UI
+// ============================================================================
+BJJTimerUI::BJJTimerUI() = default;
+
+BJJTimerUI::~BJJTimerUI() {
+    if (frameTimer_) lv_timer_delete(frameTimer_);
+    if (hud_) lv_obj_delete(hud_);
+    if (root_) lv_obj_remove_event_cb_with_user_data(root_, onSizeChanged, this);
+    for (TimerPanel*& p : panels_) {
+        delete p;
+        p = nullptr;
+    }
+}
+
+void BJJTimerUI::create(lv_obj_t* parent, unsigned panelCount) {
+    lv_obj_t* root = parent ? parent : lv_screen_active();
+    if (!root) return;
+    root_ = root;
+    initStyles();
+
+    // Main container - full screen, dark bg
+    lv_obj_set_style_bg_color(root, lv_color_hex(THEME_BG), 0);
+    lv_obj_set_style_bg_opa(root, LV_OPA_COVER, 0);
+
+    // Tile grid: 1 = full screen, 2 = side by side, 4 = 2x2, 6 = 3x2 (3 and 5 leave a cell empty)
+    panelCount_ = std::max(1u, std::min(panelCount, MAX_PANELS));
+    if (panelCount_ >= 5)      { cols_ = 3; rows_ = 2; }
+    else if (panelCount_ >= 3) { cols_ = 2; rows_ = 2; }
+    else if (panelCount_ == 2) { cols_ = 2; }
+
+    lv_obj_update_layout(root);
+    width_ = lv_obj_get_width(root);
+    height_ = lv_obj_get_height(root);
+    layout_ = computePanelLayout(width_ / cols_, height_ / rows_, panelCount_ > 1);
+    applyStyleLayout(layout_);
+    for (unsigned i = 0; i < panelCount_; ++i) {
+        panels_[i] = new TimerPanel(root, tileArea(i), layout_, i, panelCount_ > 1);
+    }
+
+    // Window resize / display rotation: one re-layout pass, objects are kept
+    lv_obj_add_event_cb(root, onSizeChanged, LV_EVENT_SIZE_CHANGED, this);
+}
+
+void BJJTimerUI::setHud(const char* text) {
+    if (!text) {
+        if (hud_) lv_obj_add_flag(hud_, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
+    if (!hud_) {
+        // Fixed font and size: independent of the panel layout and of the text
+        const lv_font_t* font = &lv_font_montserrat_12;
+        hud_ = lv_label_create(lv_layer_top());
+        lv_obj_set_style_text_font(hud_, font, 0);
+        lv_obj_set_style_text_color(hud_, lv_color_hex(THEME_GOLD), 0);
+        lv_obj_set_style_bg_color(hud_, lv_color_hex(THEME_BG), 0);
+        lv_obj_set_style_bg_opa(hud_, LV_OPA_COVER, 0);
+        lv_obj_set_style_pad_all(hud_, 4, 0);
+        lv_label_set_long_mode(hud_, LV_LABEL_LONG_MODE_CLIP);
+        lv_obj_set_size(hud_, 340, 3 * lv_font_get_line_height(font) + 8);
+        lv_obj_align(hud_, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+        lv_obj_remove_flag(hud_, LV_OBJ_FLAG_CLICKABLE);
+    }
+    lv_obj_remove_flag(hud_, LV_OBJ_FLAG_HIDDEN);
+    lv_label_set_text(hud_, text);
+}
+
+PanelArea BJJTimerUI::tileArea(unsigned index) const {
+    const int32_t cols = static_cast<int32_t>(cols_), rows = static_cast<int32_t>(rows_);
+    const int32_t c = static_cast<int32_t>(index % cols_), r = static_cast<int32_t>(index / cols_);
+    return PanelArea{
+        width_ * c / cols, height_ * r / rows,
+        width_ * (c + 1) / cols - width_ * c / cols,
+        height_ * (r + 1) / rows - height_ * r / rows,
+    };
+}
+
+void BJJTimerUI::onSizeChanged(lv_event_t* e) {
+    static_cast<BJJTimerUI*>(lv_event_get_user_data(e))->relayout();
+}
+
+void BJJTimerUI::setProgressSource(ProgressSource fn, void* ctx) {
+    progressFn_ = fn;
+    progressCtx_ = ctx;
+    for (unsigned i = 0; i < panelCount_; ++i) {
+        panels_[i]->setSmoothArc(fn != nullptr);
+    }
+    if (fn && !frameTimer_) {
+        frameTimer_ = lv_timer_create(onFrame, LV_DEF_REFR_PERIOD, this);
+    } else if (!fn && frameTimer_) {
+        lv_timer_delete(frameTimer_);
+        frameTimer_ = nullptr;
+    }
+}
+
+void BJJTimerUI::setFramePeriod(uint32_t ms) {
+    if (frameTimer_) lv_timer_set_period(frameTimer_, ms);
+}
+
+void BJJTimerUI::onFrame(lv_timer_t* t) {
+    static_cast<BJJTimerUI*>(lv_timer_get_user_data(t))->animate();
+}
+
+void BJJTimerUI::animate() {
+    if (!progressFn_) return;
+    for (unsigned i = 0; i < panelCount_; ++i) {
+        TimerPanel* p = panels_[i];
+        uint32_t remaining, span;
+        if (p->showingRunning() && progressFn_(progressCtx_, i, remaining, span)) {
+            p->setProgress(remaining, span);
+        }
+    }
+}
+
+void BJJTimerUI::relayout() {
+    if (!root_) return;
+    int32_t w = lv_obj_get_width(root_);
+    int32_t h = lv_obj_get_height(root_);
+    if (w == width_ && h == height_) return;
+    width_ = w;
+    height_ = h;
+    layout_ = computePanelLayout(width_ / cols_, height_ / rows_, panelCount_ > 1);
+    applyStyleLayout(layout_);
+    for (unsigned i = 0; i < panelCount_; ++i) {
+        panels_[i]->applyLayout(tileArea(i), layout_);
+    }
+}
+
+void BJJTimerUI::update(unsigned panel, const DisplayInfo& info) {
+    if (panel < panelCount_ && panels_[panel]) panels_[panel]->update(info);
 }
 
-void BJJTimerUI::updateArc(unsigned sec, unsigned total, bool isRest) {
-    if (total == 0) return;
-    int val = (int)((sec * 100) / total);
-    if (val < 0) val = 0;
-    if (val > 100) val = 100;
-    lv_arc_set_value(progressArc_, val);
-    lv_obj_set_style_arc_color(progressArc_, lv_color_hex(isRest ? THEME_RED : THEME_GREEN), LV_PART_INDICATOR);
+void BJJTimerUI::setPairings(unsigned panel, const char* title, const TextList& pairs) {
+    if (panel < panelCount_ && panels_[panel]) panels_[panel]->setPairings(title, pairs);
 }
 
 } // namespace bjj
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "text_list.hpp"
 #include "timer_logic.hpp"
 #include <lvgl.h>
 
@@ -18,26 +19,77 @@ namespace bjj {
 #define THEME_RED      0xFF0000   // REST
 #define THEME_GRAY     0x808080
 
-class BJJTimerUI {
+constexpr unsigned MAX_PANELS = 6;  // Split-screen tiles: 1, 2, 4 or 6
+
+struct PanelArea {
+    int32_t x, y, w, h;
+};
+
+// Everything size-dependent in a panel, derived from its pixel size. Computed
+// once per resize and cached; nothing is laid out per frame.
+struct PanelLayout {
+    const lv_font_t* fontSmall;  // Labels, compact roller
+    const lv_font_t* fontLarge;  // Header, full-screen roller
+    const lv_font_t* fontClock;  // Clock + setup value
+    int32_t clockScale;          // Glyph scale on top of fontClock (256 = 1:1)
+    int32_t headerX, headerY, letterSpace;
+    int32_t menuTitleY, rollerY, setupTitleY;
+    int32_t arcSize, arcWidth;
+    int32_t phaseY, roundY;      // Top offsets of the running-screen labels
+};
+
+// compact: tile metrics (reference 400x240) instead of full screen (800x480)
+PanelLayout computePanelLayout(int32_t w, int32_t h, bool compact);
+
+constexpr int32_t ARC_STEPS_PER_DEGREE = 10;  // Sub-degree arc resolution
+constexpr unsigned MAX_PAIR_COLUMNS = 4;      // Rest-screen partner list
+
+// ============================================================================
+// TIMER PANEL - one timer's menu/setup/running views inside a screen region
+// ============================================================================
+class TimerPanel {
 public:
-    BJJTimerUI();
-    ~BJJTimerUI();
+    // compact: tiled layout with a per-mat title instead of the full-screen header
+    TimerPanel(lv_obj_t* parent, const PanelArea& area, const PanelLayout& layout,
+               unsigned matIndex, bool compact);
+    ~TimerPanel();
+    TimerPanel(const TimerPanel&) = delete;
+    TimerPanel& operator=(const TimerPanel&) = delete;
 
-    void create(lv_obj_t* parent);
     void update(const DisplayInfo& info);
-    void setTimerLogic(TimerLogic* logic) { timer_ = logic; }
-    void setBuzzerCallback(void (*cb)(const DisplayInfo&)) { buzzerCb_ = cb; }
 
-private:
-    static void tickTimerCb(lv_timer_t* t);
+    // Move/resize the existing widgets; nothing is rebuilt
+    void applyLayout(const PanelArea& area, const PanelLayout& layout);
+
+    // Drive the arc from ms-resolution time instead of whole seconds in update()
+    void setSmoothArc(bool on) { smoothArc_ = on; }
+    void setProgress(uint32_t remainingMs, uint32_t spanMs);
+    bool showingRunning() const { return currentScreen_ == 3; }
 
+    // Partner list beside a smaller arc on the running screen; no pairs hides
+    // it. Copied, and laid out in as many columns as fit.
+    void setPairings(const char* title, const TextList& pairs);
+
+private:
+    lv_obj_t* createScreen();
     void buildMenuScreen();
-    void buildSetupScreen();
-    void buildRunningScreen();
+    void buildSetupScreen();   // Built lazily on first use
+    void buildRunningScreen(); // Built lazily on first use
+    void layoutHeader();
+    void layoutMenu();
+    void layoutSetup();
+    void layoutRunning();
     void showScreen(int screenId);
-    void updateClock(unsigned sec, bool isRest, bool warn10);
-    void updateArc(unsigned sec, unsigned total, bool isRest);
+    void updateClock(bool isRest, bool warn10);
+    void updateArc(uint32_t remaining, uint32_t span);
+    void updateArcColor(bool isRest);
+    void updateScore(const DisplayInfo& info);
+
+    // Only touch LVGL (and so invalidate) when a value actually changes
+    void setText(lv_obj_t* label, char* cache, size_t cacheSize, const char* text);
+    void setTextColor(lv_obj_t* obj, uint32_t& cache, uint32_t color);
 
+    lv_obj_t* container_ = nullptr;
     lv_obj_t* screenMenu_ = nullptr;
     lv_obj_t* screenSetup_ = nullptr;
     lv_obj_t* screenRunning_ = nullptr;
@@ -50,13 +102,79 @@ private:
     lv_obj_t* modeRoller_ = nullptr;
     lv_obj_t* setupTitleLabel_ = nullptr;
     lv_obj_t* valueLabel_ = nullptr;
+    lv_obj_t* menuTitle_ = nullptr;
+    lv_obj_t* scoreLabel_[2] = {};  // Competition: athlete 1 left of the clock, 2 right
+    lv_obj_t* pairTitle_ = nullptr;
+    lv_obj_t* pairColumns_[MAX_PAIR_COLUMNS] = {};
 
-    lv_timer_t* tickTimer_ = nullptr;
-    TimerLogic* timer_ = nullptr;
-    void (*buzzerCb_)(const DisplayInfo&) = nullptr;
-
+    PanelArea area_;
+    PanelLayout layout_;
+    unsigned matIndex_;
+    bool compact_;
     int currentScreen_ = 0;
-    unsigned lastSeconds_ = 0;
+
+    // Last values pushed to LVGL
+    char clockText_[8] = {};
+    char phaseText_[12] = {};
+    char roundText_[24] = {};
+    char valueText_[24] = {};
+    char titleText_[16] = {};
+    char scoreText_[2][16] = {};
+    uint32_t clockColor_ = 0xFFFFFFFF;
+    uint32_t phaseColor_ = 0xFFFFFFFF;
+    uint32_t arcColor_ = 0xFFFFFFFF;
+    uint32_t scoreColor_[2] = {0xFFFFFFFF, 0xFFFFFFFF};
+    bool scoreShown_ = false;
+    int32_t arcSteps_ = -1;  // Indicator end angle in 1/ARC_STEPS_PER_DEGREE degrees
+    bool smoothArc_ = false;
+    int rollerIndex_ = -1;
+    char pairTitleText_[16] = {};
+    TextList pairs_;
+};
+
+// ============================================================================
+// TIMER UI - one full-screen panel, or 2/4/6 tiles sharing styles and fonts
+// ============================================================================
+class BJJTimerUI {
+public:
+    BJJTimerUI();
+    ~BJJTimerUI();
+
+    void create(lv_obj_t* parent, unsigned panelCount = 1);
+    void update(const DisplayInfo& info) { update(0, info); }
+    void update(unsigned panel, const DisplayInfo& info);
+    void setPairings(unsigned panel, const char* title, const TextList& pairs);
+    unsigned panelCount() const { return panelCount_; }
+
+    // Re-layout every panel for the parent's current size (no-op if unchanged)
+    void relayout();
+
+    // Animate running arcs at the display refresh rate from a ms-resolution source
+    using ProgressSource = bool (*)(void* ctx, unsigned panel, uint32_t& remainingMs, uint32_t& spanMs);
+    void setProgressSource(ProgressSource fn, void* ctx);
+    void animate();  // One progress frame; normally run by the refresh-rate timer
+    void setFramePeriod(uint32_t ms);  // Follow a changed display refresh period
+
+    // Performance HUD, bottom-left on the top layer; nullptr hides it. The box
+    // has a fixed size and an opaque background, so a new text redraws that
+    // box and nothing behind it.
+    void setHud(const char* text);
+
+private:
+    static void onSizeChanged(lv_event_t* e);
+    static void onFrame(lv_timer_t* t);
+    PanelArea tileArea(unsigned index) const;
+
+    lv_obj_t* root_ = nullptr;
+    lv_timer_t* frameTimer_ = nullptr;
+    lv_obj_t* hud_ = nullptr;
+    ProgressSource progressFn_ = nullptr;
+    void* progressCtx_ = nullptr;
+    TimerPanel* panels_[MAX_PANELS] = {};
+    unsigned panelCount_ = 0;
+    unsigned cols_ = 1, rows_ = 1;
+    int32_t width_ = 0, height_ = 0;
+    PanelLayout layout_{};
 };
 
 } // namespace bjj